@@ -0,0 +1,869 @@
+﻿//--------------------------------------------------------------------------------------
+// File: AsyncLoader.h
+//
+// 多数のモデルデータ(.imdl)を非同期に読み込むクラス
+//
+// ※Linux では io_uring（登録バッファへの READ_FIXED）で読み込む
+//   io_uring のスレッドは要求の発行と完了の取り出しのみ行い、展開とコールバックはスレッドプールで行う
+//   io_uring が使えない環境（古いカーネル、コンテナの制限、Windows）ではスレッドプールで読み込む
+// ※ファイルは優先度の順、同じ優先度は要求順に読み込む（先に要求したファイルから読み終わる）
+//   ファイルの中ではチャンクごとに優先度を付けて読み込む（既定はジオメトリ → テクスチャの順）
+// ※読み込んだチャンクはコールバックに渡す（圧縮されている場合は展開してから渡す）
+//
+// Date: 2026.3.9
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "Benchmark.h"
+#include "ChunkIO.h"
+#include "Compression.h"
+#include "Imdl.h"
+#include "ImdlReader.h"
+#include "IoUring.h"
+#include "Parallel.h"
+#include "ThreadPool.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Imase
+{
+    // 読み込んだチャンク
+    // ※data はコールバックの中でのみ有効
+    struct AsyncChunk
+    {
+        const std::filesystem::path* path;  // ファイル名
+        uint32_t type;                      // チャンクタイプ
+        uint32_t flags;                     // チャンクフラグ（展開済みの場合も記録されている値）
+        Span<uint8_t> data;                 // データ（展開後）
+    };
+
+    // ファイルの読み込み結果
+    struct AsyncFileResult
+    {
+        const std::filesystem::path* path;  // ファイル名
+        bool succeeded;                     // 成功したか
+        std::string error;                  // エラーの内容
+        uint64_t bytes;                     // 読み込んだサイズ
+        double latencySec;                  // 要求から完了までの時間（秒）
+    };
+
+    using AsyncChunkCallback = std::function<void(const AsyncChunk&)>;
+    using AsyncFileCallback = std::function<void(const AsyncFileResult&)>;
+
+    // 非同期読み込みの設定
+    struct AsyncLoaderSettings
+    {
+        bool useIoUring = true;         // io_uring を使う（使えない場合はスレッドプール）
+        unsigned queueDepth = 64;       // 同時に発行する読み込みの数
+        unsigned bufferCount = 64;      // 登録バッファの数（io_uring）
+        size_t bufferSize = 1 << 20;    // 登録バッファのサイズ（これより大きいチャンクは通常の READ）
+        unsigned threads = 0;           // スレッドプールのスレッド数（0 = 論理コア数）
+    };
+
+    // チャンクタイプごとの既定の優先度（大きいほど先に読み込む）
+    // ※描画に必要なジオメトリを先に、高解像度のテクスチャを最後に読み込む
+    inline int GetDefaultChunkPriority(uint32_t type)
+    {
+        switch (type)
+        {
+        case CHUNK_MATERIAL:
+        case CHUNK_MESH:
+            return 3;
+
+        case CHUNK_VERTEX:
+        case CHUNK_INDEX:
+            return 2;
+
+        case CHUNK_TEXTURE:
+            return 0;
+
+        default:
+            return 1;
+        }
+    }
+
+    namespace AsyncDetail
+    {
+        // 位置を指定して読み込むファイル
+        class File
+        {
+        public:
+
+            File() = default;
+
+            ~File()
+            {
+                Close();
+            }
+
+            File(const File&) = delete;
+            File& operator=(const File&) = delete;
+
+            bool Open(const std::filesystem::path& path)
+            {
+#if defined(_WIN32)
+                m_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (m_handle == INVALID_HANDLE_VALUE) return false;
+
+                LARGE_INTEGER size{};
+                if (!GetFileSizeEx(m_handle, &size)) return false;
+                m_size = static_cast<uint64_t>(size.QuadPart);
+#else
+                m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (m_fd < 0) return false;
+
+                struct stat st {};
+                if (fstat(m_fd, &st) != 0) return false;
+                m_size = static_cast<uint64_t>(st.st_size);
+#endif
+                return true;
+            }
+
+            void Close()
+            {
+#if defined(_WIN32)
+                if (m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+                m_handle = INVALID_HANDLE_VALUE;
+#else
+                if (m_fd >= 0) close(m_fd);
+                m_fd = -1;
+#endif
+            }
+
+            // 指定位置から読み込む関数（戻り値は読み込んだサイズ、負の値はエラー）
+            int64_t ReadAt(void* dst, size_t size, uint64_t offset)
+            {
+                uint8_t* p = static_cast<uint8_t*>(dst);
+                size_t done = 0;
+                while (done < size)
+                {
+                    size_t request = size - done;
+                    if (request > (1u << 30)) request = 1u << 30;
+#if defined(_WIN32)
+                    OVERLAPPED overlapped{};
+                    overlapped.Offset = static_cast<DWORD>((offset + done) & 0xffffffff);
+                    overlapped.OffsetHigh = static_cast<DWORD>((offset + done) >> 32);
+                    DWORD read = 0;
+                    if (!ReadFile(m_handle, p + done, static_cast<DWORD>(request), &read, &overlapped)) return -1;
+#else
+                    ssize_t read = pread(m_fd, p + done, request, static_cast<off_t>(offset + done));
+                    if (read < 0)
+                    {
+                        if (errno == EINTR) continue;
+                        return -errno;
+                    }
+#endif
+                    if (read == 0) break;
+                    done += static_cast<size_t>(read);
+                }
+                return static_cast<int64_t>(done);
+            }
+
+            uint64_t GetSize() const
+            {
+                return m_size;
+            }
+
+#if !defined(_WIN32)
+            int GetFd() const
+            {
+                return m_fd;
+            }
+#endif
+
+        private:
+
+#if defined(_WIN32)
+            HANDLE m_handle = INVALID_HANDLE_VALUE;
+#else
+            int m_fd = -1;
+#endif
+            uint64_t m_size = 0;
+        };
+    }
+
+    class AsyncImdlLoader
+    {
+    public:
+
+        explicit AsyncImdlLoader(const AsyncLoaderSettings& settings = AsyncLoaderSettings())
+            : m_settings(settings)
+        {
+            if (m_settings.queueDepth == 0) m_settings.queueDepth = 1;
+
+#if defined(IMDL_HAS_IO_URING)
+            if (m_settings.useIoUring && m_ring.Initialize(m_settings.queueDepth))
+            {
+                // 登録バッファ（カーネルに事前にピン留めしておき、読み込みごとのマップを省く）
+                m_bufferMemory.resize(m_settings.bufferCount * m_settings.bufferSize);
+                std::vector<iovec> buffers;
+                for (unsigned i = 0; i < m_settings.bufferCount; i++)
+                {
+                    uint8_t* p = m_bufferMemory.data() + m_settings.bufferSize * i;
+                    buffers.push_back({ p, m_settings.bufferSize });
+                    m_freeBuffers.push_back(static_cast<int>(i));
+                }
+
+                if (!m_ring.RegisterBuffers(buffers))
+                {
+                    // 登録できない場合（RLIMIT_MEMLOCK など）は登録バッファを使わない
+                    m_bufferMemory.clear();
+                    m_freeBuffers.clear();
+                }
+
+                // 展開とコールバックはスレッドプールで行う（io_uring のスレッドを止めない）
+                m_pool = std::make_unique<ThreadPool>(m_settings.threads);
+
+                m_useIoUring = true;
+                m_threads.emplace_back([this]() { RunIoUring(); });
+                return;
+            }
+#endif
+            unsigned count = GetWorkerCount(m_settings.threads);
+            for (unsigned i = 0; i < count; i++)
+            {
+                m_threads.emplace_back([this]() { RunWorker(); });
+            }
+        }
+
+        ~AsyncImdlLoader()
+        {
+            Wait();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_queueChanged.notify_all();
+            for (auto& t : m_threads) t.join();
+            m_pool.reset();
+        }
+
+        AsyncImdlLoader(const AsyncImdlLoader&) = delete;
+        AsyncImdlLoader& operator=(const AsyncImdlLoader&) = delete;
+
+        // io_uring で読み込んでいるか？
+        bool IsUsingIoUring() const
+        {
+            return m_useIoUring;
+        }
+
+        // 登録バッファを使っているか？
+        bool IsUsingRegisteredBuffers() const
+        {
+            return m_useIoUring && !m_bufferMemory.empty();
+        }
+
+        // ファイルの読み込みを要求する関数
+        // priority   : ファイルの優先度（大きいほど先に読み込む）
+        // onChunk    : チャンクを読み込むたびに呼ばれる（スレッドプールから呼ばれる、同じファイルのチャンクも並行して呼ばれる）
+        // onComplete : ファイルの読み込みが終わったら呼ばれる（失敗した場合も呼ばれる）
+        void Load(const std::filesystem::path& path, int priority, AsyncChunkCallback onChunk, AsyncFileCallback onComplete = nullptr)
+        {
+            auto file = std::make_shared<FileState>();
+            file->path = path;
+            file->priority = priority;
+            file->onChunk = std::move(onChunk);
+            file->onComplete = std::move(onComplete);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                file->sequence = m_fileSequence++;
+                m_files.insert(file);
+            }
+
+            if (!file->file.Open(path))
+            {
+                Fail(*file, "could not open the file");
+                Complete(file);
+                return;
+            }
+
+            // ヘッダとチャンクテーブル（たいていは先頭 4KB に収まる）
+            uint64_t size = file->file.GetSize() < HEADER_READ_SIZE ? file->file.GetSize() : HEADER_READ_SIZE;
+            file->pending = 1;
+            Enqueue(file, ReadKind::Header, 0, 0, size);
+        }
+
+        // 要求したすべてのファイルの読み込みが終わるまで待つ関数
+        void Wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_filesChanged.wait(lock, [this]() { return m_files.empty(); });
+        }
+
+    private:
+
+        static constexpr uint64_t HEADER_READ_SIZE = 4096;
+
+        // ヘッダの優先度（チャンクより先に読み込む）
+        static constexpr int HEADER_PRIORITY = 7;
+
+        enum class ReadKind
+        {
+            Header,     // ヘッダとチャンクテーブル
+            Whole,      // ファイル全体（バージョン１）
+            Chunk,      // チャンク
+        };
+
+        struct FileState;
+
+        // 読み込み要求
+        struct ReadOp
+        {
+            std::shared_ptr<FileState> file;
+            ReadKind kind;
+            size_t chunkIndex;
+            uint64_t offset;
+            size_t size;
+            size_t done = 0;
+            uint8_t* dst = nullptr;
+            std::unique_ptr<uint8_t[]> heap; // 登録バッファを使わない場合の読み込み先（ゼロ初期化しない）
+            int buffer = -1;                // 登録バッファの番号
+            bool failed = false;            // 読み込みに失敗した
+            int priority;                   // ファイルの優先度
+            uint64_t fileSequence;          // ファイルの要求順
+            int chunkPriority;              // ファイルの中での優先度
+            uint64_t sequence;
+        };
+
+        // ファイルの優先度の高い順、ファイルの要求順、ファイルの中での優先度の高い順、要求順
+        // ※ファイルをまたいでチャンクの優先度を比べると、すべてのファイルが最後まで読み終わらない
+        struct ReadOpOrder
+        {
+            bool operator()(const ReadOp* a, const ReadOp* b) const
+            {
+                if (a->priority != b->priority) return a->priority < b->priority;
+                if (a->fileSequence != b->fileSequence) return a->fileSequence > b->fileSequence;
+                if (a->chunkPriority != b->chunkPriority) return a->chunkPriority < b->chunkPriority;
+                return a->sequence > b->sequence;
+            }
+        };
+
+        // 読み込み中のファイル
+        struct FileState
+        {
+            std::filesystem::path path;
+            int priority = 0;
+            uint64_t sequence = 0;
+            AsyncChunkCallback onChunk;
+            AsyncFileCallback onComplete;
+
+            AsyncDetail::File file;
+            Stopwatch stopwatch;
+
+            std::vector<ChunkEntry64> entries;
+            uint32_t fileFlags = 0;
+
+            std::atomic<size_t> pending{ 0 };
+            std::atomic<uint64_t> bytes{ 0 };
+            std::atomic<bool> failed{ false };
+            std::mutex mutex;
+            std::string error;
+
+            std::vector<std::unique_ptr<ReadOp>> ops;
+        };
+
+        // 読み込みを要求する関数
+        void Enqueue(const std::shared_ptr<FileState>& file, ReadKind kind, size_t chunkIndex, uint64_t offset, uint64_t size)
+        {
+            if (size > SIZE_MAX)
+            {
+                Fail(*file, "chunk is too large");
+                Finish(file);
+                return;
+            }
+
+            auto op = std::make_unique<ReadOp>();
+            op->file = file;
+            op->kind = kind;
+            op->chunkIndex = chunkIndex;
+            op->offset = offset;
+            op->size = static_cast<size_t>(size);
+
+            op->priority = file->priority;
+            op->fileSequence = file->sequence;
+            op->chunkPriority = kind == ReadKind::Chunk ? GetDefaultChunkPriority(file->entries[chunkIndex].type) : HEADER_PRIORITY;
+
+            ReadOp* p = op.get();
+            {
+                std::lock_guard<std::mutex> lock(file->mutex);
+                file->ops.push_back(std::move(op));
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                p->sequence = m_sequence++;
+                m_queue.push(p);
+            }
+            m_queueChanged.notify_one();
+        }
+
+        // 読み込みの続きを要求する関数（短い読み込みの場合）
+        void Requeue(ReadOp* op)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_queue.push(op);
+            }
+            m_queueChanged.notify_one();
+        }
+
+        void Fail(FileState& file, const std::string& error)
+        {
+            std::lock_guard<std::mutex> lock(file.mutex);
+            if (!file.failed.exchange(true)) file.error = error;
+        }
+
+        // 読み込みが終わった処理（成功、失敗とも）
+        void Finish(const std::shared_ptr<FileState>& file)
+        {
+            if (--file->pending == 0)
+            {
+                Complete(file);
+            }
+        }
+
+        // ファイルの読み込みが終わった処理
+        void Complete(const std::shared_ptr<FileState>& file)
+        {
+            file->file.Close();
+
+            // 読み込み要求を解放（要求がファイルを参照しているので循環を断つ）
+            std::vector<std::unique_ptr<ReadOp>> ops;
+            {
+                std::lock_guard<std::mutex> lock(file->mutex);
+                ops.swap(file->ops);
+            }
+            ops.clear();
+
+            if (file->onComplete)
+            {
+                AsyncFileResult result{ &file->path, !file->failed, file->error, file->bytes, file->stopwatch.ElapsedSec() };
+                file->onComplete(result);
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_files.erase(file);
+            if (m_files.empty()) m_filesChanged.notify_all();
+        }
+
+        // チャンクをコールバックに渡す関数
+        void Deliver(FileState& file, uint32_t type, uint32_t flags, const uint8_t* data, size_t size)
+        {
+            if (file.failed) return;
+
+            file.bytes += size;
+
+            // 圧縮されている場合は展開する
+            // ※チャンクごとに別のスレッドで展開するので、１つのチャンクの展開には他のスレッドを使わない
+            std::vector<uint8_t> decoded;
+            if ((flags & IMDL_CHUNK_FLAG_COMPRESSION_MASK) != COMPRESSION_NONE)
+            {
+                if (!DecompressChunkData(flags, data, size, decoded, 1))
+                {
+                    Fail(file, "could not decompress chunk " + GetChunkTypeName(type));
+                    return;
+                }
+                data = decoded.data();
+                size = decoded.size();
+            }
+
+            if (file.onChunk)
+            {
+                file.onChunk({ &file.path, type, flags, Span<uint8_t>(data, size) });
+            }
+        }
+
+        // ヘッダとチャンクテーブルを読み込んだ処理
+        void OnHeader(ReadOp* op)
+        {
+            std::shared_ptr<FileState> file = op->file;
+            uint64_t fileSize = file->file.GetSize();
+
+            FileHeader header;
+            if (op->size < sizeof(header))
+            {
+                Fail(*file, "file is too small");
+                return;
+            }
+            std::memcpy(&header, op->dst, sizeof(header));
+
+            if (header.magic != IMDL_MAGIC)
+            {
+                Fail(*file, "not an imdl file");
+                return;
+            }
+
+            // バージョン１はチャンクテーブルがないのでファイル全体を読み込む
+            if (header.version == IMDL_VERSION_1)
+            {
+                if (op->size == fileSize)
+                {
+                    OnWhole(op);
+                    return;
+                }
+                file->pending++;
+                Enqueue(file, ReadKind::Whole, 0, 0, fileSize);
+                return;
+            }
+
+            if (header.version != IMDL_VERSION_2 || op->size < sizeof(FileHeaderV2))
+            {
+                Fail(*file, "unsupported version " + std::to_string(header.version));
+                return;
+            }
+
+            // チャンクテーブルが先頭の読み込みに収まらなかった
+            FileHeaderV2 headerV2;
+            std::memcpy(&headerV2, op->dst, sizeof(headerV2));
+            uint64_t tableEnd = GetChunkTableEnd(headerV2);
+            if (tableEnd > op->size)
+            {
+                if (tableEnd > fileSize)
+                {
+                    Fail(*file, "chunk table is corrupted");
+                    return;
+                }
+                file->pending++;
+                Enqueue(file, ReadKind::Header, 0, 0, tableEnd);
+                return;
+            }
+
+            std::vector<ChunkEntry64> entries;
+            if (!ParseChunkTable(op->dst, op->size, fileSize, headerV2, entries))
+            {
+                Fail(*file, "chunk table is corrupted");
+                return;
+            }
+
+            file->entries = std::move(entries);
+            file->fileFlags = headerV2.flags;
+
+            // チャンクごとに優先度を付けて読み込む
+            for (size_t i = 0; i < file->entries.size(); i++)
+            {
+                const ChunkEntry64& entry = file->entries[i];
+                if (entry.type == CHUNK_CHECKSUM) continue;
+
+                file->pending++;
+                Enqueue(file, ReadKind::Chunk, i, entry.offset, entry.size);
+            }
+        }
+
+        // ファイル全体を読み込んだ処理（バージョン１）
+        void OnWhole(ReadOp* op)
+        {
+            FileState& file = *op->file;
+
+            FileHeader header;
+            std::memcpy(&header, op->dst, sizeof(header));
+
+            // チャンクを優先度順に渡す
+            struct Chunk
+            {
+                uint32_t type;
+                const uint8_t* data;
+                size_t size;
+            };
+            std::vector<Chunk> chunks;
+
+            uint64_t pos = sizeof(FileHeader);
+            for (uint32_t i = 0; i < header.chunkCount; i++)
+            {
+                ChunkHeader chunk;
+                if (op->size - pos < sizeof(chunk))
+                {
+                    Fail(file, "chunk header out of range");
+                    return;
+                }
+                std::memcpy(&chunk, op->dst + pos, sizeof(chunk));
+                pos += sizeof(chunk);
+
+                if (chunk.size > op->size - pos)
+                {
+                    Fail(file, "chunk " + GetChunkTypeName(chunk.type) + " out of range");
+                    return;
+                }
+                chunks.push_back({ chunk.type, op->dst + pos, chunk.size });
+                pos += chunk.size;
+            }
+
+            std::stable_sort(chunks.begin(), chunks.end(), [](const Chunk& a, const Chunk& b)
+                {
+                    return GetDefaultChunkPriority(a.type) > GetDefaultChunkPriority(b.type);
+                });
+
+            for (const auto& chunk : chunks)
+            {
+                Deliver(file, chunk.type, 0, chunk.data, chunk.size);
+            }
+        }
+
+        // 読み込みの結果を記録する関数（false の場合は続きを読み込むので、まだ処理しない）
+        // result : 読み込んだサイズ、負の値はエラー
+        bool OnRead(ReadOp* op, int64_t result)
+        {
+            if (result < 0)
+            {
+                Fail(*op->file, "read failed (error " + std::to_string(-result) + ")");
+                op->failed = true;
+                return true;
+            }
+
+            if (result == 0 && op->done < op->size)
+            {
+                Fail(*op->file, "unexpected end of file");
+                op->failed = true;
+                return true;
+            }
+
+            op->done += static_cast<size_t>(result);
+
+            // 短い読み込みの場合は続きを読み込む
+            if (op->done < op->size)
+            {
+                Requeue(op);
+                return false;
+            }
+            return true;
+        }
+
+        // 読み終わった要求を処理する関数（チャンクの展開、コールバック）
+        void Process(ReadOp* op)
+        {
+            std::shared_ptr<FileState> file = op->file;
+
+            if (!op->failed)
+            {
+                switch (op->kind)
+                {
+                case ReadKind::Header:
+                    OnHeader(op);
+                    break;
+
+                case ReadKind::Whole:
+                    OnWhole(op);
+                    break;
+
+                case ReadKind::Chunk:
+                {
+                    const ChunkEntry64& entry = file->entries[op->chunkIndex];
+                    Deliver(*file, entry.type, entry.flags, op->dst, op->size);
+                    break;
+                }
+                }
+            }
+
+            // 読み込み先を解放
+            ReleaseBuffer(op);
+            op->heap.reset();
+
+            Finish(file);
+        }
+
+        // 読み込みが完了した処理
+        void OnCompleted(ReadOp* op, int64_t result)
+        {
+            if (OnRead(op, result)) Process(op);
+        }
+
+        // 読み込み先を確保する関数（false の場合は登録バッファの空き待ち）
+        // ※m_mutex をロックした状態で呼ぶ
+        bool AcquireBuffer(ReadOp* op)
+        {
+            if (op->dst) return true;
+
+            if (IsUsingRegisteredBuffers() && op->size <= m_settings.bufferSize && op->size > 0)
+            {
+                if (m_freeBuffers.empty()) return false;
+
+                op->buffer = m_freeBuffers.back();
+                m_freeBuffers.pop_back();
+                op->dst = m_bufferMemory.data() + m_settings.bufferSize * op->buffer;
+                return true;
+            }
+
+            op->heap.reset(new uint8_t[op->size]);
+            op->dst = op->heap.get();
+            return true;
+        }
+
+        void ReleaseBuffer(ReadOp* op)
+        {
+            if (op->buffer < 0) return;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_freeBuffers.push_back(op->buffer);
+                op->buffer = -1;
+            }
+
+            // 空きを待っている io_uring のスレッドを起こす
+            m_queueChanged.notify_all();
+        }
+
+        // 次の要求を発行できるか？（登録バッファの空き待ちでない）
+        // ※m_mutex をロックした状態で呼ぶ
+        bool CanIssueLocked() const
+        {
+            if (m_queue.empty()) return false;
+
+            const ReadOp* op = m_queue.top();
+            if (op->dst || !IsUsingRegisteredBuffers() || op->size > m_settings.bufferSize || op->size == 0) return true;
+            return !m_freeBuffers.empty();
+        }
+
+        // スレッドプールで読み込む
+        void RunWorker()
+        {
+            for (;;)
+            {
+                ReadOp* op = nullptr;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_queueChanged.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+                    if (m_queue.empty()) return;
+
+                    op = m_queue.top();
+                    m_queue.pop();
+                    AcquireBuffer(op);
+                }
+
+                int64_t result = op->file->file.ReadAt(op->dst + op->done, op->size - op->done, op->offset + op->done);
+                OnCompleted(op, result);
+            }
+        }
+
+#if defined(IMDL_HAS_IO_URING)
+        // 読み終わった要求をスレッドプールで処理する関数
+        // ※優先度の高いものから処理する（プールのキューの順ではなく、完了した要求のキューから取り出す）
+        void PostCompleted(ReadOp* op)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_completed.push(op);
+            }
+
+            m_pool->Submit([this]()
+                {
+                    ReadOp* next;
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        next = m_completed.top();
+                        m_completed.pop();
+                    }
+                    Process(next);
+                });
+        }
+
+        // io_uring で読み込む
+        // ※このスレッドでは要求の発行と完了の取り出しのみ行う（展開とコールバックはスレッドプール）
+        void RunIoUring()
+        {
+            unsigned inflight = 0;
+
+            for (;;)
+            {
+                // ----- 要求を発行 ----- //
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    if (inflight == 0)
+                    {
+                        // 登録バッファはスレッドプールで処理が終わると空く
+                        m_queueChanged.wait(lock, [this]() { return m_stop || CanIssueLocked(); });
+                        if (m_queue.empty()) return;
+                    }
+
+                    while (!m_queue.empty() && inflight < m_settings.queueDepth)
+                    {
+                        ReadOp* op = m_queue.top();
+
+                        // 登録バッファの空きがない場合は完了か処理の終了を待つ
+                        if (!AcquireBuffer(op)) break;
+                        m_queue.pop();
+
+                        size_t remaining = op->size - op->done;
+                        uint32_t size = static_cast<uint32_t>(remaining < (1u << 30) ? remaining : (1u << 30));
+                        m_ring.PrepareRead(op->file->file.GetFd(), op->dst + op->done, size, op->offset + op->done,
+                            op->buffer, reinterpret_cast<uint64_t>(op));
+                        inflight++;
+                    }
+                }
+
+                if (inflight == 0) continue;
+
+                // ----- 発行して１つ以上の完了を待つ ----- //
+                // ※EAGAIN / EBUSY の場合は完了を取り出してから再度発行する
+                m_ring.Submit(1);
+
+                // ----- 完了したものを処理 ----- //
+                m_ring.Reap([&](uint64_t userData, int result)
+                    {
+                        inflight--;
+
+                        ReadOp* op = reinterpret_cast<ReadOp*>(userData);
+                        if (OnRead(op, result)) PostCompleted(op);
+                    });
+            }
+        }
+#endif
+
+    private:
+
+        // 設定
+        AsyncLoaderSettings m_settings;
+
+        // io_uring で読み込んでいるか
+        bool m_useIoUring = false;
+
+#if defined(IMDL_HAS_IO_URING)
+        IoUring m_ring;
+#endif
+
+        // 読み終わった要求を処理するスレッドプール（io_uring）
+        std::unique_ptr<ThreadPool> m_pool;
+
+        // 登録バッファ
+        std::vector<uint8_t> m_bufferMemory;
+        std::vector<int> m_freeBuffers;
+
+        // 読み込み待ちの要求
+        std::priority_queue<ReadOp*, std::vector<ReadOp*>, ReadOpOrder> m_queue;
+        uint64_t m_sequence = 0;
+        uint64_t m_fileSequence = 0;
+
+        // 読み終わって処理を待っている要求（io_uring）
+        std::priority_queue<ReadOp*, std::vector<ReadOp*>, ReadOpOrder> m_completed;
+
+        // 読み込み中のファイル
+        std::unordered_set<std::shared_ptr<FileState>> m_files;
+
+        std::mutex m_mutex;
+        std::condition_variable m_queueChanged;
+        std::condition_variable m_filesChanged;
+        bool m_stop = false;
+
+        // 読み込みスレッド
+        std::vector<std::thread> m_threads;
+    };
+}
@@ -0,0 +1,162 @@
+﻿//--------------------------------------------------------------------------------------
+// File: Benchmark.h
+//
+// 処理時間計測用のユーティリティ
+//
+// ※CPU 時間は Windows は GetProcessTimes / GetThreadTimes、その他は clock_gettime を使う
+//
+// Date: 2026.3.2
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+namespace Imase
+{
+    // 経過時間計測用クラス
+    class Stopwatch
+    {
+    public:
+
+        Stopwatch()
+            : m_start(std::chrono::steady_clock::now())
+        {
+        }
+
+        // 計測開始位置をリセットする関数
+        void Reset()
+        {
+            m_start = std::chrono::steady_clock::now();
+        }
+
+        // 経過時間（秒）を取得する関数
+        double ElapsedSec() const
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+        // 経過時間（ミリ秒）を取得する関数
+        double ElapsedMs() const
+        {
+            return ElapsedSec() * 1000.0;
+        }
+
+    private:
+
+        // 計測開始時刻
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // プロセス全体（全スレッドの合計）の CPU 時間（秒）を取得する関数
+    inline double GetProcessCpuSec()
+    {
+#if defined(_WIN32)
+        FILETIME creation, exited, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exited, &kernel, &user)) return 0.0;
+        auto toSec = [](const FILETIME& t) { return (static_cast<uint64_t>(t.dwHighDateTime) << 32 | t.dwLowDateTime) * 1e-7; };
+        return toSec(kernel) + toSec(user);
+#else
+        timespec ts{};
+        if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0.0;
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+    }
+
+    // 呼び出したスレッドの CPU 時間（秒）を取得する関数
+    inline double GetThreadCpuSec()
+    {
+#if defined(_WIN32)
+        FILETIME creation, exited, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &creation, &exited, &kernel, &user)) return 0.0;
+        auto toSec = [](const FILETIME& t) { return (static_cast<uint64_t>(t.dwHighDateTime) << 32 | t.dwLowDateTime) * 1e-7; };
+        return toSec(kernel) + toSec(user);
+#else
+        timespec ts{};
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0.0;
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+    }
+
+    // 処理時間（経過時間と CPU 時間）
+    struct StageTime
+    {
+        double wallSec = 0.0;   // 経過時間（秒）
+        double cpuSec = 0.0;    // CPU 時間（秒）
+
+        StageTime& operator+=(const StageTime& other)
+        {
+            wallSec += other.wallSec;
+            cpuSec += other.cpuSec;
+            return *this;
+        }
+    };
+
+    // 経過時間と CPU 時間を計測するクラス
+    // ※CPU 時間はプロセス全体（処理の中で起動したスレッドも含む）、threadOnly の場合は計測したスレッドのみ
+    class StageTimer
+    {
+    public:
+
+        explicit StageTimer(bool threadOnly = false)
+            : m_threadOnly(threadOnly)
+            , m_cpuStart(GetCpuSec())
+        {
+        }
+
+        // 計測開始からの処理時間を取得する関数
+        StageTime Elapsed() const
+        {
+            return { m_stopwatch.ElapsedSec(), GetCpuSec() - m_cpuStart };
+        }
+
+        // 計測開始からの処理時間を取得して、計測開始位置をリセットする関数
+        StageTime Lap()
+        {
+            StageTime time = Elapsed();
+            m_stopwatch.Reset();
+            m_cpuStart = GetCpuSec();
+            return time;
+        }
+
+    private:
+
+        double GetCpuSec() const
+        {
+            return m_threadOnly ? GetThreadCpuSec() : GetProcessCpuSec();
+        }
+
+        bool m_threadOnly;
+        Stopwatch m_stopwatch;
+        double m_cpuStart;
+    };
+
+    // 指定回数実行して最も速かった時間（秒）を返す関数
+    template<typename F>
+    double MeasureBest(int repeat, F&& func)
+    {
+        double best = 0.0;
+        for (int i = 0; i < repeat; i++)
+        {
+            Stopwatch sw;
+            func();
+            double t = sw.ElapsedSec();
+            if (i == 0 || t < best) best = t;
+        }
+        return best;
+    }
+
+    // スループット（MB/s）を計算する関数
+    inline double ToMBps(uint64_t bytes, double sec)
+    {
+        if (sec <= 0.0) return 0.0;
+        return static_cast<double>(bytes) / (1024.0 * 1024.0) / sec;
+    }
+}
@@ -4,16 +4,28 @@
 // wTCỸf[^obt@ɏłāAobt@쐬֐
 //
 // ŎwTCỸf[^ނƏ݈ʒuړĂ܂
+// ރTCYĂꍇ Reserve ŎOɗeʂmۂ邱
+//
+// BinaryWriter : std::vector ɒǋLĂ
+// MemoryWriter : mۍς݂̃i}bvt@CȂǁjɒڏ
 //
 // Date: 2026.2.16
 // Author: Hideyasu Imase
 //--------------------------------------------------------------------------------------
 #pragma once
 #include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace Imase
 {
-    class BinaryWriter
+    // ݊֐̋ʕ
+    // Derived::WriteRaw(const void*, size_t) Ăяoď
+    template<typename Derived>
+    class BinaryWriterBase
     {
     public:
 
@@ -23,6 +35,12 @@ namespace Imase
             WriteRaw(&v, sizeof(v));
         }
 
+        // yuint64_tzފ֐
+        void WriteUInt64(uint64_t v)
+        {
+            WriteRaw(&v, sizeof(v));
+        }
+
         // yint32_tzފ֐
         void WriteInt32(int32_t v)
         {
@@ -41,16 +59,77 @@ namespace Imase
             WriteRaw(data, size);
         }
 
+        // yTzPފ֐iC[Ŵ܂܏ށj
+        template<typename T>
+        void WriteValue(const T& v)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "WriteValue requires a trivially copyable type.");
+            WriteRaw(&v, sizeof(T));
+        }
+
+        // yTz̔z܂Ƃ߂ďފ֐iC[Ŵ܂܏ށj
+        template<typename T>
+        void WriteArray(const T* data, size_t count)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "WriteArray requires a trivially copyable type.");
+            if (count > 0)
+            {
+                WriteRaw(data, sizeof(T) * count);
+            }
+        }
+
+        // [wTCYފ֐iACgp̌Ԃ𖄂߂j
+        void WritePadding(size_t size)
+        {
+            static const uint8_t zeros[256] = {};
+            while (size > 0)
+            {
+                size_t n = size < sizeof(zeros) ? size : sizeof(zeros);
+                WriteRaw(zeros, n);
+                size -= n;
+            }
+        }
+
         // yTzwފ֐
         // yuint32_tz(count) + yTz * count
         template<typename T>
         void WriteVector(const std::vector<T>& vec)
         {
             WriteUInt32(static_cast<uint32_t>(vec.size()));
-            if (!vec.empty())
-            {
-                WriteRaw(vec.data(), sizeof(T) * vec.size());
-            }
+            WriteArray(vec.data(), vec.size());
+        }
+
+    private:
+
+        void WriteRaw(const void* data, size_t size)
+        {
+            static_cast<Derived*>(this)->WriteRaw(data, size);
+        }
+    };
+
+    // std::vector ɏރNX
+    class BinaryWriter : public BinaryWriterBase<BinaryWriter>
+    {
+    public:
+
+        BinaryWriter() = default;
+
+        // ރTCYw肵ėeʂmۂRXgN^
+        explicit BinaryWriter(size_t capacity)
+        {
+            m_buffer.reserve(capacity);
+        }
+
+        // obt@̗eʂmۂ֐ivTCYŎwj
+        void Reserve(size_t capacity)
+        {
+            m_buffer.reserve(capacity);
+        }
+
+        // 񂾃TCY擾֐
+        size_t GetSize() const
+        {
+            return m_buffer.size();
         }
 
         // obt@擾֐
@@ -59,17 +138,70 @@ namespace Imase
             return m_buffer;
         }
 
+        // obt@o֐iRs[Ƀ[uj
+        std::vector<uint8_t> Release()
+        {
+            return std::move(m_buffer);
+        }
+
+        // obt@ɎwTCỸf[^ފ֐
+        // resize ̓[̂ insert ŒڃRs[
+        void WriteRaw(const void* data, size_t size)
+        {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            m_buffer.insert(m_buffer.end(), p, p + size);
+        }
+
     private:
 
         // ݗpobt@
         std::vector<uint8_t> m_buffer;
+    };
 
-        // obt@ɎwTCỸf[^ފ֐
+    // mۍς݂̃ɏރNX
+    class MemoryWriter : public BinaryWriterBase<MemoryWriter>
+    {
+    public:
+
+        MemoryWriter(void* data, size_t capacity)
+            : m_data(static_cast<uint8_t*>(data))
+            , m_capacity(capacity)
+            , m_size(0)
+        {
+        }
+
+        // 񂾃TCY擾֐
+        size_t GetSize() const
+        {
+            return m_size;
+        }
+
+        // ߂c̃TCY擾֐
+        size_t GetRemaining() const
+        {
+            return m_capacity - m_size;
+        }
+
+        // ɎwTCỸf[^ފ֐
         void WriteRaw(const void* data, size_t size)
         {
-            size_t oldSize = m_buffer.size();
-            m_buffer.resize(oldSize + size);
-            std::memcpy(m_buffer.data() + oldSize, data, size);
+            if (size > m_capacity - m_size)
+            {
+                throw std::runtime_error("MemoryWriter: write exceeds the reserved region");
+            }
+            std::memcpy(m_data + m_size, data, size);
+            m_size += size;
         }
+
+    private:
+
+        // ݐ
+        uint8_t* m_data;
+
+        // ݐ̃TCY
+        size_t m_capacity;
+
+        // 񂾃TCY
+        size_t m_size;
     };
 }
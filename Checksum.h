@@ -0,0 +1,248 @@
+﻿//--------------------------------------------------------------------------------------
+// File: Checksum.h
+//
+// チャンクデータのチェックサム（CRC32C）を計算する関数
+//
+// ※SSE4.2 が使える CPU では crc32 命令を使う（実行時に判定）
+// ※大きなデータはブロックに分割して並列に計算し、結果を結合する
+//
+// Date: 2026.3.9
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Parallel.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define IMDL_HAS_SSE42_CRC 1
+#include <nmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define IMDL_HAS_SSE42_CRC 0
+#endif
+
+namespace Imase
+{
+    // 並列に計算するときのブロックサイズ
+    constexpr size_t IMDL_CRC_BLOCK_SIZE = 4 << 20;
+
+    namespace Crc32cDetail
+    {
+        // Castagnoli 多項式（ビット反転）
+        constexpr uint32_t POLY = 0x82F63B78;
+
+        // ソフトウェア計算用のテーブル（slicing-by-8）
+        struct Table
+        {
+            uint32_t t[8][256];
+
+            Table()
+            {
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    uint32_t crc = i;
+                    for (int j = 0; j < 8; j++)
+                    {
+                        crc = (crc >> 1) ^ ((crc & 1) ? POLY : 0);
+                    }
+                    t[0][i] = crc;
+                }
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    for (int k = 1; k < 8; k++)
+                    {
+                        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+                    }
+                }
+            }
+        };
+
+        inline const Table& GetTable()
+        {
+            static const Table table;
+            return table;
+        }
+
+        // ソフトウェアで計算する関数（crc は反転済みの値）
+        inline uint32_t UpdateSoftware(uint32_t crc, const uint8_t* p, size_t size)
+        {
+            const Table& table = GetTable();
+
+            while (size >= 8)
+            {
+                uint32_t lo;
+                uint32_t hi;
+                std::memcpy(&lo, p, sizeof(lo));
+                std::memcpy(&hi, p + 4, sizeof(hi));
+                lo ^= crc;
+                crc = table.t[7][lo & 0xff] ^ table.t[6][(lo >> 8) & 0xff] ^ table.t[5][(lo >> 16) & 0xff] ^ table.t[4][lo >> 24]
+                    ^ table.t[3][hi & 0xff] ^ table.t[2][(hi >> 8) & 0xff] ^ table.t[1][(hi >> 16) & 0xff] ^ table.t[0][hi >> 24];
+                p += 8;
+                size -= 8;
+            }
+            while (size-- > 0)
+            {
+                crc = (crc >> 8) ^ table.t[0][(crc ^ *p++) & 0xff];
+            }
+            return crc;
+        }
+
+#if IMDL_HAS_SSE42_CRC
+        // crc32 命令で計算する関数（crc は反転済みの値）
+#if !defined(_MSC_VER)
+        __attribute__((target("sse4.2")))
+#endif
+        inline uint32_t UpdateHardware(uint32_t crc, const uint8_t* p, size_t size)
+        {
+            uint64_t crc64 = crc;
+            while (size >= 8)
+            {
+                uint64_t v;
+                std::memcpy(&v, p, sizeof(v));
+                crc64 = _mm_crc32_u64(crc64, v);
+                p += 8;
+                size -= 8;
+            }
+            crc = static_cast<uint32_t>(crc64);
+            while (size-- > 0)
+            {
+                crc = _mm_crc32_u8(crc, *p++);
+            }
+            return crc;
+        }
+
+        // SSE4.2 が使えるか？
+        inline bool DetectSse42()
+        {
+#if defined(_MSC_VER)
+            int regs[4];
+            __cpuid(regs, 1);
+            return (regs[2] & (1 << 20)) != 0;
+#else
+            return __builtin_cpu_supports("sse4.2");
+#endif
+        }
+#endif
+
+        // 32x32 の GF(2) 行列とベクトルの積
+        inline uint32_t MatrixTimes(const uint32_t* mat, uint32_t vec)
+        {
+            uint32_t sum = 0;
+            while (vec)
+            {
+                if (vec & 1) sum ^= *mat;
+                vec >>= 1;
+                mat++;
+            }
+            return sum;
+        }
+
+        // 32x32 の GF(2) 行列の２乗
+        inline void MatrixSquare(uint32_t* square, const uint32_t* mat)
+        {
+            for (int n = 0; n < 32; n++)
+            {
+                square[n] = MatrixTimes(mat, mat[n]);
+            }
+        }
+    }
+
+    // CRC32C の計算にハードウェア（SSE4.2）を使っているか？
+    inline bool IsCrc32cHardwareAccelerated()
+    {
+#if IMDL_HAS_SSE42_CRC
+        static const bool supported = Crc32cDetail::DetectSse42();
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    // CRC32C を計算する関数
+    // ※crc に前回の結果を渡すと続きから計算する
+    inline uint32_t Crc32c(const void* data, size_t size, uint32_t crc = 0)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+
+#if IMDL_HAS_SSE42_CRC
+        if (IsCrc32cHardwareAccelerated())
+        {
+            return ~Crc32cDetail::UpdateHardware(~crc, p, size);
+        }
+#endif
+        return ~Crc32cDetail::UpdateSoftware(~crc, p, size);
+    }
+
+    // 連続する２つのデータの CRC32C を結合する関数
+    // crc1 : 前半の CRC、crc2 : 後半の CRC、size2 : 後半のサイズ
+    // ※zlib の crc32_combine と同じ方法（size2 分のゼロを前半に追加する演算を行列の累乗で求める）
+    inline uint32_t Crc32cCombine(uint32_t crc1, uint32_t crc2, uint64_t size2)
+    {
+        if (size2 == 0) return crc1;
+
+        uint32_t even[32];
+        uint32_t odd[32];
+
+        // １bit のゼロを追加する演算
+        odd[0] = Crc32cDetail::POLY;
+        uint32_t row = 1;
+        for (int n = 1; n < 32; n++)
+        {
+            odd[n] = row;
+            row <<= 1;
+        }
+
+        // ２bit、４bit のゼロを追加する演算
+        Crc32cDetail::MatrixSquare(even, odd);
+        Crc32cDetail::MatrixSquare(odd, even);
+
+        // size2 バイトのゼロを追加する
+        do
+        {
+            Crc32cDetail::MatrixSquare(even, odd);
+            if (size2 & 1) crc1 = Crc32cDetail::MatrixTimes(even, crc1);
+            size2 >>= 1;
+            if (size2 == 0) break;
+
+            Crc32cDetail::MatrixSquare(odd, even);
+            if (size2 & 1) crc1 = Crc32cDetail::MatrixTimes(odd, crc1);
+            size2 >>= 1;
+        } while (size2 != 0);
+
+        return crc1 ^ crc2;
+    }
+
+    // CRC32C を並列に計算する関数
+    // ※ブロックごとに計算して結合するので、結果は Crc32c と同じ
+    inline uint32_t Crc32cParallel(const void* data, size_t size, unsigned threads = 0)
+    {
+        if (size <= IMDL_CRC_BLOCK_SIZE || GetWorkerCount(threads) == 1)
+        {
+            return Crc32c(data, size);
+        }
+
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        size_t blockCount = (size + IMDL_CRC_BLOCK_SIZE - 1) / IMDL_CRC_BLOCK_SIZE;
+
+        std::vector<uint32_t> crcs(blockCount);
+        ParallelFor(blockCount, [&](size_t i)
+            {
+                size_t offset = i * IMDL_CRC_BLOCK_SIZE;
+                size_t length = (i + 1 == blockCount) ? size - offset : IMDL_CRC_BLOCK_SIZE;
+                crcs[i] = Crc32c(p + offset, length);
+            }, threads);
+
+        uint32_t crc = crcs[0];
+        for (size_t i = 1; i < blockCount; i++)
+        {
+            size_t length = (i + 1 == blockCount) ? size - i * IMDL_CRC_BLOCK_SIZE : IMDL_CRC_BLOCK_SIZE;
+            crc = Crc32cCombine(crc, crcs[i], length);
+        }
+        return crc;
+    }
+}
@@ -0,0 +1,219 @@
+﻿//--------------------------------------------------------------------------------------
+// File: ChunkCache.h
+//
+// 読み込んだチャンクを保持するキャッシュ
+//
+// ※合計サイズの上限を超えたら最後に使われてから最も時間が経ったものから捨てる（LRU）
+// ※複数のファイル、複数のスレッドから共有できる
+// ※捨てたチャンクも、取得した側が参照を持っている間は解放されない
+//
+// Date: 2026.3.10
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Imase
+{
+    // キャッシュしたチャンクのデータ（展開後）
+    using ChunkData = std::shared_ptr<const std::vector<uint8_t>>;
+
+    // キャッシュの既定の上限（256MB）
+    constexpr uint64_t IMDL_DEFAULT_CHUNK_CACHE_SIZE = 256ull << 20;
+
+    // キャッシュの統計
+    struct ChunkCacheStats
+    {
+        uint64_t hits = 0;          // 見つかった回数
+        uint64_t misses = 0;        // 見つからなかった回数
+        uint64_t evictions = 0;     // 捨てた数
+        uint64_t size = 0;          // 保持しているサイズ
+        size_t count = 0;           // 保持しているチャンクの数
+    };
+
+    class ChunkCache
+    {
+    public:
+
+        // キャッシュのキー
+        // ※file はファイルを識別する文字列（パス、サイズ、更新日時）
+        struct Key
+        {
+            std::string file;
+            uint32_t chunkIndex;
+
+            bool operator==(const Key& other) const
+            {
+                return chunkIndex == other.chunkIndex && file == other.file;
+            }
+        };
+
+        explicit ChunkCache(uint64_t capacity = IMDL_DEFAULT_CHUNK_CACHE_SIZE)
+            : m_capacity(capacity)
+        {
+        }
+
+        ChunkCache(const ChunkCache&) = delete;
+        ChunkCache& operator=(const ChunkCache&) = delete;
+
+        // チャンクを探す関数（見つからない場合は nullptr）
+        ChunkData Find(const Key& key)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_map.find(key);
+            if (it == m_map.end())
+            {
+                m_stats.misses++;
+                return nullptr;
+            }
+
+            // 最近使ったものとして先頭へ移動
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            m_stats.hits++;
+
+            return it->second->data;
+        }
+
+        // チャンクを追加する関数
+        // ※上限より大きいチャンクは保持しない
+        // ※同じキーが既にある場合（他のスレッドが先に読み込んだ場合）はそちらを返す
+        ChunkData Insert(const Key& key, ChunkData data)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_map.find(key);
+            if (it != m_map.end())
+            {
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+                return it->second->data;
+            }
+
+            uint64_t size = data->size();
+            if (size > m_capacity) return data;
+
+            m_entries.push_front({ key, data });
+            m_map[key] = m_entries.begin();
+            m_stats.size += size;
+
+            Trim();
+
+            return data;
+        }
+
+        // 指定したファイルのチャンクをすべて捨てる関数
+        void EraseFile(const std::string& file)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            for (auto it = m_entries.begin(); it != m_entries.end();)
+            {
+                if (it->key.file == file)
+                {
+                    m_stats.size -= it->data->size();
+                    m_map.erase(it->key);
+                    it = m_entries.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+
+        // すべて捨てる関数
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_entries.clear();
+            m_map.clear();
+            m_stats.size = 0;
+        }
+
+        // 上限を設定する関数
+        void SetCapacity(uint64_t capacity)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_capacity = capacity;
+            Trim();
+        }
+
+        uint64_t GetCapacity() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_capacity;
+        }
+
+        // 統計を取得する関数
+        ChunkCacheStats GetStats() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            ChunkCacheStats stats = m_stats;
+            stats.count = m_entries.size();
+            return stats;
+        }
+
+        // 共有のキャッシュ（既定の上限）
+        static const std::shared_ptr<ChunkCache>& GetShared()
+        {
+            static std::shared_ptr<ChunkCache> cache = std::make_shared<ChunkCache>();
+            return cache;
+        }
+
+    private:
+
+        struct Entry
+        {
+            Key key;
+            ChunkData data;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const
+            {
+                return std::hash<std::string>()(key.file) ^ (std::hash<uint32_t>()(key.chunkIndex) * 0x9e3779b97f4a7c15ull);
+            }
+        };
+
+        // 上限に収まるまで古いものから捨てる関数
+        // ※m_mutex をロックした状態で呼ぶ
+        void Trim()
+        {
+            while (m_stats.size > m_capacity && !m_entries.empty())
+            {
+                const Entry& entry = m_entries.back();
+                m_stats.size -= entry.data->size();
+                m_map.erase(entry.key);
+                m_entries.pop_back();
+                m_stats.evictions++;
+            }
+        }
+
+    private:
+
+        // 上限
+        uint64_t m_capacity;
+
+        // 最近使った順のチャンク
+        std::list<Entry> m_entries;
+
+        // キーからチャンクを探すための表
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_map;
+
+        // 統計
+        ChunkCacheStats m_stats;
+
+        mutable std::mutex m_mutex;
+    };
+}
@@ -10,7 +10,11 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstring>
+#include <string>
 #include <vector>
+#include "Checksum.h"
+#include "Imdl.h"
 
 namespace Imase
 {
@@ -21,6 +25,30 @@ namespace Imase
         uint32_t size;  // f[^TCY
     };
 
+    // `N^Cv̖Oi'VERT'  "VERT"j擾֐
+    inline std::string GetChunkTypeName(uint32_t type)
+    {
+        std::string name(4, ' ');
+        for (int i = 0; i < 4; i++)
+        {
+            name[i] = static_cast<char>((type >> (24 - i * 8)) & 0xff);
+        }
+        return name;
+    }
+
+    // O`N^Cv擾֐i"VERT"  'VERT'j
+    inline bool ParseChunkType(const std::string& name, uint32_t& type)
+    {
+        if (name.size() != 4) return false;
+
+        type = 0;
+        for (char c : name)
+        {
+            type = (type << 8) | static_cast<uint8_t>(c);
+        }
+        return true;
+    }
+
     // `Nf[^o֐
     inline void WriteChunk(std::ofstream& ofs, uint32_t type, const std::vector<uint8_t>& data)
     {
@@ -49,4 +77,228 @@ namespace Imase
 
         return true;
     }
+
+    // wb_ƃ`Ne[ũTCY擾֐io[WQj
+    inline uint64_t GetChunkTableEnd(const FileHeaderV2& header)
+    {
+        size_t entrySize = (header.flags & IMDL_FILE_FLAG_LARGE) ? sizeof(ChunkEntry64) : sizeof(ChunkEntry);
+        return sizeof(FileHeaderV2) + static_cast<uint64_t>(entrySize) * header.chunkCount;
+    }
+
+    // `Ne[ut@C͈̔͂Ɏ܂Ă邩mF֐io[WQj
+    // ꂽt@CǂݍŔ͈͊OɃANZXȂ悤ɁAf[^gOɊmF
+    inline bool ValidateChunkTable(const FileHeaderV2& header, const std::vector<ChunkEntry64>& entries, uint64_t fileSize)
+    {
+        uint64_t tableEnd = GetChunkTableEnd(header);
+        if (tableEnd > fileSize) return false;
+
+        for (const auto& entry : entries)
+        {
+            if (entry.offset < tableEnd || entry.offset > fileSize) return false;
+            if (entry.size > fileSize - entry.offset) return false;
+        }
+        return true;
+    }
+
+    // `Ne[uǂݍފ֐io[WQj
+    // t@C擪ǂݍ
+    // 4GB p̃t@CǂɊ֌WȂ ChunkEntry64 ɑĕԂ
+    // e`Nt@C͈̔͂Ɏ܂ĂȂꍇ false Ԃ
+    inline bool ReadChunkTable(std::ifstream& ifs, FileHeaderV2& header, std::vector<ChunkEntry64>& entries)
+    {
+        entries.clear();
+
+        ifs.clear();
+        ifs.seekg(0, std::ios::end);
+        uint64_t fileSize = static_cast<uint64_t>(ifs.tellg());
+        ifs.seekg(0, std::ios::beg);
+
+        if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        {
+            return false;
+        }
+
+        if (header.magic != IMDL_MAGIC || header.version != IMDL_VERSION_2)
+        {
+            return false;
+        }
+
+        // `NĂƋȃe[umۂĂ܂̂ŐɊmF
+        if (GetChunkTableEnd(header) > fileSize)
+        {
+            return false;
+        }
+
+        entries.resize(header.chunkCount);
+
+        // 4GB p͂̂܂ܓǂݍ
+        if (header.flags & IMDL_FILE_FLAG_LARGE)
+        {
+            if (!ifs.read(reinterpret_cast<char*>(entries.data()), sizeof(ChunkEntry64) * entries.size()))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            std::vector<ChunkEntry> table(header.chunkCount);
+
+            if (!ifs.read(reinterpret_cast<char*>(table.data()), sizeof(ChunkEntry) * table.size()))
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < table.size(); i++)
+            {
+                entries[i] = { table[i].type, table[i].flags, table[i].offset, table[i].size };
+            }
+        }
+
+        return ValidateChunkTable(header, entries, fileSize);
+    }
+
+    // ̃t@C̐擪`Ne[u擾֐io[WQj
+    // ReadChunkTable Ɠ ChunkEntry64 ɑĕԂA͈͂mF
+    // size  data ̃TCYiwb_ƃ`Ne[u܂ނƁjAfileSize ̓t@CŜ̃TCY
+    inline bool ParseChunkTable(const uint8_t* data, uint64_t size, uint64_t fileSize, FileHeaderV2& header, std::vector<ChunkEntry64>& entries)
+    {
+        entries.clear();
+
+        if (size < sizeof(header)) return false;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.magic != IMDL_MAGIC || header.version != IMDL_VERSION_2)
+        {
+            return false;
+        }
+
+        if (GetChunkTableEnd(header) > size)
+        {
+            return false;
+        }
+
+        entries.resize(header.chunkCount);
+
+        const uint8_t* table = data + sizeof(header);
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (header.flags & IMDL_FILE_FLAG_LARGE)
+            {
+                std::memcpy(&entries[i], table + sizeof(ChunkEntry64) * i, sizeof(ChunkEntry64));
+            }
+            else
+            {
+                ChunkEntry entry;
+                std::memcpy(&entry, table + sizeof(ChunkEntry) * i, sizeof(ChunkEntry));
+                entries[i] = { entry.type, entry.flags, entry.offset, entry.size };
+            }
+        }
+
+        return ValidateChunkTable(header, entries, fileSize);
+    }
+
+    // ̃t@CC[W`Ne[u擾֐io[WQj
+    inline bool ParseChunkTable(const uint8_t* data, uint64_t size, FileHeaderV2& header, std::vector<ChunkEntry64>& entries)
+    {
+        return ParseChunkTable(data, size, size, header, entries);
+    }
+
+    // `Ne[u`NT֐iȂꍇ nullptrj
+    inline const ChunkEntry64* FindChunk(const std::vector<ChunkEntry64>& entries, uint32_t type)
+    {
+        for (const auto& entry : entries)
+        {
+            if (entry.type == type) return &entry;
+        }
+        return nullptr;
+    }
+
+    // w`Ñf[^ǂݍފ֐io[WQj
+    inline bool ReadChunkData(std::ifstream& ifs, const ChunkEntry64& entry, std::vector<uint8_t>& buffer)
+    {
+        // 32bit ł̓ɍڂȂ
+        if (entry.size > SIZE_MAX)
+        {
+            return false;
+        }
+
+        ifs.clear();
+        ifs.seekg(static_cast<std::streamoff>(entry.offset), std::ios::beg);
+
+        buffer.resize(static_cast<size_t>(entry.size));
+
+        if (!ifs.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(entry.size)))
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    // `Ñ`FbNT
+    struct ChunkChecksums
+    {
+        uint32_t tableCrc = 0;              // wb_ƃ`Ne[u CRC32C
+        std::vector<uint32_t> chunkCrcs;    // e`N CRC32Ci`Ne[ȕj
+    };
+
+    // `FbNT`Ñf[^擾֐
+    inline bool ParseChecksumChunk(const uint8_t* data, size_t size, size_t chunkCount, ChunkChecksums& checksums)
+    {
+        if (size < sizeof(ChecksumChunkHeader)) return false;
+
+        ChecksumChunkHeader header;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.chunkCount != chunkCount) return false;
+        if (size != sizeof(header) + sizeof(uint32_t) * chunkCount) return false;
+
+        checksums.tableCrc = header.tableCrc;
+        checksums.chunkCrcs.resize(chunkCount);
+        std::memcpy(checksums.chunkCrcs.data(), data + sizeof(header), sizeof(uint32_t) * chunkCount);
+
+        return true;
+    }
+
+    // `FbNTǂݍŃwb_ƃ`Ne[umF֐io[WQj
+    // `FbNTL^ĂȂꍇAvȂꍇ false Ԃ
+    inline bool ReadChunkChecksums(std::ifstream& ifs, const FileHeaderV2& header, const std::vector<ChunkEntry64>& entries, ChunkChecksums& checksums)
+    {
+        if ((header.flags & IMDL_FILE_FLAG_CHECKSUM) == 0) return false;
+
+        const ChunkEntry64* entry = FindChunk(entries, CHUNK_CHECKSUM);
+        if (entry == nullptr) return false;
+
+        std::vector<uint8_t> buffer;
+        if (!ReadChunkData(ifs, *entry, buffer)) return false;
+        if (!ParseChecksumChunk(buffer.data(), buffer.size(), entries.size(), checksums)) return false;
+
+        // wb_ƃ`Ne[u
+        buffer.resize(static_cast<size_t>(GetChunkTableEnd(header)));
+        ifs.clear();
+        ifs.seekg(0, std::ios::beg);
+        if (!ifs.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size())))
+        {
+            return false;
+        }
+
+        return Crc32c(buffer.data(), buffer.size()) == checksums.tableCrc;
+    }
+
+    // w`Ñf[^ǂݍފ֐io[WQj
+    // checksums w肵ꍇ̓`FbNTmFAvȂꍇ false Ԃ
+    inline bool ReadChunkData(std::ifstream& ifs, const std::vector<ChunkEntry64>& entries, size_t index, std::vector<uint8_t>& buffer, const ChunkChecksums* checksums)
+    {
+        if (index >= entries.size()) return false;
+
+        if (!ReadChunkData(ifs, entries[index], buffer)) return false;
+
+        if (checksums)
+        {
+            if (index >= checksums->chunkCrcs.size()) return false;
+            return Crc32cParallel(buffer.data(), buffer.size()) == checksums->chunkCrcs[index];
+        }
+
+        return true;
+    }
 }
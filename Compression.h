@@ -0,0 +1,574 @@
+﻿//--------------------------------------------------------------------------------------
+// File: Compression.h
+//
+// チャンクデータの圧縮と展開
+//
+// ※チャンクデータは blockSize ごとのブロックに分けて圧縮するので、
+//   ブロック単位で独立して（複数のチャンクをまとめて）全コアで展開できる
+// ※LZ4 は LZ4 のブロックフォーマット互換の実装を内蔵している
+// ※zstd は zstd.h が見つかる場合のみ使用できる
+//
+// Date: 2026.3.9
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Imdl.h"
+#include "Parallel.h"
+
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#define IMDL_HAS_ZSTD 1
+#if defined(_MSC_VER)
+#pragma comment(lib, "zstd.lib")
+#endif
+#else
+#define IMDL_HAS_ZSTD 0
+#endif
+
+namespace Imase
+{
+    // ブロックサイズの既定値
+    constexpr uint32_t IMDL_DEFAULT_BLOCK_SIZE = 1 << 20;
+
+    // 圧縮の設定
+    struct CompressionSettings
+    {
+        CompressionType type = COMPRESSION_NONE;        // 圧縮形式
+        int level = 1;                                  // 圧縮レベル（LZ4 : 1～12、zstd : 1～22）
+        uint32_t blockSize = IMDL_DEFAULT_BLOCK_SIZE;   // ブロックサイズ（展開後）
+    };
+
+    // -------------------------------------------------------------------------------------- //
+    // LZ4（ブロックフォーマット）
+    namespace Lz4
+    {
+        constexpr size_t MIN_MATCH = 4;         // 最小一致長
+        constexpr size_t LAST_LITERALS = 5;     // 末尾はリテラルにする
+        constexpr size_t MF_LIMIT = 12;         // 末尾からこの範囲では一致を開始しない
+        constexpr size_t MAX_DISTANCE = 65535;  // 最大オフセット
+        constexpr int HASH_BITS = 16;
+
+        // 圧縮後の最大サイズを取得する関数
+        inline size_t CompressBound(size_t size)
+        {
+            return size + size / 255 + 16;
+        }
+
+        inline uint32_t Read32(const uint8_t* p)
+        {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline uint32_t Hash(uint32_t v)
+        {
+            return (v * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        // 長さの追加バイトを書き込む関数
+        inline uint8_t* WriteLength(uint8_t* op, size_t length)
+        {
+            while (length >= 255)
+            {
+                *op++ = 255;
+                length -= 255;
+            }
+            *op++ = static_cast<uint8_t>(length);
+            return op;
+        }
+
+        // シーケンス（リテラル + 一致）を書き込む関数
+        // ※matchLength == 0 の場合はリテラルのみ（最後のシーケンス）
+        inline uint8_t* WriteSequence(uint8_t* op, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+        {
+            uint8_t* token = op++;
+
+            size_t litToken = literalLength < 15 ? literalLength : 15;
+            if (literalLength >= 15) op = WriteLength(op, literalLength - 15);
+
+            // ※空のデータは nullptr の場合があるので、長さ 0 はコピーしない
+            if (literalLength > 0) std::memcpy(op, literals, literalLength);
+            op += literalLength;
+
+            if (matchLength == 0)
+            {
+                *token = static_cast<uint8_t>(litToken << 4);
+                return op;
+            }
+
+            *op++ = static_cast<uint8_t>(offset & 0xff);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+
+            size_t ml = matchLength - MIN_MATCH;
+            size_t matchToken = ml < 15 ? ml : 15;
+            if (ml >= 15) op = WriteLength(op, ml - 15);
+
+            *token = static_cast<uint8_t>((litToken << 4) | matchToken);
+            return op;
+        }
+
+        // 圧縮する関数（戻り値は圧縮後のサイズ、0 は失敗）
+        // ※level が大きいほど一致候補を多く探す（1 は直前の候補のみ）
+        // ※dst には CompressBound(srcSize) 以上の容量が必要
+        inline size_t Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity, int level)
+        {
+            if (dstCapacity < CompressBound(srcSize)) return 0;
+
+            uint8_t* op = dst;
+
+            // 一致を探せないほど小さい
+            if (srcSize < MF_LIMIT + 1)
+            {
+                op = WriteSequence(op, src, srcSize, 0, 0);
+                return static_cast<size_t>(op - dst);
+            }
+
+            // 候補を探す回数
+            int depth = level <= 1 ? 1 : (1 << (level < 12 ? level - 1 : 11));
+
+            std::vector<uint32_t> head(size_t(1) << HASH_BITS, UINT32_MAX);
+            std::vector<uint32_t> chain(depth > 1 ? MAX_DISTANCE + 1 : 0, UINT32_MAX);
+
+            auto insert = [&](size_t pos)
+                {
+                    uint32_t h = Hash(Read32(src + pos));
+                    if (depth > 1) chain[pos & MAX_DISTANCE] = head[h];
+                    head[h] = static_cast<uint32_t>(pos);
+                };
+
+            const size_t matchLimit = srcSize - LAST_LITERALS;
+            const size_t mfLimit = srcSize - MF_LIMIT;
+
+            size_t ip = 0;
+            size_t anchor = 0;
+
+            while (ip < mfLimit)
+            {
+                uint32_t h = Hash(Read32(src + ip));
+                uint32_t candidate = head[h];
+
+                size_t bestLength = 0;
+                size_t bestPos = 0;
+
+                for (int i = 0; i < depth && candidate != UINT32_MAX && ip - candidate <= MAX_DISTANCE; i++)
+                {
+                    if (Read32(src + candidate) == Read32(src + ip))
+                    {
+                        size_t length = MIN_MATCH;
+                        while (ip + length < matchLimit && src[candidate + length] == src[ip + length]) length++;
+
+                        if (length > bestLength)
+                        {
+                            bestLength = length;
+                            bestPos = candidate;
+                        }
+                    }
+
+                    if (depth == 1) break;
+
+                    uint32_t prev = chain[candidate & MAX_DISTANCE];
+                    if (prev == UINT32_MAX || prev >= candidate) break;
+                    candidate = prev;
+                }
+
+                insert(ip);
+
+                if (bestLength == 0)
+                {
+                    // 一致しない区間が続く場合は飛ばして調べる
+                    ip += 1 + ((ip - anchor) >> 6);
+                    continue;
+                }
+
+                // 一致の開始位置を前方に伸ばす
+                while (ip > anchor && bestPos > 0 && src[ip - 1] == src[bestPos - 1])
+                {
+                    ip--;
+                    bestPos--;
+                    bestLength++;
+                }
+
+                op = WriteSequence(op, src + anchor, ip - anchor, ip - bestPos, bestLength);
+
+                // 一致した範囲もハッシュに登録する
+                size_t end = ip + bestLength;
+                for (size_t p = ip + 1; p < end && p < mfLimit; p += (depth > 1 ? 1 : 2))
+                {
+                    insert(p);
+                }
+
+                ip = end;
+                anchor = ip;
+            }
+
+            // 残りはリテラル
+            op = WriteSequence(op, src + anchor, srcSize - anchor, 0, 0);
+
+            return static_cast<size_t>(op - dst);
+        }
+
+        // 展開する関数（展開後のサイズが dstSize と一致しない場合は失敗）
+        inline bool Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+        {
+            const uint8_t* ip = src;
+            const uint8_t* const iend = src + srcSize;
+            uint8_t* op = dst;
+            uint8_t* const oend = dst + dstSize;
+
+            auto readLength = [&](size_t& length) -> bool
+                {
+                    uint8_t b;
+                    do
+                    {
+                        if (ip >= iend) return false;
+                        b = *ip++;
+                        length += b;
+                    } while (b == 255);
+                    return true;
+                };
+
+            while (ip < iend)
+            {
+                uint8_t token = *ip++;
+
+                // リテラル
+                size_t literalLength = token >> 4;
+                if (literalLength == 15 && !readLength(literalLength)) return false;
+
+                if (literalLength > static_cast<size_t>(iend - ip) || literalLength > static_cast<size_t>(oend - op)) return false;
+                if (literalLength > 0) std::memcpy(op, ip, literalLength);
+                ip += literalLength;
+                op += literalLength;
+
+                // 最後のシーケンス
+                if (ip == iend) break;
+
+                // 一致
+                if (iend - ip < 2) return false;
+                size_t offset = ip[0] | (ip[1] << 8);
+                ip += 2;
+
+                size_t matchLength = token & 0x0f;
+                if (matchLength == 15 && !readLength(matchLength)) return false;
+                matchLength += MIN_MATCH;
+
+                if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+                if (matchLength > static_cast<size_t>(oend - op)) return false;
+
+                const uint8_t* match = op - offset;
+                if (offset >= matchLength)
+                {
+                    std::memcpy(op, match, matchLength);
+                    op += matchLength;
+                }
+                else
+                {
+                    // 重なっている場合は１バイトずつコピーする
+                    for (size_t i = 0; i < matchLength; i++) *op++ = *match++;
+                }
+            }
+
+            return op == oend;
+        }
+    }
+
+    // -------------------------------------------------------------------------------------- //
+
+    // 圧縮形式の名前を取得する関数
+    inline const char* GetCompressionName(CompressionType type)
+    {
+        switch (type)
+        {
+        case COMPRESSION_NONE: return "none";
+        case COMPRESSION_LZ4: return "lz4";
+        case COMPRESSION_ZSTD: return "zstd";
+        default: return "unknown";
+        }
+    }
+
+    // 名前から圧縮形式を取得する関数
+    inline bool ParseCompressionType(const std::string& name, CompressionType& type)
+    {
+        if (name == "none") type = COMPRESSION_NONE;
+        else if (name == "lz4") type = COMPRESSION_LZ4;
+        else if (name == "zstd") type = COMPRESSION_ZSTD;
+        else return false;
+        return true;
+    }
+
+    // この環境で使える圧縮形式か？
+    inline bool IsCompressionSupported(CompressionType type)
+    {
+        switch (type)
+        {
+        case COMPRESSION_NONE:
+        case COMPRESSION_LZ4:
+            return true;
+        case COMPRESSION_ZSTD:
+            return IMDL_HAS_ZSTD != 0;
+        default:
+            return false;
+        }
+    }
+
+    // ブロックを圧縮する関数（戻り値は圧縮後のサイズ、0 は失敗）
+    inline size_t CompressBlock(CompressionType type, int level, const uint8_t* src, size_t srcSize, std::vector<uint8_t>& dst)
+    {
+        switch (type)
+        {
+        case COMPRESSION_LZ4:
+            dst.resize(Lz4::CompressBound(srcSize));
+            return Lz4::Compress(src, srcSize, dst.data(), dst.size(), level);
+#if IMDL_HAS_ZSTD
+        case COMPRESSION_ZSTD:
+        {
+            dst.resize(ZSTD_compressBound(srcSize));
+            size_t result = ZSTD_compress(dst.data(), dst.size(), src, srcSize, level);
+            return ZSTD_isError(result) ? 0 : result;
+        }
+#endif
+        default:
+            return 0;
+        }
+    }
+
+    // ブロックを展開する関数
+    inline bool DecompressBlock(CompressionType type, const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+    {
+        switch (type)
+        {
+        case COMPRESSION_LZ4:
+            return Lz4::Decompress(src, srcSize, dst, dstSize);
+#if IMDL_HAS_ZSTD
+        case COMPRESSION_ZSTD:
+            return ZSTD_decompress(dst, dstSize, src, srcSize) == dstSize;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    // チャンクデータを圧縮する関数
+    // CompressedChunkHeader + uint32_t blockSizes[blockCount] + 圧縮データ
+    // ※ブロックは並列に圧縮する
+    inline std::vector<uint8_t> CompressChunkData(const uint8_t* data, size_t size, const CompressionSettings& settings, unsigned threads = 0)
+    {
+        uint32_t blockSize = settings.blockSize;
+        size_t blockCount = (size + blockSize - 1) / blockSize;
+
+        std::vector<std::vector<uint8_t>> blocks(blockCount);
+        std::vector<uint32_t> blockSizes(blockCount);
+
+        ParallelFor(blockCount, [&](size_t i)
+            {
+                size_t offset = i * blockSize;
+                size_t length = std::min<size_t>(blockSize, size - offset);
+
+                size_t compressed = CompressBlock(settings.type, settings.level, data + offset, length, blocks[i]);
+                if (compressed == 0)
+                {
+                    throw std::runtime_error(std::string("Compression failed: ") + GetCompressionName(settings.type));
+                }
+                blockSizes[i] = static_cast<uint32_t>(compressed);
+            }, threads);
+
+        CompressedChunkHeader header{};
+        header.rawSize = size;
+        header.blockSize = blockSize;
+        header.blockCount = static_cast<uint32_t>(blockCount);
+
+        size_t total = sizeof(header) + sizeof(uint32_t) * blockCount;
+        for (uint32_t s : blockSizes) total += s;
+
+        std::vector<uint8_t> result(total);
+        uint8_t* p = result.data();
+
+        std::memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+
+        if (blockCount > 0) std::memcpy(p, blockSizes.data(), sizeof(uint32_t) * blockCount);
+        p += sizeof(uint32_t) * blockCount;
+
+        for (size_t i = 0; i < blockCount; i++)
+        {
+            std::memcpy(p, blocks[i].data(), blockSizes[i]);
+            p += blockSizes[i];
+        }
+
+        return result;
+    }
+
+    // ブロックを展開したときの最大のサイズを取得する関数（不正なデータの場合は 0）
+    // ※LZ4 は一致長の追加のバイトごとに最大 255byte 増えるので、圧縮データの 255 倍を超えない
+    // ※zstd はフレームに記録されている展開後のサイズ
+    inline uint64_t GetMaxDecompressedBlockSize(CompressionType type, const uint8_t* src, size_t srcSize)
+    {
+        switch (type)
+        {
+        case COMPRESSION_LZ4:
+            return static_cast<uint64_t>(srcSize) * 255;
+#if IMDL_HAS_ZSTD
+        case COMPRESSION_ZSTD:
+        {
+            unsigned long long size = ZSTD_getFrameContentSize(src, srcSize);
+            return size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR ? 0 : size;
+        }
+#endif
+        default:
+            return 0;
+        }
+    }
+
+    // 圧縮されたブロック
+    struct CompressedBlock
+    {
+        const uint8_t* src;     // 圧縮データ
+        size_t srcSize;         // 圧縮データのサイズ
+        uint64_t offset;        // 展開後の位置
+        size_t size;            // 展開後のサイズ
+    };
+
+    // 圧縮されたチャンクのヘッダとブロックテーブルを検証する関数（不正なデータの場合は false）
+    // ※展開後のサイズは、ブロック数 * ブロックサイズと、各ブロックの圧縮データから展開できる最大のサイズを超えないこと
+    //   （展開先を確保する前に呼んで、壊れたファイルで巨大なメモリを確保しないようにする）
+    // blocks : 各ブロックの位置（nullptr 可）
+    inline bool ValidateCompressedChunk(uint32_t flags, const uint8_t* src, size_t srcSize,
+        CompressedChunkHeader& header, std::vector<CompressedBlock>* blocks = nullptr)
+    {
+        CompressionType type = static_cast<CompressionType>(flags & IMDL_CHUNK_FLAG_COMPRESSION_MASK);
+        if (type == COMPRESSION_NONE || !IsCompressionSupported(type)) return false;
+
+        if (srcSize < sizeof(CompressedChunkHeader)) return false;
+        std::memcpy(&header, src, sizeof(header));
+
+        if (header.blockSize == 0) return false;
+        if (header.blockCount != (header.rawSize + header.blockSize - 1) / header.blockSize) return false;
+        if (header.rawSize > static_cast<uint64_t>(header.blockCount) * header.blockSize) return false;
+
+        size_t tableSize = sizeof(uint32_t) * static_cast<size_t>(header.blockCount);
+        if (srcSize - sizeof(header) < tableSize) return false;
+
+        const uint8_t* table = src + sizeof(header);
+        const uint8_t* data = table + tableSize;
+        size_t remaining = srcSize - sizeof(header) - tableSize;
+
+        for (uint32_t i = 0; i < header.blockCount; i++)
+        {
+            uint32_t compressed;
+            std::memcpy(&compressed, table + sizeof(uint32_t) * i, sizeof(compressed));
+            if (compressed > remaining) return false;
+
+            uint64_t offset = static_cast<uint64_t>(i) * header.blockSize;
+            uint64_t length = std::min<uint64_t>(header.blockSize, header.rawSize - offset);
+            if (length > GetMaxDecompressedBlockSize(type, data, compressed)) return false;
+
+            if (blocks) blocks->push_back({ data, compressed, offset, static_cast<size_t>(length) });
+
+            data += compressed;
+            remaining -= compressed;
+        }
+
+        return true;
+    }
+
+    // 圧縮されたチャンクの展開後のサイズを取得する関数（不正なデータの場合は false）
+    // ※ヘッダとブロックテーブルを検証してから返すので、そのまま展開先の確保に使える
+    inline bool GetDecompressedSize(uint32_t flags, const uint8_t* src, size_t srcSize, uint64_t& rawSize)
+    {
+        CompressedChunkHeader header;
+        if (!ValidateCompressedChunk(flags, src, srcSize, header)) return false;
+
+        rawSize = header.rawSize;
+        return true;
+    }
+
+    // 展開するチャンクの情報
+    struct DecompressJob
+    {
+        uint32_t flags;         // チャンクフラグ（圧縮形式）
+        const uint8_t* src;     // 圧縮データ
+        size_t srcSize;         // 圧縮データのサイズ
+        uint8_t* dst;           // 展開先（展開後のサイズ分確保しておく）
+        size_t dstSize;         // 展開後のサイズ
+    };
+
+    // 複数のチャンクをまとめて展開する関数
+    // ※全チャンクのブロックを全コアに分散して展開する
+    inline bool DecompressChunks(const std::vector<DecompressJob>& jobs, unsigned threads = 0)
+    {
+        // 展開するブロックの一覧
+        struct Block
+        {
+            CompressionType type;
+            const uint8_t* src;
+            size_t srcSize;
+            uint8_t* dst;
+            size_t dstSize;
+        };
+        std::vector<Block> blocks;
+
+        std::vector<CompressedBlock> chunkBlocks;
+        for (const auto& job : jobs)
+        {
+            CompressionType type = static_cast<CompressionType>(job.flags & IMDL_CHUNK_FLAG_COMPRESSION_MASK);
+
+            // 圧縮されていない
+            if (type == COMPRESSION_NONE)
+            {
+                if (job.srcSize != job.dstSize) return false;
+                std::memcpy(job.dst, job.src, job.srcSize);
+                continue;
+            }
+
+            // ----- ブロックテーブルの検証 ----- //
+            CompressedChunkHeader header;
+            chunkBlocks.clear();
+            if (!ValidateCompressedChunk(job.flags, job.src, job.srcSize, header, &chunkBlocks)) return false;
+            if (header.rawSize != job.dstSize) return false;
+
+            for (const auto& block : chunkBlocks)
+            {
+                blocks.push_back({ type, block.src, block.srcSize, job.dst + block.offset, block.size });
+            }
+        }
+
+        // ----- 並列に展開 ----- //
+        std::atomic<bool> succeeded{ true };
+
+        ParallelFor(blocks.size(), [&](size_t i)
+            {
+                const Block& b = blocks[i];
+                if (!DecompressBlock(b.type, b.src, b.srcSize, b.dst, b.dstSize))
+                {
+                    succeeded = false;
+                }
+            }, threads);
+
+        return succeeded;
+    }
+
+    // チャンクデータを展開する関数
+    // ※圧縮されていない場合はそのままコピーする
+    inline bool DecompressChunkData(uint32_t flags, const uint8_t* src, size_t srcSize, std::vector<uint8_t>& out, unsigned threads = 0)
+    {
+        uint64_t rawSize = srcSize;
+
+        if ((flags & IMDL_CHUNK_FLAG_COMPRESSION_MASK) != COMPRESSION_NONE)
+        {
+            if (!GetDecompressedSize(flags, src, srcSize, rawSize) || rawSize > SIZE_MAX) return false;
+        }
+
+        out.resize(static_cast<size_t>(rawSize));
+
+        return DecompressChunks({ { flags, src, srcSize, out.data(), out.size() } }, threads);
+    }
+}
@@ -0,0 +1,610 @@
+﻿//--------------------------------------------------------------------------------------
+// File: CorpusGenerator.h
+//
+// 計測用の obj、mtl、テクスチャ（コーパス）を作成するユーティリティ
+//
+// ※同じ scale なら、どのプラットフォームでも同じ内容のファイルを作る（乱数は自前、小数は固定桁）
+// ※作るファイル（scale に比例して大きくなる）
+//     dense_grid.obj          : 細かい格子（１つのサブメッシュ、v/vt/vn）
+//     small_objects.obj       : 小さな立方体をたくさん（o と usemtl を物体ごと）
+//     material_switches.obj   : 面２枚ごとに usemtl を切り替える（法線なし）
+//     negative_indices.obj    : 負のインデックス（直前の頂点からの相対位置）
+//     ngons.obj               : ５～１２角形（三角形に分割される）
+//     missing_attributes.obj  : vt、vn のない面が混ざる
+//     texture_set.obj         : テクスチャ付きのマテリアル（テクスチャは 256 x scale ピクセル四方の TGA）
+// ※最後に corpus.txt を書き出す（CORPUS_GENERATOR_VERSION と scale が同じなら作り直さなくてよい）
+//
+// Date: 2026.3.16
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Imase
+{
+    // コーパスの作り方を変えたら上げる（作成済みのコーパスを作り直す）
+    static const uint32_t CORPUS_GENERATOR_VERSION = 1;
+
+    // テクスチャの一辺の上限（TGA は 65535 まで）
+    static const uint32_t CORPUS_MAX_TEXTURE_SIZE = 8192;
+
+    // 再現できる乱数（xorshift64*）
+    // ※標準の分布クラスは実装によって結果が違うので使わない
+    class CorpusRandom
+    {
+    public:
+
+        explicit CorpusRandom(uint64_t seed)
+            : m_state(seed ? seed : 0x9e3779b97f4a7c15ull)
+        {
+        }
+
+        uint64_t Next()
+        {
+            m_state ^= m_state >> 12;
+            m_state ^= m_state << 25;
+            m_state ^= m_state >> 27;
+            return m_state * 0x2545f4914f6cdd1dull;
+        }
+
+        // [0, 1)
+        float NextFloat()
+        {
+            return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f);
+        }
+
+        // [min, max)
+        float NextFloat(float min, float max)
+        {
+            return min + (max - min) * NextFloat();
+        }
+
+        // [0, count)
+        uint32_t NextUInt(uint32_t count)
+        {
+            return static_cast<uint32_t>((Next() >> 32) % count);
+        }
+
+    private:
+
+        uint64_t m_state;
+    };
+
+    // obj、mtl のテキストを作るクラス
+    class CorpusText
+    {
+    public:
+
+        void Line(const char* format, ...)
+        {
+            char line[256];
+            va_list args;
+            va_start(args, format);
+            int length = std::vsnprintf(line, sizeof(line), format, args);
+            va_end(args);
+            if (length < 0) return;
+            m_text.append(line, std::min(static_cast<size_t>(length), sizeof(line) - 1));
+            m_text += '\n';
+        }
+
+        void Vertex(float x, float y, float z) { Line("v %.4f %.4f %.4f", x, y, z); }
+        void Normal(float x, float y, float z) { Line("vn %.4f %.4f %.4f", x, y, z); }
+        void TexCoord(float u, float v) { Line("vt %.4f %.4f", u, v); }
+
+        // 面（"f " の後に続ける頂点の指定）
+        void Face(const std::vector<std::string>& corners)
+        {
+            m_text += 'f';
+            for (const auto& corner : corners)
+            {
+                m_text += ' ';
+                m_text += corner;
+            }
+            m_text += '\n';
+        }
+
+        bool Save(const std::filesystem::path& path, std::string& error) const
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            ofs.write(m_text.data(), static_cast<std::streamsize>(m_text.size()));
+            if (!ofs)
+            {
+                error = "Could not write " + path.u8string();
+                return false;
+            }
+            return true;
+        }
+
+    private:
+
+        std::string m_text;
+    };
+
+    // 面の頂点の指定を作る関数（vt、vn が 0 の場合は省略する）
+    inline std::string CorpusCorner(int64_t v, int64_t vt, int64_t vn)
+    {
+        std::string corner = std::to_string(v);
+        if (vt == 0 && vn == 0) return corner;
+        corner += '/';
+        if (vt != 0) corner += std::to_string(vt);
+        if (vn != 0)
+        {
+            corner += '/';
+            corner += std::to_string(vn);
+        }
+        return corner;
+    }
+
+    // 無圧縮 32bit の TGA を書き出す関数（左上原点、BGRA）
+    template <class F>
+    inline bool WriteCorpusTga(const std::filesystem::path& path, uint32_t size, F&& pixel, std::string& error)
+    {
+        std::vector<uint8_t> data(18 + static_cast<size_t>(size) * size * 4);
+        data[2] = 2;                                    // 無圧縮のフルカラー
+        data[12] = static_cast<uint8_t>(size & 0xff);   // 幅
+        data[13] = static_cast<uint8_t>(size >> 8);
+        data[14] = static_cast<uint8_t>(size & 0xff);   // 高さ
+        data[15] = static_cast<uint8_t>(size >> 8);
+        data[16] = 32;                                  // ビット数
+        data[17] = 0x28;                                // アルファ 8bit、左上原点
+
+        uint8_t* p = data.data() + 18;
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                uint8_t rgba[4];
+                pixel(x, y, rgba);
+                *p++ = rgba[2];
+                *p++ = rgba[1];
+                *p++ = rgba[0];
+                *p++ = rgba[3];
+            }
+        }
+
+        std::ofstream ofs(path, std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!ofs)
+        {
+            error = "Could not write " + path.u8string();
+            return false;
+        }
+        return true;
+    }
+
+    // 0～1 を 0～255 にする関数
+    inline uint8_t ToCorpusByte(float value)
+    {
+        return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    // 格子の高さ（法線は高さの傾きから求める）
+    inline float CorpusHeight(float x, float z)
+    {
+        return 0.25f * std::sin(x * 0.37f) * std::cos(z * 0.23f);
+    }
+
+    // ----- 各ファイルの作成 ----- //
+
+    // マテリアルファイル（色だけのマテリアル mat0～mat63、テクスチャ付きのマテリアル tex0～tex5）
+    inline bool GenerateCorpusMaterials(const std::filesystem::path& dir, std::string& error)
+    {
+        CorpusRandom random(1);
+
+        CorpusText geometry;
+        for (int i = 0; i < 64; i++)
+        {
+            geometry.Line("newmtl mat%d", i);
+            // 引数の評価順は決まっていないので、乱数は順に取得する
+            float r = random.NextFloat();
+            float g = random.NextFloat();
+            float b = random.NextFloat();
+            geometry.Line("Kd %.4f %.4f %.4f", r, g, b);
+            geometry.Line("Ks %.4f %.4f %.4f", 0.5f, 0.5f, 0.5f);
+            geometry.Line("Ns %.4f", random.NextFloat(10.0f, 900.0f));
+            geometry.Line("");
+        }
+        if (!geometry.Save(dir / "geometry.mtl", error)) return false;
+
+        CorpusText textured;
+        for (int i = 0; i < 6; i++)
+        {
+            textured.Line("newmtl tex%d", i);
+            textured.Line("Kd 1.0000 1.0000 1.0000");
+            textured.Line("map_Kd color%d.tga", i % 4);
+            if (i >= 4) textured.Line("map_Bump normal%d.tga", i - 4);
+            textured.Line("");
+        }
+        return textured.Save(dir / "textured.mtl", error);
+    }
+
+    // テクスチャ（ベースカラー４枚、法線マップ２枚）
+    // ※BC 圧縮の時間が実際の画像に近くなるように、模様にノイズを混ぜる
+    inline bool GenerateCorpusTextures(const std::filesystem::path& dir, uint32_t scale, std::string& error)
+    {
+        uint32_t size = std::min(256u * scale, CORPUS_MAX_TEXTURE_SIZE);
+
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            CorpusRandom random(100 + i);
+            float frequency = 0.02f * (i + 1) * 256.0f / size;
+            auto pixel = [&](uint32_t x, uint32_t y, uint8_t rgba[4])
+                {
+                    float noise = random.NextFloat(-0.08f, 0.08f);
+                    float checker = (((x / 32) ^ (y / 32)) & 1) ? 0.15f : 0.0f;
+                    rgba[0] = ToCorpusByte(0.5f + 0.4f * std::sin(x * frequency) + noise);
+                    rgba[1] = ToCorpusByte(0.5f + 0.4f * std::cos(y * frequency) + checker);
+                    rgba[2] = ToCorpusByte(static_cast<float>(x + y) / (2 * size) + noise);
+                    rgba[3] = 255;
+                };
+            if (!WriteCorpusTga(dir / ("color" + std::to_string(i) + ".tga"), size, pixel, error)) return false;
+        }
+
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            CorpusRandom random(200 + i);
+            float frequency = 0.05f * (i + 1) * 256.0f / size;
+            auto pixel = [&](uint32_t x, uint32_t y, uint8_t rgba[4])
+                {
+                    float nx = 0.5f * std::cos(x * frequency) + random.NextFloat(-0.05f, 0.05f);
+                    float ny = 0.5f * std::cos(y * frequency) + random.NextFloat(-0.05f, 0.05f);
+                    float nz = std::sqrt(std::max(0.0f, 1.0f - nx * nx - ny * ny));
+                    rgba[0] = ToCorpusByte(nx * 0.5f + 0.5f);
+                    rgba[1] = ToCorpusByte(ny * 0.5f + 0.5f);
+                    rgba[2] = ToCorpusByte(nz * 0.5f + 0.5f);
+                    rgba[3] = 255;
+                };
+            if (!WriteCorpusTga(dir / ("normal" + std::to_string(i) + ".tga"), size, pixel, error)) return false;
+        }
+
+        return true;
+    }
+
+    // 細かい格子（(256 x scale) x 256 の四角形）
+    inline bool GenerateDenseGrid(const std::filesystem::path& path, uint32_t scale, std::string& error)
+    {
+        const uint32_t w = 256 * scale, h = 256;
+
+        CorpusText obj;
+        obj.Line("mtllib geometry.mtl");
+        obj.Line("o dense_grid");
+        for (uint32_t z = 0; z <= h; z++)
+        {
+            for (uint32_t x = 0; x <= w; x++)
+            {
+                float fx = static_cast<float>(x), fz = static_cast<float>(z);
+                obj.Vertex(fx, CorpusHeight(fx, fz), fz);
+                obj.TexCoord(fx / w, fz / h);
+
+                // 高さの傾きから法線を求める
+                float dx = CorpusHeight(fx + 0.5f, fz) - CorpusHeight(fx - 0.5f, fz);
+                float dz = CorpusHeight(fx, fz + 0.5f) - CorpusHeight(fx, fz - 0.5f);
+                float length = std::sqrt(dx * dx + 1.0f + dz * dz);
+                obj.Normal(-dx / length, 1.0f / length, -dz / length);
+            }
+        }
+
+        obj.Line("usemtl mat0");
+        auto index = [w](uint32_t x, uint32_t z) { return static_cast<int64_t>(z) * (w + 1) + x + 1; };
+        for (uint32_t z = 0; z < h; z++)
+        {
+            for (uint32_t x = 0; x < w; x++)
+            {
+                int64_t a = index(x, z), b = index(x, z + 1), c = index(x + 1, z + 1), d = index(x + 1, z);
+                obj.Face({ CorpusCorner(a, a, a), CorpusCorner(b, b, b), CorpusCorner(c, c, c), CorpusCorner(d, d, d) });
+            }
+        }
+
+        return obj.Save(path, error);
+    }
+
+    // 小さな立方体（1024 x scale 個、物体ごとに o と usemtl）
+    inline bool GenerateSmallObjects(const std::filesystem::path& path, uint32_t scale, std::string& error)
+    {
+        const uint32_t count = 1024 * scale;
+        CorpusRandom random(2);
+
+        CorpusText obj;
+        obj.Line("mtllib geometry.mtl");
+
+        // 法線とテクスチャ座標はすべての立方体で共有する
+        static const float normals[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        for (const auto& n : normals) obj.Normal(n[0], n[1], n[2]);
+        obj.TexCoord(0, 0);
+        obj.TexCoord(0, 1);
+        obj.TexCoord(1, 1);
+        obj.TexCoord(1, 0);
+
+        // 面の頂点（立方体の角の番号、x = 4、y = 2、z = 1 のビット）と法線（+x、-x、+y、-y、+z、-z）
+        static const int faces[6][4] = { { 4, 6, 7, 5 }, { 0, 1, 3, 2 }, { 2, 3, 7, 6 }, { 0, 4, 5, 1 }, { 1, 5, 7, 3 }, { 0, 2, 6, 4 } };
+        static const int faceNormals[6] = { 1, 2, 3, 4, 5, 6 };
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            obj.Line("o cube_%u", i);
+
+            float cx = random.NextFloat(-100.0f, 100.0f), cy = random.NextFloat(-100.0f, 100.0f), cz = random.NextFloat(-100.0f, 100.0f);
+            float s = random.NextFloat(0.1f, 2.0f);
+            for (int corner = 0; corner < 8; corner++)
+            {
+                obj.Vertex(cx + ((corner & 4) ? s : -s), cy + ((corner & 2) ? s : -s), cz + ((corner & 1) ? s : -s));
+            }
+
+            obj.Line("usemtl mat%u", i % 64);
+            int64_t base = static_cast<int64_t>(i) * 8 + 1;
+            for (int f = 0; f < 6; f++)
+            {
+                std::vector<std::string> corners;
+                for (int k = 0; k < 4; k++) corners.push_back(CorpusCorner(base + faces[f][k], k + 1, faceNormals[f]));
+                obj.Face(corners);
+            }
+        }
+
+        return obj.Save(path, error);
+    }
+
+    // usemtl の切り替え（(128 x scale) x 128 の四角形、面２枚ごとに切り替え、法線なし）
+    inline bool GenerateMaterialSwitches(const std::filesystem::path& path, uint32_t scale, std::string& error)
+    {
+        const uint32_t w = 128 * scale, h = 128;
+        CorpusRandom random(3);
+
+        CorpusText obj;
+        obj.Line("mtllib geometry.mtl");
+        obj.Line("o material_switches");
+        for (uint32_t z = 0; z <= h; z++)
+        {
+            for (uint32_t x = 0; x <= w; x++)
+            {
+                obj.Vertex(static_cast<float>(x), 0.0f, static_cast<float>(z));
+                obj.TexCoord(static_cast<float>(x) / w, static_cast<float>(z) / h);
+            }
+        }
+
+        auto index = [w](uint32_t x, uint32_t z) { return static_cast<int64_t>(z) * (w + 1) + x + 1; };
+        uint32_t quad = 0;
+        for (uint32_t z = 0; z < h; z++)
+        {
+            for (uint32_t x = 0; x < w; x++, quad++)
+            {
+                if ((quad & 1) == 0) obj.Line("usemtl mat%u", random.NextUInt(64));
+
+                int64_t a = index(x, z), b = index(x, z + 1), c = index(x + 1, z + 1), d = index(x + 1, z);
+                obj.Face({ CorpusCorner(a, a, 0), CorpusCorner(b, b, 0), CorpusCorner(c, c, 0), CorpusCorner(d, d, 0) });
+            }
+        }
+
+        return obj.Save(path, error);
+    }
+
+    // 負のインデックス（4096 x scale 枚の 3 x 3 の四角形のパッチ）
+    inline bool GenerateNegativeIndices(const std::filesystem::path& path, uint32_t scale, std::string& error)
+    {
+        const uint32_t count = 4096 * scale;
+        CorpusRandom random(4);
+
+        CorpusText obj;
+        obj.Line("mtllib geometry.mtl");
+        obj.Line("o negative_indices");
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (i % 64 == 0) obj.Line("usemtl mat%u", (i / 64) % 64);
+
+            // パッチの頂点（4 x 4）と法線（１つ）
+            float ox = random.NextFloat(-200.0f, 200.0f), oz = random.NextFloat(-200.0f, 200.0f);
+            for (int r = 0; r < 4; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    obj.Vertex(ox + c, random.NextFloat(-0.1f, 0.1f), oz + r);
+                    obj.TexCoord(c / 3.0f, r / 3.0f);
+                }
+            }
+            obj.Normal(0.0f, 1.0f, 0.0f);
+
+            // 直前に書いた頂点を負のインデックスで参照する
+            auto index = [](int r, int c) { return static_cast<int64_t>(r * 4 + c) - 16; };
+            for (int r = 0; r < 3; r++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    int64_t a = index(r, c), b = index(r + 1, c), cc = index(r + 1, c + 1), d = index(r, c + 1);
+                    obj.Face({ CorpusCorner(a, a, -1), CorpusCorner(b, b, -1), CorpusCorner(cc, cc, -1), CorpusCorner(d, d, -1) });
+                }
+            }
+        }
+
+        return obj.Save(path, error);
+    }
+
+    // 多角形（8192 x scale 個の５～１２角形）
+    inline bool GenerateNgons(const std::filesystem::path& path, uint32_t scale, std::string& error)
+    {
+        const uint32_t count = 8192 * scale;
+        CorpusRandom random(5);
+
+        CorpusText obj;
+        obj.Line("mtllib geometry.mtl");
+        obj.Line("o ngons");
+        obj.Normal(0.0f, 1.0f, 0.0f);
+        obj.Line("usemtl mat5");
+
+        int64_t next = 1;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t sides = 5 + random.NextUInt(8);
+            float cx = random.NextFloat(-300.0f, 300.0f), cz = random.NextFloat(-300.0f, 300.0f);
+            float radius = random.NextFloat(0.2f, 3.0f);
+
+            std::vector<std::string> corners;
+            for (uint32_t k = 0; k < sides; k++)
+            {
+                float angle = 6.28318530f * k / sides;
+                obj.Vertex(cx + radius * std::cos(angle), 0.0f, cz - radius * std::sin(angle));
+                obj.TexCoord(0.5f + 0.5f * std::cos(angle), 0.5f + 0.5f * std::sin(angle));
+                corners.push_back(CorpusCorner(next, next, 1));
+                next++;
+            }
+            obj.Face(corners);
+        }
+
+        return obj.Save(path, error);
+    }
+
+    // vt、vn のない面（(128 x scale) x 128 の四角形、行ごとに v、v/vt、v//vn、v/vt/vn）
+    inline bool GenerateMissingAttributes(const std::filesystem::path& path, uint32_t scale, std::string& error)
+    {
+        const uint32_t w = 128 * scale, h = 128;
+
+        CorpusText obj;
+        obj.Line("mtllib geometry.mtl");
+        obj.Line("o missing_attributes");
+        for (uint32_t z = 0; z <= h; z++)
+        {
+            for (uint32_t x = 0; x <= w; x++)
+            {
+                float fx = static_cast<float>(x), fz = static_cast<float>(z);
+                obj.Vertex(fx, CorpusHeight(fx, fz), fz);
+                obj.TexCoord(fx / w, fz / h);
+            }
+        }
+        obj.Normal(0.0f, 1.0f, 0.0f);
+        obj.Line("usemtl mat7");
+
+        auto index = [w](uint32_t x, uint32_t z) { return static_cast<int64_t>(z) * (w + 1) + x + 1; };
+        for (uint32_t z = 0; z < h; z++)
+        {
+            bool vt = (z % 4) == 1 || (z % 4) == 3;
+            bool vn = (z % 4) >= 2;
+            for (uint32_t x = 0; x < w; x++)
+            {
+                std::vector<std::string> corners;
+                for (int64_t v : { index(x, z), index(x, z + 1), index(x + 1, z + 1), index(x + 1, z) })
+                {
+                    corners.push_back(CorpusCorner(v, vt ? v : 0, vn ? 1 : 0));
+                }
+                obj.Face(corners);
+            }
+        }
+
+        return obj.Save(path, error);
+    }
+
+    // テクスチャ付きのマテリアル（マテリアルごとに１枚の四角形）
+    inline bool GenerateTextureSet(const std::filesystem::path& path, std::string& error)
+    {
+        CorpusText obj;
+        obj.Line("mtllib textured.mtl");
+        obj.Line("o texture_set");
+        obj.Normal(0.0f, 1.0f, 0.0f);
+        obj.TexCoord(0, 0);
+        obj.TexCoord(0, 1);
+        obj.TexCoord(1, 1);
+        obj.TexCoord(1, 0);
+
+        for (int i = 0; i < 6; i++)
+        {
+            float x = i * 2.0f;
+            obj.Vertex(x, 0.0f, 0.0f);
+            obj.Vertex(x, 0.0f, 1.0f);
+            obj.Vertex(x + 1.0f, 0.0f, 1.0f);
+            obj.Vertex(x + 1.0f, 0.0f, 0.0f);
+
+            obj.Line("usemtl tex%d", i);
+            obj.Face({ CorpusCorner(i * 4 + 1, 1, 1), CorpusCorner(i * 4 + 2, 2, 1), CorpusCorner(i * 4 + 3, 3, 1), CorpusCorner(i * 4 + 4, 4, 1) });
+        }
+
+        return obj.Save(path, error);
+    }
+
+    // ----- コーパス ----- //
+
+    // 作成済みのコーパスの obj ファイルを取得する関数（作り直す必要がある場合は false）
+    inline bool GetCorpusFiles(const std::filesystem::path& dir, uint32_t scale, std::vector<std::filesystem::path>& files)
+    {
+        files.clear();
+
+        std::ifstream ifs(dir / "corpus.txt");
+        uint32_t version = 0, fileScale = 0;
+        std::string tag;
+        if (!(ifs >> tag >> version >> fileScale) || tag != "corpus" || version != CORPUS_GENERATOR_VERSION || fileScale != scale)
+        {
+            return false;
+        }
+
+        std::string name;
+        while (ifs >> name)
+        {
+            std::filesystem::path path = dir / std::filesystem::u8path(name);
+            if (!std::filesystem::exists(path)) return false;
+            files.push_back(path);
+        }
+        return !files.empty();
+    }
+
+    // コーパスを作成する関数
+    // files : 作成した obj ファイル
+    inline bool GenerateCorpus(const std::filesystem::path& dir, uint32_t scale, std::vector<std::filesystem::path>& files, std::string& error)
+    {
+        files.clear();
+
+        if (scale == 0)
+        {
+            error = "Corpus scale must be at least 1";
+            return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec)
+        {
+            error = "Could not create " + dir.u8string() + ": " + ec.message();
+            return false;
+        }
+
+        // 途中で失敗した場合に作成済みと見なさないように、最初に消しておく
+        std::filesystem::remove(dir / "corpus.txt", ec);
+
+        if (!GenerateCorpusMaterials(dir, error)) return false;
+        if (!GenerateCorpusTextures(dir, scale, error)) return false;
+
+        struct Generator
+        {
+            const char* name;
+            bool (*generate)(const std::filesystem::path&, uint32_t, std::string&);
+        };
+        static const Generator generators[] =
+        {
+            { "dense_grid.obj", GenerateDenseGrid },
+            { "small_objects.obj", GenerateSmallObjects },
+            { "material_switches.obj", GenerateMaterialSwitches },
+            { "negative_indices.obj", GenerateNegativeIndices },
+            { "ngons.obj", GenerateNgons },
+            { "missing_attributes.obj", GenerateMissingAttributes },
+        };
+        for (const auto& generator : generators)
+        {
+            files.push_back(dir / generator.name);
+            if (!generator.generate(files.back(), scale, error)) return false;
+        }
+
+        files.push_back(dir / "texture_set.obj");
+        if (!GenerateTextureSet(files.back(), error)) return false;
+
+        // 作成済みの印
+        CorpusText manifest;
+        manifest.Line("corpus %u %u", CORPUS_GENERATOR_VERSION, scale);
+        for (const auto& file : files) manifest.Line("%s", file.filename().u8string().c_str());
+        return manifest.Save(dir / "corpus.txt", error);
+    }
+}
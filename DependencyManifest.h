@@ -0,0 +1,264 @@
+﻿//--------------------------------------------------------------------------------------
+// File: DependencyManifest.h
+//
+// 出力ファイルの依存関係（入力ファイルと変換の設定）を記録、確認する関数
+//
+// ※出力ファイルの隣に <出力ファイル名>.deps として保存する（UTF-8 のテキスト）
+// ※入力ファイルごとにサイズ、更新日時、内容の CRC32C を記録する
+// ※確認するときはまずサイズと更新日時を比較し、更新日時が異なる場合だけ内容を読み込んで比較する
+//   （内容が同じ場合は更新日時を記録し直して、次回は読み込まずに済むようにする）
+//
+// Date: 2026.3.10
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "Checksum.h"
+
+namespace Imase
+{
+    // 依存関係の記録の形式のバージョン
+    constexpr uint32_t IMDL_DEPENDENCY_MANIFEST_VERSION = 1;
+
+    // 入力ファイルの記録
+    struct DependencyEntry
+    {
+        std::filesystem::path path;     // ファイル名（絶対パス）
+        uint64_t size = 0;              // サイズ
+        int64_t time = 0;               // 更新日時
+        uint32_t crc = 0;               // 内容の CRC32C
+    };
+
+    // 出力ファイルの依存関係
+    struct DependencyManifest
+    {
+        std::string settings;                   // 変換の設定（設定が変わったら作り直す）
+        uint64_t outputSize = 0;                // 出力ファイルのサイズ（書き出しに失敗した場合を検出する）
+        std::vector<DependencyEntry> inputs;    // 入力ファイル
+    };
+
+    // 依存関係の記録のファイル名を取得する関数
+    inline std::filesystem::path GetDependencyManifestPath(const std::filesystem::path& output)
+    {
+        std::filesystem::path path = output;
+        path += ".deps";
+        return path;
+    }
+
+    // ファイルの更新日時を取得する関数（取得できない場合は 0）
+    inline int64_t GetFileTime(const std::filesystem::path& path)
+    {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(path, ec);
+        return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+    }
+
+    // ファイルの内容の CRC32C を計算する関数
+    inline bool HashFile(const std::filesystem::path& path, uint32_t& crc, uint64_t& size)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs) return false;
+
+        std::vector<char> buffer(1 << 20);
+
+        crc = 0;
+        size = 0;
+        while (ifs)
+        {
+            ifs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            size_t read = static_cast<size_t>(ifs.gcount());
+            if (read == 0) break;
+
+            crc = Crc32c(buffer.data(), read, crc);
+            size += read;
+        }
+
+        return !ifs.bad();
+    }
+
+    // 入力ファイルの記録を作成する関数
+    inline bool MakeDependencyEntry(const std::filesystem::path& path, DependencyEntry& entry)
+    {
+        std::error_code ec;
+        entry.path = std::filesystem::absolute(path, ec).lexically_normal();
+        if (ec) entry.path = path;
+
+        entry.time = GetFileTime(path);
+        return HashFile(path, entry.crc, entry.size);
+    }
+
+    // 依存関係を保存する関数
+    // ※途中で失敗しても壊れた記録が残らないように、一時ファイルに書き出してから置き換える
+    inline bool SaveDependencyManifest(const std::filesystem::path& path, const DependencyManifest& manifest)
+    {
+        std::filesystem::path temp = path;
+        temp += ".tmp";
+
+        {
+            std::ofstream ofs(temp, std::ios::binary);
+            if (!ofs) return false;
+
+            ofs << "# ObjToImdl dependency manifest\n";
+            ofs << "version " << IMDL_DEPENDENCY_MANIFEST_VERSION << "\n";
+            ofs << "settings " << manifest.settings << "\n";
+            ofs << "output " << manifest.outputSize << "\n";
+
+            for (const auto& input : manifest.inputs)
+            {
+                char crc[16];
+                std::snprintf(crc, sizeof(crc), "%08x", input.crc);
+
+                // ※ファイル名は空白を含むことがあるので行の最後に置く
+                ofs << "input " << input.size << " " << input.time << " " << crc << " " << input.path.u8string() << "\n";
+            }
+
+            if (!ofs) return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temp, path, ec);
+        if (ec)
+        {
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+    // 依存関係を読み込む関数
+    inline bool LoadDependencyManifest(const std::filesystem::path& path, DependencyManifest& manifest)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs) return false;
+
+        manifest = DependencyManifest();
+        uint32_t version = 0;
+
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            size_t space = line.find(' ');
+            std::string key = line.substr(0, space);
+            std::string value = space == std::string::npos ? std::string() : line.substr(space + 1);
+
+            if (key == "version")
+            {
+                version = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+            }
+            else if (key == "settings")
+            {
+                manifest.settings = value;
+            }
+            else if (key == "output")
+            {
+                manifest.outputSize = std::strtoull(value.c_str(), nullptr, 10);
+            }
+            else if (key == "input")
+            {
+                std::istringstream iss(value);
+                DependencyEntry entry;
+                std::string crc;
+                if (!(iss >> entry.size >> entry.time >> crc)) return false;
+
+                std::string name;
+                std::getline(iss >> std::ws, name);
+                if (name.empty()) return false;
+
+                entry.crc = static_cast<uint32_t>(std::strtoul(crc.c_str(), nullptr, 16));
+                entry.path = std::filesystem::u8path(name);
+                manifest.inputs.push_back(entry);
+            }
+        }
+
+        return version == IMDL_DEPENDENCY_MANIFEST_VERSION;
+    }
+
+    // 出力ファイルが最新か確認する関数
+    // settings : 今回の変換の設定
+    // reason   : 最新でない場合にその理由を返す（nullptr 可）
+    // ※更新日時だけが変わっていて内容が同じ入力ファイルがあった場合は、記録の更新日時を更新する
+    inline bool IsOutputUpToDate(const std::filesystem::path& output, const std::string& settings, std::string* reason = nullptr)
+    {
+        auto stale = [reason](const std::string& why)
+            {
+                if (reason) *reason = why;
+                return false;
+            };
+
+        std::error_code ec;
+        uint64_t outputSize = std::filesystem::file_size(output, ec);
+        if (ec) return stale("output does not exist");
+
+        DependencyManifest manifest;
+        std::filesystem::path manifestPath = GetDependencyManifestPath(output);
+        if (!LoadDependencyManifest(manifestPath, manifest)) return stale("no dependency manifest");
+
+        if (manifest.settings != settings) return stale("settings changed");
+        if (manifest.outputSize != outputSize) return stale("output size changed");
+        if (manifest.inputs.empty()) return stale("no inputs recorded");
+
+        bool touched = false;
+        for (auto& input : manifest.inputs)
+        {
+            // ----- サイズと更新日時（ファイルを読まずに確認できる） ----- //
+            uint64_t size = std::filesystem::file_size(input.path, ec);
+            if (ec) return stale(input.path.u8string() + " is missing");
+            if (size != input.size) return stale(input.path.u8string() + " changed");
+
+            int64_t time = GetFileTime(input.path);
+            if (time == input.time) continue;
+
+            // ----- 更新日時が異なる場合は内容を比較 ----- //
+            uint32_t crc;
+            if (!HashFile(input.path, crc, size) || crc != input.crc || size != input.size)
+            {
+                return stale(input.path.u8string() + " changed");
+            }
+
+            input.time = time;
+            touched = true;
+        }
+
+        // 内容が同じだった入力ファイルの更新日時を記録し直す
+        if (touched)
+        {
+            SaveDependencyManifest(manifestPath, manifest);
+        }
+
+        return true;
+    }
+
+    // 出力ファイルの依存関係を記録する関数
+    // ※出力ファイルを書き出した後に呼ぶ
+    inline bool RecordDependencies(const std::filesystem::path& output, const std::string& settings, const std::vector<std::filesystem::path>& inputs)
+    {
+        DependencyManifest manifest;
+        manifest.settings = settings;
+
+        std::error_code ec;
+        manifest.outputSize = std::filesystem::file_size(output, ec);
+        if (ec) return false;
+
+        for (const auto& input : inputs)
+        {
+            DependencyEntry entry;
+            if (!MakeDependencyEntry(input, entry)) return false;
+            manifest.inputs.push_back(entry);
+        }
+
+        return SaveDependencyManifest(GetDependencyManifestPath(output), manifest);
+    }
+}
@@ -0,0 +1,259 @@
+﻿//--------------------------------------------------------------------------------------
+// File: FileWatcher.h
+//
+// フォルダ内のファイルの変更を監視するクラス
+//
+// ※Windows は ReadDirectoryChangesW、Linux は inotify を使う
+// ※作成、書き込み、名前の変更、削除されたファイルのパスを返す（種類は区別しない）
+//   エディタは一時ファイルに書いてから置き換えることが多いので、呼び出し側で少し待ってからまとめて処理すること
+//
+// Date: 2026.3.10
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Imase
+{
+    class FileWatcher
+    {
+    public:
+
+        FileWatcher()
+        {
+#if defined(__linux__)
+            m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+        }
+
+        ~FileWatcher()
+        {
+#if defined(_WIN32)
+            for (auto& watch : m_watches)
+            {
+                CancelIo(watch->handle);
+                CloseHandle(watch->handle);
+                CloseHandle(watch->overlapped.hEvent);
+            }
+#elif defined(__linux__)
+            if (m_fd >= 0) close(m_fd);
+#endif
+        }
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        // 監視するフォルダを追加する関数
+        // recursive : 下のフォルダも監視する
+        // ※既に監視しているフォルダの場合は何もしない
+        bool Add(const std::filesystem::path& dir, bool recursive)
+        {
+            std::error_code ec;
+            std::filesystem::path path = std::filesystem::absolute(dir, ec).lexically_normal();
+            if (ec || !std::filesystem::is_directory(path, ec)) return false;
+
+#if defined(_WIN32)
+            for (const auto& watch : m_watches)
+            {
+                if (_wcsicmp(watch->dir.c_str(), path.c_str()) == 0 && (watch->recursive || !recursive)) return true;
+            }
+
+            auto watch = std::make_unique<Watch>();
+            watch->dir = path;
+            watch->recursive = recursive;
+            watch->handle = CreateFileW(path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+            if (watch->handle == INVALID_HANDLE_VALUE) return false;
+
+            watch->overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            if (!Issue(*watch))
+            {
+                CloseHandle(watch->handle);
+                CloseHandle(watch->overlapped.hEvent);
+                return false;
+            }
+
+            m_watches.push_back(std::move(watch));
+            return true;
+#elif defined(__linux__)
+            if (m_fd < 0) return false;
+            if (!AddWatch(path)) return false;
+
+            // inotify は下のフォルダを監視しないので、フォルダごとに追加する
+            if (recursive)
+            {
+                m_recursive.push_back(path);
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(path, ec))
+                {
+                    if (entry.is_directory(ec)) AddWatch(entry.path());
+                }
+            }
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // 変更されたファイルを待つ関数
+        // timeoutMs : 待つ時間（ミリ秒）
+        // ※変更されたファイルのパス（絶対パス）を changed に追加する
+        // ※通知が溢れた場合はフォルダのパスを返すので、その下のファイルすべてが変更されたものとして扱うこと
+        // ※監視できない環境では false を返す
+        bool Wait(std::vector<std::filesystem::path>& changed, unsigned timeoutMs)
+        {
+#if defined(_WIN32)
+            if (m_watches.empty()) return false;
+
+            std::vector<HANDLE> events;
+            for (const auto& watch : m_watches)
+            {
+                events.push_back(watch->overlapped.hEvent);
+            }
+
+            // ※WaitForMultipleObjects は 64 個まで
+            DWORD count = static_cast<DWORD>(events.size() < MAXIMUM_WAIT_OBJECTS ? events.size() : MAXIMUM_WAIT_OBJECTS);
+            DWORD ret = WaitForMultipleObjects(count, events.data(), FALSE, timeoutMs);
+            if (ret == WAIT_TIMEOUT) return true;
+            if (ret >= WAIT_OBJECT_0 + count) return false;
+
+            // 通知されたものすべてを取り出す
+            for (auto& watch : m_watches)
+            {
+                if (WaitForSingleObject(watch->overlapped.hEvent, 0) != WAIT_OBJECT_0) continue;
+
+                DWORD bytes = 0;
+                if (GetOverlappedResult(watch->handle, &watch->overlapped, &bytes, FALSE))
+                {
+                    if (bytes == 0)
+                    {
+                        // バッファが溢れた場合はフォルダを変更されたものとして返す
+                        changed.push_back(watch->dir);
+                    }
+                    else
+                    {
+                        const uint8_t* p = watch->buffer.data();
+                        for (;;)
+                        {
+                            const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+                            std::wstring name(info->FileName, info->FileNameLength / sizeof(wchar_t));
+                            changed.push_back((watch->dir / name).lexically_normal());
+
+                            if (info->NextEntryOffset == 0) break;
+                            p += info->NextEntryOffset;
+                        }
+                    }
+                }
+                ResetEvent(watch->overlapped.hEvent);
+                Issue(*watch);
+            }
+            return true;
+#elif defined(__linux__)
+            if (m_fd < 0 || m_dirs.empty()) return false;
+
+            pollfd pfd{ m_fd, POLLIN, 0 };
+            int ret = poll(&pfd, 1, static_cast<int>(timeoutMs));
+            if (ret <= 0) return ret == 0 || errno == EINTR;
+
+            alignas(inotify_event) char buffer[64 * 1024];
+            for (;;)
+            {
+                ssize_t size = read(m_fd, buffer, sizeof(buffer));
+                if (size <= 0) break;
+
+                for (char* p = buffer; p < buffer + size;)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                    p += sizeof(inotify_event) + event->len;
+
+                    // キューが溢れた場合は監視しているフォルダすべてを変更されたものとして返す
+                    if (event->mask & IN_Q_OVERFLOW)
+                    {
+                        for (const auto& dir : m_dirs) changed.push_back(dir.second);
+                        continue;
+                    }
+
+                    auto it = m_dirs.find(event->wd);
+                    if (it == m_dirs.end() || event->len == 0) continue;
+
+                    std::filesystem::path path = it->second / event->name;
+                    changed.push_back(path);
+
+                    // 監視しているフォルダの下に作られたフォルダも監視する
+                    if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)) && IsUnderRecursive(path))
+                    {
+                        AddWatch(path);
+                    }
+                }
+            }
+            return true;
+#else
+            (void)changed;
+            (void)timeoutMs;
+            return false;
+#endif
+        }
+
+    private:
+
+#if defined(_WIN32)
+        struct Watch
+        {
+            std::filesystem::path dir;
+            bool recursive = false;
+            HANDLE handle = INVALID_HANDLE_VALUE;
+            OVERLAPPED overlapped{};
+            std::vector<uint8_t> buffer = std::vector<uint8_t>(64 * 1024);
+        };
+
+        // 変更の通知を要求する関数
+        bool Issue(Watch& watch)
+        {
+            const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+            return ReadDirectoryChangesW(watch.handle, watch.buffer.data(), static_cast<DWORD>(watch.buffer.size()),
+                watch.recursive ? TRUE : FALSE, filter, nullptr, &watch.overlapped, nullptr) != FALSE;
+        }
+
+        std::vector<std::unique_ptr<Watch>> m_watches;
+#elif defined(__linux__)
+        bool AddWatch(const std::filesystem::path& dir)
+        {
+            const uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB;
+            int wd = inotify_add_watch(m_fd, dir.c_str(), mask);
+            if (wd < 0) return false;
+
+            m_dirs[wd] = dir;
+            return true;
+        }
+
+        bool IsUnderRecursive(const std::filesystem::path& path) const
+        {
+            for (const auto& dir : m_recursive)
+            {
+                auto relative = path.lexically_relative(dir);
+                if (!relative.empty() && *relative.begin() != "..") return true;
+            }
+            return false;
+        }
+
+        int m_fd = -1;
+        std::map<int, std::filesystem::path> m_dirs;
+        std::vector<std::filesystem::path> m_recursive;
+#endif
+    };
+}
@@ -0,0 +1,359 @@
+﻿//--------------------------------------------------------------------------------------
+// File: FrameStream.h
+//
+// 長さ付きのメッセージ（フレーム）を送受信するクラス
+//
+// ※フレームは uint32_t のサイズ（リトルエンディアン）の後にデータが続く
+// ※標準入出力と、ローカルのソケット（Unix ドメインソケット）で使える
+// ※Windows は AF_UNIX（Windows 10 1803 以降）を使うので、windows.h より前に winsock2.h をインクルードすること
+//
+// Date: 2026.3.11
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <afunix.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace Imase
+{
+    // フレームの最大サイズ（壊れたデータで巨大な領域を確保しないようにする）
+    constexpr uint32_t IMDL_MAX_FRAME_SIZE = 16u << 20;
+
+    class FrameStream
+    {
+    public:
+
+        virtual ~FrameStream() = default;
+
+        // フレームを受信する関数（切断された場合、壊れたフレームの場合は false）
+        bool ReadFrame(std::string& payload)
+        {
+            uint8_t header[4];
+            if (!ReadAll(header, sizeof(header))) return false;
+
+            uint32_t size = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<uint32_t>(header[3]) << 24);
+            if (size > IMDL_MAX_FRAME_SIZE) return false;
+
+            payload.resize(size);
+            return size == 0 || ReadAll(payload.data(), size);
+        }
+
+        // フレームを送信する関数
+        // ※複数のスレッドから呼べる（フレームの途中に他のフレームが混ざらない）
+        bool WriteFrame(const std::string& payload)
+        {
+            if (payload.size() > IMDL_MAX_FRAME_SIZE) return false;
+
+            uint32_t size = static_cast<uint32_t>(payload.size());
+            std::string frame(4, '\0');
+            frame[0] = static_cast<char>(size & 0xff);
+            frame[1] = static_cast<char>((size >> 8) & 0xff);
+            frame[2] = static_cast<char>((size >> 16) & 0xff);
+            frame[3] = static_cast<char>((size >> 24) & 0xff);
+            frame += payload;
+
+            std::lock_guard<std::mutex> lock(m_writeMutex);
+            return WriteAll(frame.data(), frame.size());
+        }
+
+        // 接続を閉じる関数（受信を待っているスレッドを戻す）
+        virtual void Close() = 0;
+
+    protected:
+
+        // 指定したサイズを読み込む関数
+        virtual bool ReadAll(void* data, size_t size) = 0;
+
+        // 指定したサイズを書き出す関数
+        virtual bool WriteAll(const void* data, size_t size) = 0;
+
+    private:
+
+        std::mutex m_writeMutex;
+    };
+
+    // 標準入出力
+    // ※標準出力をフレームに使うので、std::cout などに表示しないこと
+    class StdioFrameStream : public FrameStream
+    {
+    public:
+
+        void Close() override
+        {
+        }
+
+    protected:
+
+        bool ReadAll(void* data, size_t size) override
+        {
+            uint8_t* p = static_cast<uint8_t*>(data);
+            while (size > 0)
+            {
+#if defined(_WIN32)
+                DWORD read = 0;
+                DWORD request = static_cast<DWORD>(size < (1u << 30) ? size : (1u << 30));
+                if (!ReadFile(GetStdHandle(STD_INPUT_HANDLE), p, request, &read, nullptr) || read == 0) return false;
+#else
+                ssize_t read = ::read(0, p, size);
+                if (read < 0 && errno == EINTR) continue;
+                if (read <= 0) return false;
+#endif
+                p += read;
+                size -= static_cast<size_t>(read);
+            }
+            return true;
+        }
+
+        bool WriteAll(const void* data, size_t size) override
+        {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            while (size > 0)
+            {
+#if defined(_WIN32)
+                DWORD written = 0;
+                DWORD request = static_cast<DWORD>(size < (1u << 30) ? size : (1u << 30));
+                if (!WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), p, request, &written, nullptr) || written == 0) return false;
+#else
+                ssize_t written = ::write(1, p, size);
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0) return false;
+#endif
+                p += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+    };
+
+#if defined(_WIN32)
+    using SocketHandle = SOCKET;
+    constexpr SocketHandle IMDL_INVALID_SOCKET = INVALID_SOCKET;
+#else
+    using SocketHandle = int;
+    constexpr SocketHandle IMDL_INVALID_SOCKET = -1;
+#endif
+
+    // ソケットの関数を使えるようにする関数（Windows は WSAStartup が必要）
+    inline bool InitializeSockets()
+    {
+#if defined(_WIN32)
+        static const bool initialized = []()
+            {
+                WSADATA data;
+                return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+            }();
+        return initialized;
+#else
+        return true;
+#endif
+    }
+
+    // ソケットを閉じる関数
+    inline void CloseSocket(SocketHandle socket)
+    {
+#if defined(_WIN32)
+        closesocket(socket);
+#else
+        ::close(socket);
+#endif
+    }
+
+    // ソケットのアドレスを作成する関数（パスが長すぎる場合は false）
+    inline bool MakeLocalSocketAddress(const std::filesystem::path& path, sockaddr_un& address)
+    {
+        std::string name = path.u8string();
+
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (name.empty() || name.size() >= sizeof(address.sun_path)) return false;
+
+        std::memcpy(address.sun_path, name.c_str(), name.size());
+        return true;
+    }
+
+    // ソケット
+    class SocketFrameStream : public FrameStream
+    {
+    public:
+
+        explicit SocketFrameStream(SocketHandle socket)
+            : m_socket(socket)
+        {
+        }
+
+        ~SocketFrameStream() override
+        {
+            CloseSocket(m_socket);
+        }
+
+        void Close() override
+        {
+#if defined(_WIN32)
+            shutdown(m_socket, SD_BOTH);
+#else
+            shutdown(m_socket, SHUT_RDWR);
+#endif
+        }
+
+    protected:
+
+        bool ReadAll(void* data, size_t size) override
+        {
+            char* p = static_cast<char*>(data);
+            while (size > 0)
+            {
+                int request = static_cast<int>(size < (1u << 30) ? size : (1u << 30));
+                int read = recv(m_socket, p, request, 0);
+#if !defined(_WIN32)
+                if (read < 0 && errno == EINTR) continue;
+#endif
+                if (read <= 0) return false;
+
+                p += read;
+                size -= static_cast<size_t>(read);
+            }
+            return true;
+        }
+
+        bool WriteAll(const void* data, size_t size) override
+        {
+            const char* p = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                int request = static_cast<int>(size < (1u << 30) ? size : (1u << 30));
+#if defined(_WIN32)
+                int written = send(m_socket, p, request, 0);
+#else
+                // ※相手が切断した場合に SIGPIPE で終了しないようにする
+                int written = static_cast<int>(send(m_socket, p, static_cast<size_t>(request), MSG_NOSIGNAL));
+                if (written < 0 && errno == EINTR) continue;
+#endif
+                if (written <= 0) return false;
+
+                p += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+
+    private:
+
+        SocketHandle m_socket;
+    };
+
+    // ローカルのソケットで接続を待つクラス
+    class LocalSocketListener
+    {
+    public:
+
+        LocalSocketListener() = default;
+
+        ~LocalSocketListener()
+        {
+            Close();
+        }
+
+        LocalSocketListener(const LocalSocketListener&) = delete;
+        LocalSocketListener& operator=(const LocalSocketListener&) = delete;
+
+        // 接続の待ち受けを開始する関数
+        // ※前回異常終了して残ったソケットのファイルは削除する
+        bool Listen(const std::filesystem::path& path)
+        {
+            sockaddr_un address;
+            if (!InitializeSockets() || !MakeLocalSocketAddress(path, address)) return false;
+
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+
+            SocketHandle server = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (server == IMDL_INVALID_SOCKET) return false;
+
+            if (bind(server, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(server, SOMAXCONN) != 0)
+            {
+                CloseSocket(server);
+                return false;
+            }
+
+            m_path = path;
+            m_socket = server;
+            return true;
+        }
+
+        // 接続を受け付ける関数（Close された場合は nullptr）
+        std::shared_ptr<FrameStream> Accept()
+        {
+            for (;;)
+            {
+                SocketHandle socket = m_socket;
+                if (socket == IMDL_INVALID_SOCKET) return nullptr;
+
+                SocketHandle client = accept(socket, nullptr, nullptr);
+                if (client != IMDL_INVALID_SOCKET) return std::make_shared<SocketFrameStream>(client);
+
+#if !defined(_WIN32)
+                if (errno == EINTR) continue;
+#endif
+                return nullptr;
+            }
+        }
+
+        // 待ち受けを終了する関数（Accept で待っているスレッドを戻す）
+        void Close()
+        {
+            SocketHandle socket = m_socket.exchange(IMDL_INVALID_SOCKET);
+            if (socket == IMDL_INVALID_SOCKET) return;
+
+#if defined(_WIN32)
+            closesocket(socket);
+#else
+            shutdown(socket, SHUT_RDWR);
+            ::close(socket);
+#endif
+
+            std::error_code ec;
+            std::filesystem::remove(m_path, ec);
+        }
+
+    private:
+
+        std::atomic<SocketHandle> m_socket{ IMDL_INVALID_SOCKET };
+        std::filesystem::path m_path;
+    };
+
+    // ローカルのソケットに接続する関数（失敗した場合は nullptr）
+    inline std::shared_ptr<FrameStream> ConnectLocalSocket(const std::filesystem::path& path)
+    {
+        sockaddr_un address;
+        if (!InitializeSockets() || !MakeLocalSocketAddress(path, address)) return nullptr;
+
+        SocketHandle client = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (client == IMDL_INVALID_SOCKET) return nullptr;
+
+        if (connect(client, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            CloseSocket(client);
+            return nullptr;
+        }
+
+        return std::make_shared<SocketFrameStream>(client);
+    }
+}
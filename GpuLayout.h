@@ -0,0 +1,169 @@
+﻿//--------------------------------------------------------------------------------------
+// File: GpuLayout.h
+//
+// テクスチャを GPU へ直接アップロードできる配置で書き込む関数
+//
+// ※各行を 256byte、各サブリソースを 512byte 境界に配置し、フットプリントを事前に計算しておく
+//   読み込み側は行ごとに詰め直す必要がなく、チャンクをそのままアップロードバッファにコピーできる
+// ※ブロック圧縮形式のフットプリントの幅、高さはブロックの倍数に切り上げる
+//   （GetCopyableFootprints と同じ。4x4 より小さいミップも CopyTextureRegion でそのままコピーできる）
+//
+// Date: 2026.3.9
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Imdl.h"
+
+namespace Imase
+{
+    // ブロック圧縮形式のブロックの幅、高さを取得する関数（ブロック圧縮形式以外は 1）
+    // ※DXGI_FORMAT の値で判定する（BC1～BC5 : 70～84、BC6H、BC7 : 94～99）
+    inline uint32_t GetGpuFormatBlockSize(uint32_t format)
+    {
+        return (format >= 70 && format <= 84) || (format >= 94 && format <= 99) ? 4 : 1;
+    }
+
+    // Vulkan の VkBufferImageCopy の bufferRowLength（テクセル数）を取得する関数
+    // ※行ピッチをテクセル数にしたもの（ブロック圧縮形式はブロックの倍数になる）
+    // ※bufferImageHeight はフットプリントの高さ（ブロック圧縮形式は numRows * 4）
+    // ※行ピッチがブロック（テクセル）のサイズで割り切れない形式（R32G32B32 など）は 0（行ピッチを表せない）
+    inline uint32_t GetGpuBufferRowLength(const GpuSubresourceFootprint& footprint)
+    {
+        uint32_t block = GetGpuFormatBlockSize(footprint.format);
+        uint64_t blocksPerRow = footprint.width / block;
+        if (blocksPerRow == 0 || footprint.rowSize % blocksPerRow != 0) return 0;
+
+        uint64_t blockBytes = footprint.rowSize / blocksPerRow;
+        if (blockBytes == 0 || footprint.rowPitch % blockBytes != 0) return 0;
+
+        return static_cast<uint32_t>(footprint.rowPitch / blockBytes * block);
+    }
+
+    // サブリソースの元データ
+    struct GpuSubresourceSource
+    {
+        const uint8_t* data;    // 先頭
+        uint32_t width;         // ミップの幅（フットプリントではブロックの倍数に切り上げる）
+        uint32_t height;        // ミップの高さ（フットプリントではブロックの倍数に切り上げる）
+        uint32_t depth;
+        uint32_t numRows;       // 行数（ブロック圧縮の場合はブロックの行数）
+        size_t rowSize;         // 各行のデータサイズ
+        size_t rowPitch;        // 元データの行ピッチ
+        size_t slicePitch;      // 元データのスライスピッチ
+    };
+
+    // テクスチャの元データ
+    // ※desc の firstSubresource、subresourceCount、dataOffset、dataSize は配置の計算で設定する
+    struct GpuTextureSource
+    {
+        GpuTextureDesc desc;
+        std::vector<GpuSubresourceSource> subresources; // D3D12 と同じ順番（mip + arraySlice * mipLevels）
+    };
+
+    // テクスチャチャンクの配置
+    struct GpuTextureLayout
+    {
+        GpuTextureChunkHeader header;
+        std::vector<GpuTextureDesc> descs;
+        std::vector<GpuSubresourceFootprint> footprints;
+        uint64_t size;          // チャンクのサイズ
+    };
+
+    // テクスチャチャンクの配置を計算する関数
+    inline GpuTextureLayout ComputeGpuTextureLayout(const std::vector<GpuTextureSource>& textures)
+    {
+        GpuTextureLayout layout{};
+
+        size_t subresourceCount = 0;
+        for (const auto& texture : textures)
+        {
+            subresourceCount += texture.subresources.size();
+        }
+
+        layout.header.textureCount = static_cast<uint32_t>(textures.size());
+        layout.header.subresourceCount = static_cast<uint32_t>(subresourceCount);
+
+        uint64_t pos = sizeof(GpuTextureChunkHeader)
+            + sizeof(GpuTextureDesc) * textures.size()
+            + sizeof(GpuSubresourceFootprint) * subresourceCount;
+
+        pos = AlignUp(pos, IMDL_GPU_SUBRESOURCE_ALIGNMENT);
+        layout.header.dataOffset = pos;
+
+        for (const auto& texture : textures)
+        {
+            GpuTextureDesc desc = texture.desc;
+            desc.firstSubresource = static_cast<uint32_t>(layout.footprints.size());
+            desc.subresourceCount = static_cast<uint32_t>(texture.subresources.size());
+            desc.dataOffset = pos;
+
+            // ブロック圧縮形式は幅、高さをブロックの倍数にする（2x2、1x1 のミップも 4x4）
+            uint32_t block = GetGpuFormatBlockSize(desc.format);
+
+            for (const auto& sub : texture.subresources)
+            {
+                GpuSubresourceFootprint footprint{};
+                footprint.offset = AlignUp(pos, IMDL_GPU_SUBRESOURCE_ALIGNMENT);
+                footprint.format = desc.format;
+                footprint.width = static_cast<uint32_t>(AlignUp(sub.width, block));
+                footprint.height = static_cast<uint32_t>(AlignUp(sub.height, block));
+                footprint.depth = sub.depth;
+                footprint.rowPitch = static_cast<uint32_t>(AlignUp(sub.rowSize, IMDL_GPU_ROW_PITCH_ALIGNMENT));
+                footprint.numRows = sub.numRows;
+                footprint.rowSize = sub.rowSize;
+
+                layout.footprints.push_back(footprint);
+                pos = footprint.offset + static_cast<uint64_t>(footprint.rowPitch) * footprint.numRows * footprint.depth;
+            }
+
+            desc.dataSize = pos - desc.dataOffset;
+            layout.descs.push_back(desc);
+        }
+
+        layout.size = pos;
+
+        return layout;
+    }
+
+    // テクスチャチャンクを書き込む関数
+    // ※layout は ComputeGpuTextureLayout で計算したもの
+    template<typename Writer>
+    void WriteGpuTextureChunk(Writer& writer, const std::vector<GpuTextureSource>& textures, const GpuTextureLayout& layout)
+    {
+        writer.WriteValue(layout.header);
+        writer.WriteArray(layout.descs.data(), layout.descs.size());
+        writer.WriteArray(layout.footprints.data(), layout.footprints.size());
+
+        uint64_t pos = sizeof(GpuTextureChunkHeader)
+            + sizeof(GpuTextureDesc) * layout.descs.size()
+            + sizeof(GpuSubresourceFootprint) * layout.footprints.size();
+
+        size_t index = 0;
+        for (const auto& texture : textures)
+        {
+            for (const auto& sub : texture.subresources)
+            {
+                const GpuSubresourceFootprint& footprint = layout.footprints[index++];
+
+                // サブリソースの境界まで埋める
+                writer.WritePadding(static_cast<size_t>(footprint.offset - pos));
+                pos = footprint.offset;
+
+                // 行ごとに行ピッチの境界まで埋めながら書き込む
+                for (uint32_t z = 0; z < sub.depth; z++)
+                {
+                    const uint8_t* slice = sub.data + sub.slicePitch * z;
+                    for (uint32_t y = 0; y < sub.numRows; y++)
+                    {
+                        writer.WriteBytes(slice + sub.rowPitch * y, sub.rowSize);
+                        writer.WritePadding(footprint.rowPitch - sub.rowSize);
+                    }
+                }
+                pos += static_cast<uint64_t>(footprint.rowPitch) * footprint.numRows * footprint.depth;
+            }
+        }
+    }
+}
@@ -9,6 +9,8 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
+#include <type_traits>
 #include <DirectXMath.h>
 
 namespace Imase
@@ -50,6 +52,16 @@ namespace Imase
         DirectX::XMFLOAT4 tangent;     // xyz = ڐ, w = ]ڐ̌𒲐i1,-1)
     };
 
+    // -------------------------------------------------------------------------------------- //
+    // t@C̃CAEgƃ̃CAEgvĂ邱Ƃ̊mF
+    // vĂ̂Ŕẑ܂܏݁^ǂݍ݂ł
+    static_assert(std::is_trivially_copyable_v<MaterialInfo>, "MaterialInfo must be trivially copyable.");
+    static_assert(std::is_trivially_copyable_v<MeshInfo>, "MeshInfo must be trivially copyable.");
+    static_assert(std::is_trivially_copyable_v<VertexPositionNormalTextureTangent>, "Vertex must be trivially copyable.");
+    static_assert(sizeof(MaterialInfo) == sizeof(float) * 9 + sizeof(int32_t) * 4, "MaterialInfo must not contain padding.");
+    static_assert(sizeof(MeshInfo) == sizeof(uint32_t) * 3, "MeshInfo must not contain padding.");
+    static_assert(sizeof(VertexPositionNormalTextureTangent) == sizeof(float) * 12, "Vertex must not contain padding.");
+
     // -------------------------------------------------------------------------------------- //
     // wb_
     struct FileHeader
@@ -59,6 +71,165 @@ namespace Imase
         uint32_t chunkCount;
     };
 
+    // wb_io[WQj
+    // 擪̂R FileHeader ƓȂ̂ FileHeader ǂ version Ŕł
+    // wb_̒Ƀ`Ne[uiChunkEntry * chunkCountj
+    // flags  IMDL_FILE_FLAG_LARGE Ăꍇ ChunkEntry64 * chunkCount
+    struct FileHeaderV2
+    {
+        uint32_t magic;      // 'IMDL'
+        uint32_t version;    // 2
+        uint32_t chunkCount;
+        uint32_t alignment;  // f[^̃ACgiQׂ̂j
+        uint32_t flags;      // t@CtOiIMDL_FILE_FLAG_XXXj
+        uint32_t reserved;   // \i0j
+    };
+
+    // `Ne[u̗vfio[WQj
+    struct ChunkEntry
+    {
+        uint32_t type;       // `N^Cv
+        uint32_t flags;      // `NtOiIMDL_CHUNK_FLAG_XXXj
+        uint32_t offset;     // t@C擪̃f[^ʒuialignment ̔{j
+        uint32_t size;       // f[^TCY
+    };
+
+    // `Ne[u̗vfio[WQA4GB pj
+    struct ChunkEntry64
+    {
+        uint32_t type;       // `N^Cv
+        uint32_t flags;      // `NtOiIMDL_CHUNK_FLAG_XXXj
+        uint64_t offset;     // t@C擪̃f[^ʒuialignment ̔{j
+        uint64_t size;       // f[^TCY
+    };
+
+    // t@CtO
+    // IMDL_FILE_FLAG_LARGE    : 4GB pi`Ne[uAeNX`̃TCYƌ 64bit ŋL^j
+    // IMDL_FILE_FLAG_CHECKSUM : `FbNT`NiCHUNK_CHECKSUMj
+    constexpr uint32_t IMDL_FILE_FLAG_LARGE = 0x00000001;
+    constexpr uint32_t IMDL_FILE_FLAG_CHECKSUM = 0x00000002;
+
+    // `NtO
+    // ʂSbit : k`iCompressionTypej
+    // IMDL_CHUNK_FLAG_GPU_LAYOUT : GPU ֒ڃAbv[hłzuieNX``N̂݁AkȂj
+    constexpr uint32_t IMDL_CHUNK_FLAG_COMPRESSION_MASK = 0x0000000F;
+    constexpr uint32_t IMDL_CHUNK_FLAG_GPU_LAYOUT = 0x00000010;
+
+    // k`
+    enum CompressionType : uint32_t
+    {
+        COMPRESSION_NONE = 0,
+        COMPRESSION_LZ4 = 1,
+        COMPRESSION_ZSTD = 2
+    };
+
+    // kꂽ`Nf[^̐擪
+    // ̌ uint32_t blockSizes[blockCount]ik̊eubÑTCYjAkf[^
+    // eubN͓ƗēWJłiWJ̃TCY͍Ō̃ubNȊO blockSizej
+    struct CompressedChunkHeader
+    {
+        uint64_t rawSize;    // WJ̃TCY
+        uint32_t blockSize;  // WJ̃ubÑTCY
+        uint32_t blockCount; // ubN
+    };
+
+    // -------------------------------------------------------------------------------------- //
+    // GPU Abv[hp̔zuiIMDL_CHUNK_FLAG_GPU_LAYOUTj
+    //
+    // GpuTextureChunkHeader
+    // GpuTextureDesc[textureCount]
+    // GpuSubresourceFootprint[subresourceCount]
+    // eNX`f[^idataOffset AeTu\[X 512byte EAes 256byte Ej
+    //
+    // ʒuׂ͂ă`N擪̃ItZbg
+    // `NŜAbv[hobt@ɃRs[i܂̓}bvj΁A
+    //   tbgvĝ܂ CopyTextureRegion / vkCmdCopyBufferToImage ɓn
+    // ubNk`̃tbgvg̕A̓ubNi4 eNZj̔{ɂi2x2A1x1 ̃~bv 4x4j
+    //   Vulkan  bufferRowLengthAbufferImageHeight  GetGpuBufferRowLengthAŋ߂iGpuLayout.hj
+
+    // ssb`̃ACgiD3D12_TEXTURE_DATA_PITCH_ALIGNMENTj
+    constexpr uint32_t IMDL_GPU_ROW_PITCH_ALIGNMENT = 256;
+
+    // Tu\[X̔zuACgiD3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENTj
+    constexpr uint32_t IMDL_GPU_SUBRESOURCE_ALIGNMENT = 512;
+
+    // obt@̔zuACgiD3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENTj
+    constexpr uint32_t IMDL_GPU_PLACEMENT_ALIGNMENT = 65536;
+
+    // eNX`tO
+    constexpr uint32_t IMDL_GPU_TEXTURE_FLAG_CUBE = 0x00000001;
+
+    struct GpuTextureChunkHeader
+    {
+        uint32_t textureCount;      // eNX`
+        uint32_t subresourceCount;  // SeNX`̃Tu\[X
+        uint64_t dataOffset;        // eNX`f[^̐擪ʒu
+    };
+
+    struct GpuTextureDesc
+    {
+        uint32_t type;              // TextureType
+        uint32_t format;            // DXGI_FORMAT
+        uint32_t dimension;         // D3D12_RESOURCE_DIMENSIONi2:1D 3:2D 4:3Dj
+        uint32_t flags;             // IMDL_GPU_TEXTURE_FLAG_XXX
+        uint32_t width;
+        uint32_t height;
+        uint32_t depth;
+        uint32_t arraySize;
+        uint32_t mipLevels;
+        uint32_t firstSubresource;  // tbgvge[u̐擪ԍ
+        uint32_t subresourceCount;  // Tu\[XimipLevels * arraySizej
+        uint32_t reserved;
+        uint64_t dataOffset;        // f[^̐擪ʒu
+        uint64_t dataSize;          // f[^TCYipfBO܂ށj
+    };
+
+    // Tu\[X̃tbgvgiD3D12_PLACED_SUBRESOURCE_FOOTPRINT + sAsTCYj
+    // Tu\[X̏Ԃ D3D12 Ɠimip + arraySlice * mipLevelsj
+    struct GpuSubresourceFootprint
+    {
+        uint64_t offset;            // f[^ʒui512 ̔{j
+        uint32_t format;            // DXGI_FORMAT
+        uint32_t width;             // iubNk`̓ubN̔{j
+        uint32_t height;            // iubNk`̓ubN̔{j
+        uint32_t depth;
+        uint32_t rowPitch;          // ssb`i256 ̔{j
+        uint32_t numRows;           // siubNk̏ꍇ̓ubN̍sj
+        uint64_t rowSize;           // es̗Lȃf[^TCY
+    };
+
+    // `FbNT`Ñf[^
+    // ̌ uint32_t chunkCrcs[chunkCount]i`Ne[ȕA`FbNT`Ng 0j
+    // `FbNT CRC32CA`N͋L^Ăf[^ikĵ܂܌vZ
+    struct ChecksumChunkHeader
+    {
+        uint32_t tableCrc;   // wb_ƃ`Ne[u CRC32C
+        uint32_t chunkCount; // `N
+    };
+
+    // t@Cʎqƃo[W
+    constexpr uint32_t IMDL_MAGIC = 'IMDL';
+    constexpr uint32_t IMDL_VERSION_1 = 1;
+    constexpr uint32_t IMDL_VERSION_2 = 2;
+
+    // f[^̃ACg̊l
+    constexpr uint32_t IMDL_DEFAULT_ALIGNMENT = 64;
+
+    // w苫Eɐ؂グ֐ialignment ͂Qׂ̂j
+    inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    static_assert(sizeof(FileHeaderV2) == 24, "FileHeaderV2 must not contain padding.");
+    static_assert(sizeof(ChunkEntry) == 16, "ChunkEntry must not contain padding.");
+    static_assert(sizeof(ChunkEntry64) == 24, "ChunkEntry64 must not contain padding.");
+    static_assert(sizeof(CompressedChunkHeader) == 16, "CompressedChunkHeader must not contain padding.");
+    static_assert(sizeof(ChecksumChunkHeader) == 8, "ChecksumChunkHeader must not contain padding.");
+    static_assert(sizeof(GpuTextureChunkHeader) == 16, "GpuTextureChunkHeader must not contain padding.");
+    static_assert(sizeof(GpuTextureDesc) == 64, "GpuTextureDesc must not contain padding.");
+    static_assert(sizeof(GpuSubresourceFootprint) == 40, "GpuSubresourceFootprint must not contain padding.");
+
     // `N^Cv
     enum ChunkType : uint32_t
     {
@@ -66,7 +237,8 @@ namespace Imase
         CHUNK_MATERIAL = 'MTRL',
         CHUNK_MESH = 'MESH',
         CHUNK_VERTEX = 'VERT',
-        CHUNK_INDEX = 'INDX'
+        CHUNK_INDEX = 'INDX',
+        CHUNK_CHECKSUM = 'CSUM'
     };
 
     // eNX`^Cv
@@ -0,0 +1,1778 @@
+﻿//--------------------------------------------------------------------------------------
+// File: ImdlConverter.cpp
+//
+// obj 形式のモデルデータを独自形式のモデルデータ(.imdl)に変換するライブラリ
+//
+// Date: 2026.3.12
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#include "ImdlConverter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#if defined(_WIN32)
+#include <windows.h>
+#include <d3d11.h>
+#endif
+#include "DirectXTex.h"
+#if __has_include(<png.h>)
+#include <png.h>
+#define IMDL_HAS_LIBPNG 1
+#if defined(_MSC_VER)
+#pragma comment(lib, "libpng16.lib")
+#endif
+#else
+#define IMDL_HAS_LIBPNG 0
+#endif
+#include "Benchmark.h"
+#include "GpuLayout.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+using namespace DirectX;
+
+namespace Imase
+{
+    // メモリ上のテキストを std::istream で読むためのバッファ（コピーしない）
+    class MemoryStreamBuf : public std::streambuf
+    {
+    public:
+
+        explicit MemoryStreamBuf(std::string_view text)
+        {
+            char* p = const_cast<char*>(text.data());
+            setg(p, p, p + text.size());
+        }
+    };
+
+    // ファイルから読み込む関数（XMFLOAT2）
+    static XMFLOAT2 ReadFloat2(std::istringstream& iss)
+    {
+        XMFLOAT2 val = {};
+        iss >> val.x >> val.y;
+        return val;
+    }
+
+    // ファイルから読み込む関数（XMFLOAT3）
+    static XMFLOAT3 ReadFloat3(std::istringstream& iss)
+    {
+        XMFLOAT3 val = {};
+        iss >> val.x >> val.y >> val.z;
+        return val;
+    }
+
+    // 面の各頂点を構成するインデックス取得関数
+    static std::vector<FaceIndex> ParseFaceLine(const std::string& line, const ObjModel& model)
+    {
+        auto fixIndex = [&](int raw, int size) {
+            if (raw > 0)  return raw - 1;
+            if (raw < 0)  return size + raw;
+            throw std::runtime_error("OBJ index cannot be zero");
+        };
+
+        std::istringstream iss(line);
+
+        std::string type;
+        iss >> type; // "f"
+
+        std::vector<FaceIndex> result;
+
+        std::string token;
+        while (iss >> token)
+        {
+            FaceIndex idx{ -1, -1, -1 };
+
+            std::istringstream tss(token);
+            std::string s;
+
+            // v
+            if (std::getline(tss, s, '/')) idx.v = fixIndex(std::stoi(s), static_cast<int>(model.positions.size()));
+
+            // vt
+            if (std::getline(tss, s, '/'))
+            {
+                if (!s.empty()) idx.vt = fixIndex(std::stoi(s), static_cast<int>(model.texcoords.size()));
+            }
+
+            // vn
+            if (std::getline(tss, s, '/'))
+            {
+                if (!s.empty()) idx.vn = fixIndex(std::stoi(s), static_cast<int>(model.normals.size()));
+            }
+
+            result.push_back(idx);
+        }
+
+        return result;
+    }
+
+    // obj のテキストを解析する関数
+    static bool ParseObjLines(std::istream& stream, ObjModel& model, std::string& error, const std::atomic<bool>* cancel)
+    {
+        std::vector<Face>* pFace = nullptr;
+        std::string object_name;
+        size_t lineCount = 0;
+
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            // 中止の確認（行ごとに確認すると遅くなるので 64K 行ごと）
+            if (cancel && (++lineCount & 0xffff) == 0 && *cancel)
+            {
+                error = "Cancelled";
+                return false;
+            }
+
+            // 空行やコメントをスキップ
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            std::istringstream iss(line);
+
+            // 先頭のトークン
+            std::string type;
+            iss >> type;
+
+            // オブジェクト名
+            if (type == "o")
+            {
+                iss >> object_name;
+                model.meshes.emplace_back();
+                pFace = nullptr;
+            }
+
+            // 頂点
+            if (type == "v")
+            {
+                model.positions.push_back(ReadFloat3(iss));
+            }
+
+            // 法線
+            else if (type == "vn")
+            {
+                model.normals.push_back(ReadFloat3(iss));
+            }
+
+            // テクスチャ座標
+            else if (type == "vt")
+            {
+                // BlenderのV座標は上が＋
+                XMFLOAT2 uv = ReadFloat2(iss);
+                uv.y = 1.0f - uv.y;
+                model.texcoords.push_back(uv);
+            }
+
+            // 面情報
+            else if (type == "f")
+            {
+                // マテリアルがない
+                if (pFace == nullptr)
+                {
+                    error = object_name + " has no material assigned.";
+                    return false;
+                }
+
+                // 面の各頂点を構成するインデックスを取得
+                std::vector<FaceIndex> result = ParseFaceLine(line, model);
+
+                // 四角形の場合は三角形２枚に置き換える
+                for (size_t i = 0; i + 2 < result.size(); i++)
+                {
+                    // 反時計回りが表
+                    Face face{ result[0], result[i + 1], result[i + 2] };
+                    pFace->push_back(face);
+                }
+            }
+
+            // マテリアル名
+            else if (type == "usemtl")
+            {
+                // "o" より前の usemtl はメッシュを追加する
+                if (model.meshes.empty()) model.meshes.emplace_back();
+
+                // メッシュを追加
+                model.meshes.back().subMeshs.emplace_back();
+
+                // マテリアル名
+                std::string material;
+                iss >> material;
+                model.meshes.back().subMeshs.back().material = material;
+
+                // 面を設定するポインタを更新
+                pFace = &model.meshes.back().subMeshs.back().faces;
+            }
+
+            // マテリアルファイル名
+            else if (type == "mtllib")
+            {
+                std::string name;
+                iss >> name;
+                // utf8 → path
+                model.mtllib = std::filesystem::u8path(name);
+            }
+        }
+
+        return true;
+    }
+
+    bool ParseObj(std::istream& stream, ObjModel& model, std::string& error, const std::atomic<bool>* cancel)
+    {
+        IMDL_TRACE_SCOPE("ParseObj");
+
+        try
+        {
+            return ParseObjLines(stream, model, error, cancel);
+        }
+        catch (const std::exception& e)
+        {
+            error = e.what();
+            return false;
+        }
+    }
+
+    bool ParseObjFile(const std::filesystem::path& path, ObjModel& model, std::string& error)
+    {
+        IMDL_TRACE_SCOPE_DETAIL("ParseObjFile", path.u8string());
+
+        // objファイルのオープン
+        std::ifstream ifs(path);
+
+        if (!ifs)
+        {
+            // ファイルのオープン失敗
+            error = "Could not open " + path.u8string();
+            return false;
+        }
+
+        return ParseObj(ifs, model, error);
+    }
+
+    bool FindObjMtllib(const std::filesystem::path& path, std::filesystem::path& mtllib, std::string& error)
+    {
+        IMDL_TRACE_SCOPE_DETAIL("FindObjMtllib", path.u8string());
+
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs)
+        {
+            error = "Could not open " + path.u8string();
+            return false;
+        }
+
+        std::ostringstream oss;
+        oss << ifs.rdbuf();
+        const std::string text = oss.str();
+
+        auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; };
+
+        // 行の先頭の単語が mtllib の行を探す（ParseObj と同じく最後の行を使う）
+        mtllib.clear();
+        const std::string keyword = "mtllib";
+        for (size_t pos = text.find(keyword); pos != std::string::npos; pos = text.find(keyword, pos + keyword.size()))
+        {
+            size_t begin = pos;
+            while (begin > 0 && isSpace(text[begin - 1])) begin--;
+            if (begin > 0 && text[begin - 1] != '\n') continue;
+
+            size_t p = pos + keyword.size();
+            if (p < text.size() && text[p] != '\n' && !isSpace(text[p])) continue;
+
+            while (p < text.size() && isSpace(text[p])) p++;
+            size_t end = p;
+            while (end < text.size() && text[end] != '\n' && !isSpace(text[end])) end++;
+            mtllib = std::filesystem::u8path(text.substr(p, end - p));
+        }
+
+        return true;
+    }
+
+    // テクスチャタイプによる変換ファイルフォーマットを取得する関数
+    static DXGI_FORMAT GetFormat(TextureType type)
+    {
+        switch (type)
+        {
+        case TextureType::BaseColor:
+            return DXGI_FORMAT_BC7_UNORM_SRGB;
+
+        case TextureType::Normal:
+            return DXGI_FORMAT_BC5_UNORM;
+
+        case TextureType::MetalRough:
+            return DXGI_FORMAT_BC1_UNORM;
+
+        case TextureType::Emissive:
+            return DXGI_FORMAT_BC7_UNORM_SRGB;
+
+        default:
+            return DXGI_FORMAT_BC7_UNORM;
+        }
+    }
+
+    // テクスチャデータをDDS形式にしてメモリに書き出す関数
+    // ※法線マップのみY要素を反転する（TexConvの-invertY相当）
+    // ※GPU圧縮はデバイスのイミディエイトコンテキストを使うので gpuMutex で排他する
+    static HRESULT ConvertToDDSMemory(
+        const TextureEncodeOptions& options,
+        ScratchImage scratch,
+        TextureType type,
+        std::vector<uint8_t>& outDDS,
+        TextureEncodeStats* stats)
+    {
+        IMDL_TRACE_SCOPE("ConvertToDDSMemory");
+
+        HRESULT hr;
+        StageTimer timer;
+
+        // ----------------------------------
+        // 1. 法線マップのみY反転（TexConv.exeの-inverty相当）
+        // ----------------------------------
+        if (type == TextureType::Normal)
+        {
+            ScratchImage flipped;
+
+            auto invertY = [](XMVECTOR* outPixels, const XMVECTOR* inPixels, size_t width, size_t y) noexcept
+                {
+                    for (size_t x = 0; x < width; ++x)
+                    {
+                        XMVECTOR v = inPixels[x];
+
+                        // G成分反転
+                        v = XMVectorSetY(v, 1.0f - XMVectorGetY(v));
+
+                        outPixels[x] = v;
+                    }
+                };
+
+            hr = TransformImage(
+                scratch.GetImages(),
+                scratch.GetImageCount(),
+                scratch.GetMetadata(),
+                invertY,
+                flipped);
+
+            if (FAILED(hr))
+                return hr;
+
+            scratch = std::move(flipped);
+        }
+
+        // ----------------------------------
+        // 2. ミップ生成
+        // ----------------------------------
+        ScratchImage mipChain;
+
+        // ※CPU で圧縮する場合は WIC のフィルタを使わない（Windows 以外と同じ結果にする）
+        {
+            IMDL_TRACE_SCOPE("GenerateMipMaps");
+            hr = GenerateMipMaps(
+                scratch.GetImages(),
+                scratch.GetImageCount(),
+                scratch.GetMetadata(),
+                options.device ? TEX_FILTER_FANT : TEX_FILTER_FANT | TEX_FILTER_FORCE_NON_WIC,
+                0,
+                mipChain);
+        }
+
+        if (FAILED(hr))
+            return hr;
+
+        if (stats) stats->mips = timer.Lap();
+
+        // ----------------------------------
+        // 3. 圧縮（デバイスがあれば GPU）
+        // ----------------------------------
+        ScratchImage compressed;
+
+        DXGI_FORMAT format = GetFormat(type);
+#if defined(_WIN32)
+        if (type == TextureType::Normal || options.device == nullptr)
+#endif
+        {
+            IMDL_TRACE_SCOPE("Compress");
+            hr = Compress(
+                mipChain.GetImages(),
+                mipChain.GetImageCount(),
+                mipChain.GetMetadata(),
+                format,
+                options.device ? TEX_COMPRESS_DEFAULT : TEX_COMPRESS_PARALLEL,
+                TEX_THRESHOLD_DEFAULT,
+                compressed);
+        }
+#if defined(_WIN32)
+        else
+        {
+            // ※デバイスを待っている時間も含める（GPU の取り合いが見える）
+            IMDL_TRACE_SCOPE("Compress (GPU)");
+            std::unique_lock<std::mutex> lock;
+            if (options.gpuMutex) lock = std::unique_lock<std::mutex>(*options.gpuMutex);
+
+            hr = Compress(
+                options.device,
+                mipChain.GetImages(),
+                mipChain.GetImageCount(),
+                mipChain.GetMetadata(),
+                format,
+                TEX_COMPRESS_DEFAULT,
+                0.5f,
+                compressed);
+        }
+#endif
+
+        if (FAILED(hr))
+            return hr;
+
+        if (stats) stats->compress = timer.Lap();
+
+        // ----------------------------------
+        // 4. メモリ内にDDS生成
+        // ----------------------------------
+        Blob ddsBlob;
+
+        {
+            IMDL_TRACE_SCOPE("SaveToDDSMemory");
+            hr = SaveToDDSMemory(
+                compressed.GetImages(),
+                compressed.GetImageCount(),
+                compressed.GetMetadata(),
+                DDS_FLAGS_NONE,
+                ddsBlob);
+        }
+
+        if (FAILED(hr))
+            return hr;
+
+        // ----------------------------------
+        // 5. vector にコピー
+        // ----------------------------------
+        outDDS.resize(ddsBlob.GetBufferSize());
+        memcpy(outDDS.data(),
+            ddsBlob.GetBufferPointer(),
+            ddsBlob.GetBufferSize());
+
+        if (stats)
+        {
+            stats->save = timer.Lap();
+
+            const TexMetadata& metadata = compressed.GetMetadata();
+            stats->width = static_cast<uint32_t>(metadata.width);
+            stats->height = static_cast<uint32_t>(metadata.height);
+            stats->mipLevels = static_cast<uint32_t>(metadata.mipLevels);
+            stats->format = static_cast<uint32_t>(metadata.format);
+            stats->ddsBytes = outDDS.size();
+        }
+
+        return S_OK;
+    }
+
+#if IMDL_HAS_LIBPNG
+    // PNG を libpng で RGBA 8bit の画像として読み込む関数
+    static bool DecodePng(const uint8_t* data, size_t size, ScratchImage& image, std::string& error)
+    {
+        png_image png{};
+        png.version = PNG_IMAGE_VERSION;
+        if (!png_image_begin_read_from_memory(&png, data, size))
+        {
+            error = std::string("Could not read PNG (") + png.message + ")";
+            return false;
+        }
+
+        png.format = PNG_FORMAT_RGBA;
+        if (FAILED(image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, png.width, png.height, 1, 1)))
+        {
+            png_image_free(&png);
+            error = "Out of memory";
+            return false;
+        }
+
+        const Image* pixels = image.GetImage(0, 0, 0);
+        if (!png_image_finish_read(&png, nullptr, pixels->pixels, static_cast<png_int_32>(pixels->rowPitch), nullptr))
+        {
+            error = std::string("Could not read PNG (") + png.message + ")";
+            return false;
+        }
+
+        return true;
+    }
+#endif
+
+    // 画像ファイルの内容を読み込む関数
+    // ※DDS、HDR、TGA は DirectXTex、PNG は libpng（ない場合は WIC）、それ以外は WIC で読み込む
+    // ※portable の場合は PNG を RGBA 8bit で読み込む（どのプラットフォームでも同じピクセルになる）
+    // ※Windows 以外は WIC がないので、PNG は libpng がある場合のみ、JPEG などは読み込めない
+    static bool DecodeImage(const uint8_t* data, size_t size, bool portable, ScratchImage& image, std::string& error)
+    {
+        IMDL_TRACE_SCOPE("DecodeImage");
+
+        TexMetadata metadata;
+        HRESULT hr;
+
+        bool png = size >= 8 && memcmp(data, "\x89PNG\r\n\x1a\n", 8) == 0;
+
+        if (size >= 4 && memcmp(data, "DDS ", 4) == 0)
+        {
+            hr = LoadFromDDSMemory(data, size, DDS_FLAGS_NONE, &metadata, image);
+
+            // 圧縮済みの場合は展開する（ミップマップを作り直して圧縮し直す）
+            if (SUCCEEDED(hr) && IsCompressed(metadata.format))
+            {
+                ScratchImage decompressed;
+                hr = Decompress(image.GetImages(), image.GetImageCount(), metadata, DXGI_FORMAT_R8G8B8A8_UNORM, decompressed);
+                if (SUCCEEDED(hr)) image = std::move(decompressed);
+            }
+        }
+        else if (size >= 2 && memcmp(data, "#?", 2) == 0)
+        {
+            hr = LoadFromHDRMemory(data, size, &metadata, image);
+        }
+#if IMDL_HAS_LIBPNG
+        else if (png && portable)
+        {
+            return DecodePng(data, size, image, error);
+        }
+#endif
+        else
+        {
+#if defined(_WIN32)
+            WIC_FLAGS flags = portable ? WIC_FLAGS_FORCE_RGB | WIC_FLAGS_IGNORE_SRGB : WIC_FLAGS_NONE;
+            hr = LoadFromWICMemory(data, size, flags, &metadata, image);
+
+            // libpng と同じ形式にそろえる
+            if (SUCCEEDED(hr) && png && portable && metadata.format != DXGI_FORMAT_R8G8B8A8_UNORM)
+            {
+                ScratchImage converted;
+                hr = Convert(image.GetImages(), image.GetImageCount(), metadata, DXGI_FORMAT_R8G8B8A8_UNORM,
+                    TEX_FILTER_DEFAULT | TEX_FILTER_FORCE_NON_WIC, TEX_THRESHOLD_DEFAULT, converted);
+                if (SUCCEEDED(hr)) image = std::move(converted);
+            }
+
+            // TGA は識別子がないので WIC で読めなかったものを TGA として読む
+            if (FAILED(hr) && !png)
+            {
+                hr = LoadFromTGAMemory(data, size, TGA_FLAGS_NONE, &metadata, image);
+            }
+#else
+            if (png)
+            {
+                error = "PNG is not supported (built without libpng)";
+                return false;
+            }
+
+            hr = LoadFromTGAMemory(data, size, TGA_FLAGS_NONE, &metadata, image);
+            if (FAILED(hr))
+            {
+                error = "Unsupported image format (only PNG, DDS, HDR and TGA can be read on this platform)";
+                return false;
+            }
+#endif
+        }
+
+        if (FAILED(hr))
+        {
+            char code[16];
+            std::snprintf(code, sizeof(code), "%08X", static_cast<unsigned>(hr));
+            error = std::string("Could not read texture (HRESULT 0x") + code + ")";
+            return false;
+        }
+
+        return true;
+    }
+
+    bool EncodeTexture(const uint8_t* data, size_t size, TextureType type, const TextureEncodeOptions& options,
+        std::vector<uint8_t>& dds, std::string& error, TextureEncodeStats* stats)
+    {
+        IMDL_TRACE_SCOPE("EncodeTexture");
+
+#if defined(_WIN32)
+        // WIC を使うので COM を初期化する（初期化済みのスレッドでは何もしない）
+        HRESULT co = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+
+        StageTimer timer;
+        ScratchImage image;
+        bool decoded = DecodeImage(data, size, options.device == nullptr, image, error);
+        if (stats)
+        {
+            stats->inputBytes = size;
+            stats->decode = timer.Elapsed();
+        }
+
+        // DDSへ変換
+        HRESULT hr = S_OK;
+        if (decoded)
+        {
+            hr = ConvertToDDSMemory(options, std::move(image), type, dds, stats);
+        }
+
+#if defined(_WIN32)
+        if (SUCCEEDED(co)) CoUninitialize();
+#endif
+
+        if (!decoded || FAILED(hr))
+        {
+            dds.clear();
+            if (decoded)
+            {
+                char code[16];
+                std::snprintf(code, sizeof(code), "%08X", static_cast<unsigned>(hr));
+                error = std::string("Could not convert texture (HRESULT 0x") + code + ")";
+            }
+            return false;
+        }
+
+        return true;
+    }
+
+    // ファイルを読み込む関数
+    static bool ReadFileData(const std::filesystem::path& path, std::vector<uint8_t>& data)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs) return false;
+
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(path, ec);
+        if (ec) return false;
+
+        data.resize(static_cast<size_t>(size));
+        ifs.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        return static_cast<uint64_t>(ifs.gcount()) == size;
+    }
+
+    bool EncodeTextureFile(const std::filesystem::path& path, TextureType type, const TextureEncodeOptions& options,
+        std::vector<uint8_t>& dds, std::string& error, TextureEncodeStats* stats)
+    {
+        IMDL_TRACE_SCOPE_DETAIL("EncodeTextureFile", path.u8string());
+
+        StageTimer timer;
+        std::vector<uint8_t> data;
+        if (!ReadFileData(path, data))
+        {
+            error = "Could not open " + path.u8string();
+            return false;
+        }
+        StageTime read = timer.Elapsed();
+
+        bool encoded = EncodeTexture(data.data(), data.size(), type, options, dds, error, stats);
+        if (stats) stats->read = read;
+        return encoded;
+    }
+
+    // テクスチャを登録する関数
+    // ※変換は EncodeTexture で行う（読み込みと変換に時間がかかるので、登録と分けて並列に処理できるようにする）
+    static int RegisterTexture(
+        const std::filesystem::path& path,
+        TextureType type,
+        std::vector<TextureRequest>& textures,
+        std::map<std::pair<std::string, TextureType>, int>& textureIndexMap)
+    {
+        IMDL_TRACE_SCOPE("RegisterTexture");
+
+        auto key = std::make_pair(path.u8string(), type);
+
+        // 既に登録済み？
+        auto it = textureIndexMap.find(key);
+        if (it != textureIndexMap.end())
+        {
+            return it->second;
+        }
+
+        int newIndex = (int)textures.size();
+
+        textures.push_back({ path, type });
+        textureIndexMap[key] = newIndex;
+
+        return newIndex;
+    }
+
+    // マテリアルのテクスチャ番号を並べ直す関数
+    static void RemapMaterialTextures(std::vector<MaterialInfo>& materials, const std::vector<int>& remap)
+    {
+        auto resolve = [&remap](int& index)
+            {
+                if (index >= 0) index = remap[index];
+            };
+
+        for (auto& material : materials)
+        {
+            resolve(material.baseColorTexIndex);
+            resolve(material.normalTexIndex);
+            resolve(material.metalRoughTexIndex);
+            resolve(material.emissiveTexIndex);
+        }
+    }
+
+    void SortTextureRequests(std::vector<MaterialInfo>& materials, std::vector<TextureRequest>& textures)
+    {
+        // 並べ替えの順番（同じ名前は種類の順）
+        std::vector<std::pair<std::string, size_t>> order;
+        order.reserve(textures.size());
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            order.emplace_back(textures[i].path.generic_u8string(), i);
+        }
+        std::sort(order.begin(), order.end(), [&textures](const auto& a, const auto& b)
+            {
+                if (a.first != b.first) return a.first < b.first;
+                return textures[a.second].type < textures[b.second].type;
+            });
+
+        std::vector<int> remap(textures.size());
+        std::vector<TextureRequest> sorted;
+        sorted.reserve(textures.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            remap[order[i].second] = static_cast<int>(i);
+            sorted.push_back(std::move(textures[order[i].second]));
+        }
+
+        textures = std::move(sorted);
+        RemapMaterialTextures(materials, remap);
+    }
+
+    void ResolveTextures(
+        std::vector<MaterialInfo>& materials,
+        std::vector<TextureEntry>& encoded,
+        std::vector<TextureEntry>& textures)
+    {
+        std::vector<int> remap(encoded.size(), -1);
+        for (size_t i = 0; i < encoded.size(); i++)
+        {
+            if (encoded[i].data.empty()) continue;
+
+            remap[i] = static_cast<int>(textures.size());
+            textures.push_back(std::move(encoded[i]));
+        }
+
+        RemapMaterialTextures(materials, remap);
+    }
+
+    void ResolveTextures(
+        std::vector<MaterialInfo>& materials,
+        std::vector<TextureEntry>& encoded,
+        std::vector<SpilledTexture>& encodedSpills,
+        ModelData& model)
+    {
+        std::vector<int> remap(encoded.size(), -1);
+        for (size_t i = 0; i < encoded.size(); i++)
+        {
+            bool spilled = i < encodedSpills.size() && !encodedSpills[i].path.empty();
+            if (encoded[i].data.empty() && !spilled) continue;
+
+            remap[i] = static_cast<int>(model.textures.size());
+            model.textures.push_back(std::move(encoded[i]));
+            model.spilled.push_back(spilled ? encodedSpills[i] : SpilledTexture());
+        }
+
+        RemapMaterialTextures(materials, remap);
+    }
+
+    bool SpillTexture(TextureEntry& texture, const std::filesystem::path& path, SpilledTexture& spilled, std::string& error)
+    {
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            ofs.write(reinterpret_cast<const char*>(texture.data.data()), static_cast<std::streamsize>(texture.data.size()));
+            if (!ofs)
+            {
+                ofs.close();
+                std::error_code ec;
+                std::filesystem::remove(path, ec);
+                error = "Could not write " + path.u8string();
+                return false;
+            }
+        }
+
+        spilled.path = path;
+        spilled.size = texture.data.size();
+        texture.data = {};
+        return true;
+    }
+
+    void RemoveSpilledTextures(std::vector<SpilledTexture>& spilled)
+    {
+        for (auto& texture : spilled)
+        {
+            if (texture.path.empty()) continue;
+
+            std::error_code ec;
+            std::filesystem::remove(texture.path, ec);
+            texture.path.clear();
+        }
+    }
+
+    // テクスチャのデータを取得する関数（退避したテクスチャは一時ファイルから読み込む）
+    static bool LoadTextureData(const ModelData& model, size_t index, std::vector<uint8_t>& loaded, const std::vector<uint8_t>*& data)
+    {
+        if (index >= model.spilled.size() || model.spilled[index].path.empty())
+        {
+            data = &model.textures[index].data;
+            return true;
+        }
+
+        data = &loaded;
+        return ReadFileData(model.spilled[index].path, loaded) && loaded.size() == model.spilled[index].size;
+    }
+
+    // テクスチャファイル名の取得関数（オプションなどは除去）
+    static std::string ExtractTextureFilename(std::istringstream& iss)
+    {
+        std::string rest;
+        std::getline(iss >> std::ws, rest);
+
+        // オプション除去
+        std::istringstream optStream(rest);
+        std::string token;
+        std::string filename;
+
+        while (optStream >> token)
+        {
+            if (token[0] == '-')
+            {
+                optStream >> token; // オプション値をスキップ
+            }
+            else
+            {
+                filename = token;
+                std::string remain;
+                std::getline(optStream, remain);
+                filename += remain;
+                break;
+            }
+        }
+
+        // 先頭のタブを除去
+        filename.erase(0, filename.find_first_not_of(" \t"));
+
+        return filename;
+    }
+
+    bool ParseMtl(std::istream& stream,
+        std::vector<MaterialInfo>& materials,
+        std::unordered_map<std::string, uint32_t>& materialIndexMap,
+        std::vector<TextureRequest>& textures,
+        std::string& error)
+    {
+        IMDL_TRACE_SCOPE("ParseMtl");
+
+        // テクスチャ登録位置を保存するコンテナ
+        std::map<std::pair<std::string, TextureType>, int> textureIndexMap;
+
+        uint32_t m_index = 0;
+
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            // 空行やコメントをスキップ
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            std::istringstream iss(line);
+
+            // 先頭のトークン
+            std::string type;
+            iss >> type;
+
+            // マテリアルファイル名
+            if (type == "newmtl")
+            {
+                std::string name;
+                iss >> name;
+                materials.resize(materials.size() + 1);
+                materialIndexMap[name] = m_index;
+                m_index++;
+                continue;
+            }
+
+            // newmtl より前の設定は無視する
+            if (materials.empty()) continue;
+
+            // ディフューズ色
+            if (type == "Kd")
+            {
+                XMFLOAT3 color = ReadFloat3(iss);
+                materials.back().diffuseColor = { color.x, color.y, color.z, 1.0f };
+            }
+
+            // スペキュラ色
+            else if (type == "Ks")
+            {
+                // メタリックにIORレベルを入れる（プログラム側ではスペキュラ色の要素として使用）
+                // （blenderではメタリックはNsで出力されるのでroughnessへ反映）
+                XMFLOAT3 specularColor = ReadFloat3(iss);
+                materials.back().metallicFactor = specularColor.x;
+            }
+
+            // スペキュラパワー
+            else if (type == "Ns")
+            {
+                float Ns;
+                iss >> Ns;
+                // ※blenderの粗さ【roughness】はobj形式には反映されない
+                // blenderではNsの値はメタリックが反映される
+                // Ns = 1000 x (1 - metallic)^2
+                // Nsを使ってroughnessを算出する
+                // シェダー側では【spcularPower = 1000 x (1 - roughness)^2】で計算
+                float roughness = 1.0f - (sqrtf(Ns / 1000.0f));
+                materials.back().roughnessFactor = roughness;
+            }
+
+            // エミッシブ色
+            else if (type == "Ke")
+            {
+                materials.back().emissiveColor = ReadFloat3(iss);
+            }
+
+            // テクスチャ（ベースカラー、法線マップ）
+            else if (type == "map_Kd" || type == "map_Bump")
+            {
+                // 最後のトークンをファイル名として取得
+                std::string name = ExtractTextureFilename(iss);
+
+                // エラー
+                if (name.empty())
+                {
+                    error = type + " has no file name";
+                    return false;
+                }
+
+                // テクスチャ登録（utf8 → path）
+                if (type == "map_Kd")
+                {
+                    materials.back().baseColorTexIndex = RegisterTexture(
+                        std::filesystem::u8path(name), TextureType::BaseColor, textures, textureIndexMap);
+                }
+                else
+                {
+                    materials.back().normalTexIndex = RegisterTexture(
+                        std::filesystem::u8path(name), TextureType::Normal, textures, textureIndexMap);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool ResolveTexturePath(const std::filesystem::path& name, const std::filesystem::path& mtlPath, std::filesystem::path& resolved)
+    {
+        // pngファイルが存在？
+        resolved = name;
+        if (std::filesystem::exists(resolved)) return true;
+
+        // 存在しない場合はmtlと一緒のフォルダに変更
+        resolved = mtlPath.parent_path() / name.filename();
+        return std::filesystem::exists(resolved);
+    }
+
+    bool ParseMtlFile(const std::filesystem::path& path,
+        std::vector<MaterialInfo>& materials,
+        std::unordered_map<std::string, uint32_t>& materialIndexMap,
+        std::vector<TextureRequest>& textures,
+        std::string& error)
+    {
+        IMDL_TRACE_SCOPE_DETAIL("ParseMtlFile", path.u8string());
+
+        // mtlファイルのオープン
+        std::ifstream ifs(path);
+
+        if (!ifs)
+        {
+            // ファイルのオープン失敗
+            error = "Could not open " + path.u8string();
+            return false;
+        }
+
+        if (!ParseMtl(ifs, materials, materialIndexMap, textures, error)) return false;
+
+        for (auto& texture : textures)
+        {
+            std::filesystem::path resolved;
+            if (!ResolveTexturePath(texture.path, path, resolved))
+            {
+                // そこにもpngがない
+                error = "Texture not found: " + resolved.u8string();
+                return false;
+            }
+            texture.path = resolved;
+        }
+
+        return true;
+    }
+
+    // 頂点データ作成関数
+    static VertexPositionNormalTextureTangent MakeVertex(const ObjModel& model, const FaceIndex& face)
+    {
+        VertexPositionNormalTextureTangent v = {};
+
+        v.position = model.positions[face.v];
+
+        if (face.vn >= 0)
+        {
+            // 法線を正規化
+            XMVECTOR n = XMLoadFloat3(&model.normals[face.vn]);
+            n = XMVector3Normalize(n);
+            XMStoreFloat3(&v.normal, n);
+        }
+        else
+        {
+            // ダミー
+            v.normal = XMFLOAT3(0.0f, 0.0f, 1.0f);
+        }
+
+        v.texcoord = (face.vt >= 0) ? model.texcoords[face.vt] : XMFLOAT2(0.0f, 0.0f);
+
+        return v;
+    }
+
+    // 重複除去のマップから頂点の番号を探す関数
+    // ※見つからない場合は newIndex を登録して true を返す（新規頂点）
+    static bool FindOrAddFaceIndex(std::unordered_map<FaceIndex, uint32_t>& indexMap, const FaceIndex& f, uint32_t newIndex, uint32_t& index)
+    {
+        auto it = indexMap.find(f);
+        if (it != indexMap.end())
+        {
+            index = it->second;
+            return false;
+        }
+
+        indexMap[f] = newIndex;
+        index = newIndex;
+        return true;
+    }
+
+    // メッシュデータから頂点バッファ、インデックスバッファ用のデータを作成する関数
+    static void CreateBufferData(const ObjModel& model,
+                                 const std::unordered_map<std::string, uint32_t>& materialIndexMap,
+                                 std::vector<MeshInfo>& meshInfo,
+                                 std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
+                                 std::vector<uint32_t>& indexBuffer)
+    {
+        IMDL_TRACE_SCOPE("CreateBufferData");
+
+        std::unordered_map<FaceIndex, uint32_t> indexMap;
+
+        for (auto& mesh : model.meshes)
+        {
+            for (auto& subMesh : mesh.subMeshs)
+            {
+                // サブメッシュ情報
+                MeshInfo data = {};
+                auto it = materialIndexMap.find(subMesh.material);
+                if (it == materialIndexMap.end()) throw std::runtime_error("Material not found: " + subMesh.material);
+                data.materialIndex = it->second;                                // マテリアルインデックス
+
+                // MeshInfo とインデックスは 32bit なので範囲外は扱えない
+                if (indexBuffer.size() + subMesh.faces.size() * 3 > UINT32_MAX)
+                    throw std::runtime_error("Index count exceeds the 32-bit range");
+
+                data.startIndex = static_cast<uint32_t>(indexBuffer.size());    // スタートインデックス
+                data.primCount = static_cast<uint32_t>(subMesh.faces.size());   // プリミティブ数
+                meshInfo.push_back(data);
+
+                for (auto& face : subMesh.faces)
+                {
+                    for (int i = 0; i < 3; i++)
+                    {
+                        const FaceIndex& f = face.faceIndices[i];
+
+                        uint32_t index;
+                        if (FindOrAddFaceIndex(indexMap, f, static_cast<uint32_t>(vertexBuffer.size()), index))
+                        {
+                            // 新規頂点
+                            if (vertexBuffer.size() >= UINT32_MAX)
+                                throw std::runtime_error("Vertex count exceeds the 32-bit range");
+
+                            // 範囲外のインデックス
+                            if (f.v < 0 || f.v >= static_cast<int>(model.positions.size())
+                                || f.vt >= static_cast<int>(model.texcoords.size())
+                                || f.vn >= static_cast<int>(model.normals.size()))
+                                throw std::runtime_error("OBJ index out of range");
+
+                            vertexBuffer.push_back(MakeVertex(model, f));
+                        }
+
+                        indexBuffer.push_back(index);
+                    }
+                }
+            }
+        }
+    }
+
+    // 頂点データに接線を追加する関数
+    static void GenerateTangents(
+        std::vector<VertexPositionNormalTextureTangent>& vertices,
+        const std::vector<uint32_t>& indices)
+    {
+        IMDL_TRACE_SCOPE("GenerateTangents");
+
+        std::vector<XMFLOAT3> tanAccum(vertices.size(), { 0,0,0 });
+        std::vector<XMFLOAT3> bitanAccum(vertices.size(), { 0,0,0 });
+
+        auto add = [&](uint32_t idx, const XMFLOAT3& t, const XMFLOAT3& b)
+            {
+                tanAccum[idx].x += t.x;
+                tanAccum[idx].y += t.y;
+                tanAccum[idx].z += t.z;
+
+                bitanAccum[idx].x += b.x;
+                bitanAccum[idx].y += b.y;
+                bitanAccum[idx].z += b.z;
+            };
+
+        auto set = [&](uint32_t idx, const XMFLOAT3& t, const XMFLOAT3& b)
+            {
+                tanAccum[idx] = t;
+                bitanAccum[idx] = b;
+            };
+
+        // 三角形の各頂点の法線が同じ向きならフラットシェーディングの面と判定
+        auto isFlatFace = [&](uint32_t i0, uint32_t i1, uint32_t i2)
+            {
+                XMVECTOR n0 = XMLoadFloat3(&vertices[i0].normal);
+                XMVECTOR n1 = XMLoadFloat3(&vertices[i1].normal);
+                XMVECTOR n2 = XMLoadFloat3(&vertices[i2].normal);
+
+                float d01 = XMVectorGetX(XMVector3Dot(n0, n1));
+                float d12 = XMVectorGetX(XMVector3Dot(n1, n2));
+
+                return d01 > 0.999f && d12 > 0.999f;
+            };
+
+        // ---- 三角形ごと ----
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            uint32_t i0 = indices[i + 0];
+            uint32_t i1 = indices[i + 1];
+            uint32_t i2 = indices[i + 2];
+
+            auto& v0 = vertices[i0];
+            auto& v1 = vertices[i1];
+            auto& v2 = vertices[i2];
+
+            XMVECTOR p0 = XMLoadFloat3(&v0.position);
+            XMVECTOR p1 = XMLoadFloat3(&v1.position);
+            XMVECTOR p2 = XMLoadFloat3(&v2.position);
+
+            float du1 = v1.texcoord.x - v0.texcoord.x;
+            float dv1 = v1.texcoord.y - v0.texcoord.y;
+            float du2 = v2.texcoord.x - v0.texcoord.x;
+            float dv2 = v2.texcoord.y - v0.texcoord.y;
+
+            float denom = du1 * dv2 - du2 * dv1;
+            if (fabs(denom) < 1e-6f)
+                continue;
+
+            float f = 1.0f / denom;
+
+            XMVECTOR e1 = p1 - p0;
+            XMVECTOR e2 = p2 - p0;
+
+            XMVECTOR T = (e1 * dv2 - e2 * dv1) * f;
+            XMVECTOR B = (e2 * du1 - e1 * du2) * f;
+
+            XMFLOAT3 t, b;
+            XMStoreFloat3(&t, T);
+            XMStoreFloat3(&b, B);
+
+            bool flat = isFlatFace(i0, i1, i2);
+
+            if (flat)
+            {
+                // フラット：上書き
+                set(i0, t, b);
+                set(i1, t, b);
+                set(i2, t, b);
+            }
+            else
+            {
+                // スムーズ：加算
+                add(i0, t, b);
+                add(i1, t, b);
+                add(i2, t, b);
+            }
+        }
+
+        // ---- 正規化 & handedness ----
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            XMVECTOR N = XMLoadFloat3(&vertices[i].normal);
+            XMVECTOR T = XMLoadFloat3(&tanAccum[i]);
+            XMVECTOR B = XMLoadFloat3(&bitanAccum[i]);
+
+            T = XMVector3Normalize(T - N * XMVector3Dot(N, T));
+
+            float w = (XMVectorGetX(
+                XMVector3Dot(XMVector3Cross(N, T), B)) < 0.0f)
+                ? -1.0f : 1.0f;
+
+            XMFLOAT3 t;
+            XMStoreFloat3(&t, T);
+            vertices[i].tangent = { t.x, t.y, t.z, w };
+        }
+    }
+
+    bool BuildGeometry(const ObjModel& model,
+        const std::unordered_map<std::string, uint32_t>& materialIndexMap,
+        std::vector<MeshInfo>& meshes,
+        std::vector<VertexPositionNormalTextureTangent>& vertices,
+        std::vector<uint32_t>& indices,
+        std::string& error,
+        GeometryStats* stats)
+    {
+        try
+        {
+            StageTimer timer;
+            CreateBufferData(model, materialIndexMap, meshes, vertices, indices);
+            StageTime dedup = timer.Lap();
+
+            // 頂点データに接線を追加
+            GenerateTangents(vertices, indices);
+
+            if (stats)
+            {
+                stats->positions = model.positions.size();
+                stats->normals = model.normals.size();
+                stats->texcoords = model.texcoords.size();
+                stats->faces = indices.size() / 3;
+                stats->subMeshes = meshes.size();
+                stats->faceVertices = indices.size();
+                stats->uniqueVertices = vertices.size();
+                stats->dedup = dedup;
+                stats->tangents = timer.Elapsed();
+            }
+        }
+        catch (const std::exception& e)
+        {
+            error = e.what();
+            return false;
+        }
+
+        return true;
+    }
+
+    // テクスチャデータのサイズを取得する関数
+    static size_t GetTextureChunkSize(const ModelData& model, bool large)
+    {
+        size_t size = large ? sizeof(uint64_t) : sizeof(uint32_t);
+        for (size_t i = 0; i < model.textures.size(); i++)
+        {
+            bool spilled = i < model.spilled.size() && !model.spilled[i].path.empty();
+            size_t dataSize = spilled ? static_cast<size_t>(model.spilled[i].size) : model.textures[i].data.size();
+            size += (large ? sizeof(uint32_t) * 2 + sizeof(uint64_t) : sizeof(uint32_t) * 2) + dataSize;
+        }
+        return size;
+    }
+
+    // 一時ファイルに退避したテクスチャを書き込む関数
+    // ※ファイル全体を読み込まずに、少しずつ書き出し先へコピーする
+    template<typename Writer>
+    static void CopySpilledTexture(Writer& writer, const SpilledTexture& spilled)
+    {
+        std::ifstream ifs(spilled.path, std::ios::binary);
+        std::vector<char> buffer(static_cast<size_t>(spilled.size < (1u << 20) ? spilled.size : (1u << 20)));
+
+        uint64_t remaining = spilled.size;
+        while (remaining > 0 && ifs)
+        {
+            size_t request = static_cast<size_t>(remaining < buffer.size() ? remaining : buffer.size());
+            ifs.read(buffer.data(), static_cast<std::streamsize>(request));
+            if (static_cast<size_t>(ifs.gcount()) != request) break;
+
+            writer.WriteBytes(buffer.data(), request);
+            remaining -= request;
+        }
+
+        if (remaining > 0)
+        {
+            throw std::runtime_error("Could not read spilled texture " + spilled.path.u8string());
+        }
+    }
+
+    // テクスチャデータの書き込み関数
+    // ※4GB 超え用は個数とサイズを 64bit で書き込む
+    //   uint64_t textureCount
+    //   { uint32_t type, uint32_t reserved, uint64_t size, uint8_t[size] data } * textureCount
+    template<typename Writer>
+    static void WriteTextureChunk(Writer& writer, const ModelData& model, bool large)
+    {
+        const auto& textures = model.textures;
+
+        if (large)
+        {
+            writer.WriteUInt64(textures.size());
+        }
+        else
+        {
+            writer.WriteUInt32(static_cast<uint32_t>(textures.size()));
+        }
+
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            bool spilled = i < model.spilled.size() && !model.spilled[i].path.empty();
+            uint64_t size = spilled ? model.spilled[i].size : textures[i].data.size();
+
+            writer.WriteUInt32(static_cast<uint32_t>(textures[i].type));
+            if (large)
+            {
+                writer.WriteUInt32(0);
+                writer.WriteUInt64(size);
+            }
+            else
+            {
+                writer.WriteUInt32(static_cast<uint32_t>(size));
+            }
+
+            if (spilled)
+            {
+                CopySpilledTexture(writer, model.spilled[i]);
+            }
+            else
+            {
+                writer.WriteBytes(textures[i].data.data(), textures[i].data.size());
+            }
+        }
+    }
+
+    // DDS データから GPU アップロード用の配置の元データを作成する関数
+    // ※images は書き出しが終わるまで保持しておくこと（sources は images のデータを参照する）
+    // ※一時ファイルに退避したテクスチャは読み込んで展開する（展開したデータは書き出しが終わるまで保持する）
+    static HRESULT CreateGpuTextureSources(
+        const ModelData& model,
+        std::vector<ScratchImage>& images,
+        std::vector<GpuTextureSource>& sources)
+    {
+        IMDL_TRACE_SCOPE("CreateGpuTextureSources");
+
+        const auto& textures = model.textures;
+        images.resize(textures.size());
+        sources.resize(textures.size());
+
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            std::vector<uint8_t> loaded;
+            const std::vector<uint8_t>* data;
+            if (!LoadTextureData(model, i, loaded, data))
+                return E_FAIL;
+
+            TexMetadata metadata;
+            HRESULT hr = LoadFromDDSMemory(data->data(), data->size(), DDS_FLAGS_NONE, &metadata, images[i]);
+            if (FAILED(hr))
+                return hr;
+
+            GpuTextureDesc& desc = sources[i].desc;
+            desc = {};
+            desc.type = static_cast<uint32_t>(textures[i].type);
+            desc.format = static_cast<uint32_t>(metadata.format);
+            desc.dimension = static_cast<uint32_t>(metadata.dimension);   // TEX_DIMENSION と D3D12_RESOURCE_DIMENSION は同じ値
+            desc.flags = metadata.IsCubemap() ? IMDL_GPU_TEXTURE_FLAG_CUBE : 0;
+            desc.width = static_cast<uint32_t>(metadata.width);
+            desc.height = static_cast<uint32_t>(metadata.height);
+            desc.depth = static_cast<uint32_t>(metadata.depth);
+            desc.arraySize = static_cast<uint32_t>(metadata.arraySize);
+            desc.mipLevels = static_cast<uint32_t>(metadata.mipLevels);
+
+            // D3D12 のサブリソースの順番（mip + arraySlice * mipLevels）
+            for (size_t item = 0; item < metadata.arraySize; item++)
+            {
+                for (size_t mip = 0; mip < metadata.mipLevels; mip++)
+                {
+                    const Image* image = images[i].GetImage(mip, item, 0);
+                    if (image == nullptr)
+                        return E_FAIL;
+
+                    // ※フットプリントの幅、高さは ComputeGpuTextureLayout でブロックの倍数に切り上げる
+                    GpuSubresourceSource sub{};
+                    sub.data = image->pixels;
+                    sub.width = static_cast<uint32_t>(image->width);
+                    sub.height = static_cast<uint32_t>(image->height);
+                    sub.depth = static_cast<uint32_t>((metadata.depth >> mip) > 0 ? (metadata.depth >> mip) : 1);
+                    sub.numRows = static_cast<uint32_t>(ComputeScanlines(image->format, image->height));
+                    sub.rowSize = image->rowPitch;
+                    sub.rowPitch = image->rowPitch;
+                    sub.slicePitch = image->slicePitch;
+                    sources[i].subresources.push_back(sub);
+                }
+            }
+        }
+
+        return S_OK;
+    }
+
+    // GPU アップロード用のテクスチャの配置
+    // ※sources は images のデータを参照するので、書き出しが終わるまで保持しておくこと
+    struct GpuTexturePlacement
+    {
+        std::vector<ScratchImage> images;
+        std::vector<GpuTextureSource> sources;
+        GpuTextureLayout layout{};
+        StageTime time;     // 作成時間（統計でテクスチャチャンクの作成時間に含める）
+    };
+
+    // GPU アップロード用の配置を作成する関数
+    static bool CreateGpuTexturePlacement(const ModelData& model, GpuTexturePlacement& placement, std::string& error)
+    {
+        StageTimer timer;
+        if (FAILED(CreateGpuTextureSources(model, placement.images, placement.sources)))
+        {
+            error = "Could not create the GPU texture layout";
+            return false;
+        }
+        placement.layout = ComputeGpuTextureLayout(placement.sources);
+        placement.time = timer.Elapsed();
+        return true;
+    }
+
+    // チャンクの情報を作成する関数
+    // gpu : GPU アップロード用の配置（settings.gpuLayout の場合のテクスチャチャンクのみ使う）
+    static ChunkSource MakeModelChunk(const ModelData& model, ModelChunk chunk, const ImdlWriteSettings& settings, const GpuTexturePlacement* gpu)
+    {
+        switch (chunk)
+        {
+        case ModelChunk::Texture:
+            if (settings.gpuLayout)
+            {
+                // テクスチャはフットプリント付きの配置に置き換える
+                return { CHUNK_TEXTURE, static_cast<size_t>(gpu->layout.size),
+                    [gpu](MemoryWriter& writer) { WriteGpuTextureChunk(writer, gpu->sources, gpu->layout); },
+                    IMDL_CHUNK_FLAG_GPU_LAYOUT, IMDL_GPU_PLACEMENT_ALIGNMENT };
+            }
+            return { CHUNK_TEXTURE, GetTextureChunkSize(model, settings.large), [&model, large = settings.large](MemoryWriter& writer) { WriteTextureChunk(writer, model, large); } };
+
+        case ModelChunk::Material:
+            return MakeVectorChunk(CHUNK_MATERIAL, model.materials, settings);
+
+        case ModelChunk::Mesh:
+            return MakeVectorChunk(CHUNK_MESH, model.meshes, settings);
+
+        case ModelChunk::Vertex:
+        case ModelChunk::Index:
+        default:
+        {
+            ChunkSource source = chunk == ModelChunk::Vertex
+                ? MakeVectorChunk(CHUNK_VERTEX, model.vertices, settings)
+                : MakeVectorChunk(CHUNK_INDEX, model.indices, settings);
+
+            // 頂点、インデックスはバッファの配置境界に揃えて、そのままバッファにコピーできるようにする
+            if (settings.gpuLayout) source.alignment = IMDL_GPU_PLACEMENT_ALIGNMENT;
+            return source;
+        }
+        }
+    }
+
+    // モデルデータのチャンクを作成して write に渡す関数
+    // ※write はファイルかメモリに書き出す（WriteImdlFile、WriteImdlMemory）
+    template<typename Write>
+    static bool WriteModelChunks(const ModelData& model, const ImdlWriteSettings& settings, std::string& error,
+        ImdlWriteStats* stats, Write&& write)
+    {
+        IMDL_TRACE_SCOPE("WriteModelChunks");
+
+        // GPU アップロード用の配置
+        // ※テクスチャは DDS を展開して行ピッチ、サブリソースの境界を揃えて書き出す
+        GpuTexturePlacement gpu;
+        if (settings.gpuLayout && !CreateGpuTexturePlacement(model, gpu, error)) return false;
+
+        // チャンクは書き出し先の領域に直接シリアライズする
+        // ※4GB を超える場合は 4GB 超え用の設定で作り直される
+        auto builder = [&](const ImdlWriteSettings& s)
+            {
+                std::vector<ChunkSource> chunks;
+                for (size_t i = 0; i < static_cast<size_t>(ModelChunk::Count); i++)
+                {
+                    chunks.push_back(MakeModelChunk(model, static_cast<ModelChunk>(i), s, &gpu));
+                }
+                return chunks;
+            };
+
+        if (!write(ChunkBuilder(builder))) return false;
+
+        // テクスチャチャンク（先頭）の作成時間に GPU アップロード用の配置の作成を含める
+        if (stats && settings.gpuLayout && !stats->chunks.empty())
+        {
+            stats->chunks[0].build += gpu.time;
+        }
+
+        return true;
+    }
+
+    bool WriteImdlModel(const std::filesystem::path& path, const ModelData& model, const ImdlWriteSettings& settings, std::string& error,
+        ImdlWriteStats* stats)
+    {
+        return WriteModelChunks(model, settings, error, stats,
+            [&](const ChunkBuilder& builder) { return WriteImdlFile(path, builder, settings, error, stats); });
+    }
+
+    bool WriteImdlModelMemory(std::vector<uint8_t>& output, const ModelData& model, const ImdlWriteSettings& settings, std::string& error,
+        ImdlWriteStats* stats)
+    {
+        return WriteModelChunks(model, settings, error, stats,
+            [&](const ChunkBuilder& builder) { return WriteImdlMemory(output, builder, settings, error, stats); });
+    }
+
+    ModelChunkWriter::ModelChunkWriter(const ModelData& model, const ImdlWriteSettings& settings)
+        : m_model(model)
+        , m_settings(settings)
+        , m_chunks(static_cast<size_t>(ModelChunk::Count))
+        , m_chunkStats(static_cast<size_t>(ModelChunk::Count))
+    {
+    }
+
+    ModelChunkWriter::~ModelChunkWriter() = default;
+
+    bool ModelChunkWriter::Prepare(ModelChunk chunk, std::string& error)
+    {
+        IMDL_TRACE_SCOPE("PrepareChunk");
+
+        // GPU アップロード用の配置はテクスチャチャンクを用意するときに作成する
+        // ※頂点、インデックスは境界を揃えるだけなので配置を待たない
+        if (chunk == ModelChunk::Texture && m_settings.gpuLayout)
+        {
+            m_gpu = std::make_unique<GpuTexturePlacement>();
+            if (!CreateGpuTexturePlacement(m_model, *m_gpu, error)) return false;
+        }
+
+        return PrepareChunk(chunk, m_settings, error);
+    }
+
+    bool ModelChunkWriter::PrepareChunk(ModelChunk chunk, const ImdlWriteSettings& settings, std::string& error)
+    {
+        // ※配置は他のチャンクを用意するスレッドから参照しない
+        const GpuTexturePlacement* gpu = chunk == ModelChunk::Texture ? m_gpu.get() : nullptr;
+
+        std::vector<ChunkSource> chunks{ MakeModelChunk(m_model, chunk, settings, gpu) };
+        ImdlWriteStats stats;
+        if (!CompressChunks(chunks, settings, error, &stats)) return false;
+
+        m_chunks[static_cast<size_t>(chunk)] = std::move(chunks[0]);
+        m_chunkStats[static_cast<size_t>(chunk)] = stats.chunks[0];
+        return true;
+    }
+
+    bool ModelChunkWriter::Write(const std::filesystem::path& path, std::string& error, ImdlWriteStats* stats)
+    {
+        IMDL_TRACE_SCOPE_DETAIL("WriteModelChunks", path.u8string());
+
+        ImdlWriteSettings settings = m_settings;
+        if (!settings.large && RequiresLargeFormat(m_chunks, settings))
+        {
+            if (!SwitchToLargeFormat(settings, error)) return false;
+            for (size_t i = 0; i < m_chunks.size(); i++)
+            {
+                if (!PrepareChunk(static_cast<ModelChunk>(i), settings, error)) return false;
+            }
+        }
+
+        // ※チャンクを用意したときの統計（圧縮）は書き出しの統計に残る
+        if (stats) stats->chunks = m_chunkStats;
+        if (!WriteImdlFile(path, m_chunks, settings, error, stats)) return false;
+
+        // テクスチャチャンクの作成時間に GPU アップロード用の配置の作成を含める（WriteImdlModel と同じ）
+        if (stats && m_gpu) stats->chunks[0].build += m_gpu->time;
+
+        return true;
+    }
+
+    bool ConvertObjToModel(std::string_view obj, const ConvertFileLoader& loader, const ConvertOptions& options,
+        ModelData& model, ConvertResult& result)
+    {
+        result = ConvertResult();
+        model = ModelData();
+
+        // 中止が要求されたか、進捗の通知で中止されたか
+        std::atomic<bool> stopped{ false };
+        std::mutex progressMutex;
+        auto proceed = [&](ConvertStage stage, size_t done, size_t total)
+            {
+                if (stopped || (options.cancel && *options.cancel)) stopped = true;
+                else if (options.progress)
+                {
+                    std::lock_guard<std::mutex> lock(progressMutex);
+                    if (!options.progress(stage, done, total)) stopped = true;
+                }
+                return !stopped;
+            };
+
+        auto fail = [&](const std::string& error)
+            {
+                result.status = stopped || (options.cancel && *options.cancel) ? ConvertStatus::Cancelled : ConvertStatus::Failed;
+                result.error = result.status == ConvertStatus::Cancelled ? "Cancelled" : error;
+                return false;
+            };
+
+        auto stageSec = [&](ConvertStage stage) -> double& { return result.stageSec[static_cast<size_t>(stage)]; };
+
+        // ----- obj ----- //
+        if (!proceed(ConvertStage::ParseObj, 0, 1)) return fail("");
+        Stopwatch stopwatch;
+
+        ObjModel object;
+        {
+            MemoryStreamBuf buffer(obj);
+            std::istream stream(&buffer);
+
+            std::string error;
+            if (!ParseObj(stream, object, error, options.cancel)) return fail(error);
+        }
+        stageSec(ConvertStage::ParseObj) = stopwatch.ElapsedSec();
+
+        // ----- mtl ----- //
+        if (!proceed(ConvertStage::ParseMtl, 0, 1)) return fail("");
+        stopwatch.Reset();
+
+        if (object.mtllib.empty()) return fail("No mtllib specified in obj file.");
+
+        std::unordered_map<std::string, uint32_t> materialIndexMap;
+        std::vector<TextureRequest> requests;
+        {
+            std::vector<uint8_t> data;
+            if (!loader || !loader(object.mtllib, data)) return fail("Material not found: " + object.mtllib.u8string());
+
+            MemoryStreamBuf buffer(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()));
+            std::istream stream(&buffer);
+
+            std::string error;
+            if (!ParseMtl(stream, model.materials, materialIndexMap, requests, error)) return fail(error);
+            if (options.write.sortTextures) SortTextureRequests(model.materials, requests);
+        }
+        stageSec(ConvertStage::ParseMtl) = stopwatch.ElapsedSec();
+
+        // ----- ジオメトリ ----- //
+        if (!proceed(ConvertStage::Geometry, 0, 1)) return fail("");
+        stopwatch.Reset();
+        {
+            std::string error;
+            if (!BuildGeometry(object, materialIndexMap, model.meshes, model.vertices, model.indices, error)) return fail(error);
+        }
+        object = ObjModel();
+        stageSec(ConvertStage::Geometry) = stopwatch.ElapsedSec();
+
+        // ----- テクスチャ（並列に変換する） ----- //
+        if (!proceed(ConvertStage::Textures, 0, requests.size())) return fail("");
+        stopwatch.Reset();
+
+        std::vector<TextureEntry> encoded(requests.size());
+        std::vector<std::string> errors(requests.size());
+        std::vector<char> missing(requests.size(), 0);
+        std::atomic<size_t> done{ 0 };
+
+        ParallelFor(requests.size(), [&](size_t i)
+            {
+                if (stopped) return;
+
+                encoded[i].type = requests[i].type;
+
+                std::vector<uint8_t> data;
+                if (!loader(requests[i].path, data))
+                {
+                    missing[i] = 1;
+                    errors[i] = "Texture not found: " + requests[i].path.u8string();
+                }
+                else if (!EncodeTexture(data.data(), data.size(), requests[i].type, options.texture, encoded[i].data, errors[i]))
+                {
+                    errors[i] = requests[i].path.u8string() + ": " + errors[i];
+                }
+
+                proceed(ConvertStage::Textures, ++done, requests.size());
+            }, options.threads);
+
+        if (stopped) return fail("");
+
+        // 見つからないテクスチャはエラー、変換できなかったテクスチャは使わない
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            if (missing[i]) return fail(errors[i]);
+            if (!errors[i].empty()) result.warnings.push_back(errors[i]);
+        }
+
+        ResolveTextures(model.materials, encoded, model.textures);
+        stageSec(ConvertStage::Textures) = stopwatch.ElapsedSec();
+
+        result.status = ConvertStatus::Succeeded;
+        return true;
+    }
+
+    bool ConvertObjToImdl(std::string_view obj, const ConvertFileLoader& loader, const ConvertOptions& options,
+        std::vector<uint8_t>& imdl, ConvertResult& result)
+    {
+        imdl.clear();
+
+        ModelData model;
+        if (!ConvertObjToModel(obj, loader, options, model, result)) return false;
+
+        // ----- 書き出し ----- //
+        if ((options.cancel && *options.cancel) || (options.progress && !options.progress(ConvertStage::Write, 0, 1)))
+        {
+            result.status = ConvertStatus::Cancelled;
+            result.error = "Cancelled";
+            return false;
+        }
+
+        Stopwatch stopwatch;
+        if (!WriteImdlModelMemory(imdl, model, options.write, result.error))
+        {
+            result.status = ConvertStatus::Failed;
+            return false;
+        }
+        result.stageSec[static_cast<size_t>(ConvertStage::Write)] = stopwatch.ElapsedSec();
+
+        if (options.progress) options.progress(ConvertStage::Write, 1, 1);
+
+        return true;
+    }
+
+    ConvertFileLoader MakeFolderFileLoader(const std::filesystem::path& dir)
+    {
+        return [dir](const std::filesystem::path& name, std::vector<uint8_t>& data)
+            {
+                std::filesystem::path path = name.is_relative() ? dir / name : name;
+                if (ReadFileData(path, data)) return true;
+
+                // 見つからない場合はフォルダ直下を探す
+                return ReadFileData(dir / name.filename(), data);
+            };
+    }
+
+    // ----- 内部の処理（マイクロベンチマーク用） ----- //
+
+    namespace Kernel
+    {
+        XMFLOAT3 ReadFloat3(std::istringstream& iss)
+        {
+            return Imase::ReadFloat3(iss);
+        }
+
+        std::vector<FaceIndex> ParseFaceLine(const std::string& line, const ObjModel& model)
+        {
+            return Imase::ParseFaceLine(line, model);
+        }
+
+        size_t DedupFaceIndices(const std::vector<FaceIndex>& faceIndices, std::vector<uint32_t>& indices)
+        {
+            std::unordered_map<FaceIndex, uint32_t> indexMap;
+
+            uint32_t vertexCount = 0;
+            for (const auto& f : faceIndices)
+            {
+                uint32_t index;
+                if (FindOrAddFaceIndex(indexMap, f, vertexCount, index)) vertexCount++;
+                indices.push_back(index);
+            }
+            return vertexCount;
+        }
+
+        void CreateBufferData(const ObjModel& model,
+            const std::unordered_map<std::string, uint32_t>& materialIndexMap,
+            std::vector<MeshInfo>& meshes,
+            std::vector<VertexPositionNormalTextureTangent>& vertices,
+            std::vector<uint32_t>& indices)
+        {
+            Imase::CreateBufferData(model, materialIndexMap, meshes, vertices, indices);
+        }
+
+        void GenerateTangents(std::vector<VertexPositionNormalTextureTangent>& vertices, const std::vector<uint32_t>& indices)
+        {
+            Imase::GenerateTangents(vertices, indices);
+        }
+    }
+}
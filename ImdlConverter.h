@@ -0,0 +1,415 @@
+﻿//--------------------------------------------------------------------------------------
+// File: ImdlConverter.h
+//
+// obj 形式のモデルデータを独自形式のモデルデータ(.imdl)に変換するライブラリ
+//
+// ※ObjToImdl.exe を起動せずに、エディタやアセットパイプラインのプロセスの中で変換できる
+// ※入力はメモリ上の obj のテキストと、mtl、テクスチャを読み込む関数（ConvertFileLoader）
+//   出力はメモリ上の imdl ファイルの内容、または頂点、インデックスなど各段階の結果（ModelData）
+// ※各段階の関数（ParseObj、ParseMtl、BuildGeometry、EncodeTexture、WriteImdlModel）も個別に使える
+// ※エラーは表示せずに戻り値と error で返す
+// ※Windows 以外でも使える（PNG は libpng で読み込む、Windows 以外では WIC と GPU は使わない）
+// ※Windows では libpng で読めない画像（JPEG など）を WIC で読み込む
+//   TextureEncodeOptions::device を指定した場合は BC6H/BC7 の圧縮に GPU、ミップの作成に WIC のフィルタを使う
+//
+// Date: 2026.3.12
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <DirectXMath.h>
+#include "Imdl.h"
+#include "ImdlWriter.h"
+
+struct ID3D11Device;
+
+namespace Imase
+{
+    // 面の各頂点を構成するインデックス
+    struct FaceIndex
+    {
+        int v;  // 位置
+        int vt; // テクスチャ座標
+        int vn; // 法線
+
+        bool operator==(const FaceIndex& other) const
+        {
+            return v == other.v && vt == other.vt && vn == other.vn;
+        }
+    };
+
+    // 面（三角形）
+    struct Face
+    {
+        FaceIndex faceIndices[3];
+    };
+
+    // サブメッシュ
+    struct SubMesh
+    {
+        std::string material;      // マテリアル名
+        std::vector<Face> faces;    // 面（三角形）情報
+    };
+
+    // メッシュ
+    struct Mesh
+    {
+        std::vector<SubMesh> subMeshs;  // サブメッシュ
+    };
+
+    // obj形式の情報取得用構造体
+    struct ObjModel
+    {
+        std::filesystem::path mtllib;               // マテリアルファイル名
+        std::vector<DirectX::XMFLOAT3> positions;   // 位置
+        std::vector<DirectX::XMFLOAT3> normals;     // 法線
+        std::vector<DirectX::XMFLOAT2> texcoords;   // テクスチャ座標
+        std::vector<Mesh> meshes;                   // メッシュ
+    };
+
+    // 変換するテクスチャ
+    struct TextureRequest
+    {
+        std::filesystem::path path; // ファイル名
+        TextureType type;           // 種類
+    };
+
+    // 変換の段階
+    enum class ConvertStage
+    {
+        ParseObj,   // obj の解析
+        ParseMtl,   // mtl の解析
+        Geometry,   // 頂点、インデックスの作成
+        Textures,   // テクスチャの変換
+        Write,      // imdl の書き出し
+
+        Count
+    };
+
+    // 変換の段階の名前を取得する関数
+    inline const char* GetConvertStageName(ConvertStage stage)
+    {
+        switch (stage)
+        {
+        case ConvertStage::ParseObj: return "parse-obj";
+        case ConvertStage::ParseMtl: return "parse-mtl";
+        case ConvertStage::Geometry: return "geometry";
+        case ConvertStage::Textures: return "textures";
+        case ConvertStage::Write:    return "write";
+        default:                     return "unknown";
+        }
+    }
+
+    // 一時ファイルに退避したテクスチャ（メモリの予算を超えた場合）
+    struct SpilledTexture
+    {
+        std::filesystem::path path; // 一時ファイル（空 = 退避していない、データは TextureEntry::data）
+        uint64_t size = 0;          // DDS のサイズ
+    };
+
+    // 変換したモデルデータ（imdl の各チャンクの内容）
+    struct ModelData
+    {
+        std::vector<MaterialInfo> materials;
+        std::vector<MeshInfo> meshes;
+        std::vector<VertexPositionNormalTextureTangent> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<TextureEntry> textures;
+
+        // textures と同じ並び（空 = すべてメモリ上）
+        // ※退避したテクスチャは書き出すときに一時ファイルから出力へ直接コピーする
+        std::vector<SpilledTexture> spilled;
+    };
+
+    // 進捗を通知する関数の型
+    // done / total : 段階の中の進み具合（テクスチャは枚数、それ以外は 0 / 1 と 1 / 1）
+    // ※false を返すと変換を中止する
+    // ※テクスチャの段階は変換したスレッドから呼ばれる（同時には呼ばれない）
+    using ConvertProgress = std::function<bool(ConvertStage stage, size_t done, size_t total)>;
+
+    // mtl、テクスチャを読み込む関数の型
+    // name : obj、mtl に書かれているファイル名（UTF-8 から変換したもの）
+    // ※見つからない場合は false を返す
+    using ConvertFileLoader = std::function<bool(const std::filesystem::path& name, std::vector<uint8_t>& data)>;
+
+    // テクスチャの変換の設定
+    struct TextureEncodeOptions
+    {
+        // BC6H/BC7 の圧縮に使うデバイス（nullptr = CPU で圧縮する）
+        // ※nullptr の場合は WIC のフィルタも使わないので、Windows とそれ以外で同じ DDS になる
+        // ※Windows 以外では常に nullptr とすること
+        ID3D11Device* device = nullptr;
+
+        // デバイスのイミディエイトコンテキストを排他するミューテックス（nullptr = 排他しない）
+        // ※同じデバイスを複数のスレッドで使う場合は指定すること
+        std::mutex* gpuMutex = nullptr;
+    };
+
+    // テクスチャの変換の統計
+    struct TextureEncodeStats
+    {
+        uint64_t inputBytes = 0;    // 画像ファイルのサイズ
+        uint64_t ddsBytes = 0;      // DDS のサイズ
+        uint32_t width = 0;         // 画像のサイズ
+        uint32_t height = 0;
+        uint32_t mipLevels = 0;     // ミップの数
+        uint32_t format = 0;        // 圧縮形式（DXGI_FORMAT）
+        StageTime read;             // ファイルの読み込み（EncodeTextureFile のみ）
+        StageTime decode;           // 画像の展開
+        StageTime mips;             // 法線マップの Y 反転とミップの生成
+        StageTime compress;         // BC 圧縮
+        StageTime save;             // DDS の作成
+    };
+
+    // 頂点、インデックスの作成の統計
+    struct GeometryStats
+    {
+        uint64_t positions = 0;         // obj の位置の数
+        uint64_t normals = 0;           // obj の法線の数
+        uint64_t texcoords = 0;         // obj のテクスチャ座標の数
+        uint64_t faces = 0;             // 面（三角形）の数
+        uint64_t subMeshes = 0;         // サブメッシュの数
+        uint64_t faceVertices = 0;      // 面の頂点の数（インデックスの数）
+        uint64_t uniqueVertices = 0;    // 重複を除いた頂点の数
+        StageTime dedup;                // 頂点の重複の除去とインデックスの作成
+        StageTime tangents;             // 接線の計算
+    };
+
+    // 変換の設定
+    struct ConvertOptions
+    {
+        ImdlWriteSettings write;            // 書き出しの設定
+        TextureEncodeOptions texture;       // テクスチャの変換の設定
+        unsigned threads = 0;               // テクスチャを変換するスレッド数（0 = 論理コア数）
+        ConvertProgress progress;           // 進捗の通知（nullptr 可）
+        const std::atomic<bool>* cancel = nullptr;  // true になったら変換を中止する（nullptr 可）
+    };
+
+    // 変換の結果
+    enum class ConvertStatus
+    {
+        Succeeded,
+        Cancelled,
+        Failed
+    };
+
+    struct ConvertResult
+    {
+        ConvertStatus status = ConvertStatus::Failed;
+        std::string error;                  // 失敗した理由
+        std::vector<std::string> warnings;  // 変換できなかったテクスチャなど（変換は続ける）
+        double stageSec[static_cast<size_t>(ConvertStage::Count)] = {};    // 各段階の処理時間（秒）
+    };
+
+    // ----- 各段階の関数 ----- //
+
+    // obj のテキストを解析する関数
+    // ※cancel が true になったら途中で false を返す
+    bool ParseObj(std::istream& stream, ObjModel& model, std::string& error, const std::atomic<bool>* cancel = nullptr);
+
+    // obj ファイルを解析する関数
+    bool ParseObjFile(const std::filesystem::path& path, ObjModel& model, std::string& error);
+
+    // obj ファイルの mtllib を探す関数（ない場合は空）
+    // ※obj 全体を解析する前に mtl の解析を始めるために使う（ParseObj と同じく最後の mtllib を使う）
+    bool FindObjMtllib(const std::filesystem::path& path, std::filesystem::path& mtllib, std::string& error);
+
+    // mtl のテキストを解析する関数
+    // ※テクスチャのファイル名は mtl に書かれているまま返す（ResolveTexturePath で探す）
+    bool ParseMtl(std::istream& stream,
+        std::vector<MaterialInfo>& materials,
+        std::unordered_map<std::string, uint32_t>& materialIndexMap,
+        std::vector<TextureRequest>& textures,
+        std::string& error);
+
+    // mtl ファイルを解析する関数
+    // ※テクスチャのファイル名は ResolveTexturePath で探したパスにする（見つからない場合は失敗）
+    bool ParseMtlFile(const std::filesystem::path& path,
+        std::vector<MaterialInfo>& materials,
+        std::unordered_map<std::string, uint32_t>& materialIndexMap,
+        std::vector<TextureRequest>& textures,
+        std::string& error);
+
+    // テクスチャのファイルを探す関数
+    // ※書かれているパスになければ mtl ファイルと同じフォルダを探す
+    bool ResolveTexturePath(const std::filesystem::path& name, const std::filesystem::path& mtlPath, std::filesystem::path& resolved);
+
+    // 頂点、インデックスを作成して接線を追加する関数
+    // stats : 処理時間と頂点の数を記録する（nullptr 可）
+    bool BuildGeometry(const ObjModel& model,
+        const std::unordered_map<std::string, uint32_t>& materialIndexMap,
+        std::vector<MeshInfo>& meshes,
+        std::vector<VertexPositionNormalTextureTangent>& vertices,
+        std::vector<uint32_t>& indices,
+        std::string& error,
+        GeometryStats* stats = nullptr);
+
+    // 画像ファイルの内容を DDS に変換する関数
+    // ※PNG、DDS、HDR、TGA を読み込める（Windows は WIC で読める形式すべて）
+    // ※Windows は COM を使うので、呼び出したスレッドで COM が初期化されていなければ初期化する
+    // stats : 段階ごとの処理時間と画像の情報を記録する（nullptr 可）
+    bool EncodeTexture(const uint8_t* data, size_t size, TextureType type, const TextureEncodeOptions& options,
+        std::vector<uint8_t>& dds, std::string& error, TextureEncodeStats* stats = nullptr);
+
+    // 画像ファイルを DDS に変換する関数
+    bool EncodeTextureFile(const std::filesystem::path& path, TextureType type, const TextureEncodeOptions& options,
+        std::vector<uint8_t>& dds, std::string& error, TextureEncodeStats* stats = nullptr);
+
+    // テクスチャの登録順をファイル名と種類の順にする関数（マテリアルのテクスチャ番号も付け直す）
+    // ※テクスチャの番号が mtl に書かれている順に左右されないようにする（決定的な出力、--deterministic）
+    // ※テクスチャを変換する前に呼ぶこと
+    void SortTextureRequests(std::vector<MaterialInfo>& materials, std::vector<TextureRequest>& textures);
+
+    // 変換したテクスチャを登録順に並べる関数
+    // ※変換に失敗したテクスチャ（data が空）は取り除き、マテリアルのテクスチャ番号を -1 にする
+    void ResolveTextures(
+        std::vector<MaterialInfo>& materials,
+        std::vector<TextureEntry>& encoded,
+        std::vector<TextureEntry>& textures);
+
+    // 一時ファイルに退避したテクスチャを含めて登録順に並べる関数
+    // encodedSpills : encoded と同じ並び（退避したテクスチャは data が空でも取り除かない）
+    void ResolveTextures(
+        std::vector<MaterialInfo>& materials,
+        std::vector<TextureEntry>& encoded,
+        std::vector<SpilledTexture>& encodedSpills,
+        ModelData& model);
+
+    // 変換したテクスチャを一時ファイルに退避する関数（texture.data は解放する）
+    bool SpillTexture(TextureEntry& texture, const std::filesystem::path& path, SpilledTexture& spilled, std::string& error);
+
+    // 退避したテクスチャの一時ファイルを削除する関数
+    void RemoveSpilledTextures(std::vector<SpilledTexture>& spilled);
+
+    // モデルデータを imdl ファイルに書き出す関数
+    // stats : チャンクごとの処理時間とサイズを記録する（nullptr 可）
+    // ※GPU アップロード用の配置では、DDS の展開と配置の計算をテクスチャチャンクの作成時間に含める
+    bool WriteImdlModel(const std::filesystem::path& path, const ModelData& model, const ImdlWriteSettings& settings, std::string& error,
+        ImdlWriteStats* stats = nullptr);
+
+    // モデルデータを imdl の形式でメモリに書き出す関数
+    bool WriteImdlModelMemory(std::vector<uint8_t>& output, const ModelData& model, const ImdlWriteSettings& settings, std::string& error,
+        ImdlWriteStats* stats = nullptr);
+
+    // imdl ファイルのチャンク（書き出す順）
+    enum class ModelChunk
+    {
+        Texture,
+        Material,
+        Mesh,
+        Vertex,
+        Index,
+
+        Count
+    };
+
+    // GPU アップロード用のテクスチャの配置（ImdlConverter.cpp で定義）
+    struct GpuTexturePlacement;
+
+    // チャンクを１つずつ用意してから imdl ファイルに書き出すクラス
+    // ※入力がそろったチャンクから Prepare を呼ぶと、圧縮や GPU アップロード用の配置の計算を
+    //   他のチャンクの入力を待たずに始められる（タスクグラフでの変換で使う）
+    // ※Prepare はチャンクごとに別のスレッドから同時に呼べる。Write はすべて用意してから呼ぶ
+    // ※書き出す内容は WriteImdlModel と同じ
+    class ModelChunkWriter
+    {
+    public:
+
+        // model は書き出しが終わるまで保持しておくこと
+        ModelChunkWriter(const ModelData& model, const ImdlWriteSettings& settings);
+        ~ModelChunkWriter();
+
+        ModelChunkWriter(const ModelChunkWriter&) = delete;
+        ModelChunkWriter& operator=(const ModelChunkWriter&) = delete;
+
+        // チャンクを用意する関数（圧縮する場合は圧縮する）
+        bool Prepare(ModelChunk chunk, std::string& error);
+
+        // 用意したチャンクをファイルに書き出す関数
+        // ※4GB を超える場合は 4GB 超え用の設定ですべてのチャンクを用意し直す
+        // stats : チャンクごとの処理時間とサイズを記録する（nullptr 可、WriteImdlModel と同じ）
+        bool Write(const std::filesystem::path& path, std::string& error, ImdlWriteStats* stats = nullptr);
+
+    private:
+
+        bool PrepareChunk(ModelChunk chunk, const ImdlWriteSettings& settings, std::string& error);
+
+        const ModelData& m_model;
+        ImdlWriteSettings m_settings;
+        std::vector<ChunkSource> m_chunks;
+        std::vector<ChunkWriteStats> m_chunkStats;  // チャンクを用意したときの統計（圧縮）
+        std::unique_ptr<GpuTexturePlacement> m_gpu;
+    };
+
+    // ----- まとめて変換する関数 ----- //
+
+    // obj を解析して、mtl、テクスチャを読み込んでモデルデータを作成する関数
+    // obj    : obj ファイルの内容
+    // loader : mtllib、map_Kd などに書かれているファイルを読み込む関数
+    bool ConvertObjToModel(std::string_view obj, const ConvertFileLoader& loader, const ConvertOptions& options,
+        ModelData& model, ConvertResult& result);
+
+    // obj を imdl に変換する関数
+    // imdl : 変換した imdl ファイルの内容
+    bool ConvertObjToImdl(std::string_view obj, const ConvertFileLoader& loader, const ConvertOptions& options,
+        std::vector<uint8_t>& imdl, ConvertResult& result);
+
+    // フォルダからファイルを読み込む関数を作成する関数
+    // ※相対パスは dir からのパス、見つからなければ dir 直下の同じ名前のファイルを探す
+    ConvertFileLoader MakeFolderFileLoader(const std::filesystem::path& dir);
+
+    // ----- 内部の処理（マイクロベンチマーク用） ----- //
+    // ※変換の中で使っている関数をそのまま呼び出す（--bench-kernels で個別に計測する）
+    namespace Kernel
+    {
+        // v、vn 行の数値を読み込む関数（先頭のトークンは読み込み済みにしておく）
+        DirectX::XMFLOAT3 ReadFloat3(std::istringstream& iss);
+
+        // f 行の各頂点のインデックスを取得する関数（負のインデックスは model の要素数から求める）
+        std::vector<FaceIndex> ParseFaceLine(const std::string& line, const ObjModel& model);
+
+        // 頂点の重複を除いてインデックスを作成する関数（CreateBufferData と同じ重複除去のマップ、頂点は作らない）
+        // 戻り値は重複を除いた頂点数
+        size_t DedupFaceIndices(const std::vector<FaceIndex>& faceIndices, std::vector<uint32_t>& indices);
+
+        // 頂点の重複を除いて頂点とインデックスを作成する関数（接線は計算しない）
+        void CreateBufferData(const ObjModel& model,
+            const std::unordered_map<std::string, uint32_t>& materialIndexMap,
+            std::vector<MeshInfo>& meshes,
+            std::vector<VertexPositionNormalTextureTangent>& vertices,
+            std::vector<uint32_t>& indices);
+
+        // 頂点に接線を追加する関数
+        void GenerateTangents(std::vector<VertexPositionNormalTextureTangent>& vertices, const std::vector<uint32_t>& indices);
+    }
+}
+
+// ハッシュ値を生成する関数
+namespace std
+{
+    template <>
+    struct hash<Imase::FaceIndex>
+    {
+        size_t operator()(const Imase::FaceIndex& f) const
+        {
+            size_t h1 = std::hash<int>()(f.v);
+            size_t h2 = std::hash<int>()(f.vt);
+            size_t h3 = std::hash<int>()(f.vn);
+
+            // ハッシュ合成
+            return h1 ^ (h2 << 1) ^ (h3 << 2);
+        }
+    };
+}
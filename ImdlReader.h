@@ -0,0 +1,556 @@
+﻿//--------------------------------------------------------------------------------------
+// File: ImdlReader.h
+//
+// モデルデータ(.imdl)を読み込むクラス
+//
+// ※ファイルをメモリにマップして、各チャンクのデータをコピーせずに型付きの範囲（Span）で参照する
+// ※圧縮されたチャンクは全コアで展開して内部のバッファに保持する
+// ※バージョン１、バージョン２（4GB 超え用を含む）に対応
+//
+// Date: 2026.3.9
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Checksum.h"
+#include "ChunkIO.h"
+#include "Compression.h"
+#include "Imdl.h"
+#include "MappedFile.h"
+
+namespace Imase
+{
+    // 連続したデータの参照（読み込み専用）
+    template<typename T>
+    class Span
+    {
+    public:
+
+        Span() = default;
+
+        Span(const T* data, size_t size)
+            : m_data(data)
+            , m_size(size)
+        {
+        }
+
+        const T* data() const { return m_data; }
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        const T* begin() const { return m_data; }
+        const T* end() const { return m_data + m_size; }
+
+        const T& operator[](size_t i) const { return m_data[i]; }
+
+    private:
+
+        const T* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    // テクスチャデータの参照
+    struct TextureView
+    {
+        TextureType type;       // 種類
+        Span<uint8_t> data;     // DDS データ
+    };
+
+    // テクスチャチャンク（DDS の配列）を解析する関数
+    // ※large は 4GB 超え用のファイルか（個数とサイズが 64bit）
+    inline bool ParseTextureList(const uint8_t* data, uint64_t size, bool large, std::vector<TextureView>& textures)
+    {
+        const uint8_t* p = data;
+        uint64_t remaining = size;
+
+        auto read = [&](void* dst, size_t n)
+            {
+                if (remaining < n) return false;
+                std::memcpy(dst, p, n);
+                p += n;
+                remaining -= n;
+                return true;
+            };
+
+        uint64_t count = 0;
+        if (large)
+        {
+            if (!read(&count, sizeof(uint64_t))) return false;
+        }
+        else
+        {
+            uint32_t count32;
+            if (!read(&count32, sizeof(count32))) return false;
+            count = count32;
+        }
+
+        for (uint64_t i = 0; i < count; i++)
+        {
+            uint32_t type;
+            uint64_t textureSize = 0;
+            if (!read(&type, sizeof(type))) return false;
+
+            if (large)
+            {
+                uint32_t reserved;
+                if (!read(&reserved, sizeof(reserved)) || !read(&textureSize, sizeof(textureSize))) return false;
+            }
+            else
+            {
+                uint32_t size32;
+                if (!read(&size32, sizeof(size32))) return false;
+                textureSize = size32;
+            }
+
+            if (textureSize > remaining) return false;
+
+            textures.push_back({ static_cast<TextureType>(type), Span<uint8_t>(p, static_cast<size_t>(textureSize)) });
+            p += textureSize;
+            remaining -= textureSize;
+        }
+
+        return true;
+    }
+
+    // 読み込みの設定
+    struct ImdlReadOptions
+    {
+        bool verifyChecksums = false;   // チェックサムを確認する（記録されている場合）
+        unsigned threads = 0;           // 展開、確認に使うスレッド数（0 = 論理コア数）
+    };
+
+    class ImdlReader
+    {
+    public:
+
+        ImdlReader() = default;
+
+        ImdlReader(const ImdlReader&) = delete;
+        ImdlReader& operator=(const ImdlReader&) = delete;
+
+        // ファイルを開く関数
+        // ※失敗した場合は GetError で理由を取得できる
+        bool Open(const std::filesystem::path& path, const ImdlReadOptions& options = ImdlReadOptions())
+        {
+            Close();
+
+            if (!m_file.Open(path))
+            {
+                return Fail("could not open the file");
+            }
+
+            if (!Parse(options))
+            {
+                m_file.Close();
+                return false;
+            }
+
+            return true;
+        }
+
+        // ファイルを閉じる関数
+        void Close()
+        {
+            m_file.Close();
+            m_chunks.clear();
+            m_owned.clear();
+            m_textures.clear();
+            m_gpuDescs = Span<GpuTextureDesc>();
+            m_gpuFootprints = Span<GpuSubresourceFootprint>();
+            m_version = 0;
+            m_fileFlags = 0;
+            m_error.clear();
+        }
+
+        // 開いているか？
+        bool IsOpen() const
+        {
+            return m_file.IsOpen();
+        }
+
+        // エラーの内容を取得する関数
+        const std::string& GetError() const
+        {
+            return m_error;
+        }
+
+        // バージョンを取得する関数
+        uint32_t GetVersion() const
+        {
+            return m_version;
+        }
+
+        // 4GB 超え用のファイルか？
+        bool IsLarge() const
+        {
+            return (m_fileFlags & IMDL_FILE_FLAG_LARGE) != 0;
+        }
+
+        // チャンクのデータを取得する関数（圧縮されている場合は展開後のデータ）
+        Span<uint8_t> GetChunkData(uint32_t type) const
+        {
+            const Chunk* chunk = FindChunk(type);
+            return chunk ? chunk->data : Span<uint8_t>();
+        }
+
+        // チャンクのフラグを取得する関数
+        uint32_t GetChunkFlags(uint32_t type) const
+        {
+            const Chunk* chunk = FindChunk(type);
+            return chunk ? chunk->flags : 0;
+        }
+
+        // マテリアル
+        Span<MaterialInfo> GetMaterials() const
+        {
+            return GetArray<MaterialInfo>(CHUNK_MATERIAL);
+        }
+
+        // メッシュ
+        Span<MeshInfo> GetMeshes() const
+        {
+            return GetArray<MeshInfo>(CHUNK_MESH);
+        }
+
+        // 頂点
+        Span<VertexPositionNormalTextureTangent> GetVertices() const
+        {
+            return GetArray<VertexPositionNormalTextureTangent>(CHUNK_VERTEX);
+        }
+
+        // インデックス
+        Span<uint32_t> GetIndices() const
+        {
+            return GetArray<uint32_t>(CHUNK_INDEX);
+        }
+
+        // テクスチャ（DDS）
+        // ※GPU アップロード用の配置の場合は空（GetGpuTextureXXX を使う）
+        const std::vector<TextureView>& GetTextures() const
+        {
+            return m_textures;
+        }
+
+        // テクスチャチャンクが GPU アップロード用の配置か？
+        bool HasGpuTextureLayout() const
+        {
+            return (GetChunkFlags(CHUNK_TEXTURE) & IMDL_CHUNK_FLAG_GPU_LAYOUT) != 0;
+        }
+
+        // GPU アップロード用の配置のテクスチャ情報
+        Span<GpuTextureDesc> GetGpuTextureDescs() const
+        {
+            return m_gpuDescs;
+        }
+
+        // GPU アップロード用の配置のサブリソースのフットプリント
+        // ※offset はテクスチャチャンク（GetChunkData(CHUNK_TEXTURE)）の先頭からの位置
+        Span<GpuSubresourceFootprint> GetGpuFootprints() const
+        {
+            return m_gpuFootprints;
+        }
+
+    private:
+
+        // チャンクの情報
+        struct Chunk
+        {
+            uint32_t type;
+            uint32_t flags;
+            Span<uint8_t> data;
+        };
+
+        bool Fail(const std::string& error)
+        {
+            m_error = error;
+            return false;
+        }
+
+        const Chunk* FindChunk(uint32_t type) const
+        {
+            for (const auto& chunk : m_chunks)
+            {
+                if (chunk.type == type) return &chunk;
+            }
+            return nullptr;
+        }
+
+        Chunk* FindChunk(uint32_t type)
+        {
+            for (auto& chunk : m_chunks)
+            {
+                if (chunk.type == type) return &chunk;
+            }
+            return nullptr;
+        }
+
+        // 配列チャンクを取得する関数
+        // ※バージョン１は先頭の個数を読み飛ばす
+        template<typename T>
+        Span<T> GetArray(uint32_t type) const
+        {
+            Span<uint8_t> data = GetChunkData(type);
+            if (data.empty()) return Span<T>();
+
+            if (m_version == IMDL_VERSION_1)
+            {
+                uint32_t count;
+                std::memcpy(&count, data.data(), sizeof(count));
+                return Span<T>(reinterpret_cast<const T*>(data.data() + sizeof(uint32_t)), count);
+            }
+            return Span<T>(reinterpret_cast<const T*>(data.data()), data.size() / sizeof(T));
+        }
+
+        // 配列チャンクのサイズとアライメントを確認する関数
+        // ※アライメントが合わない場合（バージョン１）は内部のバッファにコピーする
+        template<typename T>
+        bool ValidateArray(uint32_t type)
+        {
+            Chunk* chunk = FindChunk(type);
+            if (chunk == nullptr) return true;
+
+            size_t header = 0;
+            if (m_version == IMDL_VERSION_1)
+            {
+                uint32_t count;
+                if (chunk->data.size() < sizeof(count)) return false;
+                std::memcpy(&count, chunk->data.data(), sizeof(count));
+                if (chunk->data.size() - sizeof(count) != sizeof(T) * static_cast<uint64_t>(count)) return false;
+                header = sizeof(count);
+            }
+            else if (chunk->data.size() % sizeof(T) != 0)
+            {
+                return false;
+            }
+
+            if (reinterpret_cast<uintptr_t>(chunk->data.data() + header) % alignof(T) != 0)
+            {
+                // 先頭の個数の分ずらしてコピーして、配列の先頭を揃える
+                m_owned.emplace_back(chunk->data.size() + alignof(T));
+                std::vector<uint8_t>& buffer = m_owned.back();
+                uint8_t* dst = buffer.data() + (alignof(T) - header % alignof(T)) % alignof(T);
+                std::memcpy(dst, chunk->data.data(), chunk->data.size());
+                chunk->data = Span<uint8_t>(dst, chunk->data.size());
+            }
+
+            return true;
+        }
+
+        // テクスチャチャンクを解析する関数
+        bool ParseTextures()
+        {
+            const Chunk* chunk = FindChunk(CHUNK_TEXTURE);
+            if (chunk == nullptr) return true;
+
+            const uint8_t* p = chunk->data.data();
+            uint64_t remaining = chunk->data.size();
+
+            auto read = [&](void* dst, size_t size)
+                {
+                    if (remaining < size) return false;
+                    std::memcpy(dst, p, size);
+                    p += size;
+                    remaining -= size;
+                    return true;
+                };
+
+            // GPU アップロード用の配置
+            if (chunk->flags & IMDL_CHUNK_FLAG_GPU_LAYOUT)
+            {
+                GpuTextureChunkHeader header;
+                if (!read(&header, sizeof(header))) return false;
+
+                uint64_t tableSize = sizeof(GpuTextureDesc) * static_cast<uint64_t>(header.textureCount)
+                    + sizeof(GpuSubresourceFootprint) * static_cast<uint64_t>(header.subresourceCount);
+                if (tableSize > remaining || header.dataOffset > chunk->data.size()) return false;
+                if (reinterpret_cast<uintptr_t>(p) % alignof(GpuTextureDesc) != 0) return false;
+
+                m_gpuDescs = Span<GpuTextureDesc>(reinterpret_cast<const GpuTextureDesc*>(p), header.textureCount);
+                m_gpuFootprints = Span<GpuSubresourceFootprint>(
+                    reinterpret_cast<const GpuSubresourceFootprint*>(p + sizeof(GpuTextureDesc) * header.textureCount), header.subresourceCount);
+
+                for (const auto& footprint : m_gpuFootprints)
+                {
+                    uint64_t size = static_cast<uint64_t>(footprint.rowPitch) * footprint.numRows * footprint.depth;
+                    if (footprint.offset > chunk->data.size() || size > chunk->data.size() - footprint.offset) return false;
+                }
+                for (const auto& desc : m_gpuDescs)
+                {
+                    if (static_cast<uint64_t>(desc.firstSubresource) + desc.subresourceCount > header.subresourceCount) return false;
+                }
+                return true;
+            }
+
+            // DDS の配列
+            return ParseTextureList(p, remaining, IsLarge(), m_textures);
+        }
+
+        // バージョン１のチャンクを取得する関数
+        bool ParseV1()
+        {
+            const uint8_t* data = m_file.GetData();
+            uint64_t size = m_file.GetSize();
+
+            FileHeader header;
+            std::memcpy(&header, data, sizeof(header));
+
+            uint64_t pos = sizeof(FileHeader);
+            for (uint32_t i = 0; i < header.chunkCount; i++)
+            {
+                if (size - pos < sizeof(ChunkHeader)) return Fail("chunk header out of range");
+
+                ChunkHeader chunk;
+                std::memcpy(&chunk, data + pos, sizeof(chunk));
+                pos += sizeof(ChunkHeader);
+
+                if (chunk.size > size - pos) return Fail("chunk " + GetChunkTypeName(chunk.type) + " out of range");
+
+                m_chunks.push_back({ chunk.type, 0, Span<uint8_t>(data + pos, chunk.size) });
+                pos += chunk.size;
+            }
+
+            return true;
+        }
+
+        // バージョン２のチャンクを取得する関数
+        bool ParseV2(const ImdlReadOptions& options)
+        {
+            const uint8_t* data = m_file.GetData();
+            uint64_t size = m_file.GetSize();
+
+            FileHeaderV2 header;
+            std::vector<ChunkEntry64> entries;
+            if (!ParseChunkTable(data, size, header, entries)) return Fail("chunk table is corrupted");
+
+            m_fileFlags = header.flags;
+
+            // ----- チェックサムの確認 ----- //
+            if (options.verifyChecksums && (header.flags & IMDL_FILE_FLAG_CHECKSUM))
+            {
+                ChunkChecksums checksums;
+                const ChunkEntry64* entry = Imase::FindChunk(entries, CHUNK_CHECKSUM);
+                if (entry == nullptr || !ParseChecksumChunk(data + entry->offset, static_cast<size_t>(entry->size), entries.size(), checksums))
+                {
+                    return Fail("checksum chunk is corrupted");
+                }
+
+                if (Crc32c(data, static_cast<size_t>(GetChunkTableEnd(header))) != checksums.tableCrc)
+                {
+                    return Fail("header checksum mismatch");
+                }
+
+                for (size_t i = 0; i < entries.size(); i++)
+                {
+                    if (entries[i].type == CHUNK_CHECKSUM) continue;
+                    if (Crc32cParallel(data + entries[i].offset, static_cast<size_t>(entries[i].size), options.threads) != checksums.chunkCrcs[i])
+                    {
+                        return Fail("chunk " + GetChunkTypeName(entries[i].type) + " checksum mismatch");
+                    }
+                }
+            }
+
+            // ----- チャンクの取得 ----- //
+            // ※圧縮されたチャンクはまとめて全コアで展開する
+            std::vector<DecompressJob> jobs;
+
+            for (const auto& entry : entries)
+            {
+                const uint8_t* src = data + entry.offset;
+                size_t srcSize = static_cast<size_t>(entry.size);
+
+                if ((entry.flags & IMDL_CHUNK_FLAG_COMPRESSION_MASK) == COMPRESSION_NONE)
+                {
+                    m_chunks.push_back({ entry.type, entry.flags, Span<uint8_t>(src, srcSize) });
+                    continue;
+                }
+
+                uint64_t rawSize;
+                if (!GetDecompressedSize(entry.flags, src, srcSize, rawSize) || rawSize > SIZE_MAX)
+                {
+                    return Fail("chunk " + GetChunkTypeName(entry.type) + " is corrupted");
+                }
+
+                m_owned.emplace_back(static_cast<size_t>(rawSize));
+                std::vector<uint8_t>& buffer = m_owned.back();
+
+                jobs.push_back({ entry.flags, src, srcSize, buffer.data(), buffer.size() });
+                m_chunks.push_back({ entry.type, entry.flags, Span<uint8_t>(buffer.data(), buffer.size()) });
+            }
+
+            if (!DecompressChunks(jobs, options.threads))
+            {
+                return Fail("could not decompress chunks");
+            }
+
+            return true;
+        }
+
+        // ファイルを解析する関数
+        bool Parse(const ImdlReadOptions& options)
+        {
+            FileHeader header;
+            if (m_file.GetSize() < sizeof(header)) return Fail("file is too small");
+            std::memcpy(&header, m_file.GetData(), sizeof(header));
+
+            if (header.magic != IMDL_MAGIC) return Fail("not an imdl file");
+
+            m_version = header.version;
+
+            bool succeeded = false;
+            if (m_version == IMDL_VERSION_1)
+            {
+                succeeded = ParseV1();
+            }
+            else if (m_version == IMDL_VERSION_2)
+            {
+                succeeded = ParseV2(options);
+            }
+            else
+            {
+                return Fail("unsupported version " + std::to_string(m_version));
+            }
+            if (!succeeded) return false;
+
+            // ----- データの確認 ----- //
+            if (!ValidateArray<MaterialInfo>(CHUNK_MATERIAL)) return Fail("material chunk is corrupted");
+            if (!ValidateArray<MeshInfo>(CHUNK_MESH)) return Fail("mesh chunk is corrupted");
+            if (!ValidateArray<VertexPositionNormalTextureTangent>(CHUNK_VERTEX)) return Fail("vertex chunk is corrupted");
+            if (!ValidateArray<uint32_t>(CHUNK_INDEX)) return Fail("index chunk is corrupted");
+            if (!ParseTextures()) return Fail("texture chunk is corrupted");
+
+            return true;
+        }
+
+    private:
+
+        // マップしたファイル
+        MappedFile m_file;
+
+        // バージョン
+        uint32_t m_version = 0;
+
+        // ファイルフラグ
+        uint32_t m_fileFlags = 0;
+
+        // チャンクの一覧
+        std::vector<Chunk> m_chunks;
+
+        // 展開したチャンク、アライメントを揃えたチャンクのデータ
+        std::vector<std::vector<uint8_t>> m_owned;
+
+        // テクスチャ
+        std::vector<TextureView> m_textures;
+
+        // GPU アップロード用の配置のテクスチャ
+        Span<GpuTextureDesc> m_gpuDescs;
+        Span<GpuSubresourceFootprint> m_gpuFootprints;
+
+        // エラーの内容
+        std::string m_error;
+    };
+}
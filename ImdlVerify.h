@@ -0,0 +1,207 @@
+﻿//--------------------------------------------------------------------------------------
+// File: ImdlVerify.h
+//
+// モデルデータ(.imdl)が壊れていないか確認する関数
+//
+// ※ファイルをメモリにマップして、チャンクテーブルの範囲とチェックサムを確認する
+// ※圧縮されたチャンクはブロックテーブルも確認する（展開はしない）
+// ※チェックサムはブロックに分割して全コアで計算する
+//
+// Date: 2026.3.9
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <iostream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "Checksum.h"
+#include "ChunkIO.h"
+#include "Compression.h"
+#include "Imdl.h"
+#include "MappedFile.h"
+#include "TextEncoding.h"
+
+namespace Imase
+{
+    // チャンクの確認結果
+    struct ChunkVerifyResult
+    {
+        uint32_t type;      // チャンクタイプ
+        uint64_t size;      // データサイズ
+        bool hasChecksum;   // チェックサムが記録されているか
+        bool valid;         // 壊れていないか
+    };
+
+    // バージョン１のファイルのチャンクの範囲を確認する関数（チェックサムはない）
+    inline bool VerifyImdlV1(const uint8_t* data, uint64_t size, std::vector<ChunkVerifyResult>& results, std::string& error)
+    {
+        FileHeader header;
+        std::memcpy(&header, data, sizeof(header));
+
+        uint64_t pos = sizeof(FileHeader);
+        for (uint32_t i = 0; i < header.chunkCount; i++)
+        {
+            if (size - pos < sizeof(ChunkHeader))
+            {
+                error = "chunk header out of range";
+                return false;
+            }
+
+            ChunkHeader chunk;
+            std::memcpy(&chunk, data + pos, sizeof(chunk));
+            pos += sizeof(ChunkHeader);
+
+            if (chunk.size > size - pos)
+            {
+                error = "chunk " + GetChunkTypeName(chunk.type) + " out of range";
+                return false;
+            }
+
+            results.push_back({ chunk.type, chunk.size, false, true });
+            pos += chunk.size;
+        }
+
+        return true;
+    }
+
+    // バージョン２のファイルのチャンクテーブルとチェックサムを確認する関数
+    inline bool VerifyImdlV2(const uint8_t* data, uint64_t size, std::vector<ChunkVerifyResult>& results, std::string& error, unsigned threads)
+    {
+        FileHeaderV2 header;
+        std::vector<ChunkEntry64> entries;
+        if (!ParseChunkTable(data, size, header, entries))
+        {
+            error = "chunk table is corrupted";
+            return false;
+        }
+
+        ChunkChecksums checksums;
+        bool hasChecksum = false;
+
+        if (header.flags & IMDL_FILE_FLAG_CHECKSUM)
+        {
+            const ChunkEntry64* entry = FindChunk(entries, CHUNK_CHECKSUM);
+            if (entry == nullptr || !ParseChecksumChunk(data + entry->offset, static_cast<size_t>(entry->size), entries.size(), checksums))
+            {
+                error = "checksum chunk is corrupted";
+                return false;
+            }
+
+            if (Crc32c(data, static_cast<size_t>(GetChunkTableEnd(header))) != checksums.tableCrc)
+            {
+                error = "header checksum mismatch";
+                return false;
+            }
+
+            hasChecksum = true;
+        }
+
+        bool succeeded = true;
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            const ChunkEntry64& entry = entries[i];
+
+            // ※チェックサムチャンク自身は読み込み時に確認済み
+            ChunkVerifyResult result{ entry.type, entry.size, hasChecksum, true };
+            if (hasChecksum && entry.type != CHUNK_CHECKSUM)
+            {
+                result.valid = Crc32cParallel(data + entry.offset, static_cast<size_t>(entry.size), threads) == checksums.chunkCrcs[i];
+            }
+
+            if (!result.valid)
+            {
+                error = "chunk " + GetChunkTypeName(entry.type) + " checksum mismatch";
+                succeeded = false;
+            }
+
+            // 圧縮されたチャンクのブロックテーブル（このビルドで展開できる形式のみ）
+            CompressionType compression = static_cast<CompressionType>(entry.flags & IMDL_CHUNK_FLAG_COMPRESSION_MASK);
+            CompressedChunkHeader compressed;
+            if (result.valid && compression != COMPRESSION_NONE && IsCompressionSupported(compression)
+                && !ValidateCompressedChunk(entry.flags, data + entry.offset, static_cast<size_t>(entry.size), compressed))
+            {
+                result.valid = false;
+                error = "chunk " + GetChunkTypeName(entry.type) + " block table is corrupted";
+                succeeded = false;
+            }
+            results.push_back(result);
+        }
+
+        return succeeded;
+    }
+
+    // メモリ上のファイルイメージを確認する関数
+    inline bool VerifyImdlData(const uint8_t* data, uint64_t size, std::vector<ChunkVerifyResult>& results, std::string& error, unsigned threads = 0)
+    {
+        results.clear();
+
+        FileHeader header;
+        if (size < sizeof(header))
+        {
+            error = "file is too small";
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.magic != IMDL_MAGIC)
+        {
+            error = "not an imdl file";
+            return false;
+        }
+
+        if (header.version == IMDL_VERSION_1)
+        {
+            return VerifyImdlV1(data, size, results, error);
+        }
+
+        if (header.version == IMDL_VERSION_2)
+        {
+            return VerifyImdlV2(data, size, results, error, threads);
+        }
+
+        error = "unsupported version " + std::to_string(header.version);
+        return false;
+    }
+
+    // ファイルを確認して結果を表示する関数
+    inline bool VerifyImdlFile(const std::filesystem::path& path, unsigned threads = 0)
+    {
+        MappedFile file;
+        if (!file.Open(path))
+        {
+            std::wcerr << L"Could not open " << ToWString(path) << std::endl;
+            return false;
+        }
+
+        std::vector<ChunkVerifyResult> results;
+        std::string error;
+
+        Stopwatch stopwatch;
+        bool succeeded = VerifyImdlData(file.GetData(), file.GetSize(), results, error, threads);
+        double sec = stopwatch.ElapsedSec();
+
+        bool hasChecksum = false;
+        for (const auto& result : results)
+        {
+            std::cout << "  " << GetChunkTypeName(result.type) << ": " << result.size << " bytes, "
+                << (!result.valid ? "CORRUPTED" : result.hasChecksum ? "ok" : "no checksum") << std::endl;
+            hasChecksum = hasChecksum || result.hasChecksum;
+        }
+
+        std::wcout << ToWString(path);
+        if (!succeeded)
+        {
+            std::cout << ": CORRUPTED (" << error << ")" << std::endl;
+            return false;
+        }
+
+        std::cout << ": " << (hasChecksum ? "OK" : "OK (no checksums, structure only)")
+            << ", " << file.GetSize() << " bytes in " << sec * 1000.0 << " ms ("
+            << ToMBps(file.GetSize(), sec) << " MB/s, crc32c " << (IsCrc32cHardwareAccelerated() ? "sse4.2" : "software") << ")" << std::endl;
+
+        return true;
+    }
+}
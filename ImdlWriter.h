@@ -0,0 +1,634 @@
+﻿//--------------------------------------------------------------------------------------
+// File: ImdlWriter.h
+//
+// モデルデータ(.imdl)をファイルへ直接書き出す関数
+// ※WriteImdlMemory はファイルの代わりにメモリへ書き出す（同じ内容になる）
+//
+// ※先にファイル全体のレイアウトを計算してファイルをメモリにマップし、
+//   各チャンクは自分の領域へ並列に直接シリアライズする
+// ※一時ファイルに書き込んでから最後にリネームするので、
+//   失敗しても既存の出力ファイルは壊れない
+// ※エラーや圧縮の結果は表示せずに、error と統計（ImdlWriteStats）で返す
+//
+// バージョン１ : FileHeader + (ChunkHeader + データ) * chunkCount
+// バージョン２ : FileHeaderV2 + ChunkEntry * chunkCount + データ（alignment 境界に配置）
+//               4GB を超える場合は ChunkEntry64 を使う（IMDL_FILE_FLAG_LARGE）
+//               最後にチェックサムチャンク（CSUM）を追加する（IMDL_FILE_FLAG_CHECKSUM）
+//
+// Date: 2026.3.4
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+#include "Benchmark.h"
+#include "BinaryWriter.h"
+#include "ChunkIO.h"
+#include "Compression.h"
+#include "Imdl.h"
+#include "MappedFile.h"
+#include "Trace.h"
+
+namespace Imase
+{
+    // 書き出すチャンクの情報
+    struct ChunkSource
+    {
+        uint32_t type;                              // チャンクタイプ
+        size_t size;                                // データサイズ
+        std::function<void(MemoryWriter&)> write;   // データの書き込み関数
+        uint32_t flags = 0;                         // チャンクフラグ（IMDL_CHUNK_FLAG_XXX）
+        uint32_t alignment = 0;                     // データのアライメント（0 = 設定の alignment、バージョン２のみ）
+    };
+
+    // 書き出しの設定
+    struct ImdlWriteSettings
+    {
+        uint32_t version = IMDL_VERSION_1;              // ファイルのバージョン（1 or 2）
+        uint32_t alignment = IMDL_DEFAULT_ALIGNMENT;    // データのアライメント（バージョン２のみ）
+        bool large = false;                             // 4GB 超え用（バージョン２のみ）
+        bool upgradeVersion = true;                     // 4GB を超える場合にバージョン１を４GB 超え用のバージョン２に切り替える（false の場合はエラー）
+        std::map<uint32_t, CompressionSettings> compression;    // チャンクタイプごとの圧縮設定（バージョン２のみ）
+        bool checksum = false;                          // チェックサムを記録する（バージョン２のみ）
+        bool gpuLayout = false;                         // GPU アップロード用の配置（バージョン２のみ）
+        bool sync = false;                              // ディスクへの書き込みを待ってから名前を変更する
+        bool verifyCompression = false;                 // 圧縮したチャンクを展開して確認し、展開速度を計測する
+
+        // 変換の設定（書き出しには使わない、出力の内容が変わるので設定と一緒に扱う）
+        bool sortTextures = false;                      // テクスチャをファイル名と種類の順に並べる（SortTextureRequests）
+        bool cpuTextures = false;                       // テクスチャを CPU で圧縮する（GPU で圧縮したテクスチャとは結果が異なる）
+    };
+
+    // チャンクの書き出しの統計
+    struct ChunkWriteStats
+    {
+        uint32_t type = 0;          // チャンクタイプ
+        uint32_t flags = 0;         // チャンクフラグ（圧縮形式など）
+        uint64_t rawSize = 0;       // 圧縮前のサイズ
+        uint64_t storedSize = 0;    // ファイルに記録したサイズ
+        uint64_t compressedSize = 0; // 圧縮後のサイズ（小さくならずに圧縮しなかった場合も記録する、0 = 圧縮していない）
+        double decodeSec = 0.0;     // 展開の確認にかかった時間（verifyCompression の場合のみ）
+        uint64_t offset = 0;        // データ位置
+        StageTime build;            // 圧縮するチャンクのデータ作成と圧縮（verifyCompression の場合は展開の確認を含む、圧縮しない場合は 0）
+        StageTime write;            // 書き出し先へのシリアライズ（CPU 時間は書き込んだスレッドのみ）
+    };
+
+    // 書き出しの統計（WriteImdlFile、WriteImdlMemory に渡すと記録する）
+    struct ImdlWriteStats
+    {
+        std::vector<ChunkWriteStats> chunks;    // 書き出した順（チェックサムチャンクを含む）
+        uint64_t fileSize = 0;                  // ファイルサイズ
+        bool large = false;                     // 4GB 超え用の形式で書き出したか
+        StageTime serialize;                    // ヘッダ、全チャンク、チェックサムの書き込み
+        StageTime flush;                        // マップの解除（sync の場合はディスクへの書き込み）と名前の変更（メモリへの書き出しは 0）
+    };
+
+    // チャンク情報を作成する関数の型
+    // ※書き出しの設定（4GB 超え用かどうか）によってチャンクのサイズが変わるため
+    using ChunkBuilder = std::function<std::vector<ChunkSource>(const ImdlWriteSettings&)>;
+
+    // アライメントとして使える値か？（４以上の２のべき乗）
+    inline bool IsValidAlignment(uint32_t alignment)
+    {
+        return alignment >= 4 && (alignment & (alignment - 1)) == 0;
+    }
+
+    // 配列チャンクのサイズを取得する関数
+    // バージョン１ : 【uint32_t】(count) + 【T】 * count
+    // バージョン２ : 【T】 * count（個数はチャンクサイズから求める）
+    template<typename T>
+    size_t GetVectorChunkSize(const std::vector<T>& vec, uint32_t version)
+    {
+        size_t size = sizeof(T) * vec.size();
+        if (version == IMDL_VERSION_1) size += sizeof(uint32_t);
+        return size;
+    }
+
+    // 配列チャンクの情報を作成する関数
+    // ※vec は書き出しが終わるまで保持しておくこと
+    template<typename T>
+    ChunkSource MakeVectorChunk(uint32_t type, const std::vector<T>& vec, const ImdlWriteSettings& settings)
+    {
+        if (settings.version == IMDL_VERSION_1)
+        {
+            return { type, GetVectorChunkSize(vec, settings.version), [&vec](MemoryWriter& writer) { writer.WriteVector(vec); } };
+        }
+        return { type, GetVectorChunkSize(vec, settings.version), [&vec](MemoryWriter& writer) { writer.WriteArray(vec.data(), vec.size()); } };
+    }
+
+    // チャンクデータの配置を計算する関数（戻り値はファイルサイズ）
+    inline uint64_t ComputeImdlLayout(
+        const std::vector<ChunkSource>& chunks,
+        const ImdlWriteSettings& settings,
+        std::vector<uint64_t>& dataOffsets)
+    {
+        dataOffsets.resize(chunks.size());
+
+        if (settings.version == IMDL_VERSION_1)
+        {
+            uint64_t pos = sizeof(FileHeader);
+            for (size_t i = 0; i < chunks.size(); i++)
+            {
+                dataOffsets[i] = pos + sizeof(ChunkHeader);
+                pos = dataOffsets[i] + chunks[i].size;
+            }
+            return pos;
+        }
+
+        size_t entrySize = settings.large ? sizeof(ChunkEntry64) : sizeof(ChunkEntry);
+
+        uint64_t pos = sizeof(FileHeaderV2) + entrySize * chunks.size();
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            // チャンクごとにアライメントが指定されている場合は大きい方に揃える
+            uint32_t alignment = chunks[i].alignment > settings.alignment ? chunks[i].alignment : settings.alignment;
+            dataOffsets[i] = AlignUp(pos, alignment);
+            pos = dataOffsets[i] + chunks[i].size;
+        }
+        return pos;
+    }
+
+    // チェックサムを記録するか？
+    inline bool HasChecksumChunk(const ImdlWriteSettings& settings)
+    {
+        return settings.version == IMDL_VERSION_2 && settings.checksum;
+    }
+
+    // 書き出すチャンクの一覧を取得する関数
+    // ※チェックサムを記録する場合は最後にチェックサムチャンクを追加する
+    //   （データは全チャンクの書き込み後に計算して書き込むので、ここでは領域のみ確保する）
+    inline std::vector<ChunkSource> GetOutputChunks(const std::vector<ChunkSource>& sources, const ImdlWriteSettings& settings)
+    {
+        std::vector<ChunkSource> chunks = sources;
+        if (HasChecksumChunk(settings))
+        {
+            size_t size = sizeof(ChecksumChunkHeader) + sizeof(uint32_t) * (sources.size() + 1);
+            chunks.push_back({ CHUNK_CHECKSUM, size, nullptr });
+        }
+        return chunks;
+    }
+
+    // 4GB 超え用のフォーマットが必要か？
+    // ※サイズ、位置を 32bit で記録できない場合
+    inline bool RequiresLargeFormat(const std::vector<ChunkSource>& chunks, const ImdlWriteSettings& settings)
+    {
+        std::vector<uint64_t> dataOffsets;
+        return ComputeImdlLayout(GetOutputChunks(chunks, settings), settings, dataOffsets) > UINT32_MAX;
+    }
+
+    // 4GB 超え用のフォーマットに切り替える関数
+    // ※バージョン１が指定されている場合（upgradeVersion が false）は切り替えずに false を返す
+    inline bool SwitchToLargeFormat(ImdlWriteSettings& settings, std::string& error)
+    {
+        if (settings.version != IMDL_VERSION_2 && !settings.upgradeVersion)
+        {
+            error = "Output exceeds 4GB; v1 cannot represent it, use --format-version 2";
+            return false;
+        }
+
+        settings.version = IMDL_VERSION_2;
+        settings.large = true;
+        return true;
+    }
+
+    // チェックサムを計算してチェックサムチャンクに書き込む関数
+    // ※各チャンクはブロックに分割して全コアで計算する
+    inline void WriteChecksumChunk(uint8_t* base, const std::vector<ChunkSource>& chunks, const std::vector<uint64_t>& dataOffsets, uint64_t tableEnd)
+    {
+        size_t checksumIndex = chunks.size() - 1;
+
+        ChecksumChunkHeader header{};
+        header.tableCrc = Crc32c(base, static_cast<size_t>(tableEnd));
+        header.chunkCount = static_cast<uint32_t>(chunks.size());
+
+        std::vector<uint32_t> crcs(chunks.size(), 0);
+        for (size_t i = 0; i < checksumIndex; i++)
+        {
+            crcs[i] = Crc32cParallel(base + dataOffsets[i], chunks[i].size);
+        }
+
+        MemoryWriter writer(base + dataOffsets[checksumIndex], chunks[checksumIndex].size);
+        writer.WriteValue(header);
+        writer.WriteArray(crcs.data(), crcs.size());
+    }
+
+    // 書き出しの設定とチャンクのアライメントを確認する関数
+    inline bool ValidateImdlSources(const std::vector<ChunkSource>& sources, const ImdlWriteSettings& settings, std::string& error)
+    {
+        if (settings.version != IMDL_VERSION_1 && settings.version != IMDL_VERSION_2)
+        {
+            error = "Unsupported imdl version: " + std::to_string(settings.version);
+            return false;
+        }
+
+        if (settings.version == IMDL_VERSION_1 && settings.large)
+        {
+            error = "Large files require imdl version 2";
+            return false;
+        }
+
+        if (settings.version == IMDL_VERSION_2 && !IsValidAlignment(settings.alignment))
+        {
+            error = "Alignment must be a power of two (>= 4): " + std::to_string(settings.alignment);
+            return false;
+        }
+
+        for (const auto& chunk : sources)
+        {
+            if (chunk.alignment != 0 && !IsValidAlignment(chunk.alignment))
+            {
+                error = "Alignment must be a power of two (>= 4): " + std::to_string(chunk.alignment);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // ヘッダ、チャンクテーブル、チャンク、チェックサムを書き込む関数
+    // base : ComputeImdlLayout で求めたサイズのゼロで埋めた領域
+    // ※アライメントの隙間は書き込まないので、ゼロで埋めておくこと
+    inline bool SerializeImdl(
+        uint8_t* base,
+        const std::vector<ChunkSource>& sources,
+        const std::vector<ChunkSource>& chunks,
+        const std::vector<uint64_t>& dataOffsets,
+        const ImdlWriteSettings& settings,
+        std::string& error,
+        ImdlWriteStats* stats = nullptr)
+    {
+        StageTimer serializeTimer;
+
+        // ※圧縮の統計（build、rawSize、compressedSize、decodeSec）は CompressChunks で記録したものを残す
+        if (stats)
+        {
+            stats->chunks.resize(chunks.size());
+            stats->large = settings.large;
+            for (size_t i = 0; i < chunks.size(); i++)
+            {
+                ChunkWriteStats& entry = stats->chunks[i];
+                entry.type = chunks[i].type;
+                entry.flags = chunks[i].flags;
+                entry.storedSize = chunks[i].size;
+                entry.offset = dataOffsets[i];
+                if ((chunks[i].flags & IMDL_CHUNK_FLAG_COMPRESSION_MASK) == COMPRESSION_NONE)
+                {
+                    entry.rawSize = chunks[i].size;
+                    entry.build = StageTime();
+                }
+            }
+        }
+
+        // ----- Header ----- //
+        if (settings.version == IMDL_VERSION_1)
+        {
+            FileHeader fileHeader{};
+            fileHeader.magic = IMDL_MAGIC;
+            fileHeader.version = IMDL_VERSION_1;
+            fileHeader.chunkCount = static_cast<uint32_t>(chunks.size());
+            std::memcpy(base, &fileHeader, sizeof(fileHeader));
+
+            for (size_t i = 0; i < chunks.size(); i++)
+            {
+                ChunkHeader header{};
+                header.type = chunks[i].type;
+                header.size = static_cast<uint32_t>(chunks[i].size);
+                std::memcpy(base + dataOffsets[i] - sizeof(ChunkHeader), &header, sizeof(header));
+            }
+        }
+        else
+        {
+            FileHeaderV2 fileHeader{};
+            fileHeader.magic = IMDL_MAGIC;
+            fileHeader.version = IMDL_VERSION_2;
+            fileHeader.chunkCount = static_cast<uint32_t>(chunks.size());
+            fileHeader.alignment = settings.alignment;
+            fileHeader.flags = settings.large ? IMDL_FILE_FLAG_LARGE : 0;
+            if (HasChecksumChunk(settings)) fileHeader.flags |= IMDL_FILE_FLAG_CHECKSUM;
+            std::memcpy(base, &fileHeader, sizeof(fileHeader));
+
+            // チャンクテーブル
+            uint8_t* table = base + sizeof(FileHeaderV2);
+            for (size_t i = 0; i < chunks.size(); i++)
+            {
+                if (settings.large)
+                {
+                    ChunkEntry64 entry{};
+                    entry.type = chunks[i].type;
+                    entry.flags = chunks[i].flags;
+                    entry.offset = dataOffsets[i];
+                    entry.size = chunks[i].size;
+                    std::memcpy(table + sizeof(ChunkEntry64) * i, &entry, sizeof(entry));
+                }
+                else
+                {
+                    ChunkEntry entry{};
+                    entry.type = chunks[i].type;
+                    entry.flags = chunks[i].flags;
+                    entry.offset = static_cast<uint32_t>(dataOffsets[i]);
+                    entry.size = static_cast<uint32_t>(chunks[i].size);
+                    std::memcpy(table + sizeof(ChunkEntry) * i, &entry, sizeof(entry));
+                }
+            }
+        }
+
+        // ----- Chunk ----- //
+        // 各チャンクを自分の領域に並列で書き込む
+        std::vector<std::future<void>> tasks;
+        for (size_t i = 0; i < sources.size(); i++)
+        {
+            uint8_t* dst = base + dataOffsets[i];
+            const ChunkSource& chunk = chunks[i];
+            StageTime* time = stats ? &stats->chunks[i].write : nullptr;
+
+            tasks.push_back(std::async(std::launch::async, [dst, &chunk, time]()
+                {
+                    IMDL_TRACE_SCOPE_DETAIL("WriteChunk", GetChunkTypeName(chunk.type));
+                    StageTimer timer(true);
+                    MemoryWriter writer(dst, chunk.size);
+                    chunk.write(writer);
+                    if (time) *time = timer.Elapsed();
+                    if (writer.GetSize() != chunk.size)
+                    {
+                        throw std::runtime_error("Chunk size does not match the precomputed layout");
+                    }
+                }));
+        }
+
+        bool succeeded = true;
+        for (auto& task : tasks)
+        {
+            try
+            {
+                task.get();
+            }
+            catch (const std::exception& e)
+            {
+                if (succeeded) error = e.what();
+                succeeded = false;
+            }
+        }
+
+        // ----- Checksum ----- //
+        if (succeeded && HasChecksumChunk(settings))
+        {
+            IMDL_TRACE_SCOPE("WriteChecksumChunk");
+            StageTimer timer;
+            size_t entrySize = settings.large ? sizeof(ChunkEntry64) : sizeof(ChunkEntry);
+            WriteChecksumChunk(base, chunks, dataOffsets, sizeof(FileHeaderV2) + entrySize * chunks.size());
+            if (stats) stats->chunks.back().write = timer.Elapsed();
+        }
+
+        if (stats) stats->serialize = serializeTimer.Elapsed();
+
+        return succeeded;
+    }
+
+    // モデルデータをファイルに書き出す関数
+    // error : 失敗した理由
+    // stats : 書き出しの統計（nullptr 可）
+    inline bool WriteImdlFile(
+        const std::filesystem::path& path,
+        const std::vector<ChunkSource>& sources,
+        const ImdlWriteSettings& settings,
+        std::string& error,
+        ImdlWriteStats* stats = nullptr)
+    {
+        if (!ValidateImdlSources(sources, settings, error)) return false;
+
+        // ----- レイアウトの計算 ----- //
+        std::vector<ChunkSource> chunks = GetOutputChunks(sources, settings);
+        std::vector<uint64_t> dataOffsets;
+        uint64_t fileSize = ComputeImdlLayout(chunks, settings, dataOffsets);
+
+        // 4GB 超え用でなければサイズ、位置は 32bit で記録するので 4GB を超えるファイルは書き出せない
+        if (!settings.large && fileSize > UINT32_MAX)
+        {
+            error = "Output exceeds 4GB (use the large format): " + path.u8string();
+            return false;
+        }
+
+        // ----- 一時ファイルを作成してマップ ----- //
+        // ※アライメントの隙間はファイル作成時にゼロで埋まっている
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+
+        MappedFile file;
+        if (!file.Create(tempPath, fileSize))
+        {
+            error = "Could not create " + tempPath.u8string();
+            return false;
+        }
+
+        bool succeeded = SerializeImdl(file.GetData(), sources, chunks, dataOffsets, settings, error, stats);
+
+        // ----- 書き込み完了 ----- //
+        // ※マップを解除すれば内容はファイルに反映されるので、ディスクへの書き込みは sync の場合のみ待つ
+        IMDL_TRACE_SCOPE("FlushImdlFile");
+        StageTimer flushTimer;
+        if (succeeded && settings.sync && !file.Flush())
+        {
+            error = "Could not flush " + tempPath.u8string();
+            succeeded = false;
+        }
+        file.Close();
+
+        if (!succeeded)
+        {
+            std::filesystem::remove(tempPath);
+            error = "Could not write " + path.u8string() + (error.empty() ? "" : ": " + error);
+            return false;
+        }
+
+        // 一時ファイルを出力ファイル名に変更
+        std::error_code ec;
+        std::filesystem::rename(tempPath, path, ec);
+        if (ec)
+        {
+            std::filesystem::remove(tempPath);
+            error = "Could not rename to " + path.u8string();
+            return false;
+        }
+
+        if (stats)
+        {
+            stats->fileSize = fileSize;
+            stats->flush = flushTimer.Elapsed();
+        }
+
+        return true;
+    }
+
+    // モデルデータをメモリに書き出す関数
+    // output : 書き出したファイルの内容（ファイルに保存すればそのまま読み込める）
+    inline bool WriteImdlMemory(
+        std::vector<uint8_t>& output,
+        const std::vector<ChunkSource>& sources,
+        const ImdlWriteSettings& settings,
+        std::string& error,
+        ImdlWriteStats* stats = nullptr)
+    {
+        if (!ValidateImdlSources(sources, settings, error)) return false;
+
+        std::vector<ChunkSource> chunks = GetOutputChunks(sources, settings);
+        std::vector<uint64_t> dataOffsets;
+        uint64_t size = ComputeImdlLayout(chunks, settings, dataOffsets);
+
+        if ((!settings.large && size > UINT32_MAX) || static_cast<uint64_t>(static_cast<size_t>(size)) != size)
+        {
+            error = "Output exceeds 4GB (use the large format)";
+            return false;
+        }
+
+        output.assign(static_cast<size_t>(size), 0);
+        if (!SerializeImdl(output.data(), sources, chunks, dataOffsets, settings, error, stats))
+        {
+            output.clear();
+            return false;
+        }
+
+        if (stats)
+        {
+            stats->fileSize = size;
+            stats->flush = StageTime();
+        }
+
+        return true;
+    }
+
+    // 設定に従ってチャンクを圧縮する関数
+    // ※verifyCompression の場合は全ブロックを並列に展開して元のデータと一致するか確認し、展開時間を記録する
+    // ※圧縮しても小さくならないチャンクは圧縮しないで書き出す（ブロックテーブルの分だけ大きくなるので）
+    // stats : 圧縮したチャンクの処理時間、圧縮前後のサイズ、展開時間を記録する（nullptr 可）
+    inline bool CompressChunks(std::vector<ChunkSource>& chunks, const ImdlWriteSettings& settings, std::string& error, ImdlWriteStats* stats = nullptr)
+    {
+        if (stats) stats->chunks.assign(chunks.size(), ChunkWriteStats());
+        if (settings.compression.empty()) return true;
+
+        if (settings.version != IMDL_VERSION_2)
+        {
+            error = "Compression requires imdl version 2";
+            return false;
+        }
+
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            ChunkSource& chunk = chunks[i];
+            auto it = settings.compression.find(chunk.type);
+            if (it == settings.compression.end() || it->second.type == COMPRESSION_NONE) continue;
+
+            // GPU アップロード用の配置はそのままコピーして使うので圧縮しない
+            if (chunk.flags & IMDL_CHUNK_FLAG_GPU_LAYOUT) continue;
+
+            const CompressionSettings& compression = it->second;
+            if (!IsCompressionSupported(compression.type))
+            {
+                error = std::string("Unsupported compression: ") + GetCompressionName(compression.type);
+                return false;
+            }
+
+            // チャンクのデータを作成
+            IMDL_TRACE_SCOPE_DETAIL("CompressChunk", GetChunkTypeName(chunk.type));
+            StageTimer buildTimer;
+            std::vector<uint8_t> raw(chunk.size);
+            MemoryWriter writer(raw.data(), raw.size());
+            chunk.write(writer);
+
+            // 圧縮
+            std::shared_ptr<std::vector<uint8_t>> compressed;
+            try
+            {
+                compressed = std::make_shared<std::vector<uint8_t>>(CompressChunkData(raw.data(), raw.size(), compression));
+            }
+            catch (const std::exception& e)
+            {
+                error = GetChunkTypeName(chunk.type) + ": " + e.what();
+                return false;
+            }
+            uint32_t flags = (chunk.flags & ~IMDL_CHUNK_FLAG_COMPRESSION_MASK) | compression.type;
+
+            if (stats)
+            {
+                stats->chunks[i].rawSize = raw.size();
+                stats->chunks[i].compressedSize = compressed->size();
+            }
+
+            if (compressed->size() >= raw.size()) continue;
+
+            // 展開して確認（展開先の分メモリを使い、処理時間も増えるので指定された場合のみ）
+            if (settings.verifyCompression)
+            {
+                std::vector<uint8_t> decoded(raw.size());
+                Stopwatch stopwatch;
+                bool succeeded = DecompressChunks({ { flags, compressed->data(), compressed->size(), decoded.data(), decoded.size() } });
+                double sec = stopwatch.ElapsedSec();
+
+                if (!succeeded || decoded != raw)
+                {
+                    error = "Compression round trip failed: " + GetChunkTypeName(chunk.type);
+                    return false;
+                }
+
+                if (stats) stats->chunks[i].decodeSec = sec;
+            }
+
+            if (stats) stats->chunks[i].build = buildTimer.Elapsed();
+
+            chunk.size = compressed->size();
+            chunk.flags = flags;
+            chunk.write = [compressed](MemoryWriter& out) { out.WriteBytes(compressed->data(), compressed->size()); };
+        }
+
+        return true;
+    }
+
+    // モデルデータをファイルに書き出す関数
+    // ※4GB を超える場合は自動で 4GB 超え用のフォーマットに切り替える（stats の large で分かる、upgradeVersion が false のバージョン１はエラー）
+    // ※圧縮の設定がある場合は対象のチャンクを圧縮してから書き出す
+    inline bool WriteImdlFile(
+        const std::filesystem::path& path,
+        const ChunkBuilder& builder,
+        ImdlWriteSettings settings,
+        std::string& error,
+        ImdlWriteStats* stats = nullptr)
+    {
+        std::vector<ChunkSource> chunks = builder(settings);
+        if (!CompressChunks(chunks, settings, error, stats)) return false;
+
+        if (!settings.large && RequiresLargeFormat(chunks, settings))
+        {
+            if (!SwitchToLargeFormat(settings, error)) return false;
+            chunks = builder(settings);
+            if (!CompressChunks(chunks, settings, error, stats)) return false;
+        }
+
+        return WriteImdlFile(path, chunks, settings, error, stats);
+    }
+
+    // モデルデータをメモリに書き出す関数
+    // ※4GB を超える場合、圧縮の設定がある場合は WriteImdlFile と同じ
+    inline bool WriteImdlMemory(
+        std::vector<uint8_t>& output,
+        const ChunkBuilder& builder,
+        ImdlWriteSettings settings,
+        std::string& error,
+        ImdlWriteStats* stats = nullptr)
+    {
+        std::vector<ChunkSource> chunks = builder(settings);
+        if (!CompressChunks(chunks, settings, error, stats)) return false;
+
+        if (!settings.large && RequiresLargeFormat(chunks, settings))
+        {
+            if (!SwitchToLargeFormat(settings, error)) return false;
+            chunks = builder(settings);
+            if (!CompressChunks(chunks, settings, error, stats)) return false;
+        }
+
+        return WriteImdlMemory(output, chunks, settings, error, stats);
+    }
+}
@@ -0,0 +1,254 @@
+﻿//--------------------------------------------------------------------------------------
+// File: IoUring.h
+//
+// io_uring（Linux）で非同期に読み込むクラス
+//
+// ※liburing を使わずにシステムコールを直接呼び出す
+// ※読み込み用の最小限の機能のみ（READ / READ_FIXED、登録バッファ）
+//
+// Date: 2026.3.9
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define IMDL_HAS_IO_URING 1
+#endif
+#endif
+
+#if defined(IMDL_HAS_IO_URING)
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace Imase
+{
+    class IoUring
+    {
+    public:
+
+        IoUring() = default;
+
+        ~IoUring()
+        {
+            Close();
+        }
+
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+
+        // リングを作成する関数
+        // ※カーネルが対応していない、権限がない（コンテナなど）場合は false を返す
+        bool Initialize(unsigned entries)
+        {
+            Close();
+
+            io_uring_params params{};
+            m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (m_fd < 0) return false;
+
+            // ----- リングをマップ ----- //
+            m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+            m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+            // ※IORING_FEAT_SINGLE_MMAP の場合は SQ と CQ が同じ領域
+            bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single)
+            {
+                if (m_cqRingSize > m_sqRingSize) m_sqRingSize = m_cqRingSize;
+                m_cqRingSize = m_sqRingSize;
+            }
+
+            m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+            if (m_sqRing == MAP_FAILED)
+            {
+                m_sqRing = nullptr;
+                Close();
+                return false;
+            }
+
+            if (single)
+            {
+                m_cqRing = m_sqRing;
+            }
+            else
+            {
+                m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+                if (m_cqRing == MAP_FAILED)
+                {
+                    m_cqRing = nullptr;
+                    Close();
+                    return false;
+                }
+            }
+
+            m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED)
+            {
+                Close();
+                return false;
+            }
+            m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+            uint8_t* sq = static_cast<uint8_t*>(m_sqRing);
+            m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            m_sqEntries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+            m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+            uint8_t* cq = static_cast<uint8_t*>(m_cqRing);
+            m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            m_pending = 0;
+            m_unsubmitted = 0;
+
+            return true;
+        }
+
+        // 読み込み先のバッファを登録する関数（READ_FIXED で使う）
+        bool RegisterBuffers(const std::vector<iovec>& buffers)
+        {
+            if (m_fd < 0 || buffers.empty()) return false;
+            return syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS, buffers.data(), static_cast<unsigned>(buffers.size())) == 0;
+        }
+
+        // リングを閉じる関数
+        void Close()
+        {
+            if (m_sqes) munmap(m_sqes, m_sqesSize);
+            if (m_cqRing && m_cqRing != m_sqRing) munmap(m_cqRing, m_cqRingSize);
+            if (m_sqRing) munmap(m_sqRing, m_sqRingSize);
+            if (m_fd >= 0) close(m_fd);
+
+            m_sqes = nullptr;
+            m_sqRing = nullptr;
+            m_cqRing = nullptr;
+            m_fd = -1;
+        }
+
+        // 作成済みか？
+        bool IsOpen() const
+        {
+            return m_fd >= 0;
+        }
+
+        // 読み込みを積む関数（Submit を呼ぶまでカーネルには渡らない）
+        // bufferIndex : 登録バッファの番号（-1 = 登録バッファを使わない）
+        bool PrepareRead(int fd, void* dst, uint32_t size, uint64_t offset, int bufferIndex, uint64_t userData)
+        {
+            unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+            unsigned tail = *m_sqTail + m_pending;
+            if (tail - head >= m_sqEntries) return false;
+
+            unsigned index = tail & m_sqMask;
+            io_uring_sqe& sqe = m_sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = static_cast<uint8_t>(bufferIndex >= 0 ? IORING_OP_READ_FIXED : IORING_OP_READ);
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<uint64_t>(dst);
+            sqe.len = size;
+            sqe.off = offset;
+            sqe.buf_index = static_cast<uint16_t>(bufferIndex >= 0 ? bufferIndex : 0);
+            sqe.user_data = userData;
+
+            m_sqArray[index] = index;
+            m_pending++;
+
+            return true;
+        }
+
+        // 積んだ読み込みをカーネルに渡して、waitCount 個完了するまで待つ関数
+        // ※戻り値は 0 以上で成功、負の値はエラー（-errno）
+        int Submit(unsigned waitCount)
+        {
+            __atomic_store_n(m_sqTail, *m_sqTail + m_pending, __ATOMIC_RELEASE);
+
+            // ※前回カーネルが受け取らなかった分も合わせて渡す
+            unsigned submit = m_pending + m_unsubmitted;
+            m_pending = 0;
+
+            for (;;)
+            {
+                long ret = syscall(__NR_io_uring_enter, m_fd, submit, waitCount, waitCount > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                if (ret >= 0)
+                {
+                    m_unsubmitted = submit - static_cast<unsigned>(ret);
+                    return static_cast<int>(ret);
+                }
+                if (errno != EINTR)
+                {
+                    m_unsubmitted = submit;
+                    return -errno;
+                }
+            }
+        }
+
+        // 完了した読み込みを取り出す関数
+        // func(userData, result) : result は読み込んだサイズ、負の値はエラー（-errno）
+        template<typename F>
+        unsigned Reap(F&& func)
+        {
+            unsigned head = *m_cqHead;
+            unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+
+            unsigned count = 0;
+            while (head != tail)
+            {
+                const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+                uint64_t userData = cqe.user_data;
+                int result = cqe.res;
+
+                head++;
+                count++;
+                __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+
+                func(userData, result);
+            }
+            return count;
+        }
+
+    private:
+
+        int m_fd = -1;
+
+        // 投入キュー
+        void* m_sqRing = nullptr;
+        size_t m_sqRingSize = 0;
+        unsigned* m_sqHead = nullptr;
+        unsigned* m_sqTail = nullptr;
+        unsigned* m_sqArray = nullptr;
+        unsigned m_sqMask = 0;
+        unsigned m_sqEntries = 0;
+        io_uring_sqe* m_sqes = nullptr;
+        size_t m_sqesSize = 0;
+
+        // 完了キュー
+        void* m_cqRing = nullptr;
+        size_t m_cqRingSize = 0;
+        unsigned* m_cqHead = nullptr;
+        unsigned* m_cqTail = nullptr;
+        unsigned m_cqMask = 0;
+        io_uring_cqe* m_cqes = nullptr;
+
+        // 積んだがまだカーネルに渡していない数
+        unsigned m_pending = 0;
+
+        // カーネルに渡したが受け取られなかった数
+        unsigned m_unsubmitted = 0;
+    };
+}
+
+#endif
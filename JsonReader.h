@@ -0,0 +1,385 @@
+﻿//--------------------------------------------------------------------------------------
+// File: JsonReader.h
+//
+// JSON を読み込むクラス
+//
+// ※計測の基準（--bench-baseline）など、JsonWriter で書き出したファイルを読み込むのに使う
+// ※全体を読み込んで木（JsonValue）にする（大きなファイルは想定しない）
+// ※文字列は UTF-8 にする（\uXXXX のエスケープ、サロゲートペアも UTF-8 に変換する）
+//
+// Date: 2026.3.17
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Imase
+{
+    // JSON の値
+    class JsonValue
+    {
+    public:
+
+        enum class Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        Type GetType() const { return m_type; }
+
+        bool IsNull() const { return m_type == Type::Null; }
+        bool IsNumber() const { return m_type == Type::Number; }
+        bool IsString() const { return m_type == Type::String; }
+        bool IsArray() const { return m_type == Type::Array; }
+        bool IsObject() const { return m_type == Type::Object; }
+
+        // 値を取得する関数（型が違う場合は defaultValue）
+        bool AsBool(bool defaultValue = false) const { return m_type == Type::Bool ? m_bool : defaultValue; }
+        double AsNumber(double defaultValue = 0.0) const { return m_type == Type::Number ? m_number : defaultValue; }
+        std::string AsString(const std::string& defaultValue = std::string()) const { return m_type == Type::String ? m_string : defaultValue; }
+
+        // 配列の要素（配列以外は空）
+        const std::vector<JsonValue>& GetArray() const { return m_array; }
+
+        // オブジェクトのメンバー（書かれている順）
+        const std::vector<std::pair<std::string, JsonValue>>& GetMembers() const { return m_members; }
+
+        // オブジェクトのメンバーを探す関数（ない場合は nullptr）
+        const JsonValue* Find(std::string_view key) const
+        {
+            for (const auto& member : m_members)
+            {
+                if (member.first == key) return &member.second;
+            }
+            return nullptr;
+        }
+
+        // オブジェクトのメンバーの数値を取得する関数（ない場合は defaultValue）
+        double GetNumber(std::string_view key, double defaultValue = 0.0) const
+        {
+            const JsonValue* value = Find(key);
+            return value ? value->AsNumber(defaultValue) : defaultValue;
+        }
+
+        // オブジェクトのメンバーの文字列を取得する関数（ない場合は空）
+        std::string GetString(std::string_view key) const
+        {
+            const JsonValue* value = Find(key);
+            return value ? value->AsString() : std::string();
+        }
+
+    private:
+
+        friend class JsonReader;
+
+        Type m_type = Type::Null;
+        bool m_bool = false;
+        double m_number = 0.0;
+        std::string m_string;
+        std::vector<JsonValue> m_array;
+        std::vector<std::pair<std::string, JsonValue>> m_members;
+    };
+
+    class JsonReader
+    {
+    public:
+
+        // テキストを解析する関数
+        static bool Parse(std::string_view text, JsonValue& value, std::string& error)
+        {
+            JsonReader reader(text);
+            value = JsonValue();
+
+            if (!reader.ParseValue(value, 0) || !reader.SkipSpace() || reader.m_pos != text.size())
+            {
+                if (reader.m_error.empty()) reader.Fail("Unexpected data after the value");
+                error = reader.m_error;
+                return false;
+            }
+
+            return true;
+        }
+
+        // ファイルを解析する関数
+        static bool ParseFile(const std::filesystem::path& path, JsonValue& value, std::string& error)
+        {
+            std::ifstream ifs(path, std::ios::binary);
+            if (!ifs)
+            {
+                error = "Could not open " + path.u8string();
+                return false;
+            }
+
+            std::ostringstream oss;
+            oss << ifs.rdbuf();
+            std::string text = oss.str();
+
+            // UTF-8 の BOM は読み飛ばす
+            std::string_view view(text);
+            if (view.size() >= 3 && view.substr(0, 3) == "\xEF\xBB\xBF") view.remove_prefix(3);
+
+            if (!Parse(view, value, error))
+            {
+                error = path.u8string() + ": " + error;
+                return false;
+            }
+
+            return true;
+        }
+
+    private:
+
+        // 入れ子の深さの上限（壊れたファイルでスタックを使い切らないように）
+        static const int MAX_DEPTH = 256;
+
+        explicit JsonReader(std::string_view text)
+            : m_text(text)
+        {
+        }
+
+        bool Fail(const std::string& message)
+        {
+            if (m_error.empty()) m_error = message + " at offset " + std::to_string(m_pos);
+            return false;
+        }
+
+        // 空白を読み飛ばす関数（常に true）
+        bool SkipSpace()
+        {
+            while (m_pos < m_text.size())
+            {
+                char c = m_text[m_pos];
+                if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+                m_pos++;
+            }
+            return true;
+        }
+
+        bool Consume(std::string_view word)
+        {
+            if (m_text.substr(m_pos, word.size()) != word) return false;
+            m_pos += word.size();
+            return true;
+        }
+
+        bool ParseValue(JsonValue& value, int depth)
+        {
+            if (depth > MAX_DEPTH) return Fail("Nesting is too deep");
+
+            SkipSpace();
+            if (m_pos >= m_text.size()) return Fail("Unexpected end of data");
+
+            char c = m_text[m_pos];
+            if (c == '{') return ParseObject(value, depth);
+            if (c == '[') return ParseArray(value, depth);
+            if (c == '"')
+            {
+                value.m_type = JsonValue::Type::String;
+                return ParseString(value.m_string);
+            }
+            if (Consume("true"))
+            {
+                value.m_type = JsonValue::Type::Bool;
+                value.m_bool = true;
+                return true;
+            }
+            if (Consume("false"))
+            {
+                value.m_type = JsonValue::Type::Bool;
+                value.m_bool = false;
+                return true;
+            }
+            if (Consume("null"))
+            {
+                value.m_type = JsonValue::Type::Null;
+                return true;
+            }
+            return ParseNumber(value);
+        }
+
+        bool ParseObject(JsonValue& value, int depth)
+        {
+            value.m_type = JsonValue::Type::Object;
+            m_pos++;    // {
+
+            SkipSpace();
+            if (Consume("}")) return true;
+
+            while (true)
+            {
+                SkipSpace();
+                if (m_pos >= m_text.size() || m_text[m_pos] != '"') return Fail("Expected a member name");
+
+                std::string key;
+                if (!ParseString(key)) return false;
+
+                SkipSpace();
+                if (!Consume(":")) return Fail("Expected ':'");
+
+                value.m_members.emplace_back(std::move(key), JsonValue());
+                if (!ParseValue(value.m_members.back().second, depth + 1)) return false;
+
+                SkipSpace();
+                if (Consume(",")) continue;
+                if (Consume("}")) return true;
+                return Fail("Expected ',' or '}'");
+            }
+        }
+
+        bool ParseArray(JsonValue& value, int depth)
+        {
+            value.m_type = JsonValue::Type::Array;
+            m_pos++;    // [
+
+            SkipSpace();
+            if (Consume("]")) return true;
+
+            while (true)
+            {
+                value.m_array.emplace_back();
+                if (!ParseValue(value.m_array.back(), depth + 1)) return false;
+
+                SkipSpace();
+                if (Consume(",")) continue;
+                if (Consume("]")) return true;
+                return Fail("Expected ',' or ']'");
+            }
+        }
+
+        bool ParseNumber(JsonValue& value)
+        {
+            size_t start = m_pos;
+            while (m_pos < m_text.size())
+            {
+                char c = m_text[m_pos];
+                if ((c < '0' || c > '9') && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E') break;
+                m_pos++;
+            }
+            if (m_pos == start) return Fail("Unexpected character");
+
+            std::string token(m_text.substr(start, m_pos - start));
+            char* end = nullptr;
+            value.m_number = std::strtod(token.c_str(), &end);
+            if (end != token.c_str() + token.size())
+            {
+                m_pos = start;
+                return Fail("Invalid number");
+            }
+
+            value.m_type = JsonValue::Type::Number;
+            return true;
+        }
+
+        bool ParseHex4(uint32_t& code)
+        {
+            if (m_pos + 4 > m_text.size()) return Fail("Invalid \\u escape");
+
+            code = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                char c = m_text[m_pos++];
+                code <<= 4;
+                if (c >= '0' && c <= '9') code |= c - '0';
+                else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+                else return Fail("Invalid \\u escape");
+            }
+            return true;
+        }
+
+        static void AppendUtf8(std::string& text, uint32_t code)
+        {
+            if (code < 0x80)
+            {
+                text += static_cast<char>(code);
+            }
+            else if (code < 0x800)
+            {
+                text += static_cast<char>(0xC0 | (code >> 6));
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000)
+            {
+                text += static_cast<char>(0xE0 | (code >> 12));
+                text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                text += static_cast<char>(0xF0 | (code >> 18));
+                text += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        bool ParseString(std::string& text)
+        {
+            m_pos++;    // "
+
+            while (m_pos < m_text.size())
+            {
+                char c = m_text[m_pos++];
+                if (c == '"') return true;
+                if (static_cast<unsigned char>(c) < 0x20) return Fail("Control character in a string");
+                if (c != '\\')
+                {
+                    text += c;
+                    continue;
+                }
+
+                if (m_pos >= m_text.size()) break;
+                char e = m_text[m_pos++];
+                switch (e)
+                {
+                case '"':  text += '"'; break;
+                case '\\': text += '\\'; break;
+                case '/':  text += '/'; break;
+                case 'b':  text += '\b'; break;
+                case 'f':  text += '\f'; break;
+                case 'n':  text += '\n'; break;
+                case 'r':  text += '\r'; break;
+                case 't':  text += '\t'; break;
+                case 'u':
+                {
+                    uint32_t code;
+                    if (!ParseHex4(code)) return false;
+
+                    // サロゲートペア
+                    if (code >= 0xD800 && code <= 0xDBFF && Consume("\\u"))
+                    {
+                        uint32_t low;
+                        if (!ParseHex4(low)) return false;
+                        if (low < 0xDC00 || low > 0xDFFF) return Fail("Invalid surrogate pair");
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    AppendUtf8(text, code);
+                    break;
+                }
+                default:
+                    return Fail("Invalid escape");
+                }
+            }
+
+            return Fail("Unterminated string");
+        }
+
+        std::string_view m_text;
+        size_t m_pos = 0;
+        std::string m_error;
+    };
+}
@@ -0,0 +1,201 @@
+﻿//--------------------------------------------------------------------------------------
+// File: JsonWriter.h
+//
+// JSON を書き出すクラス
+//
+// ※統計（--stats json）などの機械で読む出力に使う
+// ※文字列は UTF-8 のまま書き出す（制御文字、"、\ のみエスケープする）
+// ※オブジェクト、配列の区切りのカンマと字下げは自動で入れる
+//
+// Date: 2026.3.15
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Imase
+{
+    class JsonWriter
+    {
+    public:
+
+        // indent : 字下げの空白の数（0 = 改行しない）
+        explicit JsonWriter(std::ostream& stream, int indent = 2)
+            : m_stream(stream)
+            , m_indent(indent)
+        {
+        }
+
+        JsonWriter(const JsonWriter&) = delete;
+        JsonWriter& operator=(const JsonWriter&) = delete;
+
+        void BeginObject()
+        {
+            BeginValue();
+            m_stream << '{';
+            m_first.push_back(true);
+        }
+
+        void EndObject()
+        {
+            EndContainer('}');
+        }
+
+        void BeginArray()
+        {
+            BeginValue();
+            m_stream << '[';
+            m_first.push_back(true);
+        }
+
+        void EndArray()
+        {
+            EndContainer(']');
+        }
+
+        // オブジェクトのキー（次に書き出す値がキーの値になる）
+        void Key(std::string_view key)
+        {
+            Separate();
+            WriteString(key);
+            m_stream << (m_indent ? ": " : ":");
+            m_afterKey = true;
+        }
+
+        void String(std::string_view value)
+        {
+            BeginValue();
+            WriteString(value);
+        }
+
+        void Number(double value)
+        {
+            BeginValue();
+
+            // JSON は NaN、無限大を表せないので null にする
+            if (!std::isfinite(value))
+            {
+                m_stream << "null";
+                return;
+            }
+
+            char text[32];
+            std::snprintf(text, sizeof(text), "%.15g", value);
+            m_stream << text;
+        }
+
+        void Number(uint64_t value)
+        {
+            BeginValue();
+            m_stream << value;
+        }
+
+        void Number(int64_t value)
+        {
+            BeginValue();
+            m_stream << value;
+        }
+
+        void Number(uint32_t value) { Number(static_cast<uint64_t>(value)); }
+        void Number(int value) { Number(static_cast<int64_t>(value)); }
+
+        void Bool(bool value)
+        {
+            BeginValue();
+            m_stream << (value ? "true" : "false");
+        }
+
+        void Null()
+        {
+            BeginValue();
+            m_stream << "null";
+        }
+
+        // キーと値をまとめて書き出す関数
+        void Member(std::string_view key, std::string_view value) { Key(key); String(value); }
+        void Member(std::string_view key, const char* value) { Key(key); String(value); }
+        void Member(std::string_view key, double value) { Key(key); Number(value); }
+        void Member(std::string_view key, uint64_t value) { Key(key); Number(value); }
+        void Member(std::string_view key, int64_t value) { Key(key); Number(value); }
+        void Member(std::string_view key, uint32_t value) { Key(key); Number(value); }
+        void Member(std::string_view key, int value) { Key(key); Number(value); }
+        void Member(std::string_view key, bool value) { Key(key); Bool(value); }
+
+    private:
+
+        // 値を書き出す前の区切り（キーの値の場合は不要）
+        void BeginValue()
+        {
+            if (m_afterKey)
+            {
+                m_afterKey = false;
+                return;
+            }
+            if (!m_first.empty()) Separate();
+        }
+
+        // 要素の区切りと字下げ
+        void Separate()
+        {
+            if (!m_first.back()) m_stream << ',';
+            m_first.back() = false;
+            NewLine(m_first.size());
+        }
+
+        void EndContainer(char close)
+        {
+            bool empty = m_first.back();
+            m_first.pop_back();
+            if (!empty) NewLine(m_first.size());
+            m_stream << close;
+            if (m_first.empty() && m_indent) m_stream << '\n';
+        }
+
+        void NewLine(size_t depth)
+        {
+            if (!m_indent) return;
+            m_stream << '\n' << std::string(depth * m_indent, ' ');
+        }
+
+        void WriteString(std::string_view value)
+        {
+            m_stream << '"';
+            for (char c : value)
+            {
+                switch (c)
+                {
+                case '"':  m_stream << "\\\""; break;
+                case '\\': m_stream << "\\\\"; break;
+                case '\n': m_stream << "\\n"; break;
+                case '\r': m_stream << "\\r"; break;
+                case '\t': m_stream << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        char code[8];
+                        std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+                        m_stream << code;
+                    }
+                    else
+                    {
+                        m_stream << c;
+                    }
+                    break;
+                }
+            }
+            m_stream << '"';
+        }
+
+        std::ostream& m_stream;
+        int m_indent;
+        std::vector<bool> m_first;  // 開いているオブジェクト、配列ごとに、まだ要素を書き出していないか
+        bool m_afterKey = false;
+    };
+}
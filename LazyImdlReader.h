@@ -0,0 +1,459 @@
+﻿//--------------------------------------------------------------------------------------
+// File: LazyImdlReader.h
+//
+// モデルデータ(.imdl)を必要なチャンクだけ読み込むクラス
+//
+// ※開くときはヘッダとチャンクの位置（チャンクテーブル）だけを読み込む
+// ※チャンクは最初に取得したときに読み込み（展開、チェックサムの確認も行う）、キャッシュに保持する
+//   サムネイルや一覧表示のようにメッシュとマテリアルだけが必要な場合はテクスチャを読み込まない
+// ※キャッシュは複数のファイルで共有する（既定は ChunkCache::GetShared()）
+// ※メンバ関数は複数のスレッドから呼べる（ファイルの情報はロックして参照し、展開はロックの外で行う）
+//   Close、Open と並行して取得したチャンクは、閉じる前のファイルのものか nullptr になる
+//
+// Date: 2026.3.10
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ChunkCache.h"
+#include "ChunkIO.h"
+#include "Compression.h"
+#include "Imdl.h"
+#include "ImdlReader.h"
+
+namespace Imase
+{
+    // キャッシュしたチャンクの型付きの参照
+    // ※参照している間はキャッシュから捨てられてもデータは解放されない
+    template<typename T>
+    class ChunkView
+    {
+    public:
+
+        ChunkView() = default;
+
+        ChunkView(ChunkData owner, Span<T> items)
+            : m_owner(std::move(owner))
+            , m_items(items)
+        {
+        }
+
+        const T* data() const { return m_items.data(); }
+        size_t size() const { return m_items.size(); }
+        bool empty() const { return m_items.empty(); }
+
+        const T* begin() const { return m_items.begin(); }
+        const T* end() const { return m_items.end(); }
+
+        const T& operator[](size_t i) const { return m_items[i]; }
+
+    private:
+
+        ChunkData m_owner;
+        Span<T> m_items;
+    };
+
+    // キャッシュしたテクスチャチャンクの参照
+    struct TextureList
+    {
+        ChunkData owner;                    // テクスチャチャンクのデータ
+        std::vector<TextureView> textures;  // テクスチャ（DDS）
+    };
+
+    // 必要なチャンクだけ読み込む場合の設定
+    struct LazyReadOptions
+    {
+        bool verifyChecksums = false;           // 読み込んだチャンクのチェックサムを確認する（記録されている場合）
+        unsigned threads = 0;                   // 展開に使うスレッド数（0 = 論理コア数）
+        std::shared_ptr<ChunkCache> cache;      // キャッシュ（nullptr = 共有のキャッシュ）
+    };
+
+    class LazyImdlReader
+    {
+    public:
+
+        LazyImdlReader() = default;
+
+        LazyImdlReader(const LazyImdlReader&) = delete;
+        LazyImdlReader& operator=(const LazyImdlReader&) = delete;
+
+        // ファイルを開く関数（ヘッダとチャンクテーブルだけを読み込む）
+        // ※失敗した場合は GetError で理由を取得できる
+        bool Open(const std::filesystem::path& path, const LazyReadOptions& options = LazyReadOptions())
+        {
+            Close();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_options = options;
+            m_cache = options.cache ? options.cache : ChunkCache::GetShared();
+
+            m_ifs.open(path, std::ios::binary);
+            if (!m_ifs)
+            {
+                return Fail("could not open the file");
+            }
+
+            std::error_code ec;
+            uint64_t fileSize = std::filesystem::file_size(path, ec);
+            if (ec)
+            {
+                m_ifs.close();
+                return Fail("could not get the file size");
+            }
+
+            // ファイルの識別子（更新されたファイルのチャンクをキャッシュから取得しないように日時とサイズを含める）
+            auto time = std::filesystem::last_write_time(path, ec);
+            m_fileKey = path.u8string() + '|' + std::to_string(fileSize) + '|'
+                + std::to_string(ec ? 0 : static_cast<long long>(time.time_since_epoch().count()));
+
+            if (!ReadIndex(fileSize))
+            {
+                m_ifs.close();
+                m_entries.clear();
+                return false;
+            }
+
+            return true;
+        }
+
+        // ファイルを閉じる関数
+        // ※キャッシュしたチャンクはそのまま残る（もう一度開いた場合に使われる）
+        void Close()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_ifs.close();
+            m_ifs.clear();
+            m_entries.clear();
+            m_checksums = ChunkChecksums();
+            m_hasChecksums = false;
+            m_cache.reset();
+            m_fileKey.clear();
+            m_version = 0;
+            m_fileFlags = 0;
+            m_bytesRead = 0;
+            m_error.clear();
+        }
+
+        // 開いているか？
+        bool IsOpen() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_ifs.is_open();
+        }
+
+        // エラーの内容を取得する関数
+        std::string GetError() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_error;
+        }
+
+        // バージョンを取得する関数
+        uint32_t GetVersion() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_version;
+        }
+
+        // 4GB 超え用のファイルか？
+        bool IsLarge() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return (m_fileFlags & IMDL_FILE_FLAG_LARGE) != 0;
+        }
+
+        // チャンクがあるか？
+        bool HasChunk(uint32_t type) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return FindIndex(type) != NOT_FOUND;
+        }
+
+        // チャンクのフラグを取得する関数
+        uint32_t GetChunkFlags(uint32_t type) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            size_t index = FindIndex(type);
+            return index != NOT_FOUND ? m_entries[index].flags : 0;
+        }
+
+        // ファイルから読み込んだサイズを取得する関数（キャッシュから取得した分は含まない）
+        uint64_t GetBytesRead() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_bytesRead;
+        }
+
+        // チャンクのデータを取得する関数（圧縮されている場合は展開後のデータ）
+        // ※初めて取得する場合はファイルから読み込む
+        // ※チャンクがない場合、読み込めなかった場合は nullptr を返す
+        ChunkData GetChunk(uint32_t type)
+        {
+            // ファイルの情報はロックしてコピーしておく（Close、Open で変わるため）
+            ChunkCache::Key key;
+            std::shared_ptr<ChunkCache> cache;
+            unsigned threads;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                size_t index = FindIndex(type);
+                if (index == NOT_FOUND) return nullptr;
+
+                key = { m_fileKey, static_cast<uint32_t>(index) };
+                cache = m_cache;
+                threads = m_options.threads;
+            }
+
+            if (ChunkData data = cache->Find(key)) return data;
+
+            std::vector<uint8_t> buffer;
+            uint32_t flags;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                // キャッシュを調べている間に閉じられた、別のファイルを開いた
+                if (m_fileKey != key.file || key.chunkIndex >= m_entries.size()) return nullptr;
+
+                const ChunkEntry64& entry = m_entries[key.chunkIndex];
+                if (!ReadChunkData(m_ifs, m_entries, key.chunkIndex, buffer, m_hasChecksums ? &m_checksums : nullptr))
+                {
+                    Fail(m_hasChecksums ? "chunk " + GetChunkTypeName(type) + " could not be read or checksum mismatch"
+                        : "chunk " + GetChunkTypeName(type) + " could not be read");
+                    return nullptr;
+                }
+                m_bytesRead += entry.size;
+                flags = entry.flags;
+            }
+
+            // 圧縮されている場合は展開する（ロックの外で行う）
+            if ((flags & IMDL_CHUNK_FLAG_COMPRESSION_MASK) != COMPRESSION_NONE)
+            {
+                std::vector<uint8_t> decoded;
+                if (!DecompressChunkData(flags, buffer.data(), buffer.size(), decoded, threads))
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    Fail("could not decompress chunk " + GetChunkTypeName(type));
+                    return nullptr;
+                }
+                buffer.swap(decoded);
+            }
+
+            return cache->Insert(key, std::make_shared<const std::vector<uint8_t>>(std::move(buffer)));
+        }
+
+        // マテリアル
+        ChunkView<MaterialInfo> GetMaterials()
+        {
+            return GetArray<MaterialInfo>(CHUNK_MATERIAL);
+        }
+
+        // メッシュ
+        ChunkView<MeshInfo> GetMeshes()
+        {
+            return GetArray<MeshInfo>(CHUNK_MESH);
+        }
+
+        // 頂点
+        ChunkView<VertexPositionNormalTextureTangent> GetVertices()
+        {
+            return GetArray<VertexPositionNormalTextureTangent>(CHUNK_VERTEX);
+        }
+
+        // インデックス
+        ChunkView<uint32_t> GetIndices()
+        {
+            return GetArray<uint32_t>(CHUNK_INDEX);
+        }
+
+        // テクスチャ（DDS）
+        // ※GPU アップロード用の配置の場合は空（GetChunk(CHUNK_TEXTURE) を ImdlReader と同じく解析する）
+        TextureList GetTextures()
+        {
+            TextureList list;
+            if (GetChunkFlags(CHUNK_TEXTURE) & IMDL_CHUNK_FLAG_GPU_LAYOUT) return list;
+
+            list.owner = GetChunk(CHUNK_TEXTURE);
+            if (!list.owner) return list;
+
+            if (!ParseTextureList(list.owner->data(), list.owner->size(), IsLarge(), list.textures))
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                Fail("texture chunk is corrupted");
+                return TextureList();
+            }
+            return list;
+        }
+
+    private:
+
+        static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+        // ※m_mutex をロックした状態で呼ぶ
+        bool Fail(const std::string& error)
+        {
+            m_error = error;
+            return false;
+        }
+
+        // ※m_mutex をロックした状態で呼ぶ
+        size_t FindIndex(uint32_t type) const
+        {
+            for (size_t i = 0; i < m_entries.size(); i++)
+            {
+                if (m_entries[i].type == type) return i;
+            }
+            return NOT_FOUND;
+        }
+
+        // 配列チャンクを取得する関数
+        // ※バージョン１は先頭の個数を読み飛ばす
+        template<typename T>
+        ChunkView<T> GetArray(uint32_t type)
+        {
+            ChunkData data = GetChunk(type);
+            if (!data) return ChunkView<T>();
+
+            size_t header = 0;
+            size_t count = data->size() / sizeof(T);
+            bool valid = data->size() % sizeof(T) == 0;
+
+            if (GetVersion() == IMDL_VERSION_1)
+            {
+                uint32_t count32 = 0;
+                valid = data->size() >= sizeof(count32);
+                if (valid)
+                {
+                    std::memcpy(&count32, data->data(), sizeof(count32));
+                    valid = data->size() - sizeof(count32) == sizeof(T) * static_cast<uint64_t>(count32);
+                }
+                header = sizeof(count32);
+                count = count32;
+            }
+
+            const uint8_t* p = data->data() + header;
+            if (!valid || reinterpret_cast<uintptr_t>(p) % alignof(T) != 0)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                Fail("chunk " + GetChunkTypeName(type) + " is corrupted");
+                return ChunkView<T>();
+            }
+
+            return ChunkView<T>(std::move(data), Span<T>(reinterpret_cast<const T*>(p), count));
+        }
+
+        // バージョン１のチャンクの位置を取得する関数
+        // ※チャンクヘッダだけを読み、データは読み飛ばす
+        bool ReadIndexV1(const FileHeader& header, uint64_t fileSize)
+        {
+            uint64_t pos = sizeof(FileHeader);
+            for (uint32_t i = 0; i < header.chunkCount; i++)
+            {
+                if (fileSize - pos < sizeof(ChunkHeader)) return Fail("chunk header out of range");
+
+                ChunkHeader chunk;
+                m_ifs.seekg(static_cast<std::streamoff>(pos), std::ios::beg);
+                if (!m_ifs.read(reinterpret_cast<char*>(&chunk), sizeof(chunk))) return Fail("could not read chunk header");
+                pos += sizeof(ChunkHeader);
+
+                if (chunk.size > fileSize - pos) return Fail("chunk " + GetChunkTypeName(chunk.type) + " out of range");
+
+                ChunkEntry64 entry{};
+                entry.type = chunk.type;
+                entry.offset = pos;
+                entry.size = chunk.size;
+                m_entries.push_back(entry);
+
+                pos += chunk.size;
+            }
+            return true;
+        }
+
+        // チャンクの位置を取得する関数
+        bool ReadIndex(uint64_t fileSize)
+        {
+            FileHeader header;
+            if (fileSize < sizeof(header) || !m_ifs.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            {
+                return Fail("file is too small");
+            }
+
+            if (header.magic != IMDL_MAGIC) return Fail("not an imdl file");
+
+            m_version = header.version;
+
+            if (m_version == IMDL_VERSION_1)
+            {
+                return ReadIndexV1(header, fileSize);
+            }
+
+            if (m_version != IMDL_VERSION_2)
+            {
+                return Fail("unsupported version " + std::to_string(m_version));
+            }
+
+            FileHeaderV2 headerV2;
+            m_ifs.seekg(0, std::ios::beg);
+            if (!ReadChunkTable(m_ifs, headerV2, m_entries)) return Fail("chunk table is corrupted");
+
+            m_fileFlags = headerV2.flags;
+
+            // チェックサムの確認（ヘッダとチャンクテーブルはここで、各チャンクは読み込むときに確認する）
+            if (m_options.verifyChecksums && (headerV2.flags & IMDL_FILE_FLAG_CHECKSUM))
+            {
+                if (!ReadChunkChecksums(m_ifs, headerV2, m_entries, m_checksums))
+                {
+                    return Fail("header checksum mismatch");
+                }
+                m_hasChecksums = true;
+            }
+
+            return true;
+        }
+
+    private:
+
+        // 設定
+        LazyReadOptions m_options;
+
+        // キャッシュ
+        std::shared_ptr<ChunkCache> m_cache;
+
+        // ファイル
+        std::ifstream m_ifs;
+
+        // キャッシュのキーに使うファイルの識別子
+        std::string m_fileKey;
+
+        // バージョン
+        uint32_t m_version = 0;
+
+        // ファイルフラグ
+        uint32_t m_fileFlags = 0;
+
+        // チャンクの位置
+        std::vector<ChunkEntry64> m_entries;
+
+        // チェックサム（確認する場合）
+        ChunkChecksums m_checksums;
+        bool m_hasChecksums = false;
+
+        // ファイルから読み込んだサイズ
+        uint64_t m_bytesRead = 0;
+
+        // エラーの内容
+        std::string m_error;
+
+        // ファイルの情報、読み込み、エラーの排他制御
+        mutable std::mutex m_mutex;
+    };
+}
@@ -0,0 +1,221 @@
+﻿//--------------------------------------------------------------------------------------
+// File: MappedFile.h
+//
+// ファイルをメモリにマップして読み書きするクラス
+//
+// Windows : CreateFileMapping / MapViewOfFile
+// その他  : mmap
+//
+// Date: 2026.3.4
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Imase
+{
+    class MappedFile
+    {
+    public:
+
+        MappedFile() = default;
+
+        ~MappedFile()
+        {
+            Close();
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // 指定サイズのファイルを作成して書き込み用にマップする関数
+        // ※既に存在する場合は上書きする
+        bool Create(const std::filesystem::path& path, uint64_t size)
+        {
+            Close();
+
+            if (size == 0) return false;
+
+#if defined(_WIN32)
+            m_file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE) return false;
+
+            // マッピングの作成時にファイルサイズも確保される
+            m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE,
+                static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xffffffff), nullptr);
+            if (m_mapping == nullptr)
+            {
+                Close();
+                return false;
+            }
+
+            m_data = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(size)));
+            if (m_data == nullptr)
+            {
+                Close();
+                return false;
+            }
+#else
+            m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (m_fd < 0) return false;
+
+            if (ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+            {
+                Close();
+                return false;
+            }
+
+            void* p = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+            if (p == MAP_FAILED)
+            {
+                Close();
+                return false;
+            }
+            m_data = static_cast<uint8_t*>(p);
+#endif
+            m_size = size;
+            m_writable = true;
+
+            return true;
+        }
+
+        // 既存のファイルを読み込み用にマップする関数
+        bool Open(const std::filesystem::path& path)
+        {
+            Close();
+
+#if defined(_WIN32)
+            m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE) return false;
+
+            LARGE_INTEGER size{};
+            if (!GetFileSizeEx(m_file, &size) || size.QuadPart <= 0 || static_cast<uint64_t>(size.QuadPart) > SIZE_MAX)
+            {
+                Close();
+                return false;
+            }
+
+            m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping == nullptr)
+            {
+                Close();
+                return false;
+            }
+
+            m_data = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+            if (m_data == nullptr)
+            {
+                Close();
+                return false;
+            }
+
+            m_size = static_cast<uint64_t>(size.QuadPart);
+#else
+            m_fd = open(path.c_str(), O_RDONLY);
+            if (m_fd < 0) return false;
+
+            struct stat st {};
+            if (fstat(m_fd, &st) != 0 || st.st_size <= 0 || static_cast<uint64_t>(st.st_size) > SIZE_MAX)
+            {
+                Close();
+                return false;
+            }
+
+            void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, m_fd, 0);
+            if (p == MAP_FAILED)
+            {
+                Close();
+                return false;
+            }
+            m_data = static_cast<uint8_t*>(p);
+            m_size = static_cast<uint64_t>(st.st_size);
+#endif
+            m_writable = false;
+
+            return true;
+        }
+
+        // 書き込んだ内容がディスクに書き込まれるまで待つ関数
+        // ※Close でマップを解除すれば内容はファイルに反映される（名前の変更などには不要）
+        //   停電などでも失われないようにする必要がある場合のみ呼ぶ
+        bool Flush()
+        {
+            if (m_data == nullptr || !m_writable) return false;
+
+#if defined(_WIN32)
+            if (!FlushViewOfFile(m_data, 0)) return false;
+            return FlushFileBuffers(m_file) != FALSE;
+#else
+            return msync(m_data, static_cast<size_t>(m_size), MS_SYNC) == 0;
+#endif
+        }
+
+        // マップを解除してファイルを閉じる関数
+        void Close()
+        {
+#if defined(_WIN32)
+            if (m_data) UnmapViewOfFile(m_data);
+            if (m_mapping) CloseHandle(m_mapping);
+            if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+            m_mapping = nullptr;
+            m_file = INVALID_HANDLE_VALUE;
+#else
+            if (m_data) munmap(m_data, static_cast<size_t>(m_size));
+            if (m_fd >= 0) close(m_fd);
+            m_fd = -1;
+#endif
+            m_data = nullptr;
+            m_size = 0;
+            m_writable = false;
+        }
+
+        // 先頭アドレスを取得する関数
+        uint8_t* GetData() const
+        {
+            return m_data;
+        }
+
+        // サイズを取得する関数
+        uint64_t GetSize() const
+        {
+            return m_size;
+        }
+
+        // マップされているか？
+        bool IsOpen() const
+        {
+            return m_data != nullptr;
+        }
+
+    private:
+
+#if defined(_WIN32)
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+#else
+        int m_fd = -1;
+#endif
+
+        // マップしたメモリの先頭
+        uint8_t* m_data = nullptr;
+
+        // マップしたサイズ
+        uint64_t m_size = 0;
+
+        // 書き込み用か？
+        bool m_writable = false;
+    };
+}
@@ -0,0 +1,186 @@
+﻿//--------------------------------------------------------------------------------------
+// File: MemoryUsage.h
+//
+// プロセスのメモリ使用量（RSS）を取得、段階ごとに記録するユーティリティ
+//
+// ※Windows は GetProcessMemoryInfo（WorkingSetSize、PeakWorkingSetSize）を使う
+// ※Linux は /proc/self/statm と /proc/self/status（VmHWM）を使う（それ以外は 0 を返す）
+// ※段階の中のピークは別スレッドで一定間隔ごとに取得した値の最大値（短い山は見逃すことがある）
+//
+// Date: 2026.3.14
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Benchmark.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(__linux__)
+#include <fstream>
+#include <unistd.h>
+#endif
+
+namespace Imase
+{
+    // 現在のメモリ使用量（バイト、取得できない場合は 0）
+    inline uint64_t GetCurrentRss()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return counters.WorkingSetSize;
+#elif defined(__linux__)
+        std::ifstream ifs("/proc/self/statm");
+        uint64_t size = 0, resident = 0;
+        if (!(ifs >> size >> resident)) return 0;
+        return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 0;
+#endif
+    }
+
+    // プロセスが起動してからのメモリ使用量のピーク（バイト、取得できない場合は 0）
+    inline uint64_t GetPeakRss()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return counters.PeakWorkingSetSize;
+#elif defined(__linux__)
+        std::ifstream ifs("/proc/self/status");
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            // VmHWM:    12345 kB
+            if (line.compare(0, 6, "VmHWM:") == 0)
+            {
+                return std::stoull(line.substr(6)) * 1024;
+            }
+        }
+        return 0;
+#else
+        return 0;
+#endif
+    }
+
+    // 段階ごとのメモリ使用量を記録するクラス
+    class MemoryMonitor
+    {
+    public:
+
+        // 段階のメモリ使用量
+        struct Stage
+        {
+            std::string name;
+            uint64_t startRss = 0;  // 開始時
+            uint64_t endRss = 0;    // 終了時
+            uint64_t peakRss = 0;   // 段階の中のピーク
+            double sec = 0.0;       // 処理時間（秒）
+        };
+
+        // interval : メモリ使用量を取得する間隔
+        explicit MemoryMonitor(std::chrono::milliseconds interval = std::chrono::milliseconds(5))
+            : m_interval(interval)
+        {
+            m_thread = std::thread([this]() { Sample(); });
+        }
+
+        ~MemoryMonitor()
+        {
+            End();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_exit = true;
+            }
+            m_wake.notify_all();
+            m_thread.join();
+        }
+
+        MemoryMonitor(const MemoryMonitor&) = delete;
+        MemoryMonitor& operator=(const MemoryMonitor&) = delete;
+
+        // 段階を開始する関数（前の段階は終了する）
+        void BeginStage(const std::string& name)
+        {
+            End();
+
+            uint64_t rss = GetCurrentRss();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Stage stage;
+            stage.name = name;
+            stage.startRss = rss;
+            stage.peakRss = rss;
+            m_stages.push_back(stage);
+            m_stopwatch.Reset();
+            m_active = true;
+        }
+
+        // 段階を終了する関数
+        void End()
+        {
+            uint64_t rss = GetCurrentRss();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_active) return;
+
+            Stage& stage = m_stages.back();
+            stage.endRss = rss;
+            stage.peakRss = std::max(stage.peakRss, rss);
+            stage.sec = m_stopwatch.ElapsedSec();
+            m_active = false;
+        }
+
+        // 記録した段階
+        std::vector<Stage> GetStages() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_stages;
+        }
+
+    private:
+
+        // 一定間隔でメモリ使用量を取得するスレッドの関数
+        void Sample()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_exit)
+            {
+                if (m_active)
+                {
+                    // 取得している間に段階が変わった場合は使わない
+                    size_t index = m_stages.size();
+                    lock.unlock();
+                    uint64_t rss = GetCurrentRss();
+                    lock.lock();
+
+                    if (m_active && m_stages.size() == index)
+                    {
+                        m_stages.back().peakRss = std::max(m_stages.back().peakRss, rss);
+                    }
+                }
+                m_wake.wait_for(lock, m_interval, [this]() { return m_exit; });
+            }
+        }
+
+        std::chrono::milliseconds m_interval;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::thread m_thread;
+        std::vector<Stage> m_stages;
+        Stopwatch m_stopwatch;
+        bool m_active = false;
+        bool m_exit = false;
+    };
+}
@@ -0,0 +1,166 @@
+﻿//--------------------------------------------------------------------------------------
+// File: Microbenchmark.h
+//
+// 小さな処理（カーネル）を繰り返し実行して処理時間を計測するクラス
+//
+// ※１つのサンプルが最低時間を超えるように、サンプルあたりの実行回数を最初に決める
+// ※計測の前に時間を計らないサンプルを実行する（クロックの上昇、キャッシュ、ページの割り当てを済ませる）
+// ※サンプルの中央値と MAD（中央値からの差の絶対値の中央値）を使う（外れ値に影響されにくい）
+// ※処理は結果（uint64_t）を返すこと（計算が最適化で消されないように、すべての結果を合計して保持する）
+//
+// Date: 2026.3.16
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "JsonWriter.h"
+
+namespace Imase
+{
+    // カーネルの計測結果
+    struct MicrobenchResult
+    {
+        std::string name;
+        uint64_t items = 0;         // １回の実行で処理する要素の数（行、頂点など）
+        uint64_t bytes = 0;         // １回の実行で処理するバイト数（0 = 計測しない）
+        uint64_t iterations = 0;    // サンプルあたりの実行回数
+        uint64_t warmupSamples = 0; // 計測の前に捨てたサンプルの数
+        std::vector<double> samples;    // １回の実行の時間（秒、サンプルごと）
+        double medianSec = 0.0;     // １回の実行の時間の中央値
+        double madSec = 0.0;        // 中央値からの差の絶対値の中央値
+        double minSec = 0.0;
+        double maxSec = 0.0;
+    };
+
+    // 中央値を求める関数（values は並び替える）
+    inline double GetMedian(std::vector<double>& values)
+    {
+        if (values.empty()) return 0.0;
+
+        std::sort(values.begin(), values.end());
+        size_t half = values.size() / 2;
+        return (values.size() & 1) ? values[half] : (values[half - 1] + values[half]) * 0.5;
+    }
+
+    class Microbenchmark
+    {
+    public:
+
+        // sampleCount   : サンプルの数
+        // minSampleSec  : １つのサンプルの最低時間（秒）
+        // warmupSamples : 計測の前に捨てるサンプルの最低数
+        // minWarmupSec  : 計測の前に捨てるサンプルの最低時間（秒、合計）
+        explicit Microbenchmark(int sampleCount = 21, double minSampleSec = 0.01, int warmupSamples = 3, double minWarmupSec = 0.1)
+            : m_sampleCount(std::max(sampleCount, 1))
+            , m_minSampleSec(minSampleSec)
+            , m_warmupSamples(std::max(warmupSamples, 0))
+            , m_minWarmupSec(minWarmupSec)
+        {
+        }
+
+        // 処理を計測する関数
+        // items : １回の実行で処理する要素の数
+        // bytes : １回の実行で処理するバイト数
+        template<typename F>
+        const MicrobenchResult& Run(const std::string& name, uint64_t items, uint64_t bytes, F&& func)
+        {
+            MicrobenchResult result;
+            result.name = name;
+            result.items = items;
+            result.bytes = bytes;
+
+            // 実行回数を決める（１回目はキャッシュなどの準備を兼ねる）
+            Stopwatch sw;
+            m_sink = m_sink + func();
+            double once = std::max(sw.ElapsedSec(), 1e-9);
+            result.iterations = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(m_minSampleSec / once)));
+
+            // ウォームアップ（最低数と最低時間の両方を満たすまで、時間は記録しない）
+            sw.Reset();
+            while (result.warmupSamples < static_cast<uint64_t>(m_warmupSamples) || sw.ElapsedSec() < m_minWarmupSec)
+            {
+                uint64_t sink = 0;
+                for (uint64_t n = 0; n < result.iterations; n++)
+                {
+                    sink += func();
+                }
+                m_sink = m_sink + sink;
+                result.warmupSamples++;
+            }
+
+            // 計測
+            for (int i = 0; i < m_sampleCount; i++)
+            {
+                uint64_t sink = 0;
+                sw.Reset();
+                for (uint64_t n = 0; n < result.iterations; n++)
+                {
+                    sink += func();
+                }
+                result.samples.push_back(sw.ElapsedSec() / result.iterations);
+                m_sink = m_sink + sink;
+            }
+
+            // 集計
+            std::vector<double> values = result.samples;
+            result.medianSec = GetMedian(values);
+            result.minSec = values.front();
+            result.maxSec = values.back();
+
+            for (auto& value : values) value = std::fabs(value - result.medianSec);
+            result.madSec = GetMedian(values);
+
+            m_results.push_back(std::move(result));
+            return m_results.back();
+        }
+
+        const std::vector<MicrobenchResult>& GetResults() const { return m_results; }
+
+        // 結果を JSON の配列で書き出す関数
+        void WriteJson(JsonWriter& json) const
+        {
+            json.BeginArray();
+            for (const auto& result : m_results)
+            {
+                json.BeginObject();
+                json.Member("name", result.name);
+                json.Member("items", result.items);
+                json.Member("bytes", result.bytes);
+                json.Member("iterations", result.iterations);
+                json.Member("samples", static_cast<uint64_t>(result.samples.size()));
+                json.Member("warmup_samples", result.warmupSamples);
+                json.Member("median_ns", result.medianSec * 1e9);
+                json.Member("mad_ns", result.madSec * 1e9);
+                json.Member("min_ns", result.minSec * 1e9);
+                json.Member("max_ns", result.maxSec * 1e9);
+                json.Member("mad_percent", result.medianSec > 0.0 ? result.madSec / result.medianSec * 100.0 : 0.0);
+                json.Member("ns_per_item", result.items ? result.medianSec * 1e9 / result.items : 0.0);
+                if (result.bytes) json.Member("mb_per_sec", ToMBps(result.bytes, result.medianSec));
+                json.Key("sample_ns");
+                json.BeginArray();
+                for (double sample : result.samples) json.Number(sample * 1e9);
+                json.EndArray();
+                json.EndObject();
+            }
+            json.EndArray();
+        }
+
+        // 処理の結果の合計（最適化で計算が消されないように使う）
+        uint64_t GetSink() const { return m_sink; }
+
+    private:
+
+        int m_sampleCount;
+        double m_minSampleSec;
+        int m_warmupSamples;
+        double m_minWarmupSec;
+        std::vector<MicrobenchResult> m_results;
+        volatile uint64_t m_sink = 0;
+    };
+}
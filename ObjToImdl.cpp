@@ -8,7 +8,7 @@
 //--------------------------------------------------------------------------------------
 
 // ------------------------------------------------------------ //
-// モデルデータフォーマット
+// モデルデータフォーマット（バージョン１）
 //
 // ファイルヘッダ (FileHeader)
 //   uint32_t magic      // 'IMDL'
@@ -16,6 +16,7 @@
 //   uint32_t chunkCount // 5
 //
 // ----- チャンク -----
+// ChunkHeader (type, size) の後にデータが続く
 //
 // 1. テクスチャチャンク (CHUNK_TEXTURE)
 //   uint32_t textureCount
@@ -41,167 +42,399 @@
 //   uint32_t[indexCount] // インデックス配列
 //
 // ------------------------------------------------------------ //
+// モデルデータフォーマット（バージョン２）
+//
+// ファイルヘッダ (FileHeaderV2)
+//   uint32_t magic      // 'IMDL'
+//   uint32_t version    // 2
+//   uint32_t chunkCount // 5（チェックサムありは 6）
+//   uint32_t alignment  // データのアライメント（既定 64）
+//   uint32_t flags      // IMDL_FILE_FLAG_LARGE : 4GB 超え用
+//                       // IMDL_FILE_FLAG_CHECKSUM : チェックサムチャンクあり
+//   uint32_t reserved   // 0
+//
+// チャンクテーブル (ChunkEntry[chunkCount])
+//   uint32_t type       // チャンクタイプ
+//   uint32_t flags      // IMDL_CHUNK_FLAG_COMPRESSION_MASK : 圧縮形式（CompressionType）
+//   uint32_t offset     // データ位置（alignment の倍数）
+//   uint32_t size       // データサイズ
+//   ※4GB 超え用は ChunkEntry64（offset, size が uint64_t）
+//
+// ----- チャンク -----
+// データは alignment 境界に配置されるので直接シーク／マップして使える
+// テクスチャチャンクはバージョン１と同じ
+// （4GB 超え用は textureCount と各テクスチャの size が uint64_t、type の後に予約 uint32_t）
+// 配列のチャンク（マテリアル、メッシュ、頂点、インデックス）は個数を持たず
+// 配列のみ（個数 = size / 要素のサイズ）
+//
+// ----- GPU アップロード用の配置 (--gpu-layout) -----
+// テクスチャチャンクは IMDL_CHUNK_FLAG_GPU_LAYOUT を立てて以下の形式にする（圧縮しない）
+//   GpuTextureChunkHeader (textureCount, subresourceCount, dataOffset)
+//   GpuTextureDesc[textureCount]               // 形式、サイズ、ミップ数、フットプリントの範囲
+//   GpuSubresourceFootprint[subresourceCount]  // D3D12_PLACED_SUBRESOURCE_FOOTPRINT + 行数、行サイズ
+//   テクスチャデータ                            // 行ピッチ 256byte、サブリソース 512byte 境界
+// テクスチャ、頂点、インデックスチャンクは 64KiB 境界に配置する
+//
+// ----- チェックサムチャンク (CHUNK_CHECKSUM) -----
+// 最後のチャンク（--checksum 指定時のみ）
+//   uint32_t tableCrc   // ヘッダとチャンクテーブルの CRC32C
+//   uint32_t chunkCount
+//   uint32_t[chunkCount] chunkCrcs // 各チャンクの記録されているデータの CRC32C（自身は 0）
+//
+// ----- 圧縮されたチャンク -----
+// size は圧縮後のサイズ、データは以下の形式（ブロックごとに独立して展開できる）
+//   uint64_t rawSize    // 展開後のサイズ
+//   uint32_t blockSize  // ブロックのサイズ（最後のブロックのみ端数）
+//   uint32_t blockCount
+//   uint32_t[blockCount] blockSizes // 各ブロックの圧縮後のサイズ
+//   圧縮データ（ブロック順に連続）
+// ※圧縮しても小さくならないチャンクは --compress の指定があっても圧縮しない
+//
+// ------------------------------------------------------------ //
 
 #include <iostream>
+#if defined(_WIN32)
+#include <winsock2.h>      // windows.h より前（FrameStream.h の AF_UNIX で使う）
 #include <windows.h>
 #include <wrl.h>
+#include <d3d11.h>
+#else
+#include <csignal>
+#endif
 #include <vector>
 #include <fstream>
 #include <string>
 #include <unordered_map>
-#include <d3d11.h>
-#include "DirectXTex.h"
+#include <cwctype>
+#include <list>
+#include <map>
+#include <set>
+#include <thread>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include "cxxopts.hpp"
 #include "ChunkIO.h"
 #include "BinaryWriter.h"
 #include "Imdl.h"
+#include "GpuLayout.h"
+#include "ImdlReader.h"
+#include "ImdlVerify.h"
+#include "LazyImdlReader.h"
+#include "ThreadPool.h"
+#include "DependencyManifest.h"
+#include "ImdlWriter.h"
+#include "Benchmark.h"
+#include "AsyncLoader.h"
+#include "FileWatcher.h"
+#include "ChunkCache.h"
+#include "FrameStream.h"
+#include "TextEncoding.h"
+#include "WorkerProcess.h"
+#include "MemoryUsage.h"
+#include "JsonReader.h"
+#include "JsonWriter.h"
+#include "Trace.h"
+#include "CorpusGenerator.h"
+#include "Microbenchmark.h"
+#include "TaskGraph.h"
+#include "ImdlConverter.h"
 
 using namespace DirectX;
 using namespace Imase;
 
+#if defined(_WIN32)
 #pragma comment(lib, "d3d11.lib")
+#endif
 
-// 面の各頂点を構成するインデックス
-struct FaceIndex
+// コマンドライン引数で指定された設定
+struct ConverterOptions
 {
-    int v;  // 位置
-    int vt; // テクスチャ座標
-    int vn; // 法線
-
-    bool operator==(const FaceIndex& other) const
-    {
-        return v == other.v && vt == other.vt && vn == other.vn;
-    }
+    std::filesystem::path input;    // 入力ファイル名
+    std::filesystem::path output;   // 出力ファイル名
+    size_t benchSerialize = 0;      // シリアライズ速度計測用の頂点数（0 = 計測しない）
+    std::filesystem::path verify;   // 確認するファイル名（空 = 変換する）
+    std::filesystem::path benchLoad; // 読み込み速度を計測するファイル名（空 = 計測しない）
+    std::filesystem::path benchAsync; // 非同期読み込みを計測するファイルまたはフォルダ（空 = 計測しない）
+    size_t benchAsyncFiles = 1000;  // 非同期読み込みで要求するファイル数
+    ImdlWriteSettings write;        // 書き出しの設定
+    std::vector<std::string> batch; // 一括変換の入力（フォルダ、ワイルドカード、リストファイル）
+    std::filesystem::path outputDir; // 一括変換の出力フォルダ（空 = 入力ファイルと同じフォルダ）
+    unsigned threads = 0;           // 一括変換のスレッド数（0 = 論理コア数）
+    bool incremental = false;       // 入力と設定が変わっていない出力ファイルは変換しない
+    std::vector<std::string> watch; // 監視する入力（フォルダ、ワイルドカード、リストファイル）
+    bool server = false;            // 変換サーバーとして動作する
+    std::filesystem::path socket;   // サーバーのソケット（空 = 標準入出力）
+    std::filesystem::path client;   // 要求を送るサーバーのソケット（空 = クライアントとして動作しない）
+    bool shutdown = false;          // サーバーを終了させる（--client）
+    uint64_t textureCacheSize = 1024ull << 20; // サーバーで共有するテクスチャのキャッシュの上限
+    bool cpuTextures = false;       // テクスチャを CPU で圧縮する（Windows 以外と同じ結果にする）
+    bool deterministic = false;     // 出力をスレッド数や mtl の記述順に左右されないようにする（テクスチャは CPU で圧縮する）
+    unsigned processes = 0;         // 一括変換を分担する変換サーバーのプロセス数（0 = プロセスを分けない）
+    std::vector<std::filesystem::path> workerSockets; // 一括変換を分担する起動済みの変換サーバー
+    uint64_t memoryBudget = 0;      // 変換中のメモリ使用量の予算（0 = 予算なし、テクスチャを一時ファイルに退避しない）
+    bool memoryReport = false;      // 段階ごとのメモリ使用量を表示する
+    bool criticalPath = false;      // タスクグラフでの変換のクリティカルパスを表示する
+    std::string stats;              // 統計の形式（空 = 出力しない、json）
+    std::filesystem::path statsOutput; // 統計の出力先（空 = <出力ファイル名>.stats.json、- = 標準出力）
+    std::filesystem::path trace;    // トレースの出力先（空 = 記録しない）
+    std::filesystem::path generateCorpus; // 計測用のコーパスを作成するフォルダ（空 = 作成しない）
+    std::filesystem::path benchCorpus; // 変換速度を計測するコーパスのフォルダ（空 = 計測しない）
+    std::vector<uint32_t> corpusScales = { 1, 2, 4 }; // コーパスの規模
+    int benchRepeat = 3;            // 計測の繰り返し回数（最速の時間を使う）
+    std::filesystem::path benchOutput; // 計測結果の JSON の出力先（空 = 出力しない、- = 標準出力）
+    std::filesystem::path benchBaseline; // 比べる計測の基準（空 = 比べない）
+    std::string benchTolerance;     // 基準との比較の許容範囲（空 = 基準のファイルの値か既定値）
+    bool benchKernels = false;      // 変換の内部の処理（カーネル）を計測する
+    int benchSamples = 21;          // カーネルの計測のサンプル数
+    std::filesystem::path checkDeterminism; // 出力が決定的か確認するコーパスのフォルダ（空 = 確認しない）
+    std::vector<unsigned> determinismThreads = { 1, 2, 0 }; // 確認する一括変換のスレッド数（0 = 論理コア数）
 };
 
-// ハッシュ値を生成する関数
-namespace std
+// ヘルプ表示
+static void Help()
+{
+    std::cout <<
+        "Usage:\n"
+        "  ObjToImdl <input.obj> [-o output.imdl]\n\n"
+        "Options:\n"
+        "  -o, --output <file>   Output file\n"
+        "  -h, --help            Show help\n"
+        "  --format-version <n>  Output format version (1 or 2, default 1)\n"
+        "  --align <bytes>       Chunk data alignment for version 2 (default 64)\n"
+        "  --large               Force 64-bit sizes and offsets (version 2). Outputs over 4GB switch to it\n"
+        "                        automatically unless --format-version 1 is given, which fails instead\n"
+        "  --compress <spec>     Compress chunks per type (version 2)\n"
+        "                        e.g. VERT=lz4:1,INDX=lz4,TXTR=zstd:19 or all=lz4\n"
+        "  --compress-block <KiB> Compression block size (default 1024)\n"
+        "  --verify-compression  Decode each compressed chunk, check it against the raw data and report the\n"
+        "                        decode speed (uses memory for the decoded copy and adds the decode time)\n"
+        "  --checksum            Store CRC32C checksums (version 2)\n"
+        "  --sync-output         Wait until each output is on disk before renaming it into place\n"
+        "  --gpu-layout          Lay out textures for direct GPU upload (256B row pitch, 512B subresources)\n"
+        "                        and align vertex/index data to 64KiB (version 2)\n"
+        "  --verify <file>       Check the chunk table and checksums of an imdl file\n"
+        "  --bench-serialize <n> Measure chunk serialization throughput with n vertices\n"
+        "  --bench-load <file>   Compare ReadChunk, the memory-mapped ImdlReader and the lazy reader on an imdl file\n"
+        "  --batch <spec>        Convert many files on one thread pool (repeatable). <spec> is a folder\n"
+        "                        (all .obj files below it), a wildcard such as models/*.obj, or a list file\n"
+        "                        with one input per line (optionally <input><TAB><output>)\n"
+        "  --output-dir <dir>    Output folder for --batch and --watch (default: next to each input)\n"
+        "  --threads <n>         Worker threads for --batch, --watch and single file conversion (default: all cores)\n"
+        "                        With --processes or --worker-socket: threads per worker process\n"
+        "  --processes <n>       Run --batch on n worker processes (ObjToImdl --server over pipes). Files are\n"
+        "                        handed out as workers finish; files on a crashed worker are retried once\n"
+        "  --worker-socket <path> Also send --batch files to a running --server --socket <path> (repeatable)\n"
+        "  --incremental         Skip outputs whose inputs (obj, mtl, textures) and settings are unchanged;\n"
+        "                        dependencies are recorded in <output>.deps\n"
+        "  --watch <spec>        Convert like --batch, then keep running and reconvert only the outputs whose\n"
+        "                        obj, mtl or textures change (repeatable). Parsed geometry and encoded\n"
+        "                        textures stay in memory between changes\n"
+        "  --server              Run as a conversion server: framed requests on stdin/stdout, or on a local\n"
+        "                        socket with --socket. Requests run concurrently on one thread pool (--threads)\n"
+        "                        and share encoded textures\n"
+        "  --socket <path>       Unix domain socket for --server\n"
+        "  --texture-cache <MiB> Encoded texture cache shared by server requests (default 1024)\n"
+        "  --cpu-textures        Encode textures on the CPU without WIC filters, so the output matches\n"
+        "                        conversions on other platforms (always on outside Windows)\n"
+        "  --deterministic       Make the output byte-identical regardless of thread count and of the order of\n"
+        "                        map_* lines in the mtl: textures are numbered by file name and type and are\n"
+        "                        encoded on the CPU (implies --cpu-textures)\n"
+        "  --client <path>       Send the remaining arguments to the server on <path> as one conversion and\n"
+        "                        print its status and statistics (no arguments: server statistics)\n"
+        "  --shutdown            With --client, ask the server to exit\n"
+        "  --memory-budget <MiB> Keep a single conversion under about <MiB> of model data: the parsed obj is\n"
+        "                        freed after geometry is built, and encoded textures that do not fit are\n"
+        "                        spilled to <output>.tex<n>.tmp and streamed into the output (implies --memory-report)\n"
+        "  --memory-report       Print the resident memory (RSS) of each conversion stage and the peak\n"
+        "                        (converts the stages one after another, like --memory-budget and --stats)\n"
+        "  --critical-path       Print the critical path of a single file conversion. A single file is converted\n"
+        "                        as a task graph: the mtl is parsed next to the obj and starts one job per\n"
+        "                        texture, geometry is built as soon as both are parsed, and each output chunk\n"
+        "                        is prepared (compressed) as soon as its inputs are ready\n"
+        "  --stats <format>      Record wall and CPU time of each stage of a single conversion (obj/mtl parse,\n"
+        "                        vertex dedup, tangents, each texture's read/decode/mips/compress/DDS save,\n"
+        "                        each chunk's build and write) with vertex counts and chunk sizes. <format>: json\n"
+        "  --stats-output <file> Where to write --stats (default <output>.stats.json, - for stdout)\n"
+        "  --trace <file>        Record each stage, texture job and worker thread as Chrome trace JSON\n"
+        "                        (open in ui.perfetto.dev or chrome://tracing). Works with every mode;\n"
+        "                        --processes records the coordinator only\n"
+        "  --generate-corpus <dir> Write the synthetic benchmark corpus to <dir>/scale<n>: a dense grid, many small\n"
+        "                        objects, usemtl switches, negative indices, n-gons, faces without vt/vn and a\n"
+        "                        texture set (256*n pixel TGA). The same scale always gives the same files\n"
+        "  --bench-corpus <dir>  Convert every corpus model (generated if missing) through the whole pipeline\n"
+        "                        on one thread and report triangles/s and input MB/s per file and scale.\n"
+        "                        Output format options such as --compress apply\n"
+        "  --corpus-scales <list> Corpus scales, e.g. 1,2,4 (default)\n"
+        "  --bench-repeat <n>    Conversions per corpus model; the fastest is reported (default 3)\n"
+        "  --bench-baseline <file> Compare --bench-corpus with a recorded --bench-output file: per file and\n"
+        "                        scale time, stage times, peak RSS and output size. Exits with 2 on a regression\n"
+        "  --bench-tolerance <spec> Allowed increase for --bench-baseline, e.g. time=10,min-time-ms=2,rss=10,\n"
+        "                        min-rss-mib=16,size=0\n"
+        "                        (percent; smaller differences than min-time-ms and min-rss-mib never count).\n"
+        "                        Default: the tolerance stored in the baseline, else these values\n"
+        "  --bench-kernels       Measure the parser, dedup, tangent and serializer kernels on fixed inputs\n"
+        "                        (ReadFloat3, ParseFaceLine, FaceIndex hash, dedup map, CreateBufferData,\n"
+        "                        GenerateTangents, BinaryWriter, SerializeVertex) and print median +- MAD\n"
+        "  --bench-samples <n>   Samples per kernel for --bench-kernels (default 21, each at least 10 ms,\n"
+        "                        after at least 100 ms of discarded warm-up samples)\n"
+        "  --bench-output <file> Also write --bench-corpus or --bench-kernels results as JSON (- for stdout)\n"
+        "  --check-determinism <dir> Convert every corpus model (generated if missing) on one thread, then check\n"
+        "                        that reversing the materials of each mtl keeps the texture order, and that\n"
+        "                        --batch and the single file task graph on each --determinism-threads count\n"
+        "                        give outputs with the same CRC32C and size (implies --deterministic).\n"
+        "                        Exits with 2 on a difference\n"
+        "  --determinism-threads <list> Thread counts for --check-determinism (default 1,2,0; 0 = all cores)\n"
+        "  --bench-async <path>  Stress the asynchronous loader with imdl files (a file or a folder)\n"
+        "  --bench-async-files <n> Number of file loads requested by --bench-async (default 1000)\n";
+}
+
+// 圧縮の指定を解析する関数
+// <type>=<algorithm>[:<level>] をカンマで区切って指定する（type に all を指定すると全チャンク）
+static void ParseCompressionSpec(const std::string& spec, uint32_t blockSize, std::map<uint32_t, CompressionSettings>& compression)
 {
-    template <>
-    struct hash<FaceIndex>
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ','))
     {
-        size_t operator()(const FaceIndex& f) const
+        size_t eq = item.find('=');
+        if (eq == std::string::npos)
         {
-            size_t h1 = std::hash<int>()(f.v);
-            size_t h2 = std::hash<int>()(f.vt);
-            size_t h3 = std::hash<int>()(f.vn);
-
-            // ハッシュ合成
-            return h1 ^ (h2 << 1) ^ (h3 << 2);
+            throw std::runtime_error("--compress expects <type>=<algorithm>[:<level>]: " + item);
         }
-    };
-}
 
-// 面（三角形）
-struct Face
-{
-    FaceIndex faceIndices[3];
-};
+        std::string typeName = item.substr(0, eq);
+        std::string algorithm = item.substr(eq + 1);
 
-// サブメッシュ
-struct SubMesh
-{
-    std::string material;      // マテリアル名
-    std::vector<Face> faces;    // 面（三角形）情報
-};
+        CompressionSettings settings;
+        settings.blockSize = blockSize;
 
-// メッシュ
-struct Mesh
-{
-    std::vector<SubMesh> subMeshs;  // サブメッシュ
-};
+        size_t colon = algorithm.find(':');
+        if (colon != std::string::npos)
+        {
+            settings.level = std::stoi(algorithm.substr(colon + 1));
+            algorithm = algorithm.substr(0, colon);
+        }
 
-// obj形式の情報取得用構造体
-struct Object
-{
-    std::filesystem::path mtllib;               // マテリアルファイル名
-    std::vector<DirectX::XMFLOAT3> positions;   // 位置
-    std::vector<DirectX::XMFLOAT3> normals;     // 法線
-    std::vector<DirectX::XMFLOAT2> texcoords;   // テクスチャ座標
-    std::vector<Mesh> meshes;                   // メッシュ
-};
+        if (!ParseCompressionType(algorithm, settings.type))
+        {
+            throw std::runtime_error("Unknown compression algorithm: " + algorithm);
+        }
 
-// パス名付きファイル名のファイル名を取得する関数
-static std::wstring GetFileNameOnly(const std::wstring& path)
-{
-    return std::filesystem::path(path).filename().wstring();
-}
+        if (!IsCompressionSupported(settings.type))
+        {
+            throw std::runtime_error("Compression algorithm is not available in this build: " + algorithm);
+        }
 
-// ファイルから読み込む関数（XMFLOAT2）
-static XMFLOAT2 ReadFloat2(std::istringstream& iss)
-{
-    XMFLOAT2 val = {};
-    iss >> val.x >> val.y;
-    return val;
+        if (typeName == "all")
+        {
+            for (uint32_t type : { CHUNK_TEXTURE, CHUNK_MATERIAL, CHUNK_MESH, CHUNK_VERTEX, CHUNK_INDEX })
+            {
+                compression[type] = settings;
+            }
+        }
+        else
+        {
+            uint32_t type;
+            if (!ParseChunkType(typeName, type))
+            {
+                throw std::runtime_error("Unknown chunk type: " + typeName);
+            }
+            compression[type] = settings;
+        }
+    }
 }
 
-// ファイルから読み込む関数（XMFLOAT3）
-static XMFLOAT3 ReadFloat3(std::istringstream& iss)
+// 計測の基準との比較の許容範囲（--bench-baseline）
+struct BenchTolerance
 {
-    XMFLOAT3 val = {};
-    iss >> val.x >> val.y >> val.z;
-    return val;
-}
+    double timePercent = 10.0;      // 処理時間（ファイル全体と各段階）
+    double minTimeMs = 2.0;         // これより小さい時間の差は悪化と見なさない（短い段階の揺れ）
+    double rssPercent = 10.0;       // メモリ使用量のピーク
+    double minRssMiB = 16.0;        // これより小さいメモリ使用量の差は悪化と見なさない（アロケータが保持している量の揺れ）
+    double sizePercent = 0.0;       // 出力ファイルのサイズ
+};
 
-// UTF-16 → UTF-8 変換
-static std::string WStringToUtf8(const std::wstring& ws)
+// 許容範囲の指定を解析する関数
+// <name>=<value> をカンマで区切って指定する（name は time、min-time-ms、rss、min-rss-mib、size、指定しないものは変えない）
+static void ParseBenchTolerance(const std::string& spec, BenchTolerance& tolerance)
 {
-    int size = WideCharToMultiByte(
-        CP_UTF8, 0,
-        ws.c_str(), -1,
-        nullptr, 0,
-        nullptr, nullptr);
-
-    std::string result(size - 1, 0);
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ','))
+    {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos)
+        {
+            throw std::runtime_error("--bench-tolerance expects <name>=<value>: " + item);
+        }
 
-    WideCharToMultiByte(
-        CP_UTF8, 0,
-        ws.c_str(), -1,
-        result.data(), size,
-        nullptr, nullptr);
+        std::string name = item.substr(0, eq);
+        double value = std::stod(item.substr(eq + 1));
+        if (value < 0.0)
+        {
+            throw std::runtime_error("--bench-tolerance must not be negative: " + item);
+        }
 
-    return result;
+        if (name == "time")             tolerance.timePercent = value;
+        else if (name == "min-time-ms") tolerance.minTimeMs = value;
+        else if (name == "rss")         tolerance.rssPercent = value;
+        else if (name == "min-rss-mib") tolerance.minRssMiB = value;
+        else if (name == "size")        tolerance.sizePercent = value;
+        else throw std::runtime_error("Unknown --bench-tolerance name (time, min-time-ms, rss, min-rss-mib or size): " + name);
+    }
 }
 
-// UTF-8 → UTF-16 変換
-static std::wstring StringToWString(const std::string& str)
+// コーパスの規模の指定を解析する関数（カンマ区切り）
+static void ParseCorpusScales(const std::string& spec, std::vector<uint32_t>& scales)
 {
-    if (str.empty()) return std::wstring();
-
-    int size_needed = MultiByteToWideChar(
-        CP_UTF8,                // UTF-8
-        0,
-        str.c_str(),
-        (int)str.size(),
-        nullptr,
-        0);
+    scales.clear();
 
-    std::wstring wstr(size_needed, 0);
-
-    MultiByteToWideChar(
-        CP_UTF8,
-        0,
-        str.c_str(),
-        (int)str.size(),
-        &wstr[0],
-        size_needed);
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ','))
+    {
+        unsigned long scale = std::stoul(item);
+        if (scale == 0 || scale > 1024)
+        {
+            throw std::runtime_error("--corpus-scales must be between 1 and 1024: " + item);
+        }
+        scales.push_back(static_cast<uint32_t>(scale));
+    }
 
-    return wstr;
+    if (scales.empty())
+    {
+        throw std::runtime_error("--corpus-scales is empty");
+    }
 }
 
-// ヘルプ表示
-static void Help()
+// スレッド数の指定を解析する関数（カンマ区切り、0 = 論理コア数）
+static void ParseThreadCounts(const std::string& spec, std::vector<unsigned>& threads)
 {
-    std::cout <<
-        "Usage:\n"
-        "  ObjToImdl <input.obj> [-o output.imdl]\n\n"
-        "Options:\n"
-        "  -o, --output <file>   Output file\n"
-        "  -h, --help            Show help\n";
+    threads.clear();
+
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ','))
+    {
+        unsigned long count = std::stoul(item);
+        if (count > 1024)
+        {
+            throw std::runtime_error("--determinism-threads must be between 0 and 1024: " + item);
+        }
+        threads.push_back(static_cast<unsigned>(count));
+    }
+
+    if (threads.empty())
+    {
+        throw std::runtime_error("--determinism-threads is empty");
+    }
 }
 
 // 引数から入力ファイル名と出力ファイル名を取得する関数
-static int AnalyzeOption(int argc, char* argv[], std::filesystem::path& input, std::filesystem::path& output)
+static int AnalyzeOption(int argc, char* argv[], ConverterOptions& opt)
 {
     // cxxoptsで引数解析
     cxxopts::Options options("ObjToMdl");
@@ -210,7 +443,84 @@ static int AnalyzeOption(int argc, char* argv[], std::filesystem::path& input, s
             cxxopts::value<std::string>())
         ("o,output", "Output file",
             cxxopts::value<std::string>())
-        ("h,help", "Show help");
+        ("h,help", "Show help")
+        ("format-version", "Output format version",
+            cxxopts::value<uint32_t>()->default_value("1"))
+        ("align", "Chunk data alignment",
+            cxxopts::value<uint32_t>()->default_value(std::to_string(IMDL_DEFAULT_ALIGNMENT)))
+        ("large", "Force 64-bit sizes and offsets")
+        ("compress", "Compress chunks per type",
+            cxxopts::value<std::string>())
+        ("compress-block", "Compression block size (KiB)",
+            cxxopts::value<uint32_t>()->default_value(std::to_string(IMDL_DEFAULT_BLOCK_SIZE / 1024)))
+        ("verify-compression", "Decode and check compressed chunks")
+        ("checksum", "Store checksums")
+        ("gpu-layout", "Lay out chunks for direct GPU upload")
+        ("sync-output", "Wait until outputs are on disk")
+        ("batch", "Convert many files",
+            cxxopts::value<std::vector<std::string>>())
+        ("output-dir", "Output folder for batch conversion",
+            cxxopts::value<std::string>())
+        ("threads", "Worker threads",
+            cxxopts::value<unsigned>()->default_value("0"))
+        ("processes", "Worker processes for batch conversion",
+            cxxopts::value<unsigned>()->default_value("0"))
+        ("worker-socket", "Conversion server for batch conversion",
+            cxxopts::value<std::vector<std::string>>())
+        ("incremental", "Skip up-to-date outputs")
+        ("watch", "Watch inputs and reconvert changes",
+            cxxopts::value<std::vector<std::string>>())
+        ("server", "Run as a conversion server")
+        ("socket", "Server socket",
+            cxxopts::value<std::string>())
+        ("texture-cache", "Server texture cache size (MiB)",
+            cxxopts::value<uint64_t>()->default_value("1024"))
+        ("cpu-textures", "Encode textures on the CPU")
+        ("deterministic", "Thread-count independent output")
+        ("client", "Send a request to a conversion server",
+            cxxopts::value<std::string>())
+        ("shutdown", "Ask the server to exit")
+        ("memory-budget", "Memory budget for a single conversion (MiB)",
+            cxxopts::value<uint64_t>())
+        ("memory-report", "Print memory usage per stage")
+        ("critical-path", "Print the critical path of the conversion")
+        ("stats", "Statistics format (json)",
+            cxxopts::value<std::string>())
+        ("stats-output", "Statistics output file",
+            cxxopts::value<std::string>())
+        ("trace", "Chrome trace output file",
+            cxxopts::value<std::string>())
+        ("verify", "Verify an imdl file",
+            cxxopts::value<std::string>())
+        ("bench-serialize", "Measure chunk serialization throughput",
+            cxxopts::value<size_t>())
+        ("bench-load", "Measure load throughput",
+            cxxopts::value<std::string>())
+        ("generate-corpus", "Write the benchmark corpus",
+            cxxopts::value<std::string>())
+        ("bench-corpus", "Measure conversion throughput on the corpus",
+            cxxopts::value<std::string>())
+        ("corpus-scales", "Corpus scales",
+            cxxopts::value<std::string>()->default_value("1,2,4"))
+        ("bench-repeat", "Conversions per corpus model",
+            cxxopts::value<int>()->default_value("3"))
+        ("bench-output", "Benchmark JSON output file",
+            cxxopts::value<std::string>())
+        ("bench-baseline", "Benchmark baseline file",
+            cxxopts::value<std::string>())
+        ("bench-tolerance", "Benchmark baseline tolerance",
+            cxxopts::value<std::string>())
+        ("bench-kernels", "Measure the converter kernels")
+        ("bench-samples", "Samples per kernel",
+            cxxopts::value<int>()->default_value("21"))
+        ("check-determinism", "Check that the corpus output does not depend on threads",
+            cxxopts::value<std::string>())
+        ("determinism-threads", "Thread counts for --check-determinism",
+            cxxopts::value<std::string>()->default_value("1,2,0"))
+        ("bench-async", "Stress the asynchronous loader",
+            cxxopts::value<std::string>())
+        ("bench-async-files", "Number of file loads",
+            cxxopts::value<size_t>()->default_value("1000"));
     options.parse_positional({ "input" });
 
     try
@@ -224,1026 +534,4262 @@ static int AnalyzeOption(int argc, char* argv[], std::filesystem::path& input, s
             return 0;
         }
 
-        // 入力ファイル名
-        input = std::filesystem::u8path(result["input"].as<std::string>());
+        // テクスチャの圧縮（どの動作でも使う）
+        opt.cpuTextures = result.count("cpu-textures") > 0;
 
-        // -o,-output 出力ファイル名
-        if (result.count("output") == 0) {
-            // 指定されていない場合は出力ファイル名は、入力ファイル名.mdlにする
-            output = std::filesystem::path(input);
-            output.replace_extension(".imdl");
+        // 決定的な出力（どの動作でも使う、GPU の圧縮はデバイスで結果が変わるので CPU で圧縮する）
+        opt.deterministic = result.count("deterministic") > 0 || result.count("check-determinism") > 0;
+        if (opt.deterministic) opt.cpuTextures = true;
+        opt.write.sortTextures = opt.deterministic;
+
+        // トレース（どの動作でも使う）
+        if (result.count("trace"))
+        {
+#if IMDL_ENABLE_TRACE
+            opt.trace = std::filesystem::u8path(result["trace"].as<std::string>());
+#else
+            throw std::runtime_error("--trace is not available in this build (IMDL_ENABLE_TRACE=0)");
+#endif
         }
-        else
+
+        // --bench-serialize 指定された（入力ファイルは不要）
+        if (result.count("bench-serialize"))
         {
-            // 指定された
-            output = std::filesystem::u8path(result["output"].as<std::string>());
+            opt.benchSerialize = result["bench-serialize"].as<size_t>();
+            return 0;
         }
-    }
-    catch (const std::exception& e)
-    {
-        std::cerr << "Error: " << e.what() << std::endl;
-        Help();
-        return 1;
-    }
 
-    return 0;
-}
+        // --bench-load 指定された（入力ファイルは不要）
+        if (result.count("bench-load"))
+        {
+            opt.benchLoad = std::filesystem::u8path(result["bench-load"].as<std::string>());
+            return 0;
+        }
 
-// 面の各頂点を構成するインデックス取得関数
-static std::vector<FaceIndex> ParseFaceLine(const std::string& line, Object& object)
-{
-    auto fixIndex = [&](int raw, int size) {
-        if (raw > 0)  return raw - 1;
-        if (raw < 0)  return size + raw;
-        throw std::runtime_error("OBJ index cannot be zero");
-    };
+        // コーパスの規模（--generate-corpus、--bench-corpus）
+        ParseCorpusScales(result["corpus-scales"].as<std::string>(), opt.corpusScales);
 
-    std::istringstream iss(line);
+        // 計測結果の出力先（--bench-corpus、--bench-kernels）
+        if (result.count("bench-output"))
+        {
+            opt.benchOutput = std::filesystem::u8path(result["bench-output"].as<std::string>());
+        }
 
-    std::string type;
-    iss >> type; // "f"
+        // --bench-kernels 指定された（入力ファイルは不要）
+        if (result.count("bench-kernels"))
+        {
+            opt.benchKernels = true;
+            opt.benchSamples = result["bench-samples"].as<int>();
+            if (opt.benchSamples < 1)
+            {
+                throw std::runtime_error("--bench-samples must be at least 1");
+            }
+            return 0;
+        }
 
-    std::vector<FaceIndex> result;
+        // --check-determinism 指定された（入力ファイルは不要）
+        if (result.count("check-determinism"))
+        {
+            opt.checkDeterminism = std::filesystem::u8path(result["check-determinism"].as<std::string>());
+            ParseThreadCounts(result["determinism-threads"].as<std::string>(), opt.determinismThreads);
+            return 0;
+        }
 
-    std::string token;
-    while (iss >> token)
-    {
-        FaceIndex idx{ -1, -1, -1 };
+        // --generate-corpus 指定された（入力ファイルは不要）
+        if (result.count("generate-corpus"))
+        {
+            opt.generateCorpus = std::filesystem::u8path(result["generate-corpus"].as<std::string>());
+            return 0;
+        }
 
-        std::istringstream tss(token);
-        std::string s;
+        // --bench-async 指定された（入力ファイルは不要）
+        if (result.count("bench-async"))
+        {
+            opt.benchAsync = std::filesystem::u8path(result["bench-async"].as<std::string>());
+            opt.benchAsyncFiles = result["bench-async-files"].as<size_t>();
+            return 0;
+        }
 
-        // v
-        if (std::getline(tss, s, '/')) idx.v = fixIndex(std::stoi(s), static_cast<int>(object.positions.size()));
+        // --server 指定された（変換の設定は要求ごとに受け取る）
+        if (result.count("server"))
+        {
+            opt.server = true;
+            opt.threads = result["threads"].as<unsigned>();
+            opt.textureCacheSize = result["texture-cache"].as<uint64_t>() << 20;
+            if (result.count("socket"))
+            {
+                opt.socket = std::filesystem::u8path(result["socket"].as<std::string>());
+            }
+            return 0;
+        }
 
-        // vt
-        if (std::getline(tss, s, '/'))
+        // --client 指定された（入力ファイルと出力ファイル以外の引数はそのままサーバーに送る）
+        if (result.count("client"))
         {
-            if (!s.empty()) idx.vt = fixIndex(std::stoi(s), static_cast<int>(object.texcoords.size()));
+            opt.client = std::filesystem::u8path(result["client"].as<std::string>());
+            opt.shutdown = result.count("shutdown") > 0;
+            if (result.count("input"))
+            {
+                opt.input = std::filesystem::u8path(result["input"].as<std::string>());
+                opt.output = opt.input;
+                opt.output.replace_extension(".imdl");
+                if (result.count("output"))
+                {
+                    opt.output = std::filesystem::u8path(result["output"].as<std::string>());
+                }
+            }
+            return 0;
         }
 
-        // vn
-        if (std::getline(tss, s, '/'))
+        // --verify 指定された（入力ファイルは不要）
+        if (result.count("verify"))
         {
-            if (!s.empty()) idx.vn = fixIndex(std::stoi(s), static_cast<int>(object.normals.size()));
+            opt.verify = std::filesystem::u8path(result["verify"].as<std::string>());
+            return 0;
         }
 
-        result.push_back(idx);
-    }
+        // 出力フォーマット
+        opt.write.version = result["format-version"].as<uint32_t>();
+        opt.write.upgradeVersion = result.count("format-version") == 0;
+        opt.write.alignment = result["align"].as<uint32_t>();
+        opt.write.large = result.count("large") > 0;
+        opt.write.checksum = result.count("checksum") > 0;
+        opt.write.gpuLayout = result.count("gpu-layout") > 0;
+        opt.write.sync = result.count("sync-output") > 0;
+        opt.incremental = result.count("incremental") > 0;
+
+        if (opt.write.version != IMDL_VERSION_1 && opt.write.version != IMDL_VERSION_2)
+        {
+            throw std::runtime_error("--format-version must be 1 or 2");
+        }
 
-    return result;
-}
+        if (opt.write.large && opt.write.version != IMDL_VERSION_2)
+        {
+            throw std::runtime_error("--large requires --format-version 2");
+        }
 
-// objファイルの情報取得関数
-static int AnalyzeObj(const std::filesystem::path& fname, Object& object)
-{
-    // objファイルのオープン
-    std::ifstream ifs(fname);
+        if (opt.write.checksum && opt.write.version != IMDL_VERSION_2)
+        {
+            throw std::runtime_error("--checksum requires --format-version 2");
+        }
 
-    if (!ifs)
-    {
-        // ファイルのオープン失敗
-        std::wcout << "Could not open " << fname << std::endl;
-        return 1;
-    }
+        if (!IsValidAlignment(opt.write.alignment))
+        {
+            throw std::runtime_error("--align must be a power of two (>= 4)");
+        }
 
-    std::vector<Face>* pFace = nullptr;
-    std::string object_name;
+        if (opt.write.gpuLayout && opt.write.version != IMDL_VERSION_2)
+        {
+            throw std::runtime_error("--gpu-layout requires --format-version 2");
+        }
 
-    std::string line;
-    while (std::getline(ifs, line))
-    {
-        // 空行やコメントをスキップ
-        if (line.empty() || line[0] == '#') continue;
+        // 圧縮
+        if (result.count("compress"))
+        {
+            if (opt.write.version != IMDL_VERSION_2)
+            {
+                throw std::runtime_error("--compress requires --format-version 2");
+            }
 
-        std::istringstream iss(line);
+            uint32_t blockSize = result["compress-block"].as<uint32_t>();
+            if (blockSize == 0 || blockSize > 64 * 1024)
+            {
+                throw std::runtime_error("--compress-block must be between 1 and 65536 KiB");
+            }
 
-        // 先頭のトークン
-        std::string type;
-        iss >> type;
+            ParseCompressionSpec(result["compress"].as<std::string>(), blockSize * 1024, opt.write.compression);
+            opt.write.verifyCompression = result.count("verify-compression") > 0;
+        }
 
-        // オブジェクト名
-        if (type == "o")
+        // --batch 指定された（入力ファイルは不要）
+        if (result.count("batch"))
         {
-            iss >> object_name;
-            object.meshes.emplace_back();
-            pFace = nullptr;
+            opt.batch = result["batch"].as<std::vector<std::string>>();
+            opt.threads = result["threads"].as<unsigned>();
+            opt.processes = result["processes"].as<unsigned>();
+            if (result.count("output-dir"))
+            {
+                opt.outputDir = std::filesystem::u8path(result["output-dir"].as<std::string>());
+            }
+            if (result.count("worker-socket"))
+            {
+                for (const auto& socket : result["worker-socket"].as<std::vector<std::string>>())
+                {
+                    opt.workerSockets.push_back(std::filesystem::u8path(socket));
+                }
+            }
+            return 0;
         }
 
-        // 頂点
-        if (type == "v")
+        // --bench-corpus 指定された（出力フォーマットの設定を使う、入力ファイルは不要）
+        if (result.count("bench-corpus"))
         {
-            object.positions.push_back(ReadFloat3(iss));
+            opt.benchCorpus = std::filesystem::u8path(result["bench-corpus"].as<std::string>());
+            opt.benchRepeat = result["bench-repeat"].as<int>();
+            if (opt.benchRepeat < 1)
+            {
+                throw std::runtime_error("--bench-repeat must be at least 1");
+            }
+            if (result.count("bench-baseline"))
+            {
+                opt.benchBaseline = std::filesystem::u8path(result["bench-baseline"].as<std::string>());
+            }
+            if (result.count("bench-tolerance"))
+            {
+                opt.benchTolerance = result["bench-tolerance"].as<std::string>();
+                BenchTolerance tolerance;
+                ParseBenchTolerance(opt.benchTolerance, tolerance);
+            }
+            return 0;
         }
 
-        // 法線
-        else if (type == "vn")
+        // --watch 指定された（入力ファイルは不要）
+        if (result.count("watch"))
         {
-            object.normals.push_back(ReadFloat3(iss));
+            opt.watch = result["watch"].as<std::vector<std::string>>();
+            opt.threads = result["threads"].as<unsigned>();
+            if (result.count("output-dir"))
+            {
+                opt.outputDir = std::filesystem::u8path(result["output-dir"].as<std::string>());
+            }
+            return 0;
         }
 
-        // テクスチャ座標
-        else if (type == "vt")
+        if (result.count("input") == 0)
         {
-            // BlenderのV座標は上が＋
-            XMFLOAT2 uv = ReadFloat2(iss);
-            uv.y = 1.0f - uv.y;
-            object.texcoords.push_back(uv);
+            throw std::runtime_error("No input file");
         }
 
-        // 面情報
-        else if (type == "f")
+        // 入力ファイル名
+        opt.input = std::filesystem::u8path(result["input"].as<std::string>());
+
+        // タスクグラフでの変換（１つのファイルの変換）
+        opt.threads = result["threads"].as<unsigned>();
+        opt.criticalPath = result.count("critical-path") > 0;
+
+        // メモリの予算（１つのファイルの変換のみ）
+        if (result.count("memory-budget"))
         {
-            // マテリアルがない
-            if (pFace == nullptr)
+            opt.memoryBudget = result["memory-budget"].as<uint64_t>() << 20;
+            if (opt.memoryBudget == 0)
             {
-                std::cout << object_name << " has no material assigned." << std::endl;
-                return 1;
+                throw std::runtime_error("--memory-budget must be at least 1 MiB");
             }
+        }
+        opt.memoryReport = opt.memoryBudget > 0 || result.count("memory-report") > 0;
 
-            // 面の各頂点を構成するインデックスを取得
-            std::vector<FaceIndex> result = ParseFaceLine(line, object);
-
-            // 四角形の場合は三角形２枚に置き換える
-            for (size_t i = 0; i < result.size() - 2; i++)
+        // 統計（１つのファイルの変換のみ）
+        if (result.count("stats"))
+        {
+            opt.stats = result["stats"].as<std::string>();
+            if (opt.stats != "json")
             {
-                // 反時計回りが表
-                Face face{ result[0], result[i + 1], result[i + 2] };
-                pFace->push_back(face);
+                throw std::runtime_error("--stats supports json only: " + opt.stats);
             }
         }
-
-        // マテリアル名
-        else if (type == "usemtl")
+        if (result.count("stats-output"))
         {
-            // メッシュを追加
-            object.meshes.back().subMeshs.emplace_back();
-
-            // マテリアル名
-            std::string material;
-            iss >> material;
-            object.meshes.back().subMeshs.back().material = material;
-
-            // 面を設定するポインタを更新
-            pFace = &object.meshes.back().subMeshs.back().faces;
+            opt.statsOutput = std::filesystem::u8path(result["stats-output"].as<std::string>());
         }
 
-        // マテリアルファイル名
-        else if (type == "mtllib")
+        // -o,-output 出力ファイル名
+        if (result.count("output") == 0) {
+            // 指定されていない場合は出力ファイル名は、入力ファイル名.mdlにする
+            opt.output = std::filesystem::path(opt.input);
+            opt.output.replace_extension(".imdl");
+        }
+        else
         {
-            std::string name;
-            iss >> name;
-            // utf8 → path
-            object.mtllib = std::filesystem::u8path(name);
+            // 指定された
+            opt.output = std::filesystem::u8path(result["output"].as<std::string>());
         }
     }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        Help();
+        return 1;
+    }
 
     return 0;
 }
 
-// テクスチャタイプによる変換ファイルフォーマットを取得する関数
-static DXGI_FORMAT GetFormat(TextureType type)
+// objファイルの情報取得関数
+static int AnalyzeObj(const std::filesystem::path& fname, ObjModel& object)
 {
-    switch (type)
+    std::string error;
+    if (!ParseObjFile(fname, object, error))
     {
-    case TextureType::BaseColor:
-        return DXGI_FORMAT_BC7_UNORM_SRGB;
-
-    case TextureType::Normal:
-        return DXGI_FORMAT_BC5_UNORM;
-
-    case TextureType::MetalRough:
-        return DXGI_FORMAT_BC1_UNORM;
-
-    case TextureType::Emissive:
-        return DXGI_FORMAT_BC7_UNORM_SRGB;
-
-    default:
-        return DXGI_FORMAT_BC7_UNORM;
+        std::wcerr << StringToWString(error) << std::endl;
+        return 1;
     }
+
+    return 0;
 }
 
-// テクスチャデータをDDS形式にしてメモリに書き出す関数
-// ※法線マップのみY要素を反転する（TexConvの-invertY相当）
-static HRESULT ConvertToDDSMemory(
-    ID3D11Device* device,
-    ScratchImage scratch,
-    size_t width,
-    size_t height,
-    TextureType type,
-    std::vector<uint8_t>& outDDS)
+// mtlファイルの情報取得関数
+// sortTextures : テクスチャの番号をファイル名と種類の順にする（--deterministic、mtl に書かれている順に左右されない）
+static int AnalyzeMtl( const std::filesystem::path& path,
+                       std::vector<MaterialInfo>& materials,
+                       std::unordered_map<std::string, uint32_t>& materialIndexMap,
+                       std::vector<TextureRequest>& textures,
+                       bool sortTextures )
 {
-    HRESULT hr;
-
-    // ----------------------------------
-    // 1. 法線マップのみY反転（TexConv.exeの-inverty相当）
-    // ----------------------------------
-    if (type == TextureType::Normal)
+    std::string error;
+    if (!ParseMtlFile(path, materials, materialIndexMap, textures, error))
     {
-        ScratchImage flipped;
-
-        auto invertY = [](XMVECTOR* outPixels, const XMVECTOR* inPixels, size_t width, size_t y) noexcept
-            {
-                for (size_t x = 0; x < width; ++x)
-                {
-                    XMVECTOR v = inPixels[x];
-
-                    // G成分反転
-                    v = XMVectorSetY(v, 1.0f - XMVectorGetY(v));
-
-                    outPixels[x] = v;
-                }
-            };
-
-        HRESULT hr = TransformImage(
-            scratch.GetImages(),
-            scratch.GetImageCount(),
-            scratch.GetMetadata(),
-            invertY,
-            flipped);
-
-        scratch = std::move(flipped);
+        std::wcerr << StringToWString(error) << std::endl;
+        return 1;
     }
 
-    // ----------------------------------
-    // 2. ミップ生成
-    // ----------------------------------
-    ScratchImage mipChain;
-
-    hr = GenerateMipMaps(
-        scratch.GetImages(),
-        scratch.GetImageCount(),
-        scratch.GetMetadata(),
-        TEX_FILTER_FANT,
-        0,
-        mipChain);
+    if (sortTextures) SortTextureRequests(materials, textures);
 
-    if (FAILED(hr))
-        return hr;
+    return 0;
+}
 
-    // ----------------------------------
-    // 3. GPU圧縮
-    // ----------------------------------
-    ScratchImage compressed;
+// マテリアル情報のシリアライズ関数
+// ※MaterialInfo はファイル上のレイアウトと同じなのでそのまま書き込む（Imdl.h で確認済み）
+inline void SerializeMaterial(BinaryWriter& writer, const MaterialInfo& m)
+{
+    writer.WriteValue(m);
+}
 
-    DXGI_FORMAT format = GetFormat(type);
-    if (type == TextureType::Normal)
+// マテリアル情報データ作成
+static std::vector<uint8_t> BuildMaterialChunk(const std::vector<MaterialInfo>& materials)
+{
+    BinaryWriter writer(GetVectorChunkSize(materials, IMDL_VERSION_1));
+    writer.WriteVector(materials);
+    return writer.Release();
+}
+
+// メッシュ情報のシリアライズ関数
+inline void SerializeMesh(BinaryWriter& writer, const MeshInfo& m)
+{
+    writer.WriteValue(m);
+}
+
+// メッシュ情報データ作成
+static std::vector<uint8_t> BuildMeshChunk(const std::vector<MeshInfo>& meshes)
+{
+    BinaryWriter writer(GetVectorChunkSize(meshes, IMDL_VERSION_1));
+    writer.WriteVector(meshes);
+    return writer.Release();
+}
+
+// 頂点データのシリアライズ関数
+inline void SerializeVertex(BinaryWriter& writer, const VertexPositionNormalTextureTangent& v)
+{
+    writer.WriteValue(v);
+}
+
+// 頂点データ作成
+static std::vector<uint8_t> BuildVertexChunk(
+    const std::vector<VertexPositionNormalTextureTangent>& vertices)
+{
+    BinaryWriter writer(GetVectorChunkSize(vertices, IMDL_VERSION_1));
+    writer.WriteVector(vertices);
+    return writer.Release();
+}
+
+// インデックスデータ作成
+static std::vector<uint8_t> BuildIndexChunk(const std::vector<uint32_t>& indices)
+{
+    BinaryWriter writer(GetVectorChunkSize(indices, IMDL_VERSION_1));
+    writer.WriteVector(indices);
+    return writer.Release();
+}
+
+// 変換処理の版（変換の結果が変わる修正をしたら上げて、--incremental でも全ファイルを作り直す）
+static const uint32_t CONVERTER_REVISION = 1;
+
+// 変換の設定を文字列にする関数（依存関係の記録で設定の変更を検出するために使う）
+static std::string GetSettingsSignature(const ImdlWriteSettings& settings)
+{
+    std::ostringstream oss;
+    oss << "revision=" << CONVERTER_REVISION
+        << " version=" << settings.version
+        << " align=" << settings.alignment
+        << " large=" << settings.large
+        << " checksum=" << settings.checksum
+        << " gpu-layout=" << settings.gpuLayout;
+
+    if (settings.cpuTextures) oss << " textures=cpu";
+    if (settings.sortTextures) oss << " deterministic";
+
+    for (const auto& [type, compression] : settings.compression)
     {
-        hr = Compress(
-            mipChain.GetImages(),
-            mipChain.GetImageCount(),
-            mipChain.GetMetadata(),
-            DXGI_FORMAT_BC5_UNORM,
-            TEX_COMPRESS_DEFAULT,
-            TEX_THRESHOLD_DEFAULT,
-            compressed);
+        oss << " " << GetChunkTypeName(type) << "=" << GetCompressionName(compression.type)
+            << ":" << compression.level << ":" << compression.blockSize;
     }
-    else
+
+    return oss.str();
+}
+
+// 出力ファイルの依存関係（obj、mtl、テクスチャ）を記録する関数
+static void RecordConversionDependencies(
+    const std::filesystem::path& output,
+    const ImdlWriteSettings& settings,
+    const std::filesystem::path& input,
+    const std::filesystem::path& mtl,
+    const std::vector<TextureRequest>& textures)
+{
+    std::vector<std::filesystem::path> inputs{ input, mtl };
+    for (const auto& texture : textures)
     {
-        hr = Compress(
-            device,
-            mipChain.GetImages(),
-            mipChain.GetImageCount(),
-            mipChain.GetMetadata(),
-            format,
-            TEX_COMPRESS_DEFAULT,
-            0.5f,
-            compressed);
+        inputs.push_back(texture.path);
     }
 
-    if (FAILED(hr))
-        return hr;
+    if (!RecordDependencies(output, GetSettingsSignature(settings), inputs))
+    {
+        std::wcerr << L"Could not record dependencies of " << ToWString(output) << std::endl;
+    }
+}
 
-    // ----------------------------------
-    // 4. メモリ内にDDS生成
-    // ----------------------------------
-    Blob ddsBlob;
+// 書き出しの結果（4GB 超え用の形式への切り替え、圧縮したチャンクの圧縮率）を表示する関数
+// ※まとめて表示して、一括変換で他のスレッドの表示と混ざらないようにする
+static void PrintWriteReport(const ImdlWriteSettings& settings, const ImdlWriteStats& stats, std::ostream& log = std::cout)
+{
+    std::ostringstream oss;
 
-    hr = SaveToDDSMemory(
-        compressed.GetImages(),
-        compressed.GetImageCount(),
-        compressed.GetMetadata(),
-        DDS_FLAGS_NONE,
-        ddsBlob);
+    if (stats.large && !settings.large)
+    {
+        oss << "Output exceeds 4GB, switched to the large format (version 2)." << std::endl;
+    }
 
-    if (FAILED(hr))
-        return hr;
+    for (const auto& chunk : stats.chunks)
+    {
+        auto it = settings.compression.find(chunk.type);
+        if (it == settings.compression.end() || it->second.type == COMPRESSION_NONE) continue;
+
+        const CompressionSettings& compression = it->second;
+        oss << "  " << GetChunkTypeName(chunk.type) << ": ";
+
+        // GPU アップロード用の配置は圧縮しない
+        if (chunk.flags & IMDL_CHUNK_FLAG_GPU_LAYOUT)
+        {
+            oss << "GPU layout, not compressed" << std::endl;
+            continue;
+        }
+
+        oss << GetCompressionName(compression.type) << " level " << compression.level << ", "
+            << chunk.rawSize << " -> " << chunk.compressedSize << " bytes";
+
+        // 小さくならなかったので圧縮していない
+        if ((chunk.flags & IMDL_CHUNK_FLAG_COMPRESSION_MASK) == COMPRESSION_NONE)
+        {
+            oss << ", not compressed" << std::endl;
+            continue;
+        }
+
+        oss << " (" << (chunk.rawSize ? 100.0 * chunk.compressedSize / chunk.rawSize : 100.0) << "%)";
+        if (settings.verifyCompression) oss << ", decode " << ToMBps(chunk.rawSize, chunk.decodeSec) << " MB/s";
+        oss << std::endl;
+    }
+
+    log << oss.str() << std::flush;
+}
+
+// ファイルへの出力関数
+// log : 書き出しの結果の表示先
+static int OutputImdl(const std::filesystem::path& path, const ImdlWriteSettings& settings, const ModelData& model,
+    ImdlWriteStats* stats = nullptr, std::ostream& log = std::cout)
+{
+    IMDL_TRACE_SCOPE_DETAIL("OutputImdl", path.u8string());
+
+    ImdlWriteStats writeStats;
+    if (stats == nullptr) stats = &writeStats;
+
+    std::string error;
+    if (!WriteImdlModel(path, model, settings, error, stats))
+    {
+        std::wcerr << StringToWString(error) << std::endl;
+        return 1;
+    }
+
+    PrintWriteReport(settings, *stats, log);
 
-    // ----------------------------------
-    // 5. vector にコピー
-    // ----------------------------------
-    outDDS.resize(ddsBlob.GetBufferSize());
-    memcpy(outDDS.data(),
-        ddsBlob.GetBufferPointer(),
-        ddsBlob.GetBufferSize());
+    return 0;
+}
+
+// 計測結果の JSON を書き出す関数（- は標準出力）
+static bool WriteBenchmarkOutput(const std::filesystem::path& path, const std::string& text)
+{
+    if (path == "-")
+    {
+        std::cout << text << std::flush;
+        return true;
+    }
+
+    std::ofstream ofs(path, std::ios::binary);
+    ofs << text;
+    if (!ofs)
+    {
+        std::wcerr << L"Could not write " << ToWString(path) << std::endl;
+        return false;
+    }
 
-    return S_OK;
+    return true;
 }
 
-// テクスチャをDDSに変換して登録する関数
-static int RegisterTexture(
-    ID3D11Device* device,
-    const std::filesystem::path& path,
-    TextureType type,
-    std::vector<TextureEntry>& textures,
-    std::map<std::pair<std::wstring, TextureType>, int>& textureIndexMap)
+// シリアライズ速度の計測関数
+static int BenchmarkSerialize(size_t vertexCount)
 {
-    auto key = std::make_pair(path.c_str(), type);
+    // ----- 計測用のデータを作成 ----- //
+    std::vector<VertexPositionNormalTextureTangent> vertices(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        float f = static_cast<float>(i);
+        vertices[i].position = { f, f * 0.5f, f * 0.25f };
+        vertices[i].normal = { 0.0f, 1.0f, 0.0f };
+        vertices[i].texcoord = { f * 0.001f, 1.0f - f * 0.001f };
+        vertices[i].tangent = { 1.0f, 0.0f, 0.0f, 1.0f };
+    }
 
-    // 既に登録済み？
-    auto it = textureIndexMap.find(key);
-    if (it != textureIndexMap.end())
+    std::vector<uint32_t> indices(vertexCount * 3);
+    for (size_t i = 0; i < indices.size(); i++)
     {
-        return it->second;
+        indices[i] = static_cast<uint32_t>((i * 7) % vertexCount);
     }
 
-    // ----- テクスチャの読み込み→DDSの変換→登録 ----- //
-    ScratchImage image;
-    TexMetadata metadata;
+    std::vector<MeshInfo> meshes(vertexCount / 64 + 1);
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        meshes[i] = { static_cast<uint32_t>(i * 192), 64, static_cast<uint32_t>(i % 16) };
+    }
 
-    // PNG読み込み（WIC使用）
-    HRESULT hr = LoadFromWICFile(path.c_str(), WIC_FLAGS_NONE, &metadata, image);
+    std::vector<MaterialInfo> materials(vertexCount / 64 + 1);
 
-    // 読み込み失敗
-    if (FAILED(hr))
-        return -1;
+    // ----- 計測 ----- //
+    const int repeat = 5;
 
-    // DDSへ変換
-    std::vector<uint8_t> dds;
-    hr = ConvertToDDSMemory(device, std::move(image), metadata.width, metadata.height, type, dds);
+    auto report = [](const char* name, size_t bytes, double sec)
+        {
+            std::cout << "  " << name << ": "
+                << static_cast<double>(bytes) / (1024.0 * 1024.0) << " MB, "
+                << sec * 1000.0 << " ms, "
+                << ToMBps(bytes, sec) << " MB/s" << std::endl;
+        };
 
-    // 変換失敗
-    if (FAILED(hr))
-        return -1;
+    std::cout << "Serialization benchmark (" << vertexCount << " vertices, best of " << repeat << ")" << std::endl;
+
+    // 頂点を１つずつシリアライズ（容量の事前確保なし）
+    size_t bytes = 0;
+    double sec = MeasureBest(repeat, [&]()
+        {
+            BinaryWriter writer;
+            writer.WriteUInt32(static_cast<uint32_t>(vertices.size()));
+            for (const auto& v : vertices)
+            {
+                SerializeVertex(writer, v);
+            }
+            bytes = writer.GetSize();
+        });
+    report("SerializeVertex (per vertex)", bytes, sec);
+
+    sec = MeasureBest(repeat, [&]() { bytes = BuildVertexChunk(vertices).size(); });
+    report("BuildVertexChunk", bytes, sec);
+
+    sec = MeasureBest(repeat, [&]() { bytes = BuildIndexChunk(indices).size(); });
+    report("BuildIndexChunk", bytes, sec);
+
+    sec = MeasureBest(repeat, [&]() { bytes = BuildMeshChunk(meshes).size(); });
+    report("BuildMeshChunk", bytes, sec);
 
-    int newIndex = (int)textures.size();
+    sec = MeasureBest(repeat, [&]() { bytes = BuildMaterialChunk(materials).size(); });
+    report("BuildMaterialChunk", bytes, sec);
+
+    // ファイルまでの書き出し（ストリーム経由とメモリマップ直接書き込みの比較）
+    std::filesystem::path benchPath = std::filesystem::temp_directory_path() / "ObjToImdl_bench.imdl";
+
+    sec = MeasureBest(repeat, [&]()
+        {
+            std::ofstream ofs(benchPath, std::ios::binary);
+            FileHeader fileHeader{ 'IMDL', 1, 4 };
+            ofs.write((char*)&fileHeader, sizeof(fileHeader));
+            WriteChunk(ofs, CHUNK_MATERIAL, BuildMaterialChunk(materials));
+            WriteChunk(ofs, CHUNK_MESH, BuildMeshChunk(meshes));
+            WriteChunk(ofs, CHUNK_VERTEX, BuildVertexChunk(vertices));
+            WriteChunk(ofs, CHUNK_INDEX, BuildIndexChunk(indices));
+            ofs.close();
+            bytes = static_cast<size_t>(std::filesystem::file_size(benchPath));
+        });
+    report("WriteChunk (ofstream)", bytes, sec);
+
+    std::string error;
+    sec = MeasureBest(repeat, [&]()
+        {
+            ImdlWriteSettings settings;
+            settings.version = IMDL_VERSION_1;
+            WriteImdlFile(benchPath,
+                {
+                    MakeVectorChunk(CHUNK_MATERIAL, materials, settings),
+                    MakeVectorChunk(CHUNK_MESH, meshes, settings),
+                    MakeVectorChunk(CHUNK_VERTEX, vertices, settings),
+                    MakeVectorChunk(CHUNK_INDEX, indices, settings),
+                }, settings, error);
+            bytes = static_cast<size_t>(std::filesystem::file_size(benchPath));
+        });
+    if (!error.empty())
+    {
+        std::cerr << "Error: " << error << std::endl;
+        std::filesystem::remove(benchPath);
+        return 1;
+    }
+    report("WriteImdlFile (mapped)", bytes, sec);
 
-    textures.push_back({ type, dds });
-    textureIndexMap[key] = newIndex;
+    std::filesystem::remove(benchPath);
 
-    return newIndex;
+    return 0;
 }
 
-// テクスチャファイル名の取得関数（オプションなどは除去）
-static std::string ExtractTextureFilename(std::istringstream& iss)
+// 変換の内部の処理（カーネル）の計測関数（--bench-kernels）
+// ※入力は乱数の種を固定して作成するので、毎回同じになる
+// ※サンプルの中央値と MAD を表示する（--bench-output で全サンプルを JSON に書き出す）
+static int BenchmarkKernels(const ConverterOptions& options)
 {
-    std::string rest;
-    std::getline(iss >> std::ws, rest);
+    // JSON を標準出力に書き出す場合は、表は標準エラーに出す
+    std::ostream& log = options.benchOutput == "-" ? std::cerr : std::cout;
+
+    // ----- 計測用のデータを作成 ----- //
+    const uint32_t gridSize = 256;      // 格子の一辺の四角形の数
+    const size_t lineCount = 65536;     // v 行、f 行の数
 
-    // オプション除去
-    std::istringstream optStream(rest);
-    std::string token;
-    std::string filename;
+    CorpusRandom random(72);
 
-    while (optStream >> token)
+    // 格子（頂点ごとに位置、法線、テクスチャ座標、四角形は三角形２枚）
+    ObjModel grid;
+    for (uint32_t z = 0; z <= gridSize; z++)
     {
-        if (token[0] == '-')
+        for (uint32_t x = 0; x <= gridSize; x++)
         {
-            optStream >> token; // オプション値をスキップ
+            float height = random.NextFloat(-0.1f, 0.1f);
+            float nx = random.NextFloat(-0.2f, 0.2f);
+            float nz = random.NextFloat(-0.2f, 0.2f);
+            grid.positions.push_back({ static_cast<float>(x), height, static_cast<float>(z) });
+            grid.normals.push_back({ nx, 1.0f, nz });
+            grid.texcoords.push_back({ static_cast<float>(x) / gridSize, static_cast<float>(z) / gridSize });
         }
-        else
+    }
+    grid.meshes.emplace_back();
+    grid.meshes.back().subMeshs.emplace_back();
+    SubMesh& gridMesh = grid.meshes.back().subMeshs.back();
+    gridMesh.material = "grid";
+    auto gridIndex = [gridSize](uint32_t x, uint32_t z)
         {
-            filename = token;
-            std::string remain;
-            std::getline(optStream, remain);
-            filename += remain;
-            break;
+            int i = static_cast<int>(z * (gridSize + 1) + x);
+            return FaceIndex{ i, i, i };
+        };
+    for (uint32_t z = 0; z < gridSize; z++)
+    {
+        for (uint32_t x = 0; x < gridSize; x++)
+        {
+            FaceIndex a = gridIndex(x, z), b = gridIndex(x, z + 1), c = gridIndex(x + 1, z + 1), d = gridIndex(x + 1, z);
+            gridMesh.faces.push_back({ { a, b, c } });
+            gridMesh.faces.push_back({ { a, c, d } });
         }
     }
+    std::unordered_map<std::string, uint32_t> materialIndexMap = { { "grid", 0 } };
 
-    // 先頭のタブを除去
-    filename.erase(0, filename.find_first_not_of(" \t"));
+    // 重複を除く前の頂点の並び（格子の三角形の頂点）
+    std::vector<FaceIndex> faceVertices;
+    for (const auto& face : gridMesh.faces)
+    {
+        faceVertices.insert(faceVertices.end(), std::begin(face.faceIndices), std::end(face.faceIndices));
+    }
 
-    return filename;
-}
+    // v 行
+    std::vector<std::string> vertexLines;
+    uint64_t vertexLineBytes = 0;
+    for (size_t i = 0; i < lineCount; i++)
+    {
+        float x = random.NextFloat(-100.0f, 100.0f);
+        float y = random.NextFloat(-100.0f, 100.0f);
+        float z = random.NextFloat(-100.0f, 100.0f);
+        char line[64];
+        std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f", x, y, z);
+        vertexLines.push_back(line);
+        vertexLineBytes += vertexLines.back().size() + 1;
+    }
 
-// mtlファイルの情報取得関数
-static int AnalyzeMtl( ID3D11Device* device,
-                       const std::filesystem::path& path,
-                       std::vector<MaterialInfo>& materials,
-                       std::unordered_map<std::string, uint32_t>& materialIndexMap,
-                       std::vector<TextureEntry>& textures )
-{
-    // mtlファイルのオープン
-    std::ifstream ifs(path.c_str());
+    // f 行（v/vt/vn の四角形、負のインデックス、v//vn を混ぜる）
+    ObjModel indexRange;
+    indexRange.positions.resize(lineCount);
+    indexRange.texcoords.resize(lineCount);
+    indexRange.normals.resize(lineCount);
 
-    if (!ifs)
+    std::vector<std::string> faceLines;
+    uint64_t faceLineBytes = 0;
+    for (size_t i = 0; i < lineCount; i++)
     {
-        // ファイルのオープン失敗
-        std::wcout << "Could not open " << path.c_str() << std::endl;
-        return 1;
+        std::string line = "f";
+        for (int k = 0; k < 4; k++)
+        {
+            int64_t v = 1 + random.NextUInt(static_cast<uint32_t>(lineCount));
+            switch (i % 4)
+            {
+            case 2:  line += " " + CorpusCorner(-(k + 1), -(k + 1), -(k + 1)); break;
+            case 3:  line += " " + CorpusCorner(v, 0, v); break;
+            default: line += " " + CorpusCorner(v, v, v); break;
+            }
+        }
+        faceLines.push_back(line);
+        faceLineBytes += line.size() + 1;
     }
 
-    // テクスチャ登録位置を保存するコンテナ
-    std::map<std::pair<std::wstring, TextureType>, int> textureIndexMap;
+    // 頂点、インデックス（接線、シリアライズの入力）
+    std::vector<MeshInfo> meshes;
+    std::vector<VertexPositionNormalTextureTangent> vertices;
+    std::vector<uint32_t> indices;
+    Kernel::CreateBufferData(grid, materialIndexMap, meshes, vertices, indices);
 
-    uint32_t m_index = 0;
-    int32_t t_index = 0;
+    // ----- 計測 ----- //
+    Microbenchmark bench(options.benchSamples);
 
-    std::string line;
-    while (std::getline(ifs, line))
-    {
-        // 空行やコメントをスキップ
-        if (line.empty() || line[0] == '#') continue;
+    auto report = [&log](const MicrobenchResult& result)
+        {
+            log << "  " << result.name << ": "
+                << result.medianSec * 1e6 << " us +- " << result.madSec * 1e6 << " us, "
+                << (result.items ? result.medianSec * 1e9 / result.items : 0.0) << " ns/item";
+            if (result.bytes) log << ", " << ToMBps(result.bytes, result.medianSec) << " MB/s";
+            log << std::endl;
+        };
 
-        std::istringstream iss(line);
+    log << "Kernel benchmark (median +- MAD of " << options.benchSamples << " samples)" << std::endl;
 
-        // 先頭のトークン
-        std::string type;
-        iss >> type;
+    // v 行の数値の読み込み（行ごとに istringstream を作るのは obj の解析と同じ）
+    report(bench.Run("ReadFloat3", vertexLines.size(), vertexLineBytes, [&]()
+        {
+            uint64_t sum = 0;
+            for (const auto& line : vertexLines)
+            {
+                std::istringstream iss(line);
+                std::string type;
+                iss >> type;
+                XMFLOAT3 v = Kernel::ReadFloat3(iss);
+                sum += static_cast<uint64_t>(static_cast<int64_t>(v.x + v.y + v.z));
+            }
+            return sum;
+        }));
 
-        // マテリアルファイル名
-        if (type == "newmtl")
+    // f 行の解析
+    report(bench.Run("ParseFaceLine", faceLines.size(), faceLineBytes, [&]()
         {
-            std::string name;
-            iss >> name;
-            materials.resize(materials.size() + 1);
-            materialIndexMap[name] = m_index;
-            m_index++;
-        }
+            uint64_t sum = 0;
+            for (const auto& line : faceLines)
+            {
+                std::vector<FaceIndex> result = Kernel::ParseFaceLine(line, indexRange);
+                sum += result.size() + static_cast<uint64_t>(result[0].v);
+            }
+            return sum;
+        }));
 
-        // ディフューズ色
-        else if (type == "Kd")
+    // FaceIndex のハッシュ値
+    report(bench.Run("FaceIndex hash", faceVertices.size(), 0, [&]()
         {
-            XMFLOAT3 color = ReadFloat3(iss);
-            materials.back().diffuseColor = { color.x, color.y, color.z, 1.0f};
-        }
+            uint64_t sum = 0;
+            std::hash<FaceIndex> hasher;
+            for (const auto& f : faceVertices)
+            {
+                sum += hasher(f);
+            }
+            return sum;
+        }));
 
-        // スペキュラ色
-        else if (type == "Ks")
+    // 重複除去のマップ（CreateBufferData と同じ検索と追加、頂点は作らない）
+    std::vector<uint32_t> dedupIndices;
+    dedupIndices.reserve(faceVertices.size());
+    report(bench.Run("Dedup map", faceVertices.size(), 0, [&]()
         {
-            // メタリックにIORレベルを入れる（プログラム側ではスペキュラ色の要素として使用）
-            // （blenderではメタリックはNsで出力されるのでroughnessへ反映）
-            XMFLOAT3 specularColor = ReadFloat3(iss);
-            materials.back().metallicFactor = specularColor.x;
-        }
+            dedupIndices.clear();
+            size_t vertexCount = Kernel::DedupFaceIndices(faceVertices, dedupIndices);
+            return static_cast<uint64_t>(vertexCount + dedupIndices.size());
+        }));
 
-        // スペキュラパワー
-        else if (type == "Ns")
+    // 頂点とインデックスの作成（重複除去と頂点の作成）
+    report(bench.Run("CreateBufferData", faceVertices.size(), 0, [&]()
         {
-            float Ns;
-            iss >> Ns;
-            // ※blenderの粗さ【roughness】はobj形式には反映されない
-            // blenderではNsの値はメタリックが反映される
-            // Ns = 1000 x (1 - metallic)^2
-            // Nsを使ってroughnessを算出する
-            // シェダー側では【spcularPower = 1000 x (1 - roughness)^2】で計算
-            float roughness = 1.0f - (sqrtf(Ns / 1000.0f));
-            materials.back().roughnessFactor = roughness;
-        }
+            std::vector<MeshInfo> m;
+            std::vector<VertexPositionNormalTextureTangent> v;
+            std::vector<uint32_t> i;
+            Kernel::CreateBufferData(grid, materialIndexMap, m, v, i);
+            return static_cast<uint64_t>(v.size() + i.size());
+        }));
+
+    // 接線の計算（接線以外は書き換えないので、同じ頂点を繰り返し使う）
+    report(bench.Run("GenerateTangents", indices.size() / 3, 0, [&]()
+        {
+            Kernel::GenerateTangents(vertices, indices);
+            return static_cast<uint64_t>(vertices.back().tangent.w > 0.0f);
+        }));
 
-        // エミッシブ色
-        else if (type == "Ke")
+    // シリアライズ
+    report(bench.Run("BinaryWriter::WriteUInt32", indices.size(), indices.size() * sizeof(uint32_t), [&]()
         {
-            materials.back().emissiveColor = ReadFloat3(iss);
-        }
+            BinaryWriter writer;
+            writer.Reserve(indices.size() * sizeof(uint32_t));
+            for (uint32_t index : indices)
+            {
+                writer.WriteUInt32(index);
+            }
+            return static_cast<uint64_t>(writer.GetSize());
+        }));
 
-        // テクスチャ（ベースカラー）
-        else if (type == "map_Kd")
+    report(bench.Run("SerializeVertex", vertices.size(), vertices.size() * sizeof(VertexPositionNormalTextureTangent), [&]()
         {
-            if (!materials.empty())
+            BinaryWriter writer;
+            writer.Reserve(vertices.size() * sizeof(VertexPositionNormalTextureTangent));
+            for (const auto& v : vertices)
             {
-                // 最後のトークンをファイル名として取得
-                std::string name = ExtractTextureFilename(iss);
+                SerializeVertex(writer, v);
+            }
+            return static_cast<uint64_t>(writer.GetSize());
+        }));
+
+    report(bench.Run("BuildVertexChunk", vertices.size(), vertices.size() * sizeof(VertexPositionNormalTextureTangent), [&]()
+        {
+            return static_cast<uint64_t>(BuildVertexChunk(vertices).size());
+        }));
+
+    // ----- JSON ----- //
+    if (options.benchOutput.empty()) return 0;
+
+    std::ostringstream oss;
+    JsonWriter json(oss);
+    json.BeginObject();
+    json.Member("benchmark", "kernels");
+    json.Member("samples", options.benchSamples);
+    json.Key("kernels");
+    bench.WriteJson(json);
+    json.EndObject();
+
+    return WriteBenchmarkOutput(options.benchOutput, oss.str()) ? 0 : 1;
+}
+
+// 読み込み速度の計測関数
+// ※ReadChunk（ifstream でチャンクごとに vector へコピー）、ImdlReader（メモリマップ）、LazyImdlReader（必要なチャンクだけ）を比較する
+static int BenchmarkLoad(const std::filesystem::path& path)
+{
+    const int repeat = 5;
+
+    ImdlReader reader;
+    if (!reader.Open(path))
+    {
+        std::wcerr << L"Could not open " << ToWString(path) << std::endl;
+        std::cerr << "Error: " << reader.GetError() << std::endl;
+        return 1;
+    }
+    uint32_t version = reader.GetVersion();
+    reader.Close();
+
+    size_t bytes = static_cast<size_t>(std::filesystem::file_size(path));
+
+    auto report = [bytes](const char* name, double sec)
+        {
+            std::cout << "  " << name << ": "
+                << sec * 1000.0 << " ms, "
+                << ToMBps(bytes, sec) << " MB/s" << std::endl;
+        };
+
+    // 全データを参照する（読み込んだだけで使われないことを防ぐ）
+    uint32_t sink = 0;
+    auto touch = [&sink](const uint8_t* data, size_t size)
+        {
+            for (size_t i = 0; i < size; i += 64) sink += data[i];
+        };
+
+    std::wcout << L"Load benchmark (" << ToWString(path) << L", ";
+    std::cout << bytes << " bytes, version " << version << ", best of " << repeat << ")" << std::endl;
 
-                // エラー
-                if (name.empty()) return -1;
+    // ReadChunk でチャンクごとに読み込む
+    double sec = MeasureBest(repeat, [&]()
+        {
+            std::ifstream ifs(path, std::ios::binary);
+            std::vector<std::vector<uint8_t>> chunks;
 
-                // utf8 → path
-                std::filesystem::path p = std::filesystem::u8path(name);
+            if (version == IMDL_VERSION_1)
+            {
+                FileHeader header;
+                ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
 
-                // pngファイルが存在？
-                if (!std::filesystem::exists(p))
+                ChunkHeader chunkHeader;
+                std::vector<uint8_t> buffer;
+                for (uint32_t i = 0; i < header.chunkCount && ReadChunk(ifs, chunkHeader, buffer); i++)
                 {
-                    // 存在しない場合はobjと一緒のフォルダに変更
-                    std::filesystem::path baseDir = path.parent_path();
-                    p = baseDir / p.filename();
-                    // そこにもpngがない
-                    if (!std::filesystem::exists(p))
+                    chunks.push_back(std::move(buffer));
+                }
+            }
+            else
+            {
+                FileHeaderV2 header;
+                std::vector<ChunkEntry64> entries;
+                if (ReadChunkTable(ifs, header, entries))
+                {
+                    chunks.resize(entries.size());
+                    for (size_t i = 0; i < entries.size(); i++)
                     {
-                        std::wcerr << L"Texture not found: " << p.wstring() << std::endl;
-                        return -1;
+                        ReadChunkData(ifs, entries[i], chunks[i]);
                     }
                 }
+            }
+
+            for (const auto& chunk : chunks) touch(chunk.data(), chunk.size());
+        });
+    report("ReadChunk (ifstream)", sec);
+
+    // メモリマップして参照するだけ
+    sec = MeasureBest(repeat, [&]()
+        {
+            ImdlReader r;
+            r.Open(path);
+            sink += static_cast<uint32_t>(r.GetVertices().size() + r.GetIndices().size());
+        });
+    report("ImdlReader (open only)", sec);
+
+    // メモリマップして全データを参照する
+    sec = MeasureBest(repeat, [&]()
+        {
+            ImdlReader r;
+            r.Open(path);
+            for (uint32_t type : { CHUNK_TEXTURE, CHUNK_MATERIAL, CHUNK_MESH, CHUNK_VERTEX, CHUNK_INDEX })
+            {
+                Span<uint8_t> data = r.GetChunkData(type);
+                touch(data.data(), data.size());
+            }
+        });
+    report("ImdlReader (open + touch)", sec);
+
+    // チェックサムを確認して全データを参照する
+    sec = MeasureBest(repeat, [&]()
+        {
+            ImdlReadOptions options;
+            options.verifyChecksums = true;
+
+            ImdlReader r;
+            r.Open(path, options);
+            for (uint32_t type : { CHUNK_TEXTURE, CHUNK_MATERIAL, CHUNK_MESH, CHUNK_VERTEX, CHUNK_INDEX })
+            {
+                Span<uint8_t> data = r.GetChunkData(type);
+                touch(data.data(), data.size());
+            }
+        });
+    report("ImdlReader (verify + touch)", sec);
+
+    // メッシュとマテリアルだけ読み込む（キャッシュなし）
+    sec = MeasureBest(repeat, [&]()
+        {
+            LazyReadOptions options;
+            options.cache = std::make_shared<ChunkCache>();
+
+            LazyImdlReader r;
+            r.Open(path, options);
+            sink += static_cast<uint32_t>(r.GetMeshes().size() + r.GetMaterials().size());
+        });
+    report("LazyImdlReader (MESH + MTRL)", sec);
+
+    // メッシュとマテリアルだけ読み込む（キャッシュ済み）
+    auto cache = std::make_shared<ChunkCache>();
+    sec = MeasureBest(repeat, [&]()
+        {
+            LazyReadOptions options;
+            options.cache = cache;
+
+            LazyImdlReader r;
+            r.Open(path, options);
+            sink += static_cast<uint32_t>(r.GetMeshes().size() + r.GetMaterials().size());
+        });
+    report("LazyImdlReader (MESH + MTRL, cached)", sec);
+
+    std::cout << "  (" << sink << ")" << std::endl;
+
+    return 0;
+}
 
-                // テクスチャ登録
-                materials.back().baseColorTexIndex = RegisterTexture(
-                    device, p, TextureType::BaseColor, textures, textureIndexMap);
+// 非同期読み込みの計測関数
+// ※指定されたファイル（フォルダの場合は中の .imdl）を繰り返し要求して、秒間ファイル数と遅延の分布を計測する
+static int BenchmarkAsyncLoad(const std::filesystem::path& path, size_t fileCount)
+{
+    std::vector<std::filesystem::path> files;
+    if (std::filesystem::is_directory(path))
+    {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(path))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".imdl")
+            {
+                files.push_back(entry.path());
             }
         }
+        std::sort(files.begin(), files.end());
+    }
+    else
+    {
+        files.push_back(path);
+    }
 
-        // テクスチャ（法線マップ）
-        else if (type == "map_Bump")
+    if (files.empty() || fileCount == 0)
+    {
+        std::wcerr << L"No imdl files in " << ToWString(path) << std::endl;
+        return 1;
+    }
+
+    std::wcout << L"Async load benchmark (" << ToWString(path) << L", ";
+    std::cout << files.size() << " files, " << fileCount << " loads)" << std::endl;
+
+    // 全データを参照する（読み込んだだけで使われないことを防ぐ）
+    std::atomic<uint32_t> sink{ 0 };
+
+    auto run = [&](const char* name, bool useIoUring)
         {
-            if (!materials.empty())
+            AsyncLoaderSettings settings;
+            settings.useIoUring = useIoUring;
+
+            std::vector<double> latencies;
+            std::mutex mutex;
+            std::atomic<uint64_t> bytes{ 0 };
+            std::atomic<size_t> failed{ 0 };
+
+            Stopwatch stopwatch;
             {
-                // 最後のトークンをファイル名として取得
-                std::string name = ExtractTextureFilename(iss);
-                
-                // エラー
-                if (name.empty()) return -1;
+                AsyncImdlLoader loader(settings);
+                if (useIoUring && !loader.IsUsingIoUring())
+                {
+                    std::cout << "  " << name << ": not available" << std::endl;
+                    return;
+                }
+
+                for (size_t i = 0; i < fileCount; i++)
+                {
+                    loader.Load(files[i % files.size()], 0,
+                        [&](const AsyncChunk& chunk)
+                        {
+                            uint32_t sum = 0;
+                            for (size_t j = 0; j < chunk.data.size(); j += 64) sum += chunk.data.data()[j];
+                            sink += sum;
+                        },
+                        [&](const AsyncFileResult& result)
+                        {
+                            if (!result.succeeded)
+                            {
+                                if (failed++ == 0)
+                                {
+                                    std::wcerr << ToWString(*result.path) << L": ";
+                                    std::cerr << result.error << std::endl;
+                                }
+                                return;
+                            }
+                            bytes += result.bytes;
+                            std::lock_guard<std::mutex> lock(mutex);
+                            latencies.push_back(result.latencySec);
+                        });
+                }
+                loader.Wait();
+            }
+            double sec = stopwatch.ElapsedSec();
+
+            std::sort(latencies.begin(), latencies.end());
+            auto percentile = [&latencies](double p)
+                {
+                    if (latencies.empty()) return 0.0;
+                    size_t index = static_cast<size_t>(p * (latencies.size() - 1) + 0.5);
+                    return latencies[index] * 1000.0;
+                };
+
+            std::cout << "  " << name << ": "
+                << fileCount / sec << " files/s, "
+                << ToMBps(bytes, sec) << " MB/s, latency ms p50 " << percentile(0.5)
+                << " p99 " << percentile(0.99)
+                << " p99.9 " << percentile(0.999)
+                << " max " << percentile(1.0);
+            if (failed) std::cout << ", " << failed << " failed";
+            std::cout << std::endl;
+        };
+
+    run("io_uring   ", true);
+    run("thread pool", false);
+
+    std::cout << "  (" << sink << ")" << std::endl;
+
+    return 0;
+}
+
+#if defined(_WIN32)
+// DirectXのデバイスを作成する関数
+static void CreateD3DDevice(ID3D11Device** device)
+{
+    D3D_FEATURE_LEVEL featureLevel;
 
-                // utf8 → path
-                std::filesystem::path p = std::filesystem::u8path(name);
+    HRESULT hr = D3D11CreateDevice(
+        nullptr,                    // アダプタ
+        D3D_DRIVER_TYPE_HARDWARE,   // GPU使用
+        nullptr,
+        0,
+        nullptr,
+        0,
+        D3D11_SDK_VERSION,
+        device,
+        &featureLevel,
+        nullptr
+    );
 
-                // pngファイルが存在？
-                if (!std::filesystem::exists(p))
+    if (FAILED(hr))
+    {
+        // ハードウェアが無理ならWARP
+        hr = D3D11CreateDevice(
+            nullptr,
+            D3D_DRIVER_TYPE_WARP,
+            nullptr,
+            0,
+            nullptr,
+            0,
+            D3D11_SDK_VERSION,
+            device,
+            &featureLevel,
+            nullptr
+        );
+    }
+}
+#endif
+
+// スレッドプールの各スレッドの開始時の処理（Windows は WIC を使うので COM を初期化する）
+static void InitializeWorkerThread()
+{
+#if defined(_WIN32)
+    CoInitializeEx(nullptr, COINITBASE_MULTITHREADED);
+#endif
+}
+
+// スレッドプールの各スレッドの終了時の処理
+static void UninitializeWorkerThread()
+{
+#if defined(_WIN32)
+    CoUninitialize();
+#endif
+}
+
+// パス付きマテリアルファイル名を取得
+static bool GetMaterialPath(std::filesystem::path input, std::filesystem::path& mtlPath)
+{
+    if (mtlPath.empty())
+    {
+        std::wcerr << L"No mtllib specified in obj file." << std::endl;
+        return false;
+    }
+
+    // 相対パスなら
+    if (mtlPath.is_relative())
+    {
+        // objの入っているフォルダのパスを付ける
+        mtlPath = input.parent_path() / mtlPath;
+    }
+
+    mtlPath = mtlPath.lexically_normal();  // 文字列レベルで正規化
+
+    // mtlファイルが存在？
+    if (!std::filesystem::exists(mtlPath))
+    {
+        std::wcerr << L"Material not found: " << ToWString(mtlPath) << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// コーパスの規模ごとのフォルダ
+static std::filesystem::path GetCorpusScaleDirectory(const std::filesystem::path& dir, uint32_t scale)
+{
+    return dir / ("scale" + std::to_string(scale));
+}
+
+// コーパスを作成する関数（--generate-corpus、作成済みでも作り直す）
+static int GenerateCorpusScales(const ConverterOptions& options)
+{
+    for (uint32_t scale : options.corpusScales)
+    {
+        std::filesystem::path dir = GetCorpusScaleDirectory(options.generateCorpus, scale);
+
+        std::vector<std::filesystem::path> files;
+        std::string error;
+        if (!GenerateCorpus(dir, scale, files, error))
+        {
+            std::wcerr << StringToWString(error) << std::endl;
+            return 1;
+        }
+
+        std::wcout << L"Generated " << files.size() << L" models: " << ToWString(dir) << std::endl;
+    }
+
+    return 0;
+}
+
+// コーパスのファイルを取得する関数（まだない場合は作成する）
+static bool PrepareCorpus(const std::filesystem::path& dir, uint32_t scale, std::vector<std::filesystem::path>& files, std::ostream& log)
+{
+    if (GetCorpusFiles(dir, scale, files)) return true;
+
+    log << "  Generating corpus (scale " << scale << ")" << std::endl;
+
+    std::string error;
+    if (!GenerateCorpus(dir, scale, files, error))
+    {
+        std::wcerr << StringToWString(error) << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// コーパスの１ファイルの計測結果
+struct CorpusBenchResult
+{
+    std::string name;               // obj ファイル名
+    uint64_t triangles = 0;         // 三角形の数
+    uint64_t vertices = 0;          // 重複を除いた頂点の数
+    uint64_t subMeshes = 0;         // サブメッシュの数
+    uint64_t textures = 0;          // テクスチャの数
+    uint64_t inputBytes = 0;        // 入力（obj、mtl、テクスチャ）のサイズ
+    uint64_t outputBytes = 0;       // 出力ファイルのサイズ
+    uint64_t peakRss = 0;           // 変換中のメモリ使用量のピーク
+    double sec = 0.0;               // 変換時間（最速）
+    double stageSec[static_cast<size_t>(ConvertStage::Count)] = {};    // 各段階の処理時間（段階ごとの最速）
+};
+
+// コーパスの規模ごとの計測結果
+struct CorpusBenchScale
+{
+    uint32_t scale = 0;
+    CorpusBenchResult total;        // すべてのファイルの合計（メモリ使用量は最大）
+    std::vector<CorpusBenchResult> files;
+};
+
+// コーパスの obj ファイルを１つ変換する関数
+// ※１つのファイルの変換と同じ流れ（obj、mtl の解析、頂点の作成、テクスチャの変換、書き出し）をスレッド１つで行う
+// ※テクスチャを変換できない場合は計測にならないので失敗にする
+static bool ConvertCorpusFile(ID3D11Device* device, const std::filesystem::path& input, const std::filesystem::path& output,
+    const ImdlWriteSettings& settings, CorpusBenchResult& result)
+{
+    std::string error;
+    Stopwatch stage;
+    auto endStage = [&](ConvertStage s)
+        {
+            result.stageSec[static_cast<size_t>(s)] = stage.ElapsedSec();
+            stage.Reset();
+        };
+
+    ObjModel object;
+    if (!ParseObjFile(input, object, error))
+    {
+        std::wcerr << ToWString(input) << L": " << StringToWString(error) << std::endl;
+        return false;
+    }
+    endStage(ConvertStage::ParseObj);
+
+    std::filesystem::path mtlPath = object.mtllib;
+    if (!GetMaterialPath(input, mtlPath)) return false;
+
+    ModelData model;
+    std::unordered_map<std::string, uint32_t> materialIndexMap;
+    std::vector<TextureRequest> textureRequests;
+    if (!ParseMtlFile(mtlPath, model.materials, materialIndexMap, textureRequests, error))
+    {
+        std::wcerr << ToWString(mtlPath) << L": " << StringToWString(error) << std::endl;
+        return false;
+    }
+    if (settings.sortTextures) SortTextureRequests(model.materials, textureRequests);
+    endStage(ConvertStage::ParseMtl);
+
+    if (!BuildGeometry(object, materialIndexMap, model.meshes, model.vertices, model.indices, error))
+    {
+        std::wcerr << ToWString(input) << L": " << StringToWString(error) << std::endl;
+        return false;
+    }
+    endStage(ConvertStage::Geometry);
+
+    std::vector<TextureEntry> encoded(textureRequests.size());
+    for (size_t i = 0; i < textureRequests.size(); i++)
+    {
+        encoded[i].type = textureRequests[i].type;
+        if (!EncodeTextureFile(textureRequests[i].path, textureRequests[i].type, { device, nullptr }, encoded[i].data, error))
+        {
+            std::wcerr << ToWString(textureRequests[i].path) << L": " << StringToWString(error) << std::endl;
+            return false;
+        }
+    }
+    ResolveTextures(model.materials, encoded, model.textures);
+    endStage(ConvertStage::Textures);
+
+    if (!WriteImdlModel(output, model, settings, error))
+    {
+        std::wcerr << ToWString(input) << L": " << StringToWString(error) << std::endl;
+        return false;
+    }
+    endStage(ConvertStage::Write);
+
+    // ----- 結果 ----- //
+    result.triangles = model.indices.size() / 3;
+    result.vertices = model.vertices.size();
+    result.subMeshes = model.meshes.size();
+    result.textures = model.textures.size();
+    result.inputBytes = std::filesystem::file_size(input) + std::filesystem::file_size(mtlPath);
+    for (const auto& request : textureRequests)
+    {
+        result.inputBytes += std::filesystem::file_size(request.path);
+    }
+    result.outputBytes = std::filesystem::file_size(output);
+
+    return true;
+}
+
+// 計測結果を計測の基準と比べる関数
+// ※悪化した項目を表示して、その数を返す（基準にないファイルは比べない）
+static size_t CompareCorpusBaseline(const JsonValue& baseline, const std::vector<CorpusBenchScale>& scales,
+    const BenchTolerance& tolerance, std::ostream& log)
+{
+    size_t regressions = 0;
+    size_t compared = 0;
+
+    // 悪化しているか確認する関数（limitPercent を超えて増えたら悪化）
+    auto check = [&](const std::string& where, const char* metric, double base, double current, double limitPercent, double minDiff, double unit, const char* unitName)
+        {
+            compared++;
+            if (current <= base * (1.0 + limitPercent / 100.0) || current - base < minDiff) return;
+
+            regressions++;
+            log << "  REGRESSION " << where << " " << metric << ": ";
+            if (unit == 1.0)
+            {
+                log << static_cast<uint64_t>(base) << " " << unitName << " -> " << static_cast<uint64_t>(current) << " " << unitName;
+            }
+            else
+            {
+                log << base / unit << " " << unitName << " -> " << current / unit << " " << unitName;
+            }
+            log
+                << " (+" << (base > 0.0 ? (current - base) / base * 100.0 : 100.0) << "%, limit +" << limitPercent << "%)" << std::endl;
+        };
+
+    auto compare = [&](const std::string& where, const JsonValue& base, const CorpusBenchResult& current)
+        {
+            // 入力が違う場合は比べられない
+            if (static_cast<uint64_t>(base.GetNumber("triangles")) != current.triangles)
+            {
+                regressions++;
+                log << "  MISMATCH " << where << ": the baseline has " << static_cast<uint64_t>(base.GetNumber("triangles"))
+                    << " triangles, the corpus has " << current.triangles << " (record the baseline again)" << std::endl;
+                return;
+            }
+
+            double minSec = tolerance.minTimeMs / 1000.0;
+            check(where, "time", base.GetNumber("sec"), current.sec, tolerance.timePercent, minSec, 1e-3, "ms");
+
+            if (const JsonValue* stages = base.Find("stages"))
+            {
+                for (size_t i = 0; i < static_cast<size_t>(ConvertStage::Count); i++)
+                {
+                    const char* name = GetConvertStageName(static_cast<ConvertStage>(i));
+                    if (const JsonValue* stage = stages->Find(name))
+                    {
+                        check(where, name, stage->AsNumber(), current.stageSec[i], tolerance.timePercent, minSec, 1e-3, "ms");
+                    }
+                }
+            }
+
+            if (base.Find("peak_rss_bytes") && current.peakRss)
+            {
+                check(where, "peak RSS", base.GetNumber("peak_rss_bytes"), static_cast<double>(current.peakRss), tolerance.rssPercent, tolerance.minRssMiB * 1024.0 * 1024.0, 1024.0 * 1024.0, "MiB");
+            }
+
+            check(where, "output size", base.GetNumber("output_bytes"), static_cast<double>(current.outputBytes), tolerance.sizePercent, 0.0, 1.0, "bytes");
+        };
+
+    // 規模、ファイルごとに比べる
+    const JsonValue* baseScales = baseline.Find("scales");
+    for (const auto& scale : scales)
+    {
+        const JsonValue* baseScale = nullptr;
+        if (baseScales)
+        {
+            for (const auto& value : baseScales->GetArray())
+            {
+                if (static_cast<uint32_t>(value.GetNumber("scale")) == scale.scale) baseScale = &value;
+            }
+        }
+
+        std::string scaleName = "scale " + std::to_string(scale.scale);
+        if (baseScale == nullptr)
+        {
+            log << "  (" << scaleName << " is not in the baseline)" << std::endl;
+            continue;
+        }
+
+        const JsonValue* baseFiles = baseScale->Find("files");
+        for (const auto& file : scale.files)
+        {
+            const JsonValue* baseFile = nullptr;
+            if (baseFiles)
+            {
+                for (const auto& value : baseFiles->GetArray())
+                {
+                    if (value.GetString("name") == file.name) baseFile = &value;
+                }
+            }
+
+            if (baseFile == nullptr)
+            {
+                log << "  (" << scaleName << " " << file.name << " is not in the baseline)" << std::endl;
+                continue;
+            }
+
+            compare(scaleName + " " + file.name, *baseFile, file);
+        }
+
+        compare(scaleName + " total", *baseScale, scale.total);
+    }
+
+    log << "Baseline: " << compared << " values compared, " << regressions << " regressions" << std::endl;
+
+    return regressions;
+}
+
+// コーパスの変換速度の計測関数（--bench-corpus）
+// ※コーパスがなければ作成する
+// ※ファイルごとに repeat 回変換して最速の時間を使う（１回目はファイルがキャッシュに載っていないことがある）
+// ※計測の基準（--bench-baseline）を指定した場合は比べて、悪化していれば 2 を返す
+static int BenchmarkCorpus(ID3D11Device* device, const ConverterOptions& options)
+{
+    const int repeat = options.benchRepeat;
+
+    // JSON を標準出力に書き出す場合は、表は標準エラーに出す
+    std::ostream& log = options.benchOutput == "-" ? std::cerr : std::cout;
+
+    // 計測の基準と許容範囲（基準のファイルの tolerance、コマンドラインの指定の順に上書きする）
+    JsonValue baseline;
+    BenchTolerance tolerance;
+    if (!options.benchBaseline.empty())
+    {
+        std::string error;
+        if (!JsonReader::ParseFile(options.benchBaseline, baseline, error))
+        {
+            std::wcerr << StringToWString(error) << std::endl;
+            return 1;
+        }
+
+        if (const JsonValue* saved = baseline.Find("tolerance"))
+        {
+            tolerance.timePercent = saved->GetNumber("time_percent", tolerance.timePercent);
+            tolerance.minTimeMs = saved->GetNumber("min_time_ms", tolerance.minTimeMs);
+            tolerance.rssPercent = saved->GetNumber("rss_percent", tolerance.rssPercent);
+            tolerance.minRssMiB = saved->GetNumber("min_rss_mib", tolerance.minRssMiB);
+            tolerance.sizePercent = saved->GetNumber("size_percent", tolerance.sizePercent);
+        }
+    }
+    ParseBenchTolerance(options.benchTolerance, tolerance);
+
+    auto report = [&log](const std::string& name, const CorpusBenchResult& result)
+        {
+            log << "    " << name << ": "
+                << result.triangles << " triangles, "
+                << result.sec * 1000.0 << " ms, "
+                << (result.sec > 0.0 ? result.triangles / result.sec / 1e6 : 0.0) << " Mtriangles/s, "
+                << ToMBps(result.inputBytes, result.sec) << " MB/s, "
+                << result.peakRss / (1024.0 * 1024.0) << " MiB peak" << std::endl;
+        };
+
+    std::filesystem::path output = std::filesystem::temp_directory_path() / "ObjToImdl_bench_corpus.imdl";
+
+    log << "Corpus benchmark (best of " << repeat << ", " << GetSettingsSignature(options.write) << ")" << std::endl;
+
+    MemoryMonitor memory;
+    std::vector<CorpusBenchScale> scales;
+    for (uint32_t scale : options.corpusScales)
+    {
+        // コーパスを用意する
+        std::filesystem::path dir = GetCorpusScaleDirectory(options.benchCorpus, scale);
+        std::vector<std::filesystem::path> files;
+        if (!PrepareCorpus(dir, scale, files, log)) return 1;
+
+        log << "  scale " << scale << std::endl;
+
+        // ファイルごとに計測
+        scales.emplace_back();
+        CorpusBenchScale& scaleResult = scales.back();
+        scaleResult.scale = scale;
+        CorpusBenchResult& total = scaleResult.total;
+        for (const auto& file : files)
+        {
+            CorpusBenchResult result;
+            memory.BeginStage(file.filename().u8string());
+            for (int i = 0; i < repeat; i++)
+            {
+                CorpusBenchResult run;
+                Stopwatch sw;
+                if (!ConvertCorpusFile(device, file, output, options.write, run))
+                {
+                    std::filesystem::remove(output);
+                    return 1;
+                }
+                run.sec = sw.ElapsedSec();
+
+                // 全体と段階ごとに最速の時間を使う
+                if (i == 0)
+                {
+                    result = run;
+                    continue;
+                }
+                result.sec = std::min(result.sec, run.sec);
+                for (size_t s = 0; s < static_cast<size_t>(ConvertStage::Count); s++)
+                {
+                    result.stageSec[s] = std::min(result.stageSec[s], run.stageSec[s]);
+                }
+            }
+            memory.End();
+            result.name = file.filename().u8string();
+            result.peakRss = memory.GetStages().back().peakRss;
+            report(result.name, result);
+
+            total.triangles += result.triangles;
+            total.vertices += result.vertices;
+            total.subMeshes += result.subMeshes;
+            total.textures += result.textures;
+            total.inputBytes += result.inputBytes;
+            total.outputBytes += result.outputBytes;
+            total.peakRss = std::max(total.peakRss, result.peakRss);
+            total.sec += result.sec;
+            for (size_t s = 0; s < static_cast<size_t>(ConvertStage::Count); s++)
+            {
+                total.stageSec[s] += result.stageSec[s];
+            }
+            scaleResult.files.push_back(result);
+        }
+        report("total", total);
+    }
+
+    std::filesystem::remove(output);
+
+    // ----- JSON ----- //
+    if (!options.benchOutput.empty())
+    {
+        std::ostringstream oss;
+        JsonWriter json(oss);
+        json.BeginObject();
+        json.Member("benchmark", "corpus");
+        json.Member("settings", GetSettingsSignature(options.write));
+        json.Member("repeat", repeat);
+
+        // 基準として使う場合の許容範囲
+        json.Key("tolerance");
+        json.BeginObject();
+        json.Member("time_percent", tolerance.timePercent);
+        json.Member("min_time_ms", tolerance.minTimeMs);
+        json.Member("rss_percent", tolerance.rssPercent);
+        json.Member("min_rss_mib", tolerance.minRssMiB);
+        json.Member("size_percent", tolerance.sizePercent);
+        json.EndObject();
+
+        auto writeResult = [&json](const CorpusBenchResult& result)
+            {
+                json.Member("triangles", result.triangles);
+                json.Member("vertices", result.vertices);
+                json.Member("sub_meshes", result.subMeshes);
+                json.Member("textures", result.textures);
+                json.Member("input_bytes", result.inputBytes);
+                json.Member("output_bytes", result.outputBytes);
+                json.Member("peak_rss_bytes", result.peakRss);
+                json.Member("sec", result.sec);
+                json.Member("triangles_per_sec", result.sec > 0.0 ? result.triangles / result.sec : 0.0);
+                json.Member("mb_per_sec", ToMBps(result.inputBytes, result.sec));
+                json.Key("stages");
+                json.BeginObject();
+                for (size_t s = 0; s < static_cast<size_t>(ConvertStage::Count); s++)
+                {
+                    json.Member(GetConvertStageName(static_cast<ConvertStage>(s)), result.stageSec[s]);
+                }
+                json.EndObject();
+            };
+
+        json.Key("scales");
+        json.BeginArray();
+        for (const auto& scale : scales)
+        {
+            json.BeginObject();
+            json.Member("scale", scale.scale);
+            writeResult(scale.total);
+            json.Key("files");
+            json.BeginArray();
+            for (const auto& result : scale.files)
+            {
+                json.BeginObject();
+                json.Member("name", result.name);
+                writeResult(result);
+                json.EndObject();
+            }
+            json.EndArray();
+            json.EndObject();
+        }
+        json.EndArray();
+        json.EndObject();
+
+        if (!WriteBenchmarkOutput(options.benchOutput, oss.str())) return 1;
+    }
+
+    // ----- 基準との比較 ----- //
+    if (!options.benchBaseline.empty())
+    {
+        log << "Comparing with " << options.benchBaseline.u8string() << std::endl;
+
+        std::string baseSettings = baseline.GetString("settings");
+        if (baseSettings != GetSettingsSignature(options.write))
+        {
+            log << "  (the baseline was recorded with different settings: " << baseSettings << ")" << std::endl;
+        }
+
+        if (CompareCorpusBaseline(baseline, scales, tolerance, log)) return 2;
+    }
+
+    return 0;
+}
+
+// 一括変換の入力と出力
+struct BatchItem
+{
+    std::filesystem::path input;    // 入力ファイル名
+    std::filesystem::path output;   // 出力ファイル名
+};
+
+// ワイルドカード（* と ?）でファイル名を比較する関数（大文字、小文字は区別しない）
+static bool MatchWildcard(const std::wstring& pattern, const std::wstring& name)
+{
+    size_t p = 0, n = 0;
+    size_t star = std::wstring::npos, mark = 0;
+
+    while (n < name.size())
+    {
+        if (p < pattern.size() && (pattern[p] == L'?' || towlower(pattern[p]) == towlower(name[n])))
+        {
+            p++;
+            n++;
+        }
+        else if (p < pattern.size() && pattern[p] == L'*')
+        {
+            star = p++;
+            mark = n;
+        }
+        else if (star != std::wstring::npos)
+        {
+            p = star + 1;
+            n = ++mark;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (p < pattern.size() && pattern[p] == L'*') p++;
+
+    return p == pattern.size();
+}
+
+// objファイルか？
+static bool IsObjFile(const std::filesystem::path& path)
+{
+    std::wstring extension = ToWString(path.extension());
+    for (auto& c : extension) c = static_cast<wchar_t>(towlower(c));
+    return extension == L".obj";
+}
+
+// 一括変換の出力ファイル名を取得する関数
+// ※出力フォルダが指定された場合は base からの相対パスをそのまま出力フォルダの下に作る
+static std::filesystem::path GetBatchOutput(const std::filesystem::path& input, const std::filesystem::path& base, const std::filesystem::path& outputDir)
+{
+    std::filesystem::path output = outputDir.empty() ? input : outputDir / input.lexically_relative(base);
+    output.replace_extension(".imdl");
+    return output;
+}
+
+// 一括変換の入力を集める関数
+// ※フォルダの場合は下の全 obj ファイル、ワイルドカードの場合は一致するファイル、それ以外はリストファイルとして読み込む
+static bool CollectBatchItems(const std::vector<std::string>& specs, const std::filesystem::path& outputDir, std::vector<BatchItem>& items)
+{
+    for (const auto& spec : specs)
+    {
+        std::filesystem::path path = std::filesystem::u8path(spec);
+
+        // フォルダ
+        if (std::filesystem::is_directory(path))
+        {
+            std::vector<std::filesystem::path> inputs;
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(path))
+            {
+                if (entry.is_regular_file() && IsObjFile(entry.path())) inputs.push_back(entry.path());
+            }
+            std::sort(inputs.begin(), inputs.end());
+
+            for (const auto& input : inputs)
+            {
+                items.push_back({ input, GetBatchOutput(input, path, outputDir) });
+            }
+        }
+
+        // ワイルドカード（ファイル名の部分のみ）
+        else if (spec.find_first_of("*?") != std::string::npos)
+        {
+            std::filesystem::path dir = path.parent_path();
+            if (dir.empty()) dir = L".";
+
+            std::wstring pattern = ToWString(path.filename());
+            if (!std::filesystem::is_directory(dir) || ToWString(dir).find_first_of(L"*?") != std::wstring::npos)
+            {
+                std::wcerr << L"Wildcards are only supported in the file name: " << ToWString(path) << std::endl;
+                return false;
+            }
+
+            std::vector<std::filesystem::path> inputs;
+            for (const auto& entry : std::filesystem::directory_iterator(dir))
+            {
+                if (entry.is_regular_file() && MatchWildcard(pattern, ToWString(entry.path().filename()))) inputs.push_back(entry.path());
+            }
+            std::sort(inputs.begin(), inputs.end());
+
+            for (const auto& input : inputs)
+            {
+                items.push_back({ input, GetBatchOutput(input, dir, outputDir) });
+            }
+        }
+
+        // objファイル
+        else if (IsObjFile(path))
+        {
+            items.push_back({ path, GetBatchOutput(path, path.parent_path(), outputDir) });
+        }
+
+        // リストファイル（１行に１ファイル、タブで区切って出力ファイル名を指定できる）
+        // ※相対パスはリストファイルのフォルダからの位置
+        else
+        {
+            std::ifstream ifs(path);
+            if (!ifs)
+            {
+                std::wcerr << L"Could not open " << ToWString(path) << std::endl;
+                return false;
+            }
+
+            std::filesystem::path base = path.parent_path();
+
+            std::string line;
+            while (std::getline(ifs, line))
+            {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty() || line[0] == '#') continue;
+
+                size_t tab = line.find('\t');
+                std::filesystem::path input = base / std::filesystem::u8path(line.substr(0, tab));
+
+                BatchItem item{ input, GetBatchOutput(input, base, outputDir) };
+                if (tab != std::string::npos)
+                {
+                    item.output = base / std::filesystem::u8path(line.substr(tab + 1));
+                }
+                items.push_back(item);
+            }
+        }
+    }
+
+    return true;
+}
+
+// ファイルのサイズと更新日時（変更を判定する）
+struct FileStamp
+{
+    uint64_t size = 0;
+    int64_t time = 0;
+
+    bool operator==(const FileStamp& other) const { return size == other.size && time == other.time; }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+// ファイルのサイズと更新日時を取得する関数（存在しない場合は 0）
+static FileStamp GetFileStamp(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    FileStamp stamp;
+    stamp.size = std::filesystem::file_size(path, ec);
+    if (ec) return FileStamp();
+
+    stamp.time = GetFileTime(path);
+    return stamp;
+}
+
+// パスを比較するためのキーを取得する関数（正規化した絶対パス、Windows は小文字にしたもの）
+static std::wstring GetPathKey(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+    std::wstring key = ToWString((ec ? path : absolute).lexically_normal());
+#if defined(_WIN32)
+    for (auto& c : key) c = static_cast<wchar_t>(towlower(c));
+#endif
+    return key;
+}
+
+// フォルダの下のパスか？（GetPathKey のキーで比較する）
+static bool IsUnderDirectory(const std::wstring& key, const std::wstring& dirKey)
+{
+    if (dirKey.empty() || key.size() <= dirKey.size() || key.compare(0, dirKey.size(), dirKey) != 0) return false;
+
+    return dirKey.back() == L'\\' || dirKey.back() == L'/' || key[dirKey.size()] == L'\\' || key[dirKey.size()] == L'/';
+}
+
+// 変換したテクスチャを共有するキャッシュのキー
+// ※ファイルが更新されたら別のキーになるように、サイズと更新日時を含める（古いものは LRU で捨てられる）
+static ChunkCache::Key GetTextureCacheKey(const TextureRequest& request)
+{
+    FileStamp stamp = GetFileStamp(request.path);
+    std::string file = WStringToUtf8(GetPathKey(request.path)) + '|' + std::to_string(stamp.size) + '|' + std::to_string(stamp.time);
+    return { file, static_cast<uint32_t>(request.type) };
+}
+
+// １ファイル分の変換の作業
+struct ConvertJob
+{
+    BatchItem item;
+
+    // 書き出しの設定
+    ImdlWriteSettings write;
+
+    // 入力と設定が変わっていない出力ファイルは変換しない
+    bool incremental = false;
+
+    // 解析結果
+    ObjModel object;
+    std::unordered_map<std::string, uint32_t> materialIndexMap;
+    std::vector<TextureRequest> textureRequests;
+
+    // 変換結果（テクスチャは encoded に変換して、書き出しの前に登録順に並べる）
+    std::vector<TextureEntry> encoded;
+    ModelData model;
+
+    // 書き出し前に終わっていないタスクの数（ジオメトリ + テクスチャ）
+    std::atomic<size_t> remaining{ 0 };
+
+    // 失敗したか
+    std::atomic<bool> failed{ false };
+
+    // 最新なので変換しなかったか（--incremental）
+    bool upToDate = false;
+
+    // 解析の開始から書き出しの終了までの時間、各段階の処理時間（秒）
+    Stopwatch stopwatch;
+    double parseSec = 0.0;
+    double geometrySec = 0.0;
+    std::vector<double> textureSec;
+    double writeSec = 0.0;
+
+    // 入力（obj とテクスチャ）、出力のサイズ
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+
+    // キャッシュから取得したテクスチャの数
+    std::atomic<size_t> texturesCached{ 0 };
+
+    // 書き出しが終わったとき（失敗した場合、変換しなかった場合も）に呼ばれる
+    std::function<void(ConvertJob&)> onComplete;
+
+    // 終わるまで保持する参照（呼び出し側が作業の寿命を管理しない場合に使う）
+    std::shared_ptr<void> keepAlive;
+};
+
+// 変換のタスクで共有するもの
+struct ConvertContext
+{
+    ID3D11Device* device = nullptr;
+    ThreadPool* pool = nullptr;
+
+    // 変換したテクスチャのキャッシュ（nullptr = 共有しない）
+    ChunkCache* textureCache = nullptr;
+
+    std::mutex gpuMutex;
+    std::mutex consoleMutex;
+};
+
+// 書き出しのタスク
+static void WriteConvertJob(ConvertJob& job)
+{
+    IMDL_TRACE_SCOPE_DETAIL("WriteConvertJob", job.item.output.u8string());
+
+    Stopwatch writeStopwatch;
+
+    if (!job.failed && !job.upToDate)
+    {
+        ResolveTextures(job.model.materials, job.encoded, job.model.textures);
+
+        std::error_code ec;
+        if (!job.item.output.parent_path().empty()) std::filesystem::create_directories(job.item.output.parent_path(), ec);
+
+        if (OutputImdl(job.item.output, job.write, job.model))
+        {
+            job.failed = true;
+        }
+        else
+        {
+            job.outputBytes = std::filesystem::file_size(job.item.output, ec);
+
+            if (job.incremental)
+            {
+                RecordConversionDependencies(job.item.output, job.write, job.item.input, job.object.mtllib, job.textureRequests);
+            }
+        }
+    }
+    job.writeSec = writeStopwatch.ElapsedSec();
+
+    // 変換結果を解放する
+    job.model = ModelData();
+    job.encoded = {};
+
+    // ※onComplete の中で作業が解放されないように、参照を取り出してから呼ぶ
+    std::shared_ptr<void> keepAlive = std::move(job.keepAlive);
+    if (job.onComplete) job.onComplete(job);
+}
+
+// ジオメトリ、テクスチャのタスクが終わった処理（最後のタスクが書き出しを積む）
+static void FinishConvertTask(ConvertContext& context, ConvertJob& job)
+{
+    if (--job.remaining == 0)
+    {
+        context.pool->Submit([&job]() { WriteConvertJob(job); });
+    }
+}
+
+// テクスチャのタスク
+static void EncodeConvertTexture(ConvertContext& context, ConvertJob& job, size_t i)
+{
+    IMDL_TRACE_SCOPE_DETAIL("EncodeConvertTexture", job.textureRequests[i].path.u8string());
+
+    Stopwatch textureStopwatch;
+    const TextureRequest& request = job.textureRequests[i];
+    job.encoded[i].type = request.type;
+
+    // 他の変換で同じテクスチャを変換済みならそれを使う
+    ChunkCache::Key key;
+    if (context.textureCache)
+    {
+        key = GetTextureCacheKey(request);
+        if (ChunkData data = context.textureCache->Find(key))
+        {
+            job.encoded[i].data = *data;
+            job.texturesCached++;
+            job.textureSec[i] = textureStopwatch.ElapsedSec();
+            FinishConvertTask(context, job);
+            return;
+        }
+    }
+
+    std::string error;
+    if (!EncodeTextureFile(request.path, request.type, { context.device, &context.gpuMutex }, job.encoded[i].data, error))
+    {
+        std::lock_guard<std::mutex> lock(context.consoleMutex);
+        std::wcerr << L"Could not convert texture: " << ToWString(request.path) << std::endl;
+    }
+    else if (context.textureCache)
+    {
+        context.textureCache->Insert(key, std::make_shared<const std::vector<uint8_t>>(job.encoded[i].data));
+    }
+
+    job.textureSec[i] = textureStopwatch.ElapsedSec();
+    FinishConvertTask(context, job);
+}
+
+// 解析のタスク
+static void ParseConvertJob(ConvertContext& context, ConvertJob& job)
+{
+    IMDL_TRACE_SCOPE_DETAIL("ParseConvertJob", job.item.input.u8string());
+
+    job.stopwatch.Reset();
+
+    // 入力と設定が変わっていなければ変換しない（サイズと更新日時だけで判定できればファイルを読まない）
+    if (job.incremental && IsOutputUpToDate(job.item.output, GetSettingsSignature(job.write)))
+    {
+        job.upToDate = true;
+        job.remaining = 1;
+        FinishConvertTask(context, job);
+        return;
+    }
+
+    Stopwatch parseStopwatch;
+
+    std::error_code ec;
+    job.inputBytes = std::filesystem::file_size(job.item.input, ec);
+    if (ec) job.inputBytes = 0;
+
+    bool parsed = false;
+    try
+    {
+        parsed = AnalyzeObj(job.item.input, job.object) == 0
+            && GetMaterialPath(job.item.input, job.object.mtllib)
+            && AnalyzeMtl(job.object.mtllib, job.model.materials, job.materialIndexMap, job.textureRequests, job.write.sortTextures) == 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::lock_guard<std::mutex> lock(context.consoleMutex);
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+
+    if (!parsed)
+    {
+        job.failed = true;
+        job.parseSec = parseStopwatch.ElapsedSec();
+        job.remaining = 1;
+        FinishConvertTask(context, job);
+        return;
+    }
+    job.parseSec = parseStopwatch.ElapsedSec();
+
+    size_t textureCount = job.textureRequests.size();
+    job.encoded.resize(textureCount);
+    job.textureSec.resize(textureCount);
+    job.remaining = 1 + textureCount;
+
+    // ジオメトリ
+    context.pool->Submit([&context, &job]()
+        {
+            IMDL_TRACE_SCOPE_DETAIL("BuildConvertGeometry", job.item.input.u8string());
+            Stopwatch geometryStopwatch;
+            std::string error;
+            if (!BuildGeometry(job.object, job.materialIndexMap, job.model.meshes, job.model.vertices, job.model.indices, error))
+            {
+                std::lock_guard<std::mutex> lock(context.consoleMutex);
+                std::cerr << "Error: " << error << std::endl;
+                job.failed = true;
+            }
+            // 解析した頂点と面は不要になるので解放する（mtl ファイル名は依存関係の記録に使う）
+            job.object.positions = {};
+            job.object.normals = {};
+            job.object.texcoords = {};
+            job.object.meshes = {};
+            job.geometrySec = geometryStopwatch.ElapsedSec();
+            FinishConvertTask(context, job);
+        });
+
+    // テクスチャ（１枚ごとに別のタスクにする）
+    for (size_t i = 0; i < textureCount; i++)
+    {
+        uint64_t size = std::filesystem::file_size(job.textureRequests[i].path, ec);
+        if (!ec) job.inputBytes += size;
+
+        context.pool->Submit([&context, &job, i]() { EncodeConvertTexture(context, job, i); });
+    }
+}
+
+// 変換を開始する関数
+// ※解析のタスクを積み、解析が終わるとジオメトリとテクスチャごとのタスクを積み、すべて終わったら書き出しのタスクを積む
+//   書き出しが終わったら job.onComplete が呼ばれる
+static void SubmitConvertJob(ConvertContext& context, ConvertJob& job)
+{
+    context.pool->Submit([&context, &job]() { ParseConvertJob(context, job); });
+}
+
+// 複数のファイルを一括で変換する関数
+// ※全ファイルの解析、ジオメトリ、テクスチャの変換を１つのワークスティーリングのスレッドプールで処理する
+static int BatchConvert(ID3D11Device* device, const ConverterOptions& options)
+{
+    std::vector<BatchItem> items;
+    if (!CollectBatchItems(options.batch, options.outputDir, items)) return 1;
+
+    if (items.empty())
+    {
+        std::cerr << "No input files" << std::endl;
+        return 1;
+    }
+
+    std::atomic<size_t> completed{ 0 };
+    std::atomic<size_t> failed{ 0 };
+    std::atomic<size_t> skipped{ 0 };
+
+    // WIC を使うので各スレッドで COM を初期化する
+    ThreadPool pool(options.threads, InitializeWorkerThread, UninitializeWorkerThread);
+
+    ConvertContext context;
+    context.device = device;
+    context.pool = &pool;
+
+    // ----- 結果の表示 ----- //
+    std::vector<std::unique_ptr<ConvertJob>> jobs;
+    auto report = [&](ConvertJob& job)
+        {
+            double textureSec = 0.0;
+            for (double sec : job.textureSec) textureSec += sec;
+            double sec = job.stopwatch.ElapsedSec();
+
+            if (job.failed) failed++;
+            if (job.upToDate) skipped++;
+            size_t index = ++completed;
+
+            std::lock_guard<std::mutex> lock(context.consoleMutex);
+            std::cout << "  [" << index << "/" << jobs.size() << "] ";
+            std::wcout << ToWString(job.item.input);
+            if (job.failed)
+            {
+                std::cout << ": FAILED" << std::endl;
+                return;
+            }
+            if (job.upToDate)
+            {
+                std::cout << ": up to date" << std::endl;
+                return;
+            }
+            std::cout << ": " << sec * 1000.0 << " ms (parse " << job.parseSec * 1000.0
+                << ", geometry " << job.geometrySec * 1000.0
+                << ", textures " << textureSec * 1000.0
+                << ", write " << job.writeSec * 1000.0 << "), "
+                << job.outputBytes / (1024.0 * 1024.0) << " MB, "
+                << ToMBps(job.inputBytes, sec) << " MB/s" << std::endl;
+        };
+
+    for (const auto& item : items)
+    {
+        jobs.push_back(std::make_unique<ConvertJob>());
+        jobs.back()->item = item;
+        jobs.back()->write = options.write;
+        jobs.back()->incremental = options.incremental;
+        jobs.back()->onComplete = report;
+    }
+
+    Stopwatch stopwatch;
+
+    std::cout << "Batch converting " << jobs.size() << " files on " << pool.GetThreadCount() << " threads" << std::endl;
+
+    for (auto& job : jobs)
+    {
+        SubmitConvertJob(context, *job);
+    }
+    pool.Wait();
+
+    double sec = stopwatch.ElapsedSec();
+
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    for (const auto& job : jobs)
+    {
+        inputBytes += job->inputBytes;
+        outputBytes += job->outputBytes;
+    }
+
+    size_t succeeded = jobs.size() - failed - skipped;
+    std::cout << "Converted " << succeeded << " of " << jobs.size() << " files (" << skipped << " up to date) in " << sec << " s: "
+        << succeeded / sec << " files/s, input " << ToMBps(inputBytes, sec) << " MB/s, output "
+        << ToMBps(outputBytes, sec) << " MB/s (" << pool.GetStealCount() << " tasks stolen)" << std::endl;
+
+    return failed ? 1 : 0;
+}
+
+// ------------------------------------------------------------ //
+// タスクグラフでの変換（１つのファイル）
+
+// タスクグラフで１つのファイルを変換する関数
+// ※obj の解析と同時に mtl を解析して（mtllib は obj を先に走査して探す）、テクスチャごとのタスクをすぐに積む
+//   ジオメトリは obj と mtl の解析が終わったら作成し、チャンクは入力がそろったものから用意（圧縮など）する
+// ※ファイルの配置には全チャンクのサイズが必要なので、書き出しはすべてのチャンクを用意してから行う
+// criticalPath : クリティカルパスの表示先（nullptr = 表示しない）
+static int ConvertTaskGraph(ID3D11Device* device, ThreadPool& pool, const std::filesystem::path& input, const std::filesystem::path& output,
+    const ImdlWriteSettings& settings, bool incremental, std::ostream* criticalPath)
+{
+    ObjModel object;
+    std::filesystem::path mtllib;   // obj を走査して見つけた mtllib
+    std::filesystem::path mtlPath;
+    ModelData model;
+    std::unordered_map<std::string, uint32_t> materialIndexMap;
+    std::vector<TextureRequest> textureRequests;
+    std::vector<TextureEntry> encoded;
+    ModelChunkWriter writer(model, settings);
+
+    std::mutex gpuMutex;
+    std::mutex consoleMutex;
+    auto printError = [&consoleMutex](const std::string& error)
+        {
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            std::cerr << "Error: " << error << std::endl;
+        };
+
+    TaskGraph graph(pool);
+    TaskGraph::TaskId resolveTextures = TaskGraph::NONE;
+
+    // ----- 解析 ----- //
+    TaskGraph::TaskId parseObj = graph.Add("ParseObj", [&]() { return AnalyzeObj(input, object) == 0; });
+
+    TaskGraph::TaskId parseMtl = graph.Add("ParseMtl", [&]()
+        {
+            std::string error;
+            if (!FindObjMtllib(input, mtllib, error))
+            {
+                printError(error);
+                return false;
+            }
+
+            mtlPath = mtllib;
+            if (!GetMaterialPath(input, mtlPath)) return false;
+            if (AnalyzeMtl(mtlPath, model.materials, materialIndexMap, textureRequests, settings.sortTextures)) return false;
+
+            // テクスチャ（１枚ごとに別のタスクにする、変換に失敗したテクスチャは使わない）
+            encoded.resize(textureRequests.size());
+            for (size_t i = 0; i < textureRequests.size(); i++)
+            {
+                TaskGraph::TaskId encode = graph.Add("EncodeTexture " + textureRequests[i].path.filename().u8string(), [&, i]()
+                    {
+                        const TextureRequest& request = textureRequests[i];
+                        encoded[i].type = request.type;
+
+                        std::string textureError;
+                        if (!EncodeTextureFile(request.path, request.type, { device, &gpuMutex }, encoded[i].data, textureError))
+                        {
+                            std::lock_guard<std::mutex> lock(consoleMutex);
+                            std::wcerr << L"Could not convert texture: " << ToWString(request.path) << std::endl;
+                        }
+                        return true;
+                    });
+                graph.AddDependency(resolveTextures, encode);
+            }
+            return true;
+        });
+
+    // ----- ジオメトリ ----- //
+    TaskGraph::TaskId geometry = graph.Add("Geometry", [&]()
+        {
+            // ※mtl は先に走査した mtllib で解析しているので、obj の解析結果と同じか確認する
+            if (object.mtllib != mtllib)
+            {
+                printError("mtllib does not match the parsed obj: " + object.mtllib.u8string());
+                return false;
+            }
+
+            std::string error;
+            if (!BuildGeometry(object, materialIndexMap, model.meshes, model.vertices, model.indices, error))
+            {
+                printError(error);
+                return false;
+            }
+
+            // obj の情報はもう使わないので解放する
+            object = ObjModel();
+            return true;
+        }, { parseObj, parseMtl });
+
+    // ----- テクスチャ ----- //
+    // ※テクスチャのタスクは mtl の解析で追加する
+    resolveTextures = graph.Add("ResolveTextures", [&]()
+        {
+            ResolveTextures(model.materials, encoded, model.textures);
+            return true;
+        }, { parseMtl });
+
+    // ----- チャンク ----- //
+    auto prepare = [&](ModelChunk chunk)
+        {
+            return [&, chunk]()
+                {
+                    std::string error;
+                    if (!writer.Prepare(chunk, error))
+                    {
+                        printError(error);
+                        return false;
+                    }
+                    return true;
+                };
+        };
+
+    std::vector<TaskGraph::TaskId> chunks
+    {
+        graph.Add("PrepareTextureChunk", prepare(ModelChunk::Texture), { resolveTextures }),
+        graph.Add("PrepareMaterialChunk", prepare(ModelChunk::Material), { resolveTextures }),
+        graph.Add("PrepareMeshChunk", prepare(ModelChunk::Mesh), { geometry }),
+        graph.Add("PrepareVertexChunk", prepare(ModelChunk::Vertex), { geometry }),
+        graph.Add("PrepareIndexChunk", prepare(ModelChunk::Index), { geometry }),
+    };
+
+    // ----- 書き出し ----- //
+    ImdlWriteStats writeStats;
+    graph.Add("WriteImdl", [&]()
+        {
+            std::string error;
+            if (!writer.Write(output, error, &writeStats))
+            {
+                printError(error);
+                return false;
+            }
+            return true;
+        }, chunks);
+
+    bool succeeded = graph.Run();
+    if (!graph.GetError().empty()) std::cerr << "Error: " << graph.GetError() << std::endl;
+    if (criticalPath) graph.PrintCriticalPath(*criticalPath);
+    if (!succeeded) return 1;
+
+    PrintWriteReport(settings, writeStats);
+
+    // 依存関係を記録
+    if (incremental)
+    {
+        RecordConversionDependencies(output, settings, input, mtlPath, textureRequests);
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------ //
+// 決定的な出力の確認（--check-determinism）
+
+// 出力ファイルの CRC32C とサイズ
+struct OutputHash
+{
+    uint32_t crc = 0;
+    uint64_t size = 0;
+
+    bool operator==(const OutputHash& other) const { return crc == other.crc && size == other.size; }
+    bool operator!=(const OutputHash& other) const { return !(*this == other); }
+};
+
+static std::string ToString(const OutputHash& hash)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), "crc32c=%08x size=%llu", hash.crc, static_cast<unsigned long long>(hash.size));
+    return text;
+}
+
+// imdl ファイルのテクスチャの並び（種類と DDS の CRC32C）を文字列にする関数
+static bool GetTextureSignature(const std::filesystem::path& path, std::string& signature)
+{
+    ImdlReader reader;
+    if (!reader.Open(path))
+    {
+        std::wcerr << L"Could not open " << ToWString(path) << std::endl;
+        std::cerr << "Error: " << reader.GetError() << std::endl;
+        return false;
+    }
+
+    signature.clear();
+    for (const auto& texture : reader.GetTextures())
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%d:%08x ", static_cast<int>(texture.type), Crc32c(texture.data.data(), texture.data.size()));
+        signature += text;
+    }
+    return true;
+}
+
+// マテリアル（newmtl からの行）の順番を逆にした mtl ファイルを書き出す関数
+// ※テクスチャを登録する順番（map_Kd、map_Bump が出てくる順番）が変わる
+static bool WriteReversedMtl(const std::filesystem::path& path)
+{
+    std::vector<std::string> header;
+    std::vector<std::vector<std::string>> blocks;
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs) return false;
+
+        std::string line;
+        while (std::getline(ifs, line))
+        {
+            if (line.rfind("newmtl", 0) == 0) blocks.emplace_back();
+            (blocks.empty() ? header : blocks.back()).push_back(line);
+        }
+    }
+    std::reverse(blocks.begin(), blocks.end());
+
+    std::ofstream ofs(path, std::ios::binary);
+    for (const auto& line : header) ofs << line << '\n';
+    for (const auto& block : blocks)
+    {
+        for (const auto& line : block) ofs << line << '\n';
+    }
+    return static_cast<bool>(ofs);
+}
+
+// コーパスの変換結果がスレッド数と mtl の記述順に左右されないか確認する関数
+// ※基準はスレッド１つで変換した出力、それと比べて以下を確認する
+//   ・mtl のマテリアルの順番を逆にして変換したテクスチャの並び（マテリアルの順番は変わるので、ファイル全体は比べない）
+//   ・スレッド数ごとに一括変換（--batch）、タスクグラフで変換した出力ファイルの CRC32C とサイズ
+// ※違いがあれば 2 を返す（確認に使ったファイルは残す）
+static int CheckDeterminism(ID3D11Device* device, const ConverterOptions& options)
+{
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "ObjToImdl_determinism";
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+
+    std::cout << "Determinism check (" << GetSettingsSignature(options.write) << ")" << std::endl;
+
+    size_t mismatches = 0;
+    for (uint32_t scale : options.corpusScales)
+    {
+        std::filesystem::path dir = GetCorpusScaleDirectory(options.checkDeterminism, scale);
+        std::vector<std::filesystem::path> files;
+        if (!PrepareCorpus(dir, scale, files, std::cout)) return 1;
+
+        std::string scaleName = dir.filename().u8string();
+        std::cout << "  scale " << scale << std::endl;
+
+        // ----- 基準（スレッド１つ） ----- //
+        std::filesystem::path referenceDir = root / "single" / scaleName;
+        std::filesystem::create_directories(referenceDir);
+
+        std::vector<OutputHash> reference(files.size());
+        std::vector<std::string> referenceTextures(files.size());
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            std::filesystem::path output = referenceDir / files[i].filename().replace_extension(".imdl");
+
+            CorpusBenchResult result;
+            if (!ConvertCorpusFile(device, files[i], output, options.write, result)) return 1;
+            if (!HashFile(output, reference[i].crc, reference[i].size)) return 1;
+            if (!GetTextureSignature(output, referenceTextures[i])) return 1;
+
+            std::cout << "    " << files[i].filename().u8string() << ": " << ToString(reference[i]) << std::endl;
+        }
+
+        // ----- mtl のマテリアルの順番を逆にする ----- //
+        {
+            std::filesystem::path reversedDir = root / "reversed" / scaleName;
+            std::filesystem::create_directories(reversedDir.parent_path());
+            std::filesystem::copy(dir, reversedDir, std::filesystem::copy_options::recursive);
+
+            for (const auto& entry : std::filesystem::directory_iterator(reversedDir))
+            {
+                if (entry.path().extension() != ".mtl") continue;
+                if (!WriteReversedMtl(entry.path()))
+                {
+                    std::wcerr << L"Could not write " << ToWString(entry.path()) << std::endl;
+                    return 1;
+                }
+            }
+
+            size_t identical = 0;
+            for (size_t i = 0; i < files.size(); i++)
+            {
+                std::filesystem::path input = reversedDir / files[i].filename();
+                std::filesystem::path output = std::filesystem::path(input).replace_extension(".imdl");
+
+                CorpusBenchResult result;
+                std::string textures;
+                if (!ConvertCorpusFile(device, input, output, options.write, result)) return 1;
+                if (!GetTextureSignature(output, textures)) return 1;
+
+                if (textures == referenceTextures[i])
+                {
+                    identical++;
+                    continue;
+                }
+                std::cout << "    MISMATCH mtl reversed " << files[i].filename().u8string()
+                    << ": textures " << textures << "(expected " << referenceTextures[i] << ")" << std::endl;
+            }
+            mismatches += files.size() - identical;
+
+            std::cout << "    mtl reversed: " << identical << " of " << files.size() << " texture orders identical" << std::endl;
+        }
+
+        // 出力ファイルを基準と比べる関数
+        auto compare = [&](const std::string& pass, const std::filesystem::path& outputDir)
+            {
+                size_t identical = 0;
+                for (size_t i = 0; i < files.size(); i++)
+                {
+                    std::filesystem::path output = outputDir / files[i].filename().replace_extension(".imdl");
+
+                    OutputHash hash;
+                    if (!HashFile(output, hash.crc, hash.size))
+                    {
+                        std::wcerr << L"Could not read " << ToWString(output) << std::endl;
+                        return false;
+                    }
+
+                    if (hash == reference[i])
+                    {
+                        identical++;
+                        continue;
+                    }
+                    std::cout << "    MISMATCH " << pass << " " << files[i].filename().u8string()
+                        << ": " << ToString(hash) << " (expected " << ToString(reference[i]) << ")" << std::endl;
+                }
+                mismatches += files.size() - identical;
+
+                std::cout << "    " << pass << ": " << identical << " of " << files.size() << " outputs identical" << std::endl;
+                return true;
+            };
+
+        for (unsigned threads : options.determinismThreads)
+        {
+            if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+            // ----- 一括変換 ----- //
+            ConverterOptions batch = options;
+            batch.batch = { dir.u8string() };
+            batch.outputDir = root / ("threads" + std::to_string(threads)) / scaleName;
+            batch.threads = threads;
+            batch.incremental = false;
+            if (BatchConvert(device, batch)) return 1;
+            if (!compare("batch threads " + std::to_string(threads), batch.outputDir)) return 1;
+
+            // ----- タスクグラフ ----- //
+            std::filesystem::path graphDir = root / ("graph" + std::to_string(threads)) / scaleName;
+            std::filesystem::create_directories(graphDir);
+            {
+                ThreadPool pool(threads, InitializeWorkerThread, UninitializeWorkerThread);
+                for (const auto& file : files)
+                {
+                    std::filesystem::path output = graphDir / file.filename().replace_extension(".imdl");
+                    if (ConvertTaskGraph(device, pool, file, output, options.write, false, nullptr)) return 1;
+                }
+            }
+            if (!compare("task graph threads " + std::to_string(threads), graphDir)) return 1;
+        }
+    }
+
+    if (mismatches)
+    {
+        std::cout << "Output is not deterministic: " << mismatches << " differences (files are in "
+            << root.u8string() << ")" << std::endl;
+        return 2;
+    }
+
+    std::filesystem::remove_all(root, ec);
+    std::cout << "All outputs are identical" << std::endl;
+    return 0;
+}
+
+// ------------------------------------------------------------ //
+// 変換サーバーの通信（--server、--client）
+//
+// 標準入出力（--server）またはローカルのソケット（--server --socket <path>）で
+// フレーム（uint32_t のサイズ + データ）を送受信する（FrameStream.h）
+// データは UTF-8 のテキストで、１行に「キー 値」を並べる
+//
+// ----- 要求 -----
+//   command convert|stats|shutdown
+//   id <任意の文字列>     // 応答にそのまま付ける
+//   arg <引数>            // convert のみ、コマンドラインの引数を１つずつ（入力ファイル、-o、--compress など）
+//   ※入力ファイルと出力ファイルは絶対パスで指定する（相対パスは失敗を返す）
+//     --client は入力ファイルと -o をクライアントのカレントフォルダからの絶対パスにして送る
+//
+// ----- 応答 -----
+//   convert : 受け付けたら status accepted、終わったら status ok|up-to-date|failed と統計
+//             （total_ms、parse_ms、geometry_ms、texture_ms、write_ms、input_bytes、output_bytes、
+//               textures、textures_cached）
+//   stats   : status stats とサーバーの統計（要求数、スレッド数、テクスチャのキャッシュ）
+//   shutdown: status ok（受け付けた変換を終えてから終了する）
+// ------------------------------------------------------------ //
+
+// サーバーのメッセージ（キーと値の組）
+using ServerMessage = std::vector<std::pair<std::string, std::string>>;
+
+// メッセージを文字列にする関数
+static std::string FormatServerMessage(const ServerMessage& message)
+{
+    std::string text;
+    for (const auto& [key, value] : message)
+    {
+        text += key;
+        text += ' ';
+        text += value;
+        text += '\n';
+    }
+    return text;
+}
+
+// 文字列をメッセージにする関数
+static ServerMessage ParseServerMessage(const std::string& text)
+{
+    ServerMessage message;
+
+    std::istringstream iss(text);
+    std::string line;
+    while (std::getline(iss, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        size_t space = line.find(' ');
+        message.push_back({ line.substr(0, space), space == std::string::npos ? std::string() : line.substr(space + 1) });
+    }
+    return message;
+}
+
+// メッセージから値を取得する関数（ない場合は空）
+static std::string FindServerValue(const ServerMessage& message, const std::string& key)
+{
+    for (const auto& [k, value] : message)
+    {
+        if (k == key) return value;
+    }
+    return std::string();
+}
+
+// 変換サーバーの状態
+struct ConvertServer
+{
+    ConvertContext context;
+
+    // 受け付けた要求、失敗した要求の数
+    std::atomic<uint64_t> requests{ 0 };
+    std::atomic<uint64_t> failed{ 0 };
+
+    // 終了するか
+    std::atomic<bool> stop{ false };
+
+    // サーバーの変換の設定（要求の設定に加える）
+    bool sortTextures = false;
+    bool cpuTextures = false;
+
+    // ソケットの待ち受け（標準入出力の場合は使わない）
+    LocalSocketListener listener;
+};
+
+// 変換の要求を処理する関数
+// ※受け付けたら応答を返してすぐに戻り、変換が終わったらスレッドプールから結果を送る
+static void HandleConvertRequest(ConvertServer& server, const std::shared_ptr<FrameStream>& stream, const std::string& id, const ServerMessage& request)
+{
+    // 引数はコマンドラインと同じように解析する
+    std::vector<std::string> args{ "ObjToImdl" };
+    for (const auto& [key, value] : request)
+    {
+        if (key == "arg") args.push_back(value);
+    }
+
+    std::vector<char*> argv;
+    for (auto& arg : args)
+    {
+        argv.push_back(arg.data());
+    }
+
+    ConverterOptions options;
+    bool valid;
+    {
+        std::lock_guard<std::mutex> lock(server.context.consoleMutex);
+        valid = AnalyzeOption(static_cast<int>(argv.size()), argv.data(), options) == 0;
+    }
+
+    // １ファイルの変換のみ受け付ける
+    if (!valid || options.input.empty())
+    {
+        server.failed++;
+        stream->WriteFrame(FormatServerMessage({ { "id", id }, { "status", "failed" }, { "error", "invalid arguments (only single-file conversions are supported)" } }));
+        return;
+    }
+
+    // 相対パスはサーバーのカレントフォルダで解決されてしまうので受け付けない
+    if (!options.input.is_absolute() || !options.output.is_absolute())
+    {
+        server.failed++;
+        stream->WriteFrame(FormatServerMessage({ { "id", id }, { "status", "failed" }, { "error", "input and output paths must be absolute" } }));
+        return;
+    }
+
+    auto job = std::make_shared<ConvertJob>();
+    job->item = { options.input, options.output };
+    job->write = options.write;
+    job->write.sortTextures = options.write.sortTextures || server.sortTextures;
+    job->write.cpuTextures = server.cpuTextures;
+    job->incremental = options.incremental;
+    job->keepAlive = job;
+
+    job->onComplete = [&server, stream, id](ConvertJob& completed)
+        {
+            double textureSec = 0.0;
+            for (double sec : completed.textureSec) textureSec += sec;
+
+            if (completed.failed) server.failed++;
+
+            stream->WriteFrame(FormatServerMessage({
+                { "id", id },
+                { "status", completed.failed ? "failed" : completed.upToDate ? "up-to-date" : "ok" },
+                { "output", completed.item.output.u8string() },
+                { "total_ms", std::to_string(completed.stopwatch.ElapsedMs()) },
+                { "parse_ms", std::to_string(completed.parseSec * 1000.0) },
+                { "geometry_ms", std::to_string(completed.geometrySec * 1000.0) },
+                { "texture_ms", std::to_string(textureSec * 1000.0) },
+                { "write_ms", std::to_string(completed.writeSec * 1000.0) },
+                { "input_bytes", std::to_string(completed.inputBytes) },
+                { "output_bytes", std::to_string(completed.outputBytes) },
+                { "textures", std::to_string(completed.textureRequests.size()) },
+                { "textures_cached", std::to_string(completed.texturesCached.load()) },
+                }));
+        };
+
+    server.requests++;
+    stream->WriteFrame(FormatServerMessage({ { "id", id }, { "status", "accepted" }, { "output", options.output.u8string() } }));
+
+    SubmitConvertJob(server.context, *job);
+}
+
+// １つの接続の要求を処理する関数（切断されるまで）
+static void ServeConnection(ConvertServer& server, const std::shared_ptr<FrameStream>& stream)
+{
+    std::string payload;
+    while (!server.stop && stream->ReadFrame(payload))
+    {
+        ServerMessage request = ParseServerMessage(payload);
+        std::string command = FindServerValue(request, "command");
+        std::string id = FindServerValue(request, "id");
+
+        if (command == "convert")
+        {
+            HandleConvertRequest(server, stream, id, request);
+        }
+        else if (command == "stats")
+        {
+            ChunkCacheStats cache = server.context.textureCache->GetStats();
+            stream->WriteFrame(FormatServerMessage({
+                { "id", id },
+                { "status", "stats" },
+                { "requests", std::to_string(server.requests.load()) },
+                { "failed", std::to_string(server.failed.load()) },
+                { "threads", std::to_string(server.context.pool->GetThreadCount()) },
+                { "steals", std::to_string(server.context.pool->GetStealCount()) },
+                { "texture_cache_hits", std::to_string(cache.hits) },
+                { "texture_cache_misses", std::to_string(cache.misses) },
+                { "texture_cache_bytes", std::to_string(cache.size) },
+                { "texture_cache_entries", std::to_string(cache.count) },
+                }));
+        }
+        else if (command == "shutdown")
+        {
+            stream->WriteFrame(FormatServerMessage({ { "id", id }, { "status", "ok" } }));
+            server.stop = true;
+            server.listener.Close();
+        }
+        else
+        {
+            stream->WriteFrame(FormatServerMessage({ { "id", id }, { "status", "failed" }, { "error", "unknown command: " + command } }));
+        }
+    }
+}
+
+// 変換サーバーとして動作する関数
+// ※すべての要求の変換を１つのスレッドプールで並列に処理し、変換したテクスチャをキャッシュで共有する
+static int RunServer(ID3D11Device* device, const ConverterOptions& options)
+{
+    // WIC を使うので各スレッドで COM を初期化する
+    ThreadPool pool(options.threads, InitializeWorkerThread, UninitializeWorkerThread);
+
+    ChunkCache textureCache(options.textureCacheSize);
+
+    ConvertServer server;
+    server.context.device = device;
+    server.context.pool = &pool;
+    server.context.textureCache = &textureCache;
+    server.sortTextures = options.write.sortTextures;
+    server.cpuTextures = options.write.cpuTextures;
+
+    // ----- 標準入出力 ----- //
+    if (options.socket.empty())
+    {
+        // 標準出力はフレームに使うので、表示は標準エラー出力へ回す
+        std::streambuf* cout = std::cout.rdbuf(std::cerr.rdbuf());
+        std::wstreambuf* wcout = std::wcout.rdbuf(std::wcerr.rdbuf());
+
+        std::cerr << "Conversion server on stdin/stdout (" << pool.GetThreadCount() << " threads)" << std::endl;
+
+        // 標準入力が閉じられたら、受け付けた変換を終えてから終了する
+        ServeConnection(server, std::make_shared<StdioFrameStream>());
+        pool.Wait();
+
+        std::cout.rdbuf(cout);
+        std::wcout.rdbuf(wcout);
+        return 0;
+    }
+
+    // ----- ソケット ----- //
+    if (!server.listener.Listen(options.socket))
+    {
+        std::wcerr << L"Could not listen on " << ToWString(options.socket) << std::endl;
+        return 1;
+    }
+
+    std::wcout << L"Conversion server on " << ToWString(options.socket);
+    std::cout << " (" << pool.GetThreadCount() << " threads)" << std::endl;
+
+    // 接続ごとのスレッド（終わったものは次の接続を受け付けたときに片付ける）
+    struct Connection
+    {
+        std::shared_ptr<FrameStream> stream;
+        std::thread thread;
+        std::atomic<bool> done{ false };
+    };
+    std::list<Connection> connections;
+
+    while (auto stream = server.listener.Accept())
+    {
+        for (auto it = connections.begin(); it != connections.end();)
+        {
+            if (it->done)
+            {
+                it->thread.join();
+                it = connections.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        Connection& connection = connections.emplace_back();
+        connection.stream = stream;
+        connection.thread = std::thread([&server, &connection]()
+            {
+                ServeConnection(server, connection.stream);
+                connection.done = true;
+            });
+    }
+
+    // 受け付けた変換を終えて結果を送ってから接続を閉じる
+    pool.Wait();
+    for (auto& connection : connections)
+    {
+        connection.stream->Close();
+        connection.thread.join();
+    }
+    pool.Wait();
+
+    std::cout << "Server stopped after " << server.requests << " requests (" << server.failed << " failed)" << std::endl;
+
+    return 0;
+}
+
+// 変換サーバーに要求を送る関数
+// args : サーバーに送る引数（なし = サーバーの統計を取得する）
+static int RunClient(const ConverterOptions& options, const std::vector<std::string>& args)
+{
+    auto stream = ConnectLocalSocket(options.client);
+    if (!stream)
+    {
+        std::wcerr << L"Could not connect to " << ToWString(options.client) << std::endl;
+        return 1;
+    }
+
+    ServerMessage request{ { "command", options.shutdown ? "shutdown" : args.empty() ? "stats" : "convert" }, { "id", "1" } };
+    if (!options.shutdown)
+    {
+        for (const auto& arg : args)
+        {
+            request.push_back({ "arg", arg });
+        }
+    }
+
+    Stopwatch stopwatch;
+    if (!stream->WriteFrame(FormatServerMessage(request)))
+    {
+        std::cerr << "Could not send the request" << std::endl;
+        return 1;
+    }
+
+    // 最終的な結果まで表示する
+    std::string payload;
+    while (stream->ReadFrame(payload))
+    {
+        ServerMessage response = ParseServerMessage(payload);
+        for (const auto& [key, value] : response)
+        {
+            if (key != "id") std::cout << "  " << key << ": " << value << std::endl;
+        }
+
+        std::string status = FindServerValue(response, "status");
+        if (status == "accepted") continue;
+
+        std::cout << "  round_trip_ms: " << stopwatch.ElapsedMs() << std::endl;
+        return status == "failed" ? 1 : 0;
+    }
+
+    std::cerr << "Connection closed by the server" << std::endl;
+    return 1;
+}
+
+// ------------------------------------------------------------ //
+// 複数のプロセスでの一括変換（--batch --processes、--worker-socket）
+//
+// 変換サーバー（--server）を子プロセスとして起動し、標準入出力のパイプで変換サーバーの要求を送る
+// 起動済みの変換サーバーのソケット（--worker-socket）も同じように使える（別のマシンへの転送の代わり）
+// ※ファイルは最初に割り振らず、各ワーカーが結果を返すたびに残りから送る（速いワーカーが多く処理する）
+// ※ワーカーが異常終了した場合は変換中だったファイルを他のワーカーで変換し直し、ワーカーを起動し直す
+//   （同じファイルで２回異常終了した場合は失敗とする）
+// ------------------------------------------------------------ //
+
+// ワーカーが異常終了したときに起動し直す回数の上限（ワーカーごと）
+static const unsigned WORKER_MAX_RESTARTS = 3;
+
+// ワーカーが異常終了したときにファイルを変換し直す回数
+static const unsigned WORKER_MAX_RETRIES = 1;
+
+// 変換サーバーに送る変換の設定の引数を取得する関数（一括変換の指定を除く）
+static std::vector<std::string> GetWorkerArguments(const std::vector<std::string>& args)
+{
+    static const char* excluded[] = { "--batch", "--output-dir", "--threads", "--processes", "--worker-socket", "--trace" };
+
+    std::vector<std::string> result;
+    for (size_t i = 1; i < args.size(); i++)
+    {
+        bool skip = false;
+        for (const char* option : excluded)
+        {
+            std::string name = option;
+            if (args[i] == name)
+            {
+                i++;
+                skip = true;
+                break;
+            }
+            if (args[i].rfind(name + "=", 0) == 0)
+            {
+                skip = true;
+                break;
+            }
+        }
+
+        if (!skip) result.push_back(args[i]);
+    }
+    return result;
+}
+
+// 一括変換のワーカー
+struct ConvertWorker
+{
+    std::string name;                           // 表示用の名前
+    std::filesystem::path socket;               // 起動済みの変換サーバー（空 = 子プロセス）
+    std::unique_ptr<WorkerProcess> process;     // 子プロセス
+    std::shared_ptr<FrameStream> stream;        // 要求を送る接続
+
+    std::map<std::string, size_t> inFlight;     // 送った要求（id とファイルの番号）
+
+    size_t converted = 0;                       // 変換したファイルの数（最新で変換しなかったものを含む）
+    size_t failed = 0;                          // 失敗したファイルの数
+    unsigned restarts = 0;                      // 起動し直した回数
+    uint64_t cacheHits = 0;                     // テクスチャのキャッシュの統計
+    uint64_t cacheMisses = 0;
+};
+
+// 一括変換のファイルごとの結果
+struct CoordinatedItem
+{
+    BatchItem item;
+    unsigned retries = 0;                       // ワーカーの異常終了で変換し直した回数
+    bool done = false;
+};
+
+// ワーカーを起動、接続する関数
+static bool StartConvertWorker(ConvertWorker& worker, const std::filesystem::path& program, const std::vector<std::string>& serverArgs)
+{
+    worker.inFlight.clear();
+
+    if (!worker.socket.empty())
+    {
+        worker.stream = ConnectLocalSocket(worker.socket);
+        return worker.stream != nullptr;
+    }
+
+    worker.process = std::make_unique<WorkerProcess>();
+    if (!worker.process->Start(program, serverArgs))
+    {
+        worker.process.reset();
+        worker.stream.reset();
+        return false;
+    }
+
+    // ※プロセスの寿命は worker.process で管理する
+    worker.stream = std::shared_ptr<FrameStream>(worker.process.get(), [](FrameStream*) {});
+    return true;
+}
+
+// 複数のプロセスで一括変換する関数
+// ※各プロセスは１つのスレッドプールで複数の要求を並列に処理するので、スレッド数だけ要求を送っておく
+static int CoordinateConvert(const ConverterOptions& options, const std::vector<std::string>& args)
+{
+    std::vector<BatchItem> batchItems;
+    if (!CollectBatchItems(options.batch, options.outputDir, batchItems)) return 1;
+
+    if (batchItems.empty())
+    {
+        std::cerr << "No input files" << std::endl;
+        return 1;
+    }
+
+    // 変換サーバーのカレントフォルダは異なることがあるので絶対パスで送る
+    std::vector<CoordinatedItem> items(batchItems.size());
+    for (size_t i = 0; i < batchItems.size(); i++)
+    {
+        std::error_code ec;
+        items[i].item.input = std::filesystem::absolute(batchItems[i].input, ec).lexically_normal();
+        items[i].item.output = std::filesystem::absolute(batchItems[i].output, ec).lexically_normal();
+    }
+
+    std::filesystem::path program = GetExecutablePath();
+    if (options.processes && program.empty())
+    {
+        std::cerr << "Could not get the path of this program to start worker processes" << std::endl;
+        return 1;
+    }
+
+    // 各ワーカーのスレッド数（既定は論理コア数をプロセス数で分ける）
+    unsigned threads = options.threads;
+    if (threads == 0)
+    {
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::max(1u, cores / std::max(1u, options.processes));
+    }
+
+    std::vector<std::string> serverArgs{ "--server", "--threads", std::to_string(threads) };
+    if (options.cpuTextures) serverArgs.push_back("--cpu-textures");
+    if (options.deterministic) serverArgs.push_back("--deterministic");
+
+    std::vector<std::string> convertArgs = GetWorkerArguments(args);
+
+    // ワーカーごとに送っておく要求の数
+    const size_t window = std::max<size_t>(2, threads);
+
+    // ----- ワーカーの起動 ----- //
+    std::vector<std::unique_ptr<ConvertWorker>> workers;
+    for (unsigned i = 0; i < options.processes; i++)
+    {
+        auto worker = std::make_unique<ConvertWorker>();
+        if (!StartConvertWorker(*worker, program, serverArgs))
+        {
+            std::cerr << "Could not start worker process " << i + 1 << std::endl;
+            continue;
+        }
+        worker->name = "process " + std::to_string(worker->process->GetId());
+        workers.push_back(std::move(worker));
+    }
+    for (const auto& socket : options.workerSockets)
+    {
+        auto worker = std::make_unique<ConvertWorker>();
+        worker->socket = socket;
+        if (!StartConvertWorker(*worker, program, serverArgs))
+        {
+            std::wcerr << L"Could not connect to " << ToWString(socket) << std::endl;
+            continue;
+        }
+        worker->name = "socket " + socket.u8string();
+        workers.push_back(std::move(worker));
+    }
+
+    if (workers.empty())
+    {
+        std::cerr << "No workers" << std::endl;
+        return 1;
+    }
+
+    // ----- 変換 ----- //
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<size_t> pending;
+    for (size_t i = 0; i < items.size(); i++) pending.push_back(i);
+
+    size_t remaining = items.size();
+    size_t completed = 0;
+    size_t failed = 0;
+    size_t skipped = 0;
+    size_t running = workers.size();    // 動いているワーカーの数
+    uint64_t requestId = 0;
+
+    // 各段階の処理時間の合計（ミリ秒）、入出力のサイズ
+    double parseMs = 0.0, geometryMs = 0.0, textureMs = 0.0, writeMs = 0.0;
+    uint64_t inputBytes = 0, outputBytes = 0;
+
+    // ファイルの変換が終わった処理（mutex をロックして呼ぶ）
+    auto finish = [&](ConvertWorker& worker, size_t index, const std::string& status, const std::string& detail)
+        {
+            CoordinatedItem& item = items[index];
+            if (item.done) return;
+            item.done = true;
+            remaining--;
+
+            worker.converted++;
+            if (status == "failed")
+            {
+                worker.failed++;
+                failed++;
+            }
+            if (status == "up-to-date") skipped++;
+
+            std::cout << "  [" << ++completed << "/" << items.size() << "] ";
+            std::wcout << ToWString(item.item.input);
+            std::cout << ": " << (status == "failed" ? "FAILED" : status) << detail << " (" << worker.name << ")" << std::endl;
+
+            changed.notify_all();
+        };
+
+    // ワーカーが異常終了、切断された処理（mutex をロックして呼ぶ）
+    auto lose = [&](ConvertWorker& worker)
+        {
+            for (const auto& [id, index] : worker.inFlight)
+            {
+                if (items[index].retries < WORKER_MAX_RETRIES)
+                {
+                    items[index].retries++;
+                    pending.push_front(index);
+                }
+                else
+                {
+                    finish(worker, index, "failed", ", worker crashed twice");
+                }
+            }
+            worker.inFlight.clear();
+            changed.notify_all();
+        };
+
+    auto serve = [&](ConvertWorker& worker)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;)
+            {
+                // 要求を送る
+                while (worker.inFlight.size() < window && !pending.empty())
+                {
+                    size_t index = pending.front();
+                    pending.pop_front();
+
+                    std::string id = std::to_string(++requestId);
+                    ServerMessage request{ { "command", "convert" }, { "id", id },
+                        { "arg", items[index].item.input.u8string() }, { "arg", "-o" }, { "arg", items[index].item.output.u8string() } };
+                    for (const auto& arg : convertArgs)
+                    {
+                        request.push_back({ "arg", arg });
+                    }
+
+                    worker.inFlight[id] = index;
+                    if (!worker.stream->WriteFrame(FormatServerMessage(request))) break;
+                }
+
+                // 送るものがなければ、他のワーカーの異常終了で戻ってくるか、すべて終わるまで待つ
+                if (worker.inFlight.empty())
+                {
+                    changed.wait(lock, [&]() { return remaining == 0 || !pending.empty(); });
+                    if (remaining == 0) break;
+                    continue;
+                }
+
+                // 結果を受け取る
+                lock.unlock();
+                std::string payload;
+                bool received = worker.stream->ReadFrame(payload);
+                lock.lock();
+
+                if (!received)
+                {
+                    // ----- 異常終了、切断 ----- //
+                    std::cerr << "Worker " << worker.name << " stopped with " << worker.inFlight.size() << " files in flight" << std::endl;
+                    lose(worker);
+
+                    if (worker.process)
+                    {
+                        worker.process->Kill();
+                        if (worker.restarts < WORKER_MAX_RESTARTS && StartConvertWorker(worker, program, serverArgs))
+                        {
+                            worker.restarts++;
+                            worker.name = "process " + std::to_string(worker.process->GetId());
+                            continue;
+                        }
+                    }
+                    worker.stream.reset();
+                    break;
+                }
+
+                ServerMessage response = ParseServerMessage(payload);
+                std::string status = FindServerValue(response, "status");
+                auto it = worker.inFlight.find(FindServerValue(response, "id"));
+                if (status == "accepted" || it == worker.inFlight.end()) continue;
+
+                size_t index = it->second;
+                worker.inFlight.erase(it);
+
+                std::string detail;
+                if (status == "failed")
+                {
+                    std::string error = FindServerValue(response, "error");
+                    if (!error.empty()) detail = ", " + error;
+                }
+                else if (status == "ok")
+                {
+                    auto number = [&response](const char* key) { return std::atof(FindServerValue(response, key).c_str()); };
+                    parseMs += number("parse_ms");
+                    geometryMs += number("geometry_ms");
+                    textureMs += number("texture_ms");
+                    writeMs += number("write_ms");
+                    inputBytes += std::strtoull(FindServerValue(response, "input_bytes").c_str(), nullptr, 10);
+                    outputBytes += std::strtoull(FindServerValue(response, "output_bytes").c_str(), nullptr, 10);
+                    detail = ", " + FindServerValue(response, "total_ms") + " ms";
+                }
+                finish(worker, index, status, detail);
+            }
+
+            // 他のワーカーがすべて止まった場合は残りを失敗とする
+            running--;
+            if (running == 0)
+            {
+                while (!pending.empty())
+                {
+                    size_t index = pending.front();
+                    pending.pop_front();
+                    finish(worker, index, "failed", ", no workers left");
+                }
+            }
+            changed.notify_all();
+        };
+
+    Stopwatch stopwatch;
+
+    std::cout << "Batch converting " << items.size() << " files on " << workers.size() << " workers ("
+        << threads << " threads each)" << std::endl;
+
+    std::vector<std::thread> threadsOfWorkers;
+    for (auto& worker : workers)
+    {
+        threadsOfWorkers.emplace_back([&serve, &worker]() { serve(*worker); });
+    }
+    for (auto& thread : threadsOfWorkers)
+    {
+        thread.join();
+    }
+
+    double sec = stopwatch.ElapsedSec();
+
+    // ----- ワーカーの統計を取得して終了させる ----- //
+    for (auto& worker : workers)
+    {
+        if (!worker->stream) continue;
+
+        if (worker->stream->WriteFrame(FormatServerMessage({ { "command", "stats" }, { "id", "stats" } })))
+        {
+            std::string payload;
+            while (worker->stream->ReadFrame(payload))
+            {
+                ServerMessage response = ParseServerMessage(payload);
+                if (FindServerValue(response, "status") != "stats") continue;
+
+                worker->cacheHits = std::strtoull(FindServerValue(response, "texture_cache_hits").c_str(), nullptr, 10);
+                worker->cacheMisses = std::strtoull(FindServerValue(response, "texture_cache_misses").c_str(), nullptr, 10);
+                break;
+            }
+        }
+
+        // 子プロセスは標準入力を閉じると終了する（起動済みの変換サーバーは切断するだけ）
+        worker->stream->Close();
+        if (worker->process) worker->process->Wait();
+    }
+
+    // ----- 結果の表示 ----- //
+    size_t succeeded = items.size() - failed - skipped;
+    std::cout << "Converted " << succeeded << " of " << items.size() << " files (" << skipped << " up to date, "
+        << failed << " failed) in " << sec << " s: " << succeeded / sec << " files/s, input "
+        << ToMBps(inputBytes, sec) << " MB/s, output " << ToMBps(outputBytes, sec) << " MB/s" << std::endl;
+    std::cout << "  stage totals: parse " << parseMs << " ms, geometry " << geometryMs << " ms, textures "
+        << textureMs << " ms, write " << writeMs << " ms" << std::endl;
+
+    for (const auto& worker : workers)
+    {
+        std::cout << "  " << worker->name << ": " << worker->converted << " files, " << worker->failed << " failed, "
+            << worker->restarts << " restarts, texture cache " << worker->cacheHits << " hits / "
+            << worker->cacheMisses << " misses" << std::endl;
+    }
+
+    return failed ? 1 : 0;
+}
+
+// 監視モードで変更がなくなってから変換するまでの時間（ミリ秒）
+// ※エディタは一時ファイルへの書き込み、置き換えと何度か通知が来るので、まとめて処理する
+static const double WATCH_DEBOUNCE_MS = 100.0;
+
+// 監視モードを終了するか（Ctrl+C）
+static std::atomic<bool> g_stopWatch{ false };
+
+// 監視モードで保持する変換済みのテクスチャ
+struct CachedTexture
+{
+    FileStamp stamp;            // 変換したときのファイルのサイズと更新日時
+    std::vector<uint8_t> dds;   // DDS（変換に失敗した場合は空）
+};
+
+// 監視モードで新しい obj ファイルを探すフォルダ
+struct WatchRoot
+{
+    std::filesystem::path dir;  // フォルダ
+    std::wstring pattern;       // ファイル名のパターン
+    bool recursive;             // 下のフォルダも対象にする
+};
+
+// 監視モードで保持する１ファイル分の状態
+struct WatchAsset
+{
+    BatchItem item;
+
+    // 解析した obj ファイル（obj ファイルが変わるまで使い回す）
+    ObjModel object;
+    FileStamp objStamp;
+    bool parsed = false;
+
+    // 作成した頂点、インデックス（obj ファイルかマテリアルの並びが変わるまで使い回す）
+    // ※マテリアルとテクスチャは変換ごとに設定する
+    std::unordered_map<std::string, uint32_t> materialIndexMap;
+    ModelData model;
+    bool built = false;
+
+    // 依存するファイル（obj、mtl、テクスチャの GetPathKey のキー）
+    std::vector<std::wstring> dependencies;
+};
+
+// Ctrl+C で監視モードを終了する
+#if defined(_WIN32)
+static BOOL WINAPI OnWatchConsoleCtrl(DWORD type)
+{
+    if (type != CTRL_C_EVENT && type != CTRL_BREAK_EVENT) return FALSE;
+
+    g_stopWatch = true;
+    return TRUE;
+}
+#else
+static void OnWatchSignal(int)
+{
+    g_stopWatch = true;
+}
+#endif
+
+// 監視モードを終了する Ctrl+C の処理を登録、解除する関数
+static void SetWatchStopHandler(bool enable)
+{
+#if defined(_WIN32)
+    SetConsoleCtrlHandler(OnWatchConsoleCtrl, enable ? TRUE : FALSE);
+#else
+    std::signal(SIGINT, enable ? OnWatchSignal : SIG_DFL);
+    std::signal(SIGTERM, enable ? OnWatchSignal : SIG_DFL);
+#endif
+}
+
+// フォルダを監視して、変更されたファイルに依存する出力ファイルだけを変換し直す関数
+// ※解析した obj ファイル、頂点、インデックス、変換したテクスチャをメモリに保持して、変わったものだけを作り直す
+//   （obj ファイルだけの変更はテクスチャを変換しない、テクスチャだけの変更は obj ファイルを読み込まない）
+// ※mtl ファイルは小さいので毎回読み込み、マテリアルの並びが変わった場合だけ頂点、インデックスを作り直す
+static int WatchConvert(ID3D11Device* device, const ConverterOptions& options)
+{
+    std::vector<BatchItem> items;
+    if (!CollectBatchItems(options.watch, options.outputDir, items)) return 1;
+
+    // 新しい obj ファイルを探すフォルダ（フォルダとワイルドカードの指定）
+    std::vector<WatchRoot> roots;
+    for (const auto& spec : options.watch)
+    {
+        std::filesystem::path path = std::filesystem::u8path(spec);
+        if (std::filesystem::is_directory(path))
+        {
+            roots.push_back({ path, L"*.obj", true });
+        }
+        else if (spec.find_first_of("*?") != std::string::npos)
+        {
+            std::filesystem::path dir = path.parent_path();
+            roots.push_back({ dir.empty() ? std::filesystem::path(".") : dir, ToWString(path.filename()), false });
+        }
+    }
+
+    // 変換の状態（入力ファイルのキーごと）
+    std::map<std::wstring, std::unique_ptr<WatchAsset>> assets;
+
+    auto addAsset = [&](const BatchItem& item)
+        {
+            auto& asset = assets[GetPathKey(item.input)];
+            if (asset) return false;
+
+            asset = std::make_unique<WatchAsset>();
+            asset->item = item;
+            return true;
+        };
+
+    for (const auto& item : items)
+    {
+        addAsset(item);
+    }
+
+    // 新しい obj ファイルなら追加する関数
+    auto addNewFile = [&](const std::filesystem::path& path)
+        {
+            std::wstring key = GetPathKey(path);
+            if (assets.count(key) || !IsObjFile(path)) return false;
+
+            for (const auto& root : roots)
+            {
+                std::wstring dirKey = GetPathKey(root.dir);
+                bool inside = root.recursive ? IsUnderDirectory(key, dirKey) : GetPathKey(path.parent_path()) == dirKey;
+                if (!inside || !MatchWildcard(root.pattern, ToWString(path.filename()))) continue;
+
+                // 監視の通知は絶対パスなので、出力ファイル名も絶対パスで求める
+                std::error_code ec;
+                std::filesystem::path base = std::filesystem::absolute(root.dir, ec).lexically_normal();
+                return addAsset({ path, GetBatchOutput(path, base, options.outputDir) });
+            }
+            return false;
+        };
+
+    std::mutex gpuMutex;
+    std::mutex consoleMutex;
+
+    // 変換したテクスチャ（ファイルと種類ごと）
+    std::map<std::pair<std::wstring, TextureType>, CachedTexture> textureCache;
+
+    // WIC を使うので各スレッドで COM を初期化する
+    ThreadPool pool(options.threads, InitializeWorkerThread, UninitializeWorkerThread);
+
+    // ----- １ファイルの変換 ----- //
+    auto convert = [&](WatchAsset& asset)
+        {
+            Stopwatch stopwatch;
+            double parseSec = 0.0, geometrySec = 0.0, textureSec = 0.0, writeSec = 0.0;
+            bool reparsed = false, rebuilt = false;
+            size_t encodedCount = 0;
+
+            // 失敗しても obj ファイルの変更は検出できるようにする
+            asset.dependencies = { GetPathKey(asset.item.input) };
+
+            try
+            {
+                // ----- obj（変わった場合だけ読み込む） ----- //
+                Stopwatch parseStopwatch;
+                FileStamp objStamp = GetFileStamp(asset.item.input);
+                if (!asset.parsed || objStamp != asset.objStamp)
+                {
+                    asset.parsed = false;
+                    asset.built = false;
+                    asset.object = ObjModel();
+
+                    ObjModel object;
+                    if (AnalyzeObj(asset.item.input, object) || !GetMaterialPath(asset.item.input, object.mtllib)) return false;
+
+                    asset.object = std::move(object);
+                    asset.objStamp = objStamp;
+                    asset.parsed = true;
+                    reparsed = true;
+                }
+                asset.dependencies.push_back(GetPathKey(asset.object.mtllib));
+
+                // ----- mtl（毎回読み込む） ----- //
+                std::vector<MaterialInfo> materials;
+                std::unordered_map<std::string, uint32_t> materialIndexMap;
+                std::vector<TextureRequest> textureRequests;
+                if (AnalyzeMtl(asset.object.mtllib, materials, materialIndexMap, textureRequests, options.write.sortTextures)) return false;
+
+                for (const auto& request : textureRequests)
+                {
+                    asset.dependencies.push_back(GetPathKey(request.path));
+                }
+                parseSec = parseStopwatch.ElapsedSec();
+
+                // ----- ジオメトリ（obj ファイルかマテリアルの並びが変わった場合だけ作り直す） ----- //
+                Stopwatch geometryStopwatch;
+                if (!asset.built || materialIndexMap != asset.materialIndexMap)
+                {
+                    asset.built = false;
+                    asset.model.meshes.clear();
+                    asset.model.vertices.clear();
+                    asset.model.indices.clear();
+                    asset.materialIndexMap = materialIndexMap;
+
+                    std::string error;
+                    if (!BuildGeometry(asset.object, asset.materialIndexMap, asset.model.meshes, asset.model.vertices, asset.model.indices, error))
+                    {
+                        throw std::runtime_error(error);
+                    }
+
+                    asset.built = true;
+                    rebuilt = true;
+                }
+                geometrySec = geometryStopwatch.ElapsedSec();
+
+                // ----- テクスチャ（変わったものだけ並列に変換する） ----- //
+                Stopwatch textureStopwatch;
+                size_t textureCount = textureRequests.size();
+                std::vector<std::pair<std::wstring, TextureType>> keys(textureCount);
+                std::vector<FileStamp> stamps(textureCount);
+                std::vector<TextureEntry> encoded(textureCount);
+                std::vector<size_t> stale;
+                for (size_t i = 0; i < textureCount; i++)
+                {
+                    keys[i] = { GetPathKey(textureRequests[i].path), textureRequests[i].type };
+                    stamps[i] = GetFileStamp(textureRequests[i].path);
+                    encoded[i].type = textureRequests[i].type;
+
+                    auto it = textureCache.find(keys[i]);
+                    if (it == textureCache.end() || it->second.stamp != stamps[i]) stale.push_back(i);
+                }
+
+                for (size_t i : stale)
+                {
+                    pool.Submit([&, i]()
+                        {
+                            const TextureRequest& request = textureRequests[i];
+                            std::string error;
+                            if (!EncodeTextureFile(request.path, request.type, { device, &gpuMutex }, encoded[i].data, error))
+                            {
+                                std::lock_guard<std::mutex> lock(consoleMutex);
+                                std::wcerr << L"Could not convert texture: " << ToWString(request.path) << std::endl;
+                            }
+                        });
+                }
+                pool.Wait();
+                encodedCount = stale.size();
+
+                // ※変換の途中で変更された場合は次の通知で作り直せるように、変換前に取得した日時で記録する
+                for (size_t i : stale)
+                {
+                    textureCache[keys[i]] = { stamps[i], encoded[i].data };
+                }
+                for (size_t i = 0; i < textureCount; i++)
+                {
+                    if (encoded[i].data.empty()) encoded[i].data = textureCache[keys[i]].dds;
+                }
+
+                asset.model.materials = std::move(materials);
+                asset.model.textures.clear();
+                ResolveTextures(asset.model.materials, encoded, asset.model.textures);
+                textureSec = textureStopwatch.ElapsedSec();
+
+                // ----- 書き出し ----- //
+                Stopwatch writeStopwatch;
+                std::error_code ec;
+                if (!asset.item.output.parent_path().empty()) std::filesystem::create_directories(asset.item.output.parent_path(), ec);
+
+                // ※変換したテクスチャはキャッシュにあるので、書き出したら解放する
+                bool written = OutputImdl(asset.item.output, options.write, asset.model) == 0;
+                asset.model.textures = {};
+                if (!written) return false;
+
+                if (options.incremental)
+                {
+                    RecordConversionDependencies(asset.item.output, options.write, asset.item.input, asset.object.mtllib, textureRequests);
+                }
+                writeSec = writeStopwatch.ElapsedSec();
+            }
+            catch (const std::exception& e)
+            {
+                std::lock_guard<std::mutex> lock(consoleMutex);
+                std::cerr << "Error: " << e.what() << std::endl;
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            std::cout << "  ";
+            std::wcout << ToWString(asset.item.input);
+            std::cout << ": " << stopwatch.ElapsedMs() << " ms (parse " << parseSec * 1000.0 << (reparsed ? "" : " obj reused")
+                << ", geometry " << geometrySec * 1000.0 << (rebuilt ? "" : " reused")
+                << ", textures " << textureSec * 1000.0 << " " << encodedCount << " encoded"
+                << ", write " << writeSec * 1000.0 << ")" << std::endl;
+            return true;
+        };
+
+    // 変換して結果を表示する関数
+    auto update = [&](WatchAsset& asset)
+        {
+            if (convert(asset)) return true;
+
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            std::cout << "  ";
+            std::wcout << ToWString(asset.item.input);
+            std::cout << ": FAILED" << std::endl;
+            return false;
+        };
+
+    // ----- 監視するフォルダ ----- //
+    FileWatcher watcher;
+    for (const auto& root : roots)
+    {
+        if (!watcher.Add(root.dir, root.recursive))
+        {
+            std::wcerr << L"Could not watch " << ToWString(root.dir) << std::endl;
+            return 1;
+        }
+    }
+
+    // 依存するファイルのフォルダを監視する関数（フォルダの指定の外にある obj、mtl、テクスチャ）
+    auto watchDependencies = [&]()
+        {
+            for (const auto& [key, asset] : assets)
+            {
+                for (const auto& dependency : asset->dependencies)
+                {
+                    bool covered = false;
+                    for (const auto& root : roots)
+                    {
+                        if (root.recursive && IsUnderDirectory(dependency, GetPathKey(root.dir))) covered = true;
+                    }
+                    if (!covered) watcher.Add(std::filesystem::path(dependency).parent_path(), false);
+                }
+            }
+        };
+
+    // 使われなくなったテクスチャを捨てる関数
+    auto pruneTextures = [&]()
+        {
+            std::set<std::wstring> used;
+            for (const auto& [key, asset] : assets)
+            {
+                used.insert(asset->dependencies.begin(), asset->dependencies.end());
+            }
+
+            for (auto it = textureCache.begin(); it != textureCache.end();)
+            {
+                it = used.count(it->first.first) ? std::next(it) : textureCache.erase(it);
+            }
+        };
+
+    // ----- 最初に全ファイルを変換 ----- //
+    Stopwatch stopwatch;
+    std::cout << "Converting " << assets.size() << " files" << std::endl;
+    for (auto& [key, asset] : assets)
+    {
+        update(*asset);
+    }
+    watchDependencies();
+    std::cout << "Converted in " << stopwatch.ElapsedSec() << " s" << std::endl;
+
+    SetWatchStopHandler(true);
+    std::cout << "Watching for changes (Ctrl+C to stop)" << std::endl;
+
+    // ----- 変更の監視 ----- //
+    std::map<std::wstring, std::filesystem::path> pending;
+    Stopwatch quiet;
+    while (!g_stopWatch)
+    {
+        std::vector<std::filesystem::path> changed;
+        if (!watcher.Wait(changed, static_cast<unsigned>(WATCH_DEBOUNCE_MS)))
+        {
+            std::cerr << "Could not watch for changes" << std::endl;
+            SetWatchStopHandler(false);
+            return 1;
+        }
+
+        // 通知が続いている間は待つ
+        if (!changed.empty())
+        {
+            for (const auto& path : changed)
+            {
+                pending[GetPathKey(path)] = path;
+            }
+            quiet.Reset();
+            continue;
+        }
+        if (pending.empty() || quiet.ElapsedMs() < WATCH_DEBOUNCE_MS) continue;
+
+        // 変更されたファイルに依存する出力ファイルを探す
+        std::set<std::wstring> dirty;
+        for (const auto& [key, path] : pending)
+        {
+            std::error_code ec;
+            bool isDirectory = std::filesystem::is_directory(path, ec);
+
+            // 追加された obj ファイル（フォルダが追加された場合や通知が溢れた場合は下を探す）
+            if (isDirectory)
+            {
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(path, ec))
+                {
+                    if (entry.is_regular_file(ec) && addNewFile(entry.path())) dirty.insert(GetPathKey(entry.path()));
+                }
+            }
+            else if (std::filesystem::is_regular_file(path, ec) && addNewFile(path))
+            {
+                dirty.insert(key);
+            }
+
+            for (const auto& [assetKey, asset] : assets)
+            {
+                for (const auto& dependency : asset->dependencies)
                 {
-                    // 存在しない場合はobjと一緒のフォルダに変更
-                    std::filesystem::path baseDir = path.parent_path();
-                    p = baseDir / p.filename();
-                    // そこにもpngがない
-                    if (!std::filesystem::exists(p))
-                    {
-                        std::wcerr << L"Texture not found: " << p.wstring() << std::endl;
-                        return -1;
-                    }
+                    if (dependency == key || (isDirectory && IsUnderDirectory(dependency, key))) dirty.insert(assetKey);
                 }
-                // テクスチャ登録
-                materials.back().normalTexIndex = RegisterTexture(
-                    device, p, TextureType::Normal, textures, textureIndexMap);
             }
         }
-    }
+        pending.clear();
 
-    return 0;
-}
+        if (dirty.empty()) continue;
 
-// 頂点データ作成関数
-static VertexPositionNormalTextureTangent MakeVertex(Object& object, const FaceIndex& face)
-{
-    VertexPositionNormalTextureTangent v = {};
+        // 変換し直す（削除された obj ファイルは対象から外す）
+        stopwatch.Reset();
+        for (const auto& key : dirty)
+        {
+            auto it = assets.find(key);
+            if (it == assets.end()) continue;
 
-    v.position = object.positions[face.v];
+            std::error_code ec;
+            if (!std::filesystem::exists(it->second->item.input, ec))
+            {
+                std::wcout << L"  Removed: " << ToWString(it->second->item.input) << std::endl;
+                assets.erase(it);
+                continue;
+            }
+            update(*it->second);
+        }
+        watchDependencies();
+        pruneTextures();
 
-    if (face.vn >= 0)
-    {
-        // 法線を正規化
-        XMVECTOR n = XMLoadFloat3(&object.normals[face.vn]);
-        n = XMVector3Normalize(n);
-        XMStoreFloat3(&v.normal, n);
-    }
-    else
-    {
-        // ダミー
-        v.normal = XMFLOAT3(0.0f, 0.0f, 1.0f);
+        std::cout << "Updated " << dirty.size() << " files in " << stopwatch.ElapsedMs() << " ms (" << textureCache.size() << " textures cached)" << std::endl;
     }
 
-    v.texcoord = (face.vt >= 0) ? object.texcoords[face.vt] : XMFLOAT2(0.0f, 0.0f);
+    SetWatchStopHandler(false);
+    std::cout << "Stopped watching" << std::endl;
 
-    return v;
+    return 0;
 }
 
-// メッシュデータから頂点バッファ、インデックスバッファ用のデータを作成する関数
-static void CreateBufferData( Object& object, 
-                              std::unordered_map<std::string, uint32_t>& materialIndexMap,
-                              std::vector<MeshInfo>& meshInfo,
-                              std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
-                              std::vector<uint32_t>& indexBuffer )
+// サーバーに送る引数を取得する関数（--client、--shutdown を除く）
+// ※入力ファイルと出力ファイルはクライアントのカレントフォルダからの絶対パスにして最後に付ける
+static std::vector<std::string> GetClientArguments(const std::vector<std::string>& args, const ConverterOptions& options)
 {
-    std::unordered_map<FaceIndex, uint32_t> indexMap;
+    std::string input = options.input.u8string();
+    bool inputFound = false;
 
-    for (auto& mesh : object.meshes)
+    std::vector<std::string> result;
+    for (size_t i = 1; i < args.size(); i++)
     {
-        for (auto& subMesh : mesh.subMeshs)
+        if (args[i] == "--client")
         {
-            // サブメッシュ情報
-            MeshInfo data = {};
-            auto it = materialIndexMap.find(subMesh.material);
-            if (it == materialIndexMap.end()) throw std::runtime_error("Material not found: " + subMesh.material);
-            data.materialIndex = it->second;                                // マテリアルインデックス
-            data.startIndex = static_cast<uint32_t>(indexBuffer.size());    // スタートインデックス
-            data.primCount = static_cast<uint32_t>(subMesh.faces.size());   // プリミティブ数
-            meshInfo.push_back(data);
+            i++;
+            continue;
+        }
+        if (args[i].rfind("--client=", 0) == 0 || args[i] == "--shutdown") continue;
 
-            for (auto& face : subMesh.faces)
+        if (!options.input.empty())
+        {
+            // 出力ファイル（-o <path>、--output <path>、--output=<path>、-o<path>）
+            if (args[i] == "-o" || args[i] == "--output")
             {
-                for (int i = 0; i < 3; i++)
-                {
-                    auto it = indexMap.find(face.faceIndices[i]);
-
-                    if (it == indexMap.end())
-                    {
-                        // 新規頂点
-                        uint32_t newIndex = static_cast<uint32_t>(vertexBuffer.size());
-                        indexMap[face.faceIndices[i]] = newIndex;
+                i++;
+                continue;
+            }
+            if (args[i].rfind("--output=", 0) == 0 || (args[i].rfind("-o", 0) == 0 && args[i].rfind("--", 0) != 0)) continue;
 
-                        vertexBuffer.push_back(MakeVertex(object, face.faceIndices[i]));
-                        indexBuffer.push_back(newIndex);
-                    }
-                    else
-                    {
-                        // 既存頂点
-                        indexBuffer.push_back(it->second);
-                    }
-                }
+            // 入力ファイル
+            if (!inputFound && args[i] == input)
+            {
+                inputFound = true;
+                continue;
             }
         }
-    }
-}
-
-// テクスチャデータ作成
-static std::vector<uint8_t> BuildTextureChunk(const std::vector<TextureEntry>& textures)
-{
-    BinaryWriter writer;
 
-    writer.WriteUInt32(static_cast<uint32_t>(textures.size()));
+        result.push_back(args[i]);
+    }
 
-    for (const auto& tex : textures)
+    if (!options.input.empty())
     {
-        writer.WriteUInt32(static_cast<uint32_t>(tex.type));
-        writer.WriteUInt32(static_cast<uint32_t>(tex.data.size()));
-        writer.WriteBytes(tex.data.data(), tex.data.size());
+        std::error_code ec;
+        std::filesystem::path absoluteInput = std::filesystem::absolute(options.input, ec).lexically_normal();
+        std::filesystem::path absoluteOutput = std::filesystem::absolute(options.output, ec).lexically_normal();
+
+        result.push_back("-o");
+        result.push_back(absoluteOutput.u8string());
+        result.push_back("--input");
+        result.push_back(absoluteInput.u8string());
     }
-
-    return writer.GetBuffer();
+    return result;
 }
 
-// マテリアル情報のシリアライズ関数
-inline void SerializeMaterial(BinaryWriter& writer, const MaterialInfo& m)
+// モデルデータがメモリ上で使っているサイズを取得する関数（退避したテクスチャは含まない）
+static uint64_t GetModelDataBytes(const ModelData& model)
 {
-    writer.WriteFloat(m.diffuseColor.x);
-    writer.WriteFloat(m.diffuseColor.y);
-    writer.WriteFloat(m.diffuseColor.z);
-    writer.WriteFloat(m.diffuseColor.w);
-
-    writer.WriteFloat(m.metallicFactor);
-    writer.WriteFloat(m.roughnessFactor);
-
-    writer.WriteFloat(m.emissiveColor.x);
-    writer.WriteFloat(m.emissiveColor.y);
-    writer.WriteFloat(m.emissiveColor.z);
-
-    writer.WriteInt32(m.baseColorTexIndex);
-    writer.WriteInt32(m.normalTexIndex);
-    writer.WriteInt32(m.metalRoughTexIndex);
-    writer.WriteInt32(m.emissiveTexIndex);
+    uint64_t bytes = model.materials.size() * sizeof(MaterialInfo)
+        + model.meshes.size() * sizeof(MeshInfo)
+        + model.vertices.size() * sizeof(VertexPositionNormalTextureTangent)
+        + model.indices.size() * sizeof(uint32_t);
+    for (const auto& texture : model.textures)
+    {
+        bytes += texture.data.size();
+    }
+    return bytes;
 }
 
-// マテリアル情報データ作成
-static std::vector<uint8_t> BuildMaterialChunk(const std::vector<MaterialInfo>& materials)
+// 段階ごとのメモリ使用量を表示する関数
+static void PrintMemoryReport(const MemoryMonitor& memory, const ModelData& model, uint64_t budget)
 {
-    BinaryWriter writer;
+    auto toMB = [](uint64_t bytes) { return bytes / (1024.0 * 1024.0); };
 
-    writer.WriteUInt32(static_cast<uint32_t>(materials.size()));
+    for (const auto& stage : memory.GetStages())
+    {
+        std::cout << "  " << stage.name << ": " << stage.sec * 1000.0 << " ms, RSS start " << toMB(stage.startRss)
+            << " MB, end " << toMB(stage.endRss) << " MB, peak " << toMB(stage.peakRss) << " MB" << std::endl;
+    }
 
-    for (const auto& m : materials)
+    size_t spilled = 0;
+    uint64_t spilledBytes = 0;
+    for (const auto& texture : model.spilled)
     {
-        SerializeMaterial(writer, m);
+        if (texture.size == 0) continue;
+        spilled++;
+        spilledBytes += texture.size;
     }
 
-    return writer.GetBuffer();
+    std::cout << "Peak RSS " << toMB(GetPeakRss()) << " MB, model data " << toMB(GetModelDataBytes(model)) << " MB in memory";
+    if (budget)
+    {
+        std::cout << " (budget " << toMB(budget) << " MB), " << spilled << " textures spilled (" << toMB(spilledBytes) << " MB)";
+    }
+    std::cout << std::endl;
 }
 
-// メッシュ情報のシリアライズ関数
-inline void SerializeMesh(BinaryWriter& writer, const MeshInfo& m)
+// １つのファイルの変換の統計（--stats json）
+struct ConversionStats
+{
+    StageTime stages[static_cast<size_t>(ConvertStage::Count)];    // 各段階の処理時間
+    GeometryStats geometry;                     // 頂点、インデックスの作成
+    std::vector<TextureEncodeStats> textures;   // テクスチャの変換（要求と同じ並び）
+    std::vector<bool> textureEncoded;           // 変換できたか
+    std::vector<bool> textureSpilled;           // 一時ファイルに退避したか（--memory-budget）
+    ImdlWriteStats write;                       // チャンクの作成と書き出し
+    StageTime total;                            // 全体
+};
+
+// 処理時間を JSON に書き出す関数（ミリ秒）
+static void WriteStageTimeJson(JsonWriter& json, std::string_view key, const StageTime& time)
 {
-    writer.WriteUInt32(m.startIndex);
-    writer.WriteUInt32(m.primCount);
-    writer.WriteUInt32(m.materialIndex);
+    json.Key(key);
+    json.BeginObject();
+    json.Member("wall_ms", time.wallSec * 1000.0);
+    json.Member("cpu_ms", time.cpuSec * 1000.0);
+    json.EndObject();
 }
 
-// メッシュ情報データ作成
-static std::vector<uint8_t> BuildMeshChunk(const std::vector<MeshInfo>& meshes)
+// テクスチャの種類の名前を取得する関数
+static const char* GetTextureTypeName(TextureType type)
 {
-    BinaryWriter writer;
+    switch (type)
+    {
+    case TextureType::BaseColor:  return "base-color";
+    case TextureType::Normal:     return "normal";
+    case TextureType::MetalRough: return "metal-rough";
+    case TextureType::Emissive:   return "emissive";
+    default:                      return "unknown";
+    }
+}
 
-    writer.WriteUInt32(static_cast<uint32_t>(meshes.size()));
+// 変換の統計を JSON で書き出す関数
+static bool WriteConversionStats(const ConverterOptions& options, const ConversionStats& stats,
+    const std::vector<TextureRequest>& textureRequests)
+{
+    std::ostringstream oss;
+    JsonWriter json(oss);
+
+    json.BeginObject();
+    json.Member("input", options.input.u8string());
+    json.Member("output", options.output.u8string());
+    json.Member("settings", GetSettingsSignature(options.write));
+    WriteStageTimeJson(json, "total", stats.total);
+
+    // ----- 段階 ----- //
+    json.Key("stages");
+    json.BeginArray();
+    for (size_t i = 0; i < static_cast<size_t>(ConvertStage::Count); i++)
+    {
+        json.BeginObject();
+        json.Member("name", GetConvertStageName(static_cast<ConvertStage>(i)));
+        json.Member("wall_ms", stats.stages[i].wallSec * 1000.0);
+        json.Member("cpu_ms", stats.stages[i].cpuSec * 1000.0);
+        json.EndObject();
+    }
+    json.EndArray();
+
+    // ----- 頂点、インデックス ----- //
+    const GeometryStats& geometry = stats.geometry;
+    json.Key("geometry");
+    json.BeginObject();
+    json.Member("positions", geometry.positions);
+    json.Member("normals", geometry.normals);
+    json.Member("texcoords", geometry.texcoords);
+    json.Member("faces", geometry.faces);
+    json.Member("sub_meshes", geometry.subMeshes);
+    json.Member("face_vertices", geometry.faceVertices);
+    json.Member("unique_vertices", geometry.uniqueVertices);
+    json.Member("dedup_ratio", geometry.uniqueVertices ? static_cast<double>(geometry.faceVertices) / geometry.uniqueVertices : 0.0);
+    WriteStageTimeJson(json, "dedup", geometry.dedup);
+    WriteStageTimeJson(json, "tangents", geometry.tangents);
+    json.EndObject();
+
+    // ----- テクスチャ ----- //
+    json.Key("textures");
+    json.BeginArray();
+    for (size_t i = 0; i < textureRequests.size(); i++)
+    {
+        const TextureEncodeStats& texture = stats.textures[i];
+        json.BeginObject();
+        json.Member("path", textureRequests[i].path.u8string());
+        json.Member("type", GetTextureTypeName(textureRequests[i].type));
+        json.Member("encoded", static_cast<bool>(stats.textureEncoded[i]));
+        json.Member("spilled", static_cast<bool>(stats.textureSpilled[i]));
+        json.Member("input_bytes", texture.inputBytes);
+        json.Member("dds_bytes", texture.ddsBytes);
+        json.Member("width", texture.width);
+        json.Member("height", texture.height);
+        json.Member("mip_levels", texture.mipLevels);
+        json.Member("dxgi_format", texture.format);
+        WriteStageTimeJson(json, "read", texture.read);
+        WriteStageTimeJson(json, "decode", texture.decode);
+        WriteStageTimeJson(json, "mips", texture.mips);
+        WriteStageTimeJson(json, "compress", texture.compress);
+        WriteStageTimeJson(json, "save", texture.save);
+        json.EndObject();
+    }
+    json.EndArray();
 
-    for (const auto& m : meshes)
+    // ----- チャンク ----- //
+    json.Key("chunks");
+    json.BeginArray();
+    for (const auto& chunk : stats.write.chunks)
     {
-        SerializeMesh(writer, m);
+        json.BeginObject();
+        json.Member("type", GetChunkTypeName(chunk.type));
+        json.Member("compression", GetCompressionName(static_cast<CompressionType>(chunk.flags & IMDL_CHUNK_FLAG_COMPRESSION_MASK)));
+        json.Member("gpu_layout", (chunk.flags & IMDL_CHUNK_FLAG_GPU_LAYOUT) != 0);
+        json.Member("offset", chunk.offset);
+        json.Member("raw_bytes", chunk.rawSize);
+        json.Member("stored_bytes", chunk.storedSize);
+        if (chunk.compressedSize) json.Member("compressed_bytes", chunk.compressedSize);
+        if (chunk.decodeSec > 0.0) json.Member("decode_ms", chunk.decodeSec * 1000.0);
+        WriteStageTimeJson(json, "build", chunk.build);
+        WriteStageTimeJson(json, "write", chunk.write);
+        json.EndObject();
     }
+    json.EndArray();
 
-    return writer.GetBuffer();
-}
+    json.Member("output_bytes", stats.write.fileSize);
+    json.Member("large", stats.write.large);
+    WriteStageTimeJson(json, "serialize", stats.write.serialize);
+    WriteStageTimeJson(json, "flush", stats.write.flush);
+    json.Member("peak_rss_bytes", GetPeakRss());
+    json.EndObject();
 
-// 頂点データのシリアライズ関数
-inline void SerializeVertex(BinaryWriter& writer, const VertexPositionNormalTextureTangent& v)
-{
-    writer.WriteFloat(v.position.x);
-    writer.WriteFloat(v.position.y);
-    writer.WriteFloat(v.position.z);
+    // ----- 出力 ----- //
+    if (options.statsOutput == "-")
+    {
+        std::cout << oss.str() << std::flush;
+        return true;
+    }
 
-    writer.WriteFloat(v.normal.x);
-    writer.WriteFloat(v.normal.y);
-    writer.WriteFloat(v.normal.z);
+    std::filesystem::path path = options.statsOutput;
+    if (path.empty())
+    {
+        path = options.output;
+        path += ".stats.json";
+    }
 
-    writer.WriteFloat(v.texcoord.x);
-    writer.WriteFloat(v.texcoord.y);
+    std::ofstream ofs(path, std::ios::binary);
+    ofs << oss.str();
+    if (!ofs)
+    {
+        std::wcerr << L"Could not write " << ToWString(path) << std::endl;
+        return false;
+    }
 
-    writer.WriteFloat(v.tangent.x);
-    writer.WriteFloat(v.tangent.y);
-    writer.WriteFloat(v.tangent.z);
-    writer.WriteFloat(v.tangent.w);
+    return true;
 }
 
-// 頂点データ作成
-static std::vector<uint8_t> BuildVertexChunk(
-    const std::vector<VertexPositionNormalTextureTangent>& vertices)
+// トレースを記録して、終了時に書き出すクラス（--trace）
+class TraceSession
 {
-    BinaryWriter writer;
+public:
+
+    explicit TraceSession(const std::filesystem::path& path)
+        : m_path(path)
+    {
+        if (m_path.empty()) return;
 
-    writer.WriteUInt32(static_cast<uint32_t>(vertices.size()));
+        GetTraceRecorder().Start();
+        SetTraceThreadName("main");
+    }
 
-    for (const auto& v : vertices)
+    ~TraceSession()
     {
-        SerializeVertex(writer, v);
+        if (m_path.empty()) return;
+
+        GetTraceRecorder().Stop();
+        if (!GetTraceRecorder().Write(m_path))
+        {
+            std::wcerr << L"Could not write " << ToWString(m_path) << std::endl;
+        }
     }
 
-    return writer.GetBuffer();
-}
+    TraceSession(const TraceSession&) = delete;
+    TraceSession& operator=(const TraceSession&) = delete;
 
-// インデックスデータ作成
-static std::vector<uint8_t> BuildIndexChunk(const std::vector<uint32_t>& indices)
-{
-    BinaryWriter writer;
-    writer.WriteVector(indices);
-    return writer.GetBuffer();
-}
+private:
 
-// ファイルへの出力関数
-static int OutputImdl( const std::filesystem::path& path,
-                       std::vector<MaterialInfo>& materials,
-                       std::vector<MeshInfo>& meshInfo,
-                       std::vector<TextureEntry>& textures,
-                       std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
-                       std::vector<uint32_t>& indexBuffer )
-{
-    // 出力ファイルオープン
-    std::ofstream ofs(path.c_str(), std::ios::binary);
+    std::filesystem::path m_path;
+};
 
-    if (!ofs.is_open())
+// 引数（UTF-8）に従って処理する関数
+static int Run(std::vector<std::string>& args)
+{
+    std::vector<char*> argv;
+    for (auto& s : args)
     {
-        std::wcout << "Could not open " << path.c_str() << std::endl;
-        return 1;
+        argv.push_back(s.data());
     }
 
-    // ----- Header ----- //
-    FileHeader fileHeader{};
-    fileHeader.magic = 'IMDL';
-    fileHeader.version = 1;
-    fileHeader.chunkCount = 5;
+    ConverterOptions options;
 
-    ofs.write((char*)&fileHeader, sizeof(fileHeader));
+    // 入力ファイル名と出力ファイル名を取得
+    if (AnalyzeOption(static_cast<int>(argv.size()), argv.data(), options)) return 1;
 
-    // ----- Texture ----- //
-    WriteChunk(ofs, CHUNK_TEXTURE, BuildTextureChunk(textures));
+    // トレースの記録（どの動作でも終了時に書き出す）
+    TraceSession trace(options.trace);
 
-    // ----- Material ----- //
-    WriteChunk(ofs, CHUNK_MATERIAL, BuildMaterialChunk(materials));
+    // DirectXのデバイスを作成（テクスチャ圧縮で使用、作成できない場合は CPU で圧縮する）
+#if defined(_WIN32)
+    Microsoft::WRL::ComPtr<ID3D11Device> d3dDevice;
+    if (!options.cpuTextures)
+    {
+        CreateD3DDevice(d3dDevice.GetAddressOf());
+    }
+    ID3D11Device* device = d3dDevice.Get();
+#else
+    ID3D11Device* device = nullptr;
+#endif
+    options.write.cpuTextures = device == nullptr;
+
+    // シリアライズ速度の計測
+    if (options.benchSerialize)
+    {
+        return BenchmarkSerialize(options.benchSerialize);
+    }
 
-    // ----- Mesh ----- //
-    WriteChunk(ofs, CHUNK_MESH, BuildMeshChunk(meshInfo));
+    // 読み込み速度の計測
+    if (!options.benchLoad.empty())
+    {
+        return BenchmarkLoad(options.benchLoad);
+    }
 
-    // ----- Vertex ----- //
-    WriteChunk(ofs, CHUNK_VERTEX, BuildVertexChunk(vertexBuffer));
+    // カーネルの計測
+    if (options.benchKernels)
+    {
+        return BenchmarkKernels(options);
+    }
 
-    // ----- Index ----- //
-    WriteChunk(ofs, CHUNK_INDEX, BuildIndexChunk(indexBuffer));
+    // コーパスの作成
+    if (!options.generateCorpus.empty())
+    {
+        return GenerateCorpusScales(options);
+    }
 
-    return 0;
-}
+    // コーパスの変換速度の計測
+    if (!options.benchCorpus.empty())
+    {
+        return BenchmarkCorpus(device, options);
+    }
 
-// 頂点データに接線を追加する関数
-static void GenerateTangents(
-    std::vector<VertexPositionNormalTextureTangent>& vertices,
-    const std::vector<uint32_t>& indices)
-{
-    std::vector<XMFLOAT3> tanAccum(vertices.size(), { 0,0,0 });
-    std::vector<XMFLOAT3> bitanAccum(vertices.size(), { 0,0,0 });
+    // 出力が決定的かの確認
+    if (!options.checkDeterminism.empty())
+    {
+        return CheckDeterminism(device, options);
+    }
 
-    auto add = [&](uint32_t idx, const XMFLOAT3& t, const XMFLOAT3& b)
-        {
-            tanAccum[idx].x += t.x;
-            tanAccum[idx].y += t.y;
-            tanAccum[idx].z += t.z;
+    // 非同期読み込みの計測
+    if (!options.benchAsync.empty())
+    {
+        return BenchmarkAsyncLoad(options.benchAsync, options.benchAsyncFiles);
+    }
 
-            bitanAccum[idx].x += b.x;
-            bitanAccum[idx].y += b.y;
-            bitanAccum[idx].z += b.z;
-        };
+    // ファイルの確認
+    if (!options.verify.empty())
+    {
+        return VerifyImdlFile(options.verify) ? 0 : 1;
+    }
 
-    auto set = [&](uint32_t idx, const XMFLOAT3& t, const XMFLOAT3& b)
-        {
-            tanAccum[idx] = t;
-            bitanAccum[idx] = b;
-        };
+    // 変換サーバー
+    if (options.server)
+    {
+        return RunServer(device, options);
+    }
+
+    // 変換サーバーに要求を送る
+    if (!options.client.empty())
+    {
+        return RunClient(options, GetClientArguments(args, options));
+    }
 
-    // 三角形の各頂点の法線が同じ向きならフラットシェーディングの面と判定
-    auto isFlatFace = [&](uint32_t i0, uint32_t i1, uint32_t i2)
+    // 一括変換
+    if (!options.batch.empty())
+    {
+        if (options.processes || !options.workerSockets.empty())
         {
-            XMVECTOR n0 = XMLoadFloat3(&vertices[i0].normal);
-            XMVECTOR n1 = XMLoadFloat3(&vertices[i1].normal);
-            XMVECTOR n2 = XMLoadFloat3(&vertices[i2].normal);
+            return CoordinateConvert(options, args);
+        }
+        return BatchConvert(device, options);
+    }
 
-            float d01 = XMVectorGetX(XMVector3Dot(n0, n1));
-            float d12 = XMVectorGetX(XMVector3Dot(n1, n2));
+    // 監視モード
+    if (!options.watch.empty())
+    {
+        return WatchConvert(device, options);
+    }
 
-            return d01 > 0.999f && d12 > 0.999f;
-        };
+    const std::filesystem::path& input = options.input;
+    const std::filesystem::path& output = options.output;
 
-    // ---- 三角形ごと ----
-    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    // 入力と設定が変わっていなければ変換しない
+    if (options.incremental && IsOutputUpToDate(output, GetSettingsSignature(options.write)))
     {
-        uint32_t i0 = indices[i + 0];
-        uint32_t i1 = indices[i + 1];
-        uint32_t i2 = indices[i + 2];
+        std::wcout << L"Up to date: " << ToWString(output) << std::endl;
+        return 0;
+    }
 
-        auto& v0 = vertices[i0];
-        auto& v1 = vertices[i1];
-        auto& v2 = vertices[i2];
+    // タスクグラフで変換する
+    // ※メモリの予算、段階ごとのメモリ使用量、統計は段階を順に処理して計測する
+    if (!options.memoryReport && options.stats.empty())
+    {
+        ThreadPool pool(options.threads, InitializeWorkerThread, UninitializeWorkerThread);
+        return ConvertTaskGraph(device, pool, input, output, options.write, options.incremental, options.criticalPath ? &std::cout : nullptr);
+    }
 
-        XMVECTOR p0 = XMLoadFloat3(&v0.position);
-        XMVECTOR p1 = XMLoadFloat3(&v1.position);
-        XMVECTOR p2 = XMLoadFloat3(&v2.position);
+    // 段階ごとのメモリ使用量（--memory-report）
+    std::unique_ptr<MemoryMonitor> memory;
+    if (options.memoryReport)
+    {
+        memory = std::make_unique<MemoryMonitor>();
+    }
 
-        float du1 = v1.texcoord.x - v0.texcoord.x;
-        float dv1 = v1.texcoord.y - v0.texcoord.y;
-        float du2 = v2.texcoord.x - v0.texcoord.x;
-        float dv2 = v2.texcoord.y - v0.texcoord.y;
+    // 段階ごとの処理時間（--stats）
+    ConversionStats stats;
+    StageTimer totalTimer;
+    StageTimer stageTimer;
+    ConvertStage currentStage = ConvertStage::Count;
+    auto beginStage = [&](ConvertStage stage)
+        {
+            StageTime time = stageTimer.Lap();
+            if (currentStage != ConvertStage::Count) stats.stages[static_cast<size_t>(currentStage)] += time;
+            currentStage = stage;
 
-        float denom = du1 * dv2 - du2 * dv1;
-        if (fabs(denom) < 1e-6f)
-            continue;
+            if (memory && stage != ConvertStage::Count) memory->BeginStage(GetConvertStageName(stage));
+        };
 
-        float f = 1.0f / denom;
+    // ----- 情報取得 ----- //
 
-        XMVECTOR e1 = p1 - p0;
-        XMVECTOR e2 = p2 - p0;
+    ObjModel object;
 
-        XMVECTOR T = (e1 * dv2 - e2 * dv1) * f;
-        XMVECTOR B = (e2 * du1 - e1 * du2) * f;
+    // objファイルの情報取得
+    beginStage(ConvertStage::ParseObj);
+    if (AnalyzeObj(input, object)) return 1;
 
-        XMFLOAT3 t, b;
-        XMStoreFloat3(&t, T);
-        XMStoreFloat3(&b, B);
+    // パス付きマテリアルファイル名を取得
+    if (!GetMaterialPath(input, object.mtllib))
+    {
+        return -1;
+    }
 
-        bool flat = isFlatFace(i0, i1, i2);
+    // マテリアルを取得
+    beginStage(ConvertStage::ParseMtl);
+    ModelData model;
+    std::unordered_map<std::string, uint32_t> materialIndexMap;
+    std::vector<TextureRequest> textureRequests;
+    if (AnalyzeMtl(object.mtllib, model.materials, materialIndexMap, textureRequests, options.write.sortTextures)) return 1;
 
-        if (flat)
-        {
-            // フラット：上書き
-            set(i0, t, b);
-            set(i1, t, b);
-            set(i2, t, b);
-        }
-        else
-        {
-            // スムーズ：加算
-            add(i0, t, b);
-            add(i1, t, b);
-            add(i2, t, b);
-        }
+    // 頂点、インデックスを取得（接線も追加する）
+    beginStage(ConvertStage::Geometry);
+    std::string error;
+    if (!BuildGeometry(object, materialIndexMap, model.meshes, model.vertices, model.indices, error, &stats.geometry))
+    {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
     }
 
-    // ---- 正規化 & handedness ----
-    for (size_t i = 0; i < vertices.size(); i++)
+    // obj の情報はもう使わないので、テクスチャを変換する前に解放する（マテリアルファイル名は依存関係の記録で使う）
+    std::filesystem::path mtlPath = std::move(object.mtllib);
+    object = ObjModel();
+
+    // テクスチャをDDSに変換（失敗したテクスチャは使わない）
+    // ※１枚ずつ変換して、予算を超える場合は変換したテクスチャを一時ファイルに退避する
+    beginStage(ConvertStage::Textures);
+    uint64_t modelBytes = GetModelDataBytes(model);
+
+    std::mutex gpuMutex;
+    std::vector<TextureEntry> encoded(textureRequests.size());
+    std::vector<SpilledTexture> spills(textureRequests.size());
+    stats.textures.resize(textureRequests.size());
+    stats.textureEncoded.resize(textureRequests.size());
+    stats.textureSpilled.resize(textureRequests.size());
+    for (size_t i = 0; i < textureRequests.size(); i++)
     {
-        XMVECTOR N = XMLoadFloat3(&vertices[i].normal);
-        XMVECTOR T = XMLoadFloat3(&tanAccum[i]);
-        XMVECTOR B = XMLoadFloat3(&bitanAccum[i]);
+        encoded[i].type = textureRequests[i].type;
 
-        T = XMVector3Normalize(T - N * XMVector3Dot(N, T));
+        if (!EncodeTextureFile(textureRequests[i].path, textureRequests[i].type, { device, &gpuMutex }, encoded[i].data, error, &stats.textures[i])) continue;
+        stats.textureEncoded[i] = true;
 
-        float w = (XMVectorGetX(
-            XMVector3Dot(XMVector3Cross(N, T), B)) < 0.0f)
-            ? -1.0f : 1.0f;
+        if (options.memoryBudget && modelBytes + encoded[i].data.size() > options.memoryBudget)
+        {
+            std::filesystem::path spillPath = output;
+            spillPath += ".tex" + std::to_string(i) + ".tmp";
+            if (!SpillTexture(encoded[i], spillPath, spills[i], error))
+            {
+                std::cerr << "Error: " << error << std::endl;
+                RemoveSpilledTextures(spills);
+                return 1;
+            }
+            stats.textureSpilled[i] = true;
+            continue;
+        }
 
-        XMFLOAT3 t;
-        XMStoreFloat3(&t, T);
-        vertices[i].tangent = { t.x, t.y, t.z, w };
+        modelBytes += encoded[i].data.size();
     }
-}
 
-// DirectXのデバイスを作成する関数
-static void CreateD3DDevice(ID3D11Device** device)
-{
-    D3D_FEATURE_LEVEL featureLevel;
-
-    HRESULT hr = D3D11CreateDevice(
-        nullptr,                    // アダプタ
-        D3D_DRIVER_TYPE_HARDWARE,   // GPU使用
-        nullptr,
-        0,
-        nullptr,
-        0,
-        D3D11_SDK_VERSION,
-        device,
-        &featureLevel,
-        nullptr
-    );
+    ResolveTextures(model.materials, encoded, spills, model);
 
-    if (FAILED(hr))
-    {
-        // ハードウェアが無理ならWARP
-        hr = D3D11CreateDevice(
-            nullptr,
-            D3D_DRIVER_TYPE_WARP,
-            nullptr,
-            0,
-            nullptr,
-            0,
-            D3D11_SDK_VERSION,
-            device,
-            &featureLevel,
-            nullptr
-        );
-    }
-}
+    // ----- 書き出し ----- //
 
-// パス付きマテリアルファイル名を取得
-static bool GetMaterialPath(std::filesystem::path input, std::filesystem::path& mtlPath)
-{
-    if (mtlPath.empty())
+    beginStage(ConvertStage::Write);
+    // ※統計を標準出力に書き出す場合は、書き出しの結果は標準エラーに出す
+    int ret = OutputImdl(output, options.write, model, options.stats.empty() ? nullptr : &stats.write,
+        options.statsOutput == "-" ? std::cerr : std::cout);
+    RemoveSpilledTextures(model.spilled);
+    if (ret) return 1;
+    beginStage(ConvertStage::Count);
+    stats.total = totalTimer.Elapsed();
+
+    // 依存関係を記録
+    if (options.incremental)
     {
-        std::wcerr << L"No mtllib specified in obj file." << std::endl;
-        return false;
+        RecordConversionDependencies(output, options.write, input, mtlPath, textureRequests);
     }
 
-    // 相対パスなら
-    if (mtlPath.is_relative())
+    if (memory)
     {
-        // objの入っているフォルダのパスを付ける
-        mtlPath = input.parent_path() / mtlPath;
+        memory->End();
+        PrintMemoryReport(*memory, model, options.memoryBudget);
     }
 
-    mtlPath = mtlPath.lexically_normal();  // 文字列レベルで正規化
-
-    // mtlファイルが存在？
-    if (!std::filesystem::exists(mtlPath))
+    // 統計
+    if (!options.stats.empty() && !WriteConversionStats(options, stats, textureRequests))
     {
-        std::wcerr << L"Material not found: " << mtlPath << std::endl;
-        return false;
+        return 1;
     }
 
-    return true;
+    return 0;
 }
 
 // メイン
+#if defined(_WIN32)
 int wmain(int argc, wchar_t* wargv[])
 {
     HRESULT hr = CoInitializeEx(nullptr, COINITBASE_MULTITHREADED);
     if (FAILED(hr))
         return 1;
 
-    Microsoft::WRL::ComPtr<ID3D11Device> device;
-
-    // DirectXのデバイスを作成（テクスチャ圧縮で使用）
-    CreateD3DDevice(device.GetAddressOf());
-    std::vector<std::string> args;
-    std::vector<char*> argv;
-
     // 文字コードをUTF-8へ変換する
+    std::vector<std::string> args;
     for (int i = 0; i < argc; ++i)
     {
         args.push_back(WStringToUtf8(wargv[i]));
     }
 
-    for (auto& s : args)
-    {
-        argv.push_back(s.data());
-    }
-
-    std::filesystem::path input, output;
-
-    // 入力ファイル名と出力ファイル名を取得
-    if (AnalyzeOption(argc, argv.data(), input, output)) return 1;
-
-    // ----- 情報取得 ----- //
-
-    Object object;
-    std::string path;
-
-    // objファイルの情報取得
-    if (AnalyzeObj(input, object)) return 1;
-
-    // パス付きマテリアルファイル名を取得
-    if (!GetMaterialPath(input, object.mtllib))
-    {
-        return -1;
-    }
-
-    // マテリアルを取得
-    std::vector<MaterialInfo> materials;
-    std::unordered_map<std::string, uint32_t> materialIndexMap;
-    std::vector<TextureEntry> textures;
-    if (AnalyzeMtl(device.Get(), object.mtllib, materials, materialIndexMap, textures)) return 1;
-
-    // 頂点、インデックスを取得
-    std::vector<MeshInfo> meshInfo;
-    std::vector<VertexPositionNormalTextureTangent> vertexBuffer;
-    std::vector<uint32_t> indexBuffer;
-    CreateBufferData(object, materialIndexMap, meshInfo, vertexBuffer, indexBuffer);
-
-    // 頂点データに接線を追加
-    GenerateTangents(vertexBuffer, indexBuffer);
+    int ret = Run(args);
 
-    // ----- 書き出し ----- //
+    CoUninitialize();
 
-    if (OutputImdl(output, materials, meshInfo, textures, vertexBuffer, indexBuffer)) return 1;
+    return ret;
+}
+#else
+int main(int argc, char* argv[])
+{
+    // std::wcout、std::wcerr は UTF-8 にして std::cout、std::cerr と同じバッファに書き込む
+    static Utf8WideStreamBuf wout(std::cout.rdbuf());
+    static Utf8WideStreamBuf werr(std::cerr.rdbuf());
+    std::wcout.rdbuf(&wout);
+    std::wcerr.rdbuf(&werr);
 
-    CoUninitialize();
+    // 引数は UTF-8 のまま使う
+    std::vector<std::string> args(argv, argv + argc);
 
-    return 0;
+    return Run(args);
 }
+#endif
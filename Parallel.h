@@ -0,0 +1,73 @@
+﻿//--------------------------------------------------------------------------------------
+// File: Parallel.h
+//
+// 処理を全コアに分散して実行する関数
+//
+// Date: 2026.3.9
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Imase
+{
+    // 使用するスレッド数を取得する関数（0 = 論理コア数）
+    inline unsigned GetWorkerCount(unsigned threads = 0)
+    {
+        if (threads > 0) return threads;
+        unsigned n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+    // func(i) を i = 0 ～ count - 1 について並列に実行する関数
+    // ※各スレッドは空いたら次の番号を取りに行くので、処理時間に偏りがあっても均等になる
+    // ※例外が発生した場合は最初の例外を呼び出し元に投げる
+    template<typename F>
+    void ParallelFor(size_t count, F&& func, unsigned threads = 0)
+    {
+        if (count == 0) return;
+
+        unsigned workerCount = static_cast<unsigned>(std::min<size_t>(GetWorkerCount(threads), count));
+
+        std::atomic<size_t> next{ 0 };
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        auto worker = [&]()
+            {
+                for (size_t i = next++; i < count; i = next++)
+                {
+                    try
+                    {
+                        func(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (!error) error = std::current_exception();
+                    }
+                }
+            };
+
+        // 呼び出したスレッドも処理に参加する
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < workerCount; i++)
+        {
+            workers.emplace_back(worker);
+        }
+        worker();
+
+        for (auto& t : workers)
+        {
+            t.join();
+        }
+
+        if (error) std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,390 @@
+﻿//--------------------------------------------------------------------------------------
+// File: TaskGraph.h
+//
+// 依存関係のあるタスクをスレッドプールで実行するクラス（タスクグラフ）
+//
+// ※依存するタスクがすべて終わったタスクから ThreadPool に積む
+// ※実行中のタスクの中からタスクと依存関係を追加できる（mtl を解析してからテクスチャのタスクを追加するなど）
+//   追加したタスクは、クリティカルパスでは追加したタスクの後に続くものとして扱う
+// ※タスクが失敗（false を返す、例外）すると、それに依存するタスクは実行しない
+// ※終了後に各タスクの開始、終了時刻からクリティカルパスを求める
+//   （最後に終わったタスクから、それぞれ最後に終わった依存するタスクをたどった連鎖）
+//
+// Date: 2026.3.18
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+#include "Trace.h"
+
+namespace Imase
+{
+    class TaskGraph
+    {
+    public:
+
+        using TaskId = size_t;
+
+        // タスクの処理（失敗した場合は false を返す）
+        using Task = std::function<bool()>;
+
+        // タスクの状態
+        enum class State
+        {
+            Waiting,    // 依存するタスクを待っている
+            Queued,     // スレッドプールに積んだ
+            Running,    // 実行中
+            Succeeded,
+            Failed,
+            Skipped,    // 依存するタスクが失敗したので実行しなかった
+        };
+
+        // タスクの記録
+        struct Record
+        {
+            std::string name;
+            State state = State::Waiting;
+            double readySec = 0.0;      // 実行できるようになった時刻（Run からの秒）
+            double startSec = 0.0;      // 開始時刻（Run からの秒）
+            double endSec = 0.0;        // 終了時刻（Run からの秒）
+            int thread = -1;            // 実行したスレッドの番号
+            TaskId critical = NONE;     // 最後に終わった依存するタスクか、追加したタスク（NONE = なし）
+        };
+
+        // 依存するタスクがないことを表す番号
+        static constexpr TaskId NONE = static_cast<TaskId>(-1);
+
+        explicit TaskGraph(ThreadPool& pool)
+            : m_pool(pool)
+        {
+        }
+
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        // タスクを追加する関数（dependencies がすべて終わったら実行する）
+        // ※Run の前でも、実行中のタスクの中からでも呼べる
+        TaskId Add(std::string name, Task task, const std::vector<TaskId>& dependencies = {})
+        {
+            std::vector<TaskId> ready;
+            TaskId id;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                id = m_nodes.size();
+                m_nodes.emplace_back();
+                Node& node = m_nodes.back();
+                node.record.name = std::move(name);
+                node.task = std::move(task);
+                m_unfinished++;
+
+                // 実行中のタスクの中から追加した
+                if (GetCurrent().graph == this) node.record.critical = GetCurrent().id;
+
+                for (TaskId dependency : dependencies)
+                {
+                    LinkLocked(id, dependency);
+                }
+
+                if (m_running && node.remaining == 0) ReadyLocked(id, ready);
+            }
+            Submit(ready);
+            return id;
+        }
+
+        // 依存関係を追加する関数（task は dependency が終わるまで実行しない）
+        // ※task はまだ積まれていないこと（実行中のタスクから、それを待っているタスクに追加する場合など）
+        void AddDependency(TaskId task, TaskId dependency)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (m_nodes[task].record.state != State::Waiting || (m_running && m_nodes[task].remaining == 0))
+            {
+                throw std::logic_error("TaskGraph: a dependency was added to a task that has already started: " + m_nodes[task].record.name);
+            }
+            LinkLocked(task, dependency);
+        }
+
+        // すべてのタスクが終わるまで実行する関数（すべて成功した場合は true）
+        // ※プールのスレッドから呼ばないこと
+        bool Run()
+        {
+            std::vector<TaskId> ready;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_start = std::chrono::steady_clock::now();
+                m_running = true;
+
+                for (TaskId id = 0; id < m_nodes.size(); id++)
+                {
+                    if (m_nodes[id].record.state == State::Waiting && m_nodes[id].remaining == 0) ReadyLocked(id, ready);
+                }
+            }
+            Submit(ready);
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [this]() { return m_unfinished == 0; });
+            m_running = false;
+            m_wallSec = ElapsedLocked();
+
+            return !m_failed;
+        }
+
+        // 最初に失敗したタスクの例外のメッセージ（例外でない場合は空）
+        const std::string& GetError() const { return m_error; }
+
+        // タスクの記録（Run の後に使う）
+        std::vector<Record> GetRecords() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::vector<Record> records;
+            for (const auto& node : m_nodes) records.push_back(node.record);
+            return records;
+        }
+
+        // クリティカルパスのタスクの番号を取得する関数（実行順、Run の後に使う）
+        std::vector<TaskId> GetCriticalPath() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // 最後に終わったタスク
+            TaskId last = NONE;
+            for (TaskId id = 0; id < m_nodes.size(); id++)
+            {
+                const Record& record = m_nodes[id].record;
+                if (record.state != State::Succeeded && record.state != State::Failed) continue;
+                if (last == NONE || record.endSec > m_nodes[last].record.endSec) last = id;
+            }
+
+            std::vector<TaskId> path;
+            for (TaskId id = last; id != NONE; id = m_nodes[id].record.critical)
+            {
+                path.push_back(id);
+            }
+            std::reverse(path.begin(), path.end());
+            return path;
+        }
+
+        // クリティカルパスを表示する関数
+        // ※待ち時間は実行できるようになってから開始するまで（スレッドが空くのを待った時間）
+        void PrintCriticalPath(std::ostream& os) const
+        {
+            std::vector<TaskId> path = GetCriticalPath();
+            std::vector<Record> records = GetRecords();
+
+            double pathSec = 0.0;
+            double busySec = 0.0;
+            for (TaskId id : path) pathSec += records[id].endSec - records[id].startSec;
+            for (const auto& record : records)
+            {
+                if (record.state == State::Succeeded || record.state == State::Failed) busySec += record.endSec - record.startSec;
+            }
+
+            os << "Critical path: " << pathSec * 1000.0 << " ms of " << m_wallSec * 1000.0 << " ms ("
+                << path.size() << " of " << records.size() << " tasks, average parallelism "
+                << (m_wallSec > 0.0 ? busySec / m_wallSec : 0.0) << ")" << std::endl;
+
+            for (TaskId id : path)
+            {
+                const Record& record = records[id];
+                os << "  " << record.name << ": "
+                    << (record.endSec - record.startSec) * 1000.0 << " ms (start " << record.startSec * 1000.0
+                    << " ms, waited " << (record.startSec - record.readySec) * 1000.0 << " ms, thread " << record.thread << ")";
+                if (record.state == State::Failed) os << " failed";
+                os << std::endl;
+            }
+        }
+
+    private:
+
+        struct Node
+        {
+            Record record;
+            Task task;
+            size_t remaining = 0;               // 終わっていない依存するタスクの数
+            bool blocked = false;               // 依存するタスクが失敗した
+            std::vector<TaskId> dependents;     // このタスクに依存するタスク
+        };
+
+        // 実行中のタスク（タスクの中から追加したタスクを記録するため）
+        struct Current
+        {
+            const TaskGraph* graph = nullptr;
+            TaskId id = NONE;
+        };
+
+        static Current& GetCurrent()
+        {
+            thread_local Current current;
+            return current;
+        }
+
+        double ElapsedLocked() const
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+        static bool IsFinished(State state)
+        {
+            return state == State::Succeeded || state == State::Failed || state == State::Skipped;
+        }
+
+        // task が dependency を待つようにする関数
+        void LinkLocked(TaskId task, TaskId dependency)
+        {
+            Node& node = m_nodes[task];
+            const Record& depend = m_nodes[dependency].record;
+
+            if (!IsFinished(depend.state))
+            {
+                node.remaining++;
+                m_nodes[dependency].dependents.push_back(task);
+                return;
+            }
+
+            // 終わっているタスクは、最後に終わったものをクリティカルパスの候補にする
+            // ※追加したタスク（実行中）より後に終わることはないので置き換えない
+            if (depend.state != State::Succeeded) node.blocked = true;
+            if (depend.state != State::Skipped
+                && (node.record.critical == NONE
+                    || (IsFinished(m_nodes[node.record.critical].record.state) && depend.endSec > m_nodes[node.record.critical].record.endSec)))
+            {
+                node.record.critical = dependency;
+            }
+        }
+
+        // 依存するタスクが終わったタスクを積む（依存するタスクが失敗していれば実行しないで終わらせる）
+        void ReadyLocked(TaskId id, std::vector<TaskId>& ready)
+        {
+            std::vector<TaskId> stack{ id };
+            while (!stack.empty())
+            {
+                TaskId current = stack.back();
+                stack.pop_back();
+
+                Node& node = m_nodes[current];
+                if (!node.blocked)
+                {
+                    node.record.state = State::Queued;
+                    node.record.readySec = ElapsedLocked();
+                    ready.push_back(current);
+                    continue;
+                }
+
+                node.record.state = State::Skipped;
+                node.record.readySec = node.record.startSec = node.record.endSec = ElapsedLocked();
+                node.task = nullptr;
+                m_unfinished--;
+
+                for (TaskId dependent : node.dependents)
+                {
+                    Node& next = m_nodes[dependent];
+                    next.blocked = true;
+                    if (--next.remaining == 0) stack.push_back(dependent);
+                }
+            }
+
+            if (m_unfinished == 0) m_done.notify_all();
+        }
+
+        void Submit(const std::vector<TaskId>& ready)
+        {
+            for (TaskId id : ready)
+            {
+                m_pool.Submit([this, id]() { Execute(id); });
+            }
+        }
+
+        void Execute(TaskId id)
+        {
+            Task task;
+            std::string name;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                Node& node = m_nodes[id];
+                node.record.state = State::Running;
+                node.record.startSec = ElapsedLocked();
+                node.record.thread = m_pool.GetCurrentThreadIndex();
+                task = std::move(node.task);
+                name = node.record.name;
+            }
+
+            bool succeeded = false;
+            std::string error;
+            {
+                IMDL_TRACE_SCOPE_DETAIL("TaskGraph", name);
+                Current previous = GetCurrent();
+                GetCurrent() = { this, id };
+                try
+                {
+                    succeeded = task();
+                }
+                catch (const std::exception& e)
+                {
+                    error = e.what();
+                }
+                catch (...)
+                {
+                    // std::exception 以外の例外も失敗にする（外に投げると終わらないタスクが残り、Run が戻らない）
+                    error = "unknown exception";
+                }
+                GetCurrent() = previous;
+            }
+
+            std::vector<TaskId> ready;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                Node& node = m_nodes[id];
+                node.record.state = succeeded ? State::Succeeded : State::Failed;
+                node.record.endSec = ElapsedLocked();
+                if (!succeeded)
+                {
+                    if (!m_failed && !error.empty()) m_error = name + ": " + error;
+                    m_failed = true;
+                }
+                m_unfinished--;
+
+                // ※終わった順に処理するので、最後に終わった依存するタスクで上書きされる
+                for (TaskId dependent : node.dependents)
+                {
+                    Node& next = m_nodes[dependent];
+                    next.record.critical = id;
+                    if (!succeeded) next.blocked = true;
+                    if (--next.remaining == 0) ReadyLocked(dependent, ready);
+                }
+
+                if (m_unfinished == 0) m_done.notify_all();
+            }
+            Submit(ready);
+        }
+
+        ThreadPool& m_pool;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_done;
+
+        // ※追加しても参照が無効にならないように deque にする
+        std::deque<Node> m_nodes;
+        size_t m_unfinished = 0;
+        bool m_running = false;
+        bool m_failed = false;
+        std::string m_error;
+
+        std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+        double m_wallSec = 0.0;
+    };
+}
@@ -0,0 +1,195 @@
+﻿//--------------------------------------------------------------------------------------
+// File: TextEncoding.h
+//
+// 文字コードを変換する関数
+//
+// ※Windows の wchar_t は UTF-16（WideCharToMultiByte / MultiByteToWideChar）、その他は UTF-32
+// ※Windows 以外の path::wstring() は ASCII 以外のファイル名で例外になるので、
+//   パスを表示するときは ToWString を使うこと
+//
+// Date: 2026.3.13
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <streambuf>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace Imase
+{
+#if defined(_WIN32)
+    // UTF-16 → UTF-8 変換
+    inline std::string WStringToUtf8(const std::wstring& ws)
+    {
+        int size = WideCharToMultiByte(
+            CP_UTF8, 0,
+            ws.c_str(), -1,
+            nullptr, 0,
+            nullptr, nullptr);
+
+        std::string result(size - 1, 0);
+
+        WideCharToMultiByte(
+            CP_UTF8, 0,
+            ws.c_str(), -1,
+            result.data(), size,
+            nullptr, nullptr);
+
+        return result;
+    }
+
+    // UTF-8 → UTF-16 変換
+    inline std::wstring StringToWString(const std::string& str)
+    {
+        if (str.empty()) return std::wstring();
+
+        int size_needed = MultiByteToWideChar(
+            CP_UTF8,                // UTF-8
+            0,
+            str.c_str(),
+            (int)str.size(),
+            nullptr,
+            0);
+
+        std::wstring wstr(size_needed, 0);
+
+        MultiByteToWideChar(
+            CP_UTF8,
+            0,
+            str.c_str(),
+            (int)str.size(),
+            &wstr[0],
+            size_needed);
+
+        return wstr;
+    }
+#else
+    // UTF-32 → UTF-8 変換
+    inline std::string WStringToUtf8(const std::wstring& ws)
+    {
+        std::string result;
+        result.reserve(ws.size());
+
+        for (wchar_t wc : ws)
+        {
+            uint32_t c = static_cast<uint32_t>(wc);
+            if (c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff)) c = 0xfffd;
+
+            if (c < 0x80)
+            {
+                result += static_cast<char>(c);
+            }
+            else if (c < 0x800)
+            {
+                result += static_cast<char>(0xc0 | (c >> 6));
+                result += static_cast<char>(0x80 | (c & 0x3f));
+            }
+            else if (c < 0x10000)
+            {
+                result += static_cast<char>(0xe0 | (c >> 12));
+                result += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+                result += static_cast<char>(0x80 | (c & 0x3f));
+            }
+            else
+            {
+                result += static_cast<char>(0xf0 | (c >> 18));
+                result += static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+                result += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+                result += static_cast<char>(0x80 | (c & 0x3f));
+            }
+        }
+
+        return result;
+    }
+
+    // UTF-8 → UTF-32 変換（不正なバイトは U+FFFD にする）
+    inline std::wstring StringToWString(const std::string& str)
+    {
+        std::wstring result;
+        result.reserve(str.size());
+
+        for (size_t i = 0; i < str.size();)
+        {
+            uint8_t c = static_cast<uint8_t>(str[i]);
+            size_t length = c < 0x80 ? 1 : (c >> 5) == 0x06 ? 2 : (c >> 4) == 0x0e ? 3 : (c >> 3) == 0x1e ? 4 : 0;
+            uint32_t code = length == 1 ? c : length == 2 ? (c & 0x1f) : length == 3 ? (c & 0x0f) : (c & 0x07);
+
+            bool valid = length > 0 && i + length <= str.size();
+            for (size_t j = 1; valid && j < length; j++)
+            {
+                uint8_t next = static_cast<uint8_t>(str[i + j]);
+                valid = (next & 0xc0) == 0x80;
+                code = (code << 6) | (next & 0x3f);
+            }
+
+            if (valid)
+            {
+                result += static_cast<wchar_t>(code);
+                i += length;
+            }
+            else
+            {
+                result += static_cast<wchar_t>(0xfffd);
+                i++;
+            }
+        }
+
+        return result;
+    }
+
+    // wchar_t の出力を UTF-8 にして書き込むバッファ（std::wcout、std::wcerr 用）
+    // ※std::cout と std::wcout が同じ標準出力に書き込むと文字の向きが固定されて片方が表示されなくなるので、
+    //   std::cout のバッファに UTF-8 で書き込む
+    class Utf8WideStreamBuf : public std::wstreambuf
+    {
+    public:
+
+        explicit Utf8WideStreamBuf(std::streambuf* output)
+            : m_output(output)
+        {
+        }
+
+    protected:
+
+        int_type overflow(int_type c) override
+        {
+            if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+
+            wchar_t wc = traits_type::to_char_type(c);
+            return xsputn(&wc, 1) == 1 ? c : traits_type::eof();
+        }
+
+        std::streamsize xsputn(const char_type* s, std::streamsize count) override
+        {
+            std::string text = WStringToUtf8(std::wstring(s, static_cast<size_t>(count)));
+            std::streamsize size = static_cast<std::streamsize>(text.size());
+            return m_output->sputn(text.data(), size) == size ? count : 0;
+        }
+
+        int sync() override
+        {
+            return m_output->pubsync();
+        }
+
+    private:
+
+        std::streambuf* m_output;
+    };
+#endif
+
+    // パスを表示用の文字列にする関数
+    inline std::wstring ToWString(const std::filesystem::path& path)
+    {
+#if defined(_WIN32)
+        return path.wstring();
+#else
+        return StringToWString(path.u8string());
+#endif
+    }
+}
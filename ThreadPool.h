@@ -0,0 +1,263 @@
+﻿//--------------------------------------------------------------------------------------
+// File: ThreadPool.h
+//
+// ワークスティーリングのスレッドプール
+//
+// ※スレッドごとにタスクのキューを持ち、自分のキューは後ろから（最後に積んだものから）取り出す
+//   自分のキューが空になったら他のスレッドのキューの前から盗む
+// ※タスクの中から積んだ後続のタスクは同じスレッドのキューに入るので、データがキャッシュに残ったまま処理できる
+//
+// Date: 2026.3.10
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Parallel.h"
+#include "Trace.h"
+
+namespace Imase
+{
+    class ThreadPool
+    {
+    public:
+
+        using Task = std::function<void()>;
+
+        // threads : スレッド数（0 = 論理コア数）
+        // onThreadStart, onThreadExit : 各スレッドの開始時、終了時に呼ばれる（COM の初期化など）
+        explicit ThreadPool(unsigned threads = 0, std::function<void()> onThreadStart = nullptr, std::function<void()> onThreadExit = nullptr)
+            : m_onThreadStart(std::move(onThreadStart))
+            , m_onThreadExit(std::move(onThreadExit))
+        {
+            unsigned count = GetWorkerCount(threads);
+
+            for (unsigned i = 0; i < count; i++)
+            {
+                m_queues.push_back(std::make_unique<Queue>());
+            }
+
+            for (unsigned i = 0; i < count; i++)
+            {
+                m_threads.emplace_back([this, i]() { Run(i); });
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_done.wait(lock, [this]() { return m_pending == 0; });
+                m_stop = true;
+            }
+            m_wake.notify_all();
+
+            for (auto& t : m_threads)
+            {
+                t.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // タスクを積む関数
+        // ※プールのスレッドから呼んだ場合はそのスレッドのキューに積む
+        void Submit(Task task)
+        {
+            m_pending++;
+
+            unsigned index;
+            if (GetCurrent().pool == this)
+            {
+                index = GetCurrent().index;
+            }
+            else
+            {
+                index = static_cast<unsigned>(m_next++ % m_queues.size());
+            }
+
+            // ※取り出す側が先に減らさないように、キューに入れる前に数える
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_queued++;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+                m_queues[index]->tasks.push_back(std::move(task));
+            }
+            m_wake.notify_one();
+        }
+
+        // 積んだタスク（タスクの中から積んだものを含む）がすべて終わるまで待つ関数
+        // ※タスクで例外が発生した場合は最初の例外を投げる
+        // ※プールのスレッドから呼ばないこと
+        void Wait()
+        {
+            std::exception_ptr error;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_done.wait(lock, [this]() { return m_pending == 0; });
+                error = m_error;
+                m_error = nullptr;
+            }
+
+            if (error) std::rethrow_exception(error);
+        }
+
+        // スレッド数を取得する関数
+        unsigned GetThreadCount() const
+        {
+            return static_cast<unsigned>(m_threads.size());
+        }
+
+        // 他のスレッドから盗んだタスクの数を取得する関数
+        uint64_t GetStealCount() const
+        {
+            return m_steals;
+        }
+
+        // 実行中のスレッドの番号を取得する関数（プールのスレッドでない場合は -1）
+        int GetCurrentThreadIndex() const
+        {
+            return GetCurrent().pool == this ? static_cast<int>(GetCurrent().index) : -1;
+        }
+
+    private:
+
+        // スレッドごとのキュー
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        // 実行中のスレッドが属するプール
+        struct Current
+        {
+            ThreadPool* pool = nullptr;
+            unsigned index = 0;
+        };
+
+        static Current& GetCurrent()
+        {
+            thread_local Current current;
+            return current;
+        }
+
+        // 自分のキューの後ろから取り出す関数
+        bool Pop(unsigned index, Task& task)
+        {
+            Queue& queue = *m_queues[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) return false;
+
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+
+        // 他のスレッドのキューの前から盗む関数
+        bool Steal(unsigned index, Task& task)
+        {
+            size_t count = m_queues.size();
+            for (size_t i = 1; i < count; i++)
+            {
+                Queue& queue = *m_queues[(index + i) % count];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.tasks.empty()) continue;
+
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                m_steals++;
+                return true;
+            }
+            return false;
+        }
+
+        void Run(unsigned index)
+        {
+            GetCurrent() = { this, index };
+            SetTraceThreadName("ThreadPool worker " + std::to_string(index));
+
+            if (m_onThreadStart) m_onThreadStart();
+
+            for (;;)
+            {
+                Task task;
+                if (Pop(index, task) || Steal(index, task))
+                {
+                    m_queued--;
+
+                    try
+                    {
+                        task();
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (!m_error) m_error = std::current_exception();
+                    }
+                    task = nullptr;
+
+                    if (--m_pending == 0)
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        m_done.notify_all();
+                    }
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this]() { return m_stop || m_queued > 0; });
+                if (m_stop && m_queued == 0) break;
+            }
+
+            if (m_onThreadExit) m_onThreadExit();
+
+            GetCurrent() = {};
+        }
+
+    private:
+
+        // スレッドごとのキュー
+        std::vector<std::unique_ptr<Queue>> m_queues;
+
+        // スレッド
+        std::vector<std::thread> m_threads;
+
+        std::function<void()> m_onThreadStart;
+        std::function<void()> m_onThreadExit;
+
+        // 終わっていないタスクの数（実行中を含む）
+        std::atomic<size_t> m_pending{ 0 };
+
+        // キューに入っているタスクの数
+        std::atomic<size_t> m_queued{ 0 };
+
+        // 外から積む場合に使うキューの番号
+        std::atomic<size_t> m_next{ 0 };
+
+        // 盗んだタスクの数
+        std::atomic<uint64_t> m_steals{ 0 };
+
+        // 最初に発生した例外
+        std::exception_ptr m_error;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        bool m_stop = false;
+    };
+}
@@ -0,0 +1,269 @@
+﻿//--------------------------------------------------------------------------------------
+// File: Trace.h
+//
+// 処理の区間を記録して Chrome のトレース形式（JSON）で書き出すユーティリティ
+//
+// ※IMDL_TRACE_SCOPE("name") を置いたスコープの開始から終了までを１つのイベントにする
+//   Perfetto（ui.perfetto.dev）や chrome://tracing で開くと、スレッドごとの処理と空き時間が見える
+// ※記録していない間は、区間の開始と終了で atomic の bool を１回読むだけ
+// ※IMDL_ENABLE_TRACE を 0 にしてビルドすると、IMDL_TRACE_SCOPE は何もしない（コードも生成しない）
+// ※イベントはスレッドごとのバッファに追加するので、記録中もスレッド間でロックを取り合わない
+//
+// Date: 2026.3.15
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "JsonWriter.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifndef IMDL_ENABLE_TRACE
+#define IMDL_ENABLE_TRACE 1
+#endif
+
+namespace Imase
+{
+    // 記録したイベント（Chrome のトレース形式の "X" イベント）
+    struct TraceEvent
+    {
+        const char* name;       // 区間の名前（文字列リテラル）
+        std::string detail;     // 付加情報（ファイル名など、args.detail に書き出す）
+        int64_t startUs;        // 開始時刻（記録開始からのマイクロ秒）
+        int64_t durationUs;     // 時間（マイクロ秒）
+    };
+
+    class TraceRecorder
+    {
+    public:
+
+        // 記録を開始する関数（それまでのイベントは破棄する）
+        void Start()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& buffer : m_buffers)
+            {
+                std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+                buffer->events.clear();
+            }
+            m_start = std::chrono::steady_clock::now();
+            m_enabled.store(true, std::memory_order_release);
+        }
+
+        // 記録を終了する関数
+        void Stop()
+        {
+            m_enabled.store(false, std::memory_order_release);
+        }
+
+        // 記録中か？
+        bool IsEnabled() const
+        {
+            return m_enabled.load(std::memory_order_relaxed);
+        }
+
+        // 記録開始からの時間（マイクロ秒）
+        int64_t Now() const
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+        // 呼び出したスレッドにイベントを追加する関数
+        void Add(TraceEvent&& event)
+        {
+            ThreadBuffer& buffer = GetThreadBuffer();
+            std::lock_guard<std::mutex> lock(buffer.mutex);
+            buffer.events.push_back(std::move(event));
+        }
+
+        // 呼び出したスレッドの名前を設定する関数（トレースのスレッド名になる）
+        void SetThreadName(const std::string& name)
+        {
+            ThreadBuffer& buffer = GetThreadBuffer();
+            std::lock_guard<std::mutex> lock(buffer.mutex);
+            buffer.name = name;
+        }
+
+        // 記録したイベントを Chrome のトレース形式で書き出す関数
+        bool Write(const std::filesystem::path& path)
+        {
+            std::ostringstream oss;
+            JsonWriter json(oss, 0);
+
+            uint64_t pid = GetProcessId();
+
+            json.BeginObject();
+            json.Member("displayTimeUnit", "ms");
+            json.Key("traceEvents");
+            json.BeginArray();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (auto& buffer : m_buffers)
+                {
+                    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+                    // スレッド名
+                    if (!buffer->name.empty())
+                    {
+                        json.BeginObject();
+                        json.Member("name", "thread_name");
+                        json.Member("ph", "M");
+                        json.Member("pid", pid);
+                        json.Member("tid", buffer->id);
+                        json.Key("args");
+                        json.BeginObject();
+                        json.Member("name", buffer->name);
+                        json.EndObject();
+                        json.EndObject();
+                    }
+
+                    for (const auto& event : buffer->events)
+                    {
+                        json.BeginObject();
+                        json.Member("name", event.name);
+                        json.Member("ph", "X");
+                        json.Member("pid", pid);
+                        json.Member("tid", buffer->id);
+                        json.Member("ts", event.startUs);
+                        json.Member("dur", event.durationUs);
+                        if (!event.detail.empty())
+                        {
+                            json.Key("args");
+                            json.BeginObject();
+                            json.Member("detail", event.detail);
+                            json.EndObject();
+                        }
+                        json.EndObject();
+                    }
+                }
+            }
+            json.EndArray();
+            json.EndObject();
+
+            std::ofstream ofs(path, std::ios::binary);
+            ofs << oss.str();
+            return static_cast<bool>(ofs);
+        }
+
+    private:
+
+        // スレッドごとのイベントのバッファ
+        // ※スレッドが終了しても書き出すまで残す
+        struct ThreadBuffer
+        {
+            std::mutex mutex;   // 書き出しと追加の排他（追加は同じスレッドからのみ）
+            uint64_t id = 0;    // トレースのスレッド番号
+            std::string name;
+            std::vector<TraceEvent> events;
+        };
+
+        ThreadBuffer& GetThreadBuffer()
+        {
+            thread_local ThreadBuffer* buffer = nullptr;
+            if (buffer == nullptr)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_buffers.push_back(std::make_unique<ThreadBuffer>());
+                buffer = m_buffers.back().get();
+                buffer->id = m_buffers.size();
+            }
+            return *buffer;
+        }
+
+        static uint64_t GetProcessId()
+        {
+#if defined(_WIN32)
+            return GetCurrentProcessId();
+#else
+            return static_cast<uint64_t>(getpid());
+#endif
+        }
+
+        std::atomic<bool> m_enabled{ false };
+        std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+        std::mutex m_mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    };
+
+    // プロセスで共有するトレースの記録
+    inline TraceRecorder& GetTraceRecorder()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    // 区間を記録するクラス（IMDL_TRACE_SCOPE で使う）
+    class TraceScope
+    {
+    public:
+
+        explicit TraceScope(const char* name)
+            : m_name(name)
+            , m_active(GetTraceRecorder().IsEnabled())
+        {
+            if (m_active) m_startUs = GetTraceRecorder().Now();
+        }
+
+        ~TraceScope()
+        {
+            if (!m_active) return;
+
+            TraceRecorder& recorder = GetTraceRecorder();
+            recorder.Add({ m_name, std::move(m_detail), m_startUs, recorder.Now() - m_startUs });
+        }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+        bool IsActive() const { return m_active; }
+
+        void SetDetail(std::string detail) { m_detail = std::move(detail); }
+
+    private:
+
+        const char* m_name;
+        bool m_active;
+        int64_t m_startUs = 0;
+        std::string m_detail;
+    };
+
+    // 呼び出したスレッドの名前を設定する関数（記録していない場合は何もしない）
+    inline void SetTraceThreadName(const std::string& name)
+    {
+#if IMDL_ENABLE_TRACE
+        if (GetTraceRecorder().IsEnabled()) GetTraceRecorder().SetThreadName(name);
+#else
+        (void)name;
+#endif
+    }
+}
+
+#if IMDL_ENABLE_TRACE
+#define IMDL_TRACE_CONCAT_INNER(a, b) a##b
+#define IMDL_TRACE_CONCAT(a, b) IMDL_TRACE_CONCAT_INNER(a, b)
+
+// スコープの終わりまでを name の区間として記録する
+#define IMDL_TRACE_SCOPE(name) ::Imase::TraceScope IMDL_TRACE_CONCAT(imdlTraceScope, __LINE__)(name)
+
+// 付加情報付きで記録する（detail は記録している場合のみ評価する）
+#define IMDL_TRACE_SCOPE_DETAIL(name, detail) \
+    ::Imase::TraceScope IMDL_TRACE_CONCAT(imdlTraceScope, __LINE__)(name); \
+    if (IMDL_TRACE_CONCAT(imdlTraceScope, __LINE__).IsActive()) IMDL_TRACE_CONCAT(imdlTraceScope, __LINE__).SetDetail(detail)
+#else
+#define IMDL_TRACE_SCOPE(name) ((void)0)
+#define IMDL_TRACE_SCOPE_DETAIL(name, detail) ((void)0)
+#endif
@@ -0,0 +1,371 @@
+﻿//--------------------------------------------------------------------------------------
+// File: WorkerProcess.h
+//
+// 子プロセスを起動して、その標準入出力でフレームを送受信するクラス
+//
+// ※変換サーバー（ObjToImdl --server）を子プロセスとして起動し、パイプで要求を送るために使う
+// ※Windows は CreateProcessW と匿名パイプ、その他は posix_spawn と pipe を使う
+// ※子プロセスの標準エラー出力は親と同じ（エラーの表示はそのまま出る）
+//
+// Date: 2026.3.13
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "FrameStream.h"
+#include "TextEncoding.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace Imase
+{
+    // 実行中のプログラムのパスを取得する関数（取得できない場合は空）
+    inline std::filesystem::path GetExecutablePath()
+    {
+#if defined(_WIN32)
+        std::wstring path(MAX_PATH, L'\0');
+        for (;;)
+        {
+            DWORD size = GetModuleFileNameW(nullptr, path.data(), static_cast<DWORD>(path.size()));
+            if (size == 0) return std::filesystem::path();
+            if (size < path.size())
+            {
+                path.resize(size);
+                return path;
+            }
+            path.resize(path.size() * 2);
+        }
+#elif defined(__linux__)
+        std::error_code ec;
+        std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", ec);
+        return ec ? std::filesystem::path() : path;
+#else
+        return std::filesystem::path();
+#endif
+    }
+
+#if defined(_WIN32)
+    // コマンドラインの引数を CommandLineToArgvW で元に戻せるように引用符で囲む関数
+    inline std::wstring QuoteCommandLineArgument(const std::wstring& arg)
+    {
+        if (!arg.empty() && arg.find_first_of(L" \t\n\v\"") == std::wstring::npos) return arg;
+
+        std::wstring quoted = L"\"";
+        for (auto it = arg.begin(); ; ++it)
+        {
+            // 引用符の前の \ は２倍にする
+            size_t backslashes = 0;
+            while (it != arg.end() && *it == L'\\')
+            {
+                ++it;
+                ++backslashes;
+            }
+
+            if (it == arg.end())
+            {
+                quoted.append(backslashes * 2, L'\\');
+                break;
+            }
+
+            if (*it == L'"')
+            {
+                quoted.append(backslashes * 2 + 1, L'\\');
+            }
+            else
+            {
+                quoted.append(backslashes, L'\\');
+            }
+            quoted += *it;
+        }
+        quoted += L'"';
+        return quoted;
+    }
+#endif
+
+    class WorkerProcess : public FrameStream
+    {
+    public:
+
+        WorkerProcess() = default;
+
+        ~WorkerProcess() override
+        {
+            Close();
+            if (IsRunning())
+            {
+                Kill();
+            }
+            CloseOutput();
+        }
+
+        WorkerProcess(const WorkerProcess&) = delete;
+        WorkerProcess& operator=(const WorkerProcess&) = delete;
+
+        // 子プロセスを起動する関数
+        // args : 引数（UTF-8、プログラム名は含めない）
+        bool Start(const std::filesystem::path& program, const std::vector<std::string>& args)
+        {
+#if defined(_WIN32)
+            SECURITY_ATTRIBUTES attributes{ sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+
+            HANDLE inputRead, inputWrite, outputRead, outputWrite;
+            if (!CreatePipe(&inputRead, &inputWrite, &attributes, 0)) return false;
+            if (!CreatePipe(&outputRead, &outputWrite, &attributes, 0))
+            {
+                CloseHandle(inputRead);
+                CloseHandle(inputWrite);
+                return false;
+            }
+
+            // 親が使う側は子プロセスに継承させない
+            SetHandleInformation(inputWrite, HANDLE_FLAG_INHERIT, 0);
+            SetHandleInformation(outputRead, HANDLE_FLAG_INHERIT, 0);
+
+            std::wstring commandLine = QuoteCommandLineArgument(program.wstring());
+            for (const auto& arg : args)
+            {
+                commandLine += L' ';
+                commandLine += QuoteCommandLineArgument(StringToWString(arg));
+            }
+
+            STARTUPINFOW startup{};
+            startup.cb = sizeof(startup);
+            startup.dwFlags = STARTF_USESTDHANDLES;
+            startup.hStdInput = inputRead;
+            startup.hStdOutput = outputWrite;
+            startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+            PROCESS_INFORMATION info{};
+            BOOL created = CreateProcessW(program.c_str(), commandLine.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startup, &info);
+
+            CloseHandle(inputRead);
+            CloseHandle(outputWrite);
+
+            if (!created)
+            {
+                CloseHandle(inputWrite);
+                CloseHandle(outputRead);
+                return false;
+            }
+
+            CloseHandle(info.hThread);
+            m_process = info.hProcess;
+            m_id = info.dwProcessId;
+            m_input = inputWrite;
+            m_output = outputRead;
+            return true;
+#else
+            // 終了した子プロセスのパイプに書き込んだときに SIGPIPE で終了しないようにする（write がエラーを返す）
+            std::signal(SIGPIPE, SIG_IGN);
+
+            int input[2], output[2];
+            if (pipe(input) != 0) return false;
+            if (pipe(output) != 0)
+            {
+                ::close(input[0]);
+                ::close(input[1]);
+                return false;
+            }
+
+            // 他の子プロセスにパイプを継承させない（dup2 した標準入出力は継承される）
+            for (int fd : { input[0], input[1], output[0], output[1] })
+            {
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_adddup2(&actions, input[0], 0);
+            posix_spawn_file_actions_adddup2(&actions, output[1], 1);
+
+            std::string programName = program.u8string();
+            std::vector<std::string> argStrings{ programName };
+            argStrings.insert(argStrings.end(), args.begin(), args.end());
+
+            std::vector<char*> argv;
+            for (auto& arg : argStrings)
+            {
+                argv.push_back(arg.data());
+            }
+            argv.push_back(nullptr);
+
+            pid_t pid;
+            int ret = posix_spawn(&pid, programName.c_str(), &actions, nullptr, argv.data(), environ);
+            posix_spawn_file_actions_destroy(&actions);
+
+            ::close(input[0]);
+            ::close(output[1]);
+
+            if (ret != 0)
+            {
+                ::close(input[1]);
+                ::close(output[0]);
+                return false;
+            }
+
+            m_pid = pid;
+            m_id = static_cast<uint32_t>(pid);
+            m_input = input[1];
+            m_output = output[0];
+            return true;
+#endif
+        }
+
+        // 子プロセスの標準入力を閉じる関数
+        // ※変換サーバーは受け付けた変換を終えてから終了する
+        void Close() override
+        {
+#if defined(_WIN32)
+            if (m_input != nullptr)
+            {
+                CloseHandle(m_input);
+                m_input = nullptr;
+            }
+#else
+            if (m_input >= 0)
+            {
+                ::close(m_input);
+                m_input = -1;
+            }
+#endif
+        }
+
+        // 子プロセスを強制的に終了する関数
+        void Kill()
+        {
+#if defined(_WIN32)
+            if (m_process != nullptr) TerminateProcess(m_process, 1);
+#else
+            if (m_pid > 0) kill(m_pid, SIGKILL);
+#endif
+            Wait();
+        }
+
+        // 子プロセスの終了を待つ関数（終了コード、異常終了した場合は -1）
+        int Wait()
+        {
+#if defined(_WIN32)
+            if (m_process == nullptr) return m_exitCode;
+
+            WaitForSingleObject(m_process, INFINITE);
+            DWORD code = 0;
+            m_exitCode = GetExitCodeProcess(m_process, &code) ? static_cast<int>(code) : -1;
+            CloseHandle(m_process);
+            m_process = nullptr;
+#else
+            if (m_pid <= 0) return m_exitCode;
+
+            int status = 0;
+            pid_t ret;
+            do
+            {
+                ret = waitpid(m_pid, &status, 0);
+            } while (ret < 0 && errno == EINTR);
+
+            m_exitCode = ret == m_pid && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+            m_pid = -1;
+#endif
+            return m_exitCode;
+        }
+
+        // 子プロセスが動いているか（終了を待っていないか）
+        bool IsRunning() const
+        {
+#if defined(_WIN32)
+            return m_process != nullptr;
+#else
+            return m_pid > 0;
+#endif
+        }
+
+        // プロセスID
+        uint32_t GetId() const { return m_id; }
+
+    protected:
+
+        bool ReadAll(void* data, size_t size) override
+        {
+            uint8_t* p = static_cast<uint8_t*>(data);
+            while (size > 0)
+            {
+#if defined(_WIN32)
+                DWORD read = 0;
+                DWORD request = static_cast<DWORD>(size < (1u << 30) ? size : (1u << 30));
+                if (m_output == nullptr || !ReadFile(m_output, p, request, &read, nullptr) || read == 0) return false;
+#else
+                ssize_t read = m_output < 0 ? -1 : ::read(m_output, p, size);
+                if (read < 0 && errno == EINTR) continue;
+                if (read <= 0) return false;
+#endif
+                p += read;
+                size -= static_cast<size_t>(read);
+            }
+            return true;
+        }
+
+        bool WriteAll(const void* data, size_t size) override
+        {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            while (size > 0)
+            {
+#if defined(_WIN32)
+                DWORD written = 0;
+                DWORD request = static_cast<DWORD>(size < (1u << 30) ? size : (1u << 30));
+                if (m_input == nullptr || !WriteFile(m_input, p, request, &written, nullptr) || written == 0) return false;
+#else
+                ssize_t written = m_input < 0 ? -1 : ::write(m_input, p, size);
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0) return false;
+#endif
+                p += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+
+    private:
+
+        // 子プロセスの標準出力を閉じる関数
+        void CloseOutput()
+        {
+#if defined(_WIN32)
+            if (m_output != nullptr)
+            {
+                CloseHandle(m_output);
+                m_output = nullptr;
+            }
+#else
+            if (m_output >= 0)
+            {
+                ::close(m_output);
+                m_output = -1;
+            }
+#endif
+        }
+
+#if defined(_WIN32)
+        HANDLE m_process = nullptr;
+        HANDLE m_input = nullptr;
+        HANDLE m_output = nullptr;
+#else
+        pid_t m_pid = -1;
+        int m_input = -1;
+        int m_output = -1;
+#endif
+        uint32_t m_id = 0;
+        int m_exitCode = -1;
+    };
+}
@@ -0,0 +1,312 @@
+﻿//--------------------------------------------------------------------------------------
+// File: CompressionTest.cpp
+//
+// チャンクデータの圧縮と展開（Compression.h）を確認するテスト
+//
+// ※ctest で実行する（失敗した項目を表示して 1 を返す）
+// ※壊れたデータは過不足のない大きさのバッファに入れて展開するので、
+//   範囲外の読み込みはアドレスサニタイザ（-fsanitize=address）で検出できる
+//
+// Date: 2026.3.20
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Compression.h"
+
+using namespace Imase;
+
+namespace
+{
+    int g_failures = 0;
+
+    void Check(bool condition, const char* expression, int line)
+    {
+        if (condition) return;
+        std::cerr << "CompressionTest.cpp(" << line << "): failed: " << expression << std::endl;
+        g_failures++;
+    }
+
+#define CHECK(expression) Check((expression), #expression, __LINE__)
+
+    // 圧縮しにくいデータ（乱数）
+    std::vector<uint8_t> MakeRandom(size_t size, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::vector<uint8_t> data(size);
+        for (auto& b : data) b = static_cast<uint8_t>(random());
+        return data;
+    }
+
+    // 長い一致を含むデータ（同じ値の連続と、少しずつ変わる短い周期の繰り返し）
+    std::vector<uint8_t> MakeRepetitive(size_t size)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            data[i] = i < size / 2 ? 0x5a : static_cast<uint8_t>((i % 7) + (i / 4096));
+        }
+        return data;
+    }
+
+    // LZ4 のブロックで圧縮して展開できるか確認する関数
+    void CheckLz4RoundTrip(const std::vector<uint8_t>& data, int level)
+    {
+        std::vector<uint8_t> compressed(Lz4::CompressBound(data.size()));
+        size_t size = Lz4::Compress(data.data(), data.size(), compressed.data(), compressed.size(), level);
+        CHECK(size > 0);
+        CHECK(size <= Lz4::CompressBound(data.size()));
+        compressed.resize(size);
+
+        std::vector<uint8_t> decoded(data.size());
+        CHECK(Lz4::Decompress(compressed.data(), compressed.size(), decoded.data(), decoded.size()));
+        CHECK(decoded == data);
+
+        // 展開後のサイズが異なる場合は失敗にする
+        std::vector<uint8_t> larger(data.size() + 1);
+        CHECK(!Lz4::Decompress(compressed.data(), compressed.size(), larger.data(), larger.size()));
+    }
+
+    // チャンク（ブロックテーブル付き）で圧縮して展開できるか確認する関数
+    void CheckChunkRoundTrip(const std::vector<uint8_t>& data, CompressionType type, int level, uint32_t blockSize)
+    {
+        CompressionSettings settings;
+        settings.type = type;
+        settings.level = level;
+        settings.blockSize = blockSize;
+
+        std::vector<uint8_t> compressed = CompressChunkData(data.data(), data.size(), settings);
+
+        CompressedChunkHeader header;
+        std::vector<CompressedBlock> blocks;
+        CHECK(ValidateCompressedChunk(type, compressed.data(), compressed.size(), header, &blocks));
+        CHECK(header.rawSize == data.size());
+        CHECK(blocks.size() == (data.size() + blockSize - 1) / blockSize);
+
+        uint64_t rawSize = 0;
+        CHECK(GetDecompressedSize(type, compressed.data(), compressed.size(), rawSize));
+        CHECK(rawSize == data.size());
+
+        std::vector<uint8_t> decoded;
+        CHECK(DecompressChunkData(type, compressed.data(), compressed.size(), decoded));
+        CHECK(decoded == data);
+    }
+
+    // LZ4 のブロックの圧縮と展開
+    void TestLz4RoundTrip()
+    {
+        for (int level : { 1, 9 })
+        {
+            CheckLz4RoundTrip({}, level);                               // 空
+            CheckLz4RoundTrip({ 1, 2, 3 }, level);                      // 一致を探せないほど小さい
+            CheckLz4RoundTrip(MakeRandom(100000, 1), level);            // 圧縮しにくい
+            CheckLz4RoundTrip(MakeRepetitive(300000), level);           // 長い一致（最大オフセットより長い）
+            CheckLz4RoundTrip(std::vector<uint8_t>(70000, 0), level);   // 全体が１つの一致
+        }
+
+        // 圧縮しにくいデータは CompressBound を超えない
+        std::vector<uint8_t> random = MakeRandom(4096, 2);
+        std::vector<uint8_t> compressed(Lz4::CompressBound(random.size()));
+        CHECK(Lz4::Compress(random.data(), random.size(), compressed.data(), compressed.size(), 1) > random.size());
+
+        // 容量が CompressBound より小さい場合は失敗
+        CHECK(Lz4::Compress(random.data(), random.size(), compressed.data(), random.size(), 1) == 0);
+    }
+
+    // チャンクの圧縮と展開（複数のブロック）
+    void TestChunkRoundTrip()
+    {
+        CheckChunkRoundTrip({}, COMPRESSION_LZ4, 1, 4096);
+        CheckChunkRoundTrip(MakeRandom(10000, 3), COMPRESSION_LZ4, 1, 4096);    // 最後のブロックは端数
+        CheckChunkRoundTrip(MakeRepetitive(1 << 20), COMPRESSION_LZ4, 1, 65536);
+        CheckChunkRoundTrip(MakeRepetitive(100000), COMPRESSION_LZ4, 12, IMDL_DEFAULT_BLOCK_SIZE);
+
+        // 圧縮されていないチャンクはそのまま
+        std::vector<uint8_t> raw = MakeRandom(100, 4);
+        std::vector<uint8_t> decoded;
+        CHECK(DecompressChunkData(COMPRESSION_NONE, raw.data(), raw.size(), decoded));
+        CHECK(decoded == raw);
+    }
+
+    // 壊れた LZ4 のデータを展開する関数（過不足のない大きさのバッファに入れる）
+    bool DecompressLz4(const std::vector<uint8_t>& src, size_t dstSize)
+    {
+        std::unique_ptr<uint8_t[]> input(new uint8_t[src.size() ? src.size() : 1]);
+        if (!src.empty()) std::memcpy(input.get(), src.data(), src.size());
+        std::unique_ptr<uint8_t[]> output(new uint8_t[dstSize ? dstSize : 1]);
+        return Lz4::Decompress(input.get(), src.size(), output.get(), dstSize);
+    }
+
+    // 壊れた LZ4 のデータ
+    void TestLz4Corrupt()
+    {
+        // リテラル 4byte + オフセット 0 の一致
+        CHECK(!DecompressLz4({ 0x40, 'a', 'b', 'c', 'd', 0x00, 0x00 }, 8));
+
+        // 展開済みのデータより前を指すオフセット
+        CHECK(!DecompressLz4({ 0x40, 'a', 'b', 'c', 'd', 0x05, 0x00 }, 8));
+
+        // 入力の残りより長いリテラル
+        CHECK(!DecompressLz4({ 0x50, 'a', 'b', 'c', 'd' }, 5));
+
+        // 追加のバイトで長くしたリテラル（出力より長い）
+        CHECK(!DecompressLz4({ 0xf0, 0xff, 0xff, 0xff, 0x10, 'a' }, 16));
+
+        // 長さの追加のバイトの途中で終わる
+        CHECK(!DecompressLz4({ 0xf0, 0xff, 0xff }, 1024));
+        CHECK(!DecompressLz4({ 0x4f, 'a', 'b', 'c', 'd', 0x01, 0x00, 0xff }, 1024));
+
+        // オフセットの途中で終わる
+        CHECK(!DecompressLz4({ 0x41, 'a', 'b', 'c', 'd', 0x01 }, 9));
+
+        // 出力より長い一致
+        CHECK(!DecompressLz4({ 0x4f, 'a', 'b', 'c', 'd', 0x01, 0x00, 0x10 }, 16));
+
+        // 正しいデータ（リテラル 4byte + オフセット 1 の 5byte の一致）は展開できる
+        CHECK(DecompressLz4({ 0x41, 'a', 'b', 'c', 'd', 0x01, 0x00 }, 9));
+
+        // 正しい圧縮データを途中で切ったもの、1byte ずつ書き換えたもの
+        std::vector<uint8_t> data = MakeRepetitive(20000);
+        std::vector<uint8_t> compressed(Lz4::CompressBound(data.size()));
+        compressed.resize(Lz4::Compress(data.data(), data.size(), compressed.data(), compressed.size(), 1));
+
+        for (size_t size = 0; size < compressed.size(); size += 1 + size / 8)
+        {
+            std::vector<uint8_t> truncated(compressed.begin(), compressed.begin() + size);
+            CHECK(!DecompressLz4(truncated, data.size()));
+        }
+
+        std::mt19937 random(5);
+        for (int i = 0; i < 2000; i++)
+        {
+            std::vector<uint8_t> corrupt = compressed;
+            corrupt[random() % corrupt.size()] ^= static_cast<uint8_t>(1 + random() % 255);
+            DecompressLz4(corrupt, data.size());    // 失敗するとは限らないが、範囲外を読み書きしないこと
+        }
+    }
+
+    // 壊れたチャンクのヘッダとブロックテーブル
+    void TestChunkCorrupt()
+    {
+        std::vector<uint8_t> data = MakeRepetitive(10000);
+
+        CompressionSettings settings;
+        settings.type = COMPRESSION_LZ4;
+        settings.blockSize = 4096;
+        const std::vector<uint8_t> compressed = CompressChunkData(data.data(), data.size(), settings);
+
+        CompressedChunkHeader original;
+        std::memcpy(&original, compressed.data(), sizeof(original));
+        CHECK(original.blockCount == 3);
+
+        // ヘッダを書き換えたものを検証する関数
+        auto validate = [&](const CompressedChunkHeader& header)
+            {
+                std::vector<uint8_t> corrupt = compressed;
+                std::memcpy(corrupt.data(), &header, sizeof(header));
+
+                uint64_t rawSize = 0;
+                std::vector<uint8_t> decoded;
+                bool valid = GetDecompressedSize(COMPRESSION_LZ4, corrupt.data(), corrupt.size(), rawSize);
+                CHECK(valid == DecompressChunkData(COMPRESSION_LZ4, corrupt.data(), corrupt.size(), decoded));
+                return valid;
+            };
+
+        CHECK(validate(original));
+
+        // 展開後のサイズがブロック数 * ブロックサイズを超える
+        CompressedChunkHeader header = original;
+        header.rawSize = static_cast<uint64_t>(header.blockCount) * header.blockSize + 1;
+        CHECK(!validate(header));
+
+        // 巨大な展開後のサイズ（展開先を確保する前に失敗する）
+        header = original;
+        header.rawSize = UINT64_MAX - 1;
+        CHECK(!validate(header));
+
+        // ブロックのサイズ 0
+        header = original;
+        header.blockSize = 0;
+        CHECK(!validate(header));
+
+        // ブロック数が展開後のサイズと合わない
+        header = original;
+        header.blockCount = 0x40000000;
+        CHECK(!validate(header));
+
+        // 各ブロックの圧縮データから展開できるサイズを超える
+        header = original;
+        header.blockSize = 0x10000000;
+        header.blockCount = 1;
+        header.rawSize = header.blockSize;
+        CHECK(!validate(header));
+
+        // ヘッダ、ブロックテーブル、圧縮データの途中で終わる
+        CompressedChunkHeader parsed;
+        for (size_t size : { size_t(0), sizeof(CompressedChunkHeader) - 1, sizeof(CompressedChunkHeader) + 4, compressed.size() - 1 })
+        {
+            std::unique_ptr<uint8_t[]> truncated(new uint8_t[size ? size : 1]);
+            std::memcpy(truncated.get(), compressed.data(), size);
+            CHECK(!ValidateCompressedChunk(COMPRESSION_LZ4, truncated.get(), size, parsed));
+        }
+
+        // ブロックテーブルの圧縮後のサイズがデータを超える
+        std::vector<uint8_t> corrupt = compressed;
+        uint32_t blockSize = 0x7fffffff;
+        std::memcpy(corrupt.data() + sizeof(CompressedChunkHeader), &blockSize, sizeof(blockSize));
+        CHECK(!ValidateCompressedChunk(COMPRESSION_LZ4, corrupt.data(), corrupt.size(), parsed));
+
+        // 圧縮形式が指定されていない、不明な圧縮形式
+        CHECK(!ValidateCompressedChunk(COMPRESSION_NONE, compressed.data(), compressed.size(), parsed));
+        CHECK(!ValidateCompressedChunk(IMDL_CHUNK_FLAG_COMPRESSION_MASK, compressed.data(), compressed.size(), parsed));
+    }
+
+    // zstd（zstd.h が見つかった場合のみ）
+    void TestZstd()
+    {
+#if IMDL_HAS_ZSTD
+        CheckChunkRoundTrip({}, COMPRESSION_ZSTD, 3, 4096);
+        CheckChunkRoundTrip(MakeRandom(10000, 6), COMPRESSION_ZSTD, 3, 4096);
+        CheckChunkRoundTrip(MakeRepetitive(1 << 20), COMPRESSION_ZSTD, 19, 65536);
+
+        // 展開後のサイズがフレームの記録と合わない
+        std::vector<uint8_t> data = MakeRepetitive(10000);
+        CompressionSettings settings;
+        settings.type = COMPRESSION_ZSTD;
+        std::vector<uint8_t> compressed = CompressChunkData(data.data(), data.size(), settings);
+
+        CompressedChunkHeader header;
+        std::memcpy(&header, compressed.data(), sizeof(header));
+        header.rawSize++;
+        std::memcpy(compressed.data(), &header, sizeof(header));
+
+        uint64_t rawSize = 0;
+        CHECK(!GetDecompressedSize(COMPRESSION_ZSTD, compressed.data(), compressed.size(), rawSize));
+#else
+        CHECK(!IsCompressionSupported(COMPRESSION_ZSTD));
+        std::cout << "CompressionTest: zstd is not available, skipped" << std::endl;
+#endif
+    }
+}
+
+int main()
+{
+    TestLz4RoundTrip();
+    TestChunkRoundTrip();
+    TestLz4Corrupt();
+    TestChunkCorrupt();
+    TestZstd();
+
+    if (g_failures)
+    {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "CompressionTest: all checks passed" << std::endl;
+    return 0;
+}
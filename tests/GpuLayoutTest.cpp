@@ -0,0 +1,190 @@
+﻿//--------------------------------------------------------------------------------------
+// File: GpuLayoutTest.cpp
+//
+// GPU アップロード用の配置（GpuLayout.h）のフットプリントを確認するテスト
+//
+// ※ctest で実行する（失敗した項目を表示して 1 を返す）
+//
+// Date: 2026.3.19
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "BinaryWriter.h"
+#include "GpuLayout.h"
+
+using namespace Imase;
+
+namespace
+{
+    // DXGI_FORMAT の値
+    constexpr uint32_t FORMAT_R8G8B8A8_UNORM = 28;
+    constexpr uint32_t FORMAT_BC1_UNORM = 71;
+    constexpr uint32_t FORMAT_BC7_UNORM = 98;
+
+    int g_failures = 0;
+
+    void Check(bool condition, const char* expression, int line)
+    {
+        if (condition) return;
+        std::cerr << "GpuLayoutTest.cpp(" << line << "): failed: " << expression << std::endl;
+        g_failures++;
+    }
+
+#define CHECK(expression) Check((expression), #expression, __LINE__)
+
+    // 2D テクセルの元データを作成する関数（ブロック圧縮形式はブロック単位）
+    GpuTextureSource MakeTexture(uint32_t format, uint32_t width, uint32_t height, uint32_t mipLevels,
+        uint32_t blockBytes, std::vector<std::vector<uint8_t>>& pixels)
+    {
+        uint32_t block = GetGpuFormatBlockSize(format);
+
+        GpuTextureSource texture{};
+        texture.desc.format = format;
+        texture.desc.dimension = 3;
+        texture.desc.width = width;
+        texture.desc.height = height;
+        texture.desc.depth = 1;
+        texture.desc.arraySize = 1;
+        texture.desc.mipLevels = mipLevels;
+
+        for (uint32_t mip = 0; mip < mipLevels; mip++)
+        {
+            uint32_t w = width >> mip ? width >> mip : 1;
+            uint32_t h = height >> mip ? height >> mip : 1;
+
+            GpuSubresourceSource sub{};
+            sub.width = w;
+            sub.height = h;
+            sub.depth = 1;
+            sub.numRows = (h + block - 1) / block;
+            sub.rowSize = static_cast<size_t>((w + block - 1) / block) * blockBytes;
+            sub.rowPitch = sub.rowSize;
+            sub.slicePitch = sub.rowPitch * sub.numRows;
+
+            pixels.emplace_back(sub.slicePitch, static_cast<uint8_t>(mip + 1));
+            sub.data = pixels.back().data();
+            texture.subresources.push_back(sub);
+        }
+
+        return texture;
+    }
+
+    // フットプリントの配置が D3D12 の制約を満たしているか確認する関数
+    void CheckPlacement(const GpuTextureLayout& layout)
+    {
+        for (const auto& footprint : layout.footprints)
+        {
+            uint32_t block = GetGpuFormatBlockSize(footprint.format);
+            CHECK(footprint.offset % IMDL_GPU_SUBRESOURCE_ALIGNMENT == 0);
+            CHECK(footprint.rowPitch % IMDL_GPU_ROW_PITCH_ALIGNMENT == 0);
+            CHECK(footprint.rowPitch >= footprint.rowSize);
+            CHECK(footprint.width % block == 0 && footprint.width >= block);
+            CHECK(footprint.height % block == 0 && footprint.height >= block);
+            CHECK(footprint.numRows * block == footprint.height);
+            CHECK(footprint.offset + static_cast<uint64_t>(footprint.rowPitch) * footprint.numRows * footprint.depth <= layout.size);
+        }
+    }
+
+    // BC1 の 8x8（ミップ 8x8、4x4、2x2、1x1）
+    void TestBlockCompressedMips()
+    {
+        std::vector<std::vector<uint8_t>> pixels;
+        std::vector<GpuTextureSource> textures{ MakeTexture(FORMAT_BC1_UNORM, 8, 8, 4, 8, pixels) };
+
+        GpuTextureLayout layout = ComputeGpuTextureLayout(textures);
+        CheckPlacement(layout);
+
+        CHECK(layout.header.textureCount == 1);
+        CHECK(layout.header.subresourceCount == 4);
+        CHECK(layout.footprints.size() == 4);
+        if (layout.footprints.size() != 4) return;
+
+        const uint32_t sizes[] = { 8, 4, 4, 4 };    // 2x2、1x1 は 4x4 に切り上げる
+        for (size_t i = 0; i < 4; i++)
+        {
+            const GpuSubresourceFootprint& footprint = layout.footprints[i];
+            CHECK(footprint.format == FORMAT_BC1_UNORM);
+            CHECK(footprint.width == sizes[i]);
+            CHECK(footprint.height == sizes[i]);
+            CHECK(footprint.depth == 1);
+            CHECK(footprint.numRows == sizes[i] / 4);
+            CHECK(footprint.rowSize == sizes[i] / 4 * 8);
+            CHECK(footprint.rowPitch == 256);
+
+            // Vulkan の bufferRowLength は 256byte / 8byte * 4 テクセル
+            CHECK(GetGpuBufferRowLength(footprint) == 128);
+        }
+
+        // 1x1 のミップ
+        const GpuSubresourceFootprint& last = layout.footprints.back();
+        CHECK(last.width == 4 && last.height == 4 && last.numRows == 1 && last.rowSize == 8);
+
+        // 書き込んだサイズと各サブリソースのデータの位置
+        std::vector<uint8_t> chunk(static_cast<size_t>(layout.size));
+        MemoryWriter writer(chunk.data(), chunk.size());
+        WriteGpuTextureChunk(writer, textures, layout);
+        CHECK(writer.GetSize() == layout.size);
+
+        for (size_t i = 0; i < layout.footprints.size(); i++)
+        {
+            CHECK(chunk[static_cast<size_t>(layout.footprints[i].offset)] == static_cast<uint8_t>(i + 1));
+        }
+    }
+
+    // BC7 の 1x1（ミップ１つ）
+    void TestBlockCompressedSinglePixel()
+    {
+        std::vector<std::vector<uint8_t>> pixels;
+        std::vector<GpuTextureSource> textures{ MakeTexture(FORMAT_BC7_UNORM, 1, 1, 1, 16, pixels) };
+
+        GpuTextureLayout layout = ComputeGpuTextureLayout(textures);
+        CheckPlacement(layout);
+
+        CHECK(layout.footprints.size() == 1);
+        if (layout.footprints.empty()) return;
+
+        const GpuSubresourceFootprint& footprint = layout.footprints[0];
+        CHECK(footprint.width == 4);
+        CHECK(footprint.height == 4);
+        CHECK(footprint.numRows == 1);
+        CHECK(footprint.rowSize == 16);
+        CHECK(GetGpuBufferRowLength(footprint) == 64);
+    }
+
+    // ブロック圧縮形式でなければ切り上げない
+    void TestUncompressedMips()
+    {
+        std::vector<std::vector<uint8_t>> pixels;
+        std::vector<GpuTextureSource> textures{ MakeTexture(FORMAT_R8G8B8A8_UNORM, 2, 2, 2, 4, pixels) };
+
+        GpuTextureLayout layout = ComputeGpuTextureLayout(textures);
+        CheckPlacement(layout);
+
+        CHECK(layout.footprints.size() == 2);
+        if (layout.footprints.size() != 2) return;
+
+        CHECK(layout.footprints[1].width == 1);
+        CHECK(layout.footprints[1].height == 1);
+        CHECK(layout.footprints[1].numRows == 1);
+        CHECK(layout.footprints[1].rowSize == 4);
+        CHECK(GetGpuBufferRowLength(layout.footprints[1]) == 64);
+    }
+}
+
+int main()
+{
+    TestBlockCompressedMips();
+    TestBlockCompressedSinglePixel();
+    TestUncompressedMips();
+
+    if (g_failures)
+    {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "GpuLayoutTest: all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,239 @@
+﻿//--------------------------------------------------------------------------------------
+// File: ImdlConverterTest.cpp
+//
+// プロセスの中で変換するライブラリ（ImdlConverter.h の ConvertObjToImdl）を確認するテスト
+//
+// ※ctest で実行する（失敗した項目を表示して 1 を返す）
+// ※格子状の obj とテクスチャのない mtl をメモリ上に作成して変換する
+//
+// Date: 2026.3.20
+// Author: Hideyasu Imase
+//--------------------------------------------------------------------------------------
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ChunkIO.h"
+#include "ImdlConverter.h"
+
+using namespace Imase;
+
+namespace
+{
+    int g_failures = 0;
+
+    void Check(bool condition, const char* expression, int line)
+    {
+        if (condition) return;
+        std::cerr << "ImdlConverterTest.cpp(" << line << "): failed: " << expression << std::endl;
+        g_failures++;
+    }
+
+#define CHECK(expression) Check((expression), #expression, __LINE__)
+
+    // 格子の分割数（四角形の面を n * n 個）
+    constexpr uint32_t GRID = 4;
+    constexpr uint32_t GRID_VERTICES = (GRID + 1) * (GRID + 1);
+    constexpr uint32_t GRID_INDICES = GRID * GRID * 6;
+
+    // 格子状の obj を作成する関数（頂点は位置、テクスチャ座標、法線が１対１）
+    std::string MakeGridObj()
+    {
+        std::ostringstream oss;
+        oss << "mtllib grid.mtl\n";
+        for (uint32_t y = 0; y <= GRID; y++)
+        {
+            for (uint32_t x = 0; x <= GRID; x++)
+            {
+                oss << "v " << x << " " << y << " 0\n";
+                oss << "vt " << static_cast<float>(x) / GRID << " " << static_cast<float>(y) / GRID << "\n";
+            }
+        }
+        oss << "vn 0 0 1\n";
+        oss << "usemtl grid\n";
+        for (uint32_t y = 0; y < GRID; y++)
+        {
+            for (uint32_t x = 0; x < GRID; x++)
+            {
+                uint32_t i = y * (GRID + 1) + x + 1;
+                uint32_t face[] = { i, i + 1, i + GRID + 2, i + GRID + 1 };
+                oss << "f";
+                for (uint32_t v : face) oss << " " << v << "/" << v << "/1";
+                oss << "\n";
+            }
+        }
+        return oss.str();
+    }
+
+    // mtl（grid.mtl のみ）を読み込む関数
+    bool LoadFile(const std::filesystem::path& name, std::vector<uint8_t>& data)
+    {
+        if (name != "grid.mtl") return false;
+
+        const char mtl[] = "newmtl grid\nKd 0.5 0.25 1\n";
+        data.assign(mtl, mtl + sizeof(mtl) - 1);
+        return true;
+    }
+
+    // バージョン２のファイルのチャンクのサイズを取得する関数（ない場合は UINT64_MAX）
+    uint64_t GetChunkSize(const std::vector<uint8_t>& imdl, uint32_t type)
+    {
+        FileHeaderV2 header;
+        std::vector<ChunkEntry64> entries;
+        if (!ParseChunkTable(imdl.data(), imdl.size(), header, entries)) return UINT64_MAX;
+
+        const ChunkEntry64* entry = FindChunk(entries, type);
+        return entry ? entry->size : UINT64_MAX;
+    }
+
+    // 変換してチャンクを確認する（バージョン２）
+    void TestConvertToMemory()
+    {
+        ConvertOptions options;
+        options.write.version = IMDL_VERSION_2;
+
+        std::vector<ConvertStage> stages;
+        options.progress = [&stages](ConvertStage stage, size_t done, size_t)
+            {
+                if (done == 0) stages.push_back(stage);
+                return true;
+            };
+
+        std::vector<uint8_t> imdl;
+        ConvertResult result;
+        CHECK(ConvertObjToImdl(MakeGridObj(), LoadFile, options, imdl, result));
+        CHECK(result.status == ConvertStatus::Succeeded);
+        CHECK(result.error.empty());
+        CHECK(result.warnings.empty());
+
+        // 各段階の開始が順に通知される
+        const std::vector<ConvertStage> expected{ ConvertStage::ParseObj, ConvertStage::ParseMtl,
+            ConvertStage::Geometry, ConvertStage::Textures, ConvertStage::Write };
+        CHECK(stages == expected);
+
+        // チャンク
+        CHECK(GetChunkSize(imdl, CHUNK_TEXTURE) == sizeof(uint32_t));     // テクスチャの個数（0）のみ
+        CHECK(GetChunkSize(imdl, CHUNK_MATERIAL) == sizeof(MaterialInfo));
+        CHECK(GetChunkSize(imdl, CHUNK_MESH) == sizeof(MeshInfo));
+        CHECK(GetChunkSize(imdl, CHUNK_VERTEX) == sizeof(VertexPositionNormalTextureTangent) * GRID_VERTICES);
+        CHECK(GetChunkSize(imdl, CHUNK_INDEX) == sizeof(uint32_t) * GRID_INDICES);
+        CHECK(GetChunkSize(imdl, CHUNK_CHECKSUM) == UINT64_MAX);
+
+        // マテリアルとメッシュの内容
+        FileHeaderV2 header;
+        std::vector<ChunkEntry64> entries;
+        if (!ParseChunkTable(imdl.data(), imdl.size(), header, entries)) return;
+
+        const ChunkEntry64* material = FindChunk(entries, CHUNK_MATERIAL);
+        const ChunkEntry64* mesh = FindChunk(entries, CHUNK_MESH);
+        if (!material || !mesh) return;
+
+        MaterialInfo m;
+        std::memcpy(&m, imdl.data() + material->offset, sizeof(m));
+        CHECK(m.diffuseColor.x == 0.5f && m.diffuseColor.y == 0.25f && m.diffuseColor.z == 1.0f);
+        CHECK(m.baseColorTexIndex == -1);
+
+        MeshInfo info;
+        std::memcpy(&info, imdl.data() + mesh->offset, sizeof(info));
+        CHECK(info.startIndex == 0);
+        CHECK(info.primCount == GRID * GRID * 2);
+        CHECK(info.materialIndex == 0);
+    }
+
+    // 既定の設定はバージョン１
+    void TestDefaultVersion()
+    {
+        std::vector<uint8_t> imdl;
+        ConvertResult result;
+        CHECK(ConvertObjToImdl(MakeGridObj(), LoadFile, ConvertOptions(), imdl, result));
+
+        FileHeader header{};
+        CHECK(imdl.size() > sizeof(header));
+        if (imdl.size() < sizeof(header)) return;
+        std::memcpy(&header, imdl.data(), sizeof(header));
+        CHECK(header.magic == IMDL_MAGIC);
+        CHECK(header.version == IMDL_VERSION_1);
+        CHECK(header.chunkCount == 5);
+
+        // モデルデータまで（書き出さない）
+        ModelData model;
+        CHECK(ConvertObjToModel(MakeGridObj(), LoadFile, ConvertOptions(), model, result));
+        CHECK(model.vertices.size() == GRID_VERTICES);
+        CHECK(model.indices.size() == GRID_INDICES);
+        CHECK(model.materials.size() == 1);
+        CHECK(model.textures.empty());
+    }
+
+    // 変換の途中で中止する
+    void TestCancel()
+    {
+        // 進捗の通知で中止する（各段階）
+        for (ConvertStage cancelStage : { ConvertStage::ParseMtl, ConvertStage::Geometry, ConvertStage::Textures, ConvertStage::Write })
+        {
+            ConvertOptions options;
+            options.progress = [cancelStage](ConvertStage stage, size_t, size_t) { return stage != cancelStage; };
+
+            std::vector<uint8_t> imdl{ 1, 2, 3 };
+            ConvertResult result;
+            CHECK(!ConvertObjToImdl(MakeGridObj(), LoadFile, options, imdl, result));
+            CHECK(result.status == ConvertStatus::Cancelled);
+            CHECK(imdl.empty());
+        }
+
+        // 中止のフラグ（解析の後で立てる）
+        std::atomic<bool> cancel{ false };
+        ConvertOptions options;
+        options.cancel = &cancel;
+        options.progress = [&cancel](ConvertStage stage, size_t, size_t)
+            {
+                if (stage == ConvertStage::Geometry) cancel = true;
+                return true;
+            };
+
+        std::vector<uint8_t> imdl;
+        ConvertResult result;
+        CHECK(!ConvertObjToImdl(MakeGridObj(), LoadFile, options, imdl, result));
+        CHECK(result.status == ConvertStatus::Cancelled);
+        CHECK(result.error == "Cancelled");
+        CHECK(imdl.empty());
+
+        // 始める前に立っている
+        cancel = true;
+        options.progress = nullptr;
+        CHECK(!ConvertObjToImdl(MakeGridObj(), LoadFile, options, imdl, result));
+        CHECK(result.status == ConvertStatus::Cancelled);
+        CHECK(imdl.empty());
+    }
+
+    // 失敗（mtl が見つからない）は中止と区別する
+    void TestMissingMaterial()
+    {
+        std::vector<uint8_t> imdl;
+        ConvertResult result;
+        auto loader = [](const std::filesystem::path&, std::vector<uint8_t>&) { return false; };
+        CHECK(!ConvertObjToImdl(MakeGridObj(), loader, ConvertOptions(), imdl, result));
+        CHECK(result.status == ConvertStatus::Failed);
+        CHECK(!result.error.empty());
+        CHECK(imdl.empty());
+    }
+}
+
+int main()
+{
+    TestConvertToMemory();
+    TestDefaultVersion();
+    TestCancel();
+    TestMissingMaterial();
+
+    if (g_failures)
+    {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "ImdlConverterTest: all checks passed" << std::endl;
+    return 0;
+}